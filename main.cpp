@@ -25,7 +25,10 @@
 #include <random>
 #include <boost/lexical_cast.hpp>
 #include <fstream>
+#include <string>
+#include <vector>
 #include <thread>     // for reading the number of concurrent threads supported
+#include <algorithm>
 
 #include "omp.h"
 
@@ -33,6 +36,12 @@
 #include "src/Random.h"
 #include "src/Environment.h"
 #include "src/DataHandler.h"
+#include "src/Scenario.h"
+#include "src/Simulation.h"
+#include "src/SweepRunner.h"
+#include "src/EnsembleRunner.h"
+#include "src/Snapshot.h"
+#include "src/MetricsStore.h"
 #include "src/nlohmann/json.hpp"
 
 using jsonf = nlohmann::json;
@@ -42,8 +51,9 @@ using jsonf = nlohmann::json;
  */
 void printTipsToRun(){
     std::cout << std::endl;
-    std::cout << "This is the sex scenario when partner searches an optimal number of MHC types in offspring."
-            "With alpha limitting the fitness! (param No. 17). Parameters should be:" << std::endl;
+    std::cout << "This is the MHC evolution model. By default it runs the sex scenario when partner searches an "
+            "optimal number of MHC types in offspring. With alpha limitting the fitness! (param No. 17). "
+            "Parameters should be:" << std::endl;
     std::cout << " 1. The number of threads the program will use. Give 0 to use all the available CPU cores." << std::endl;
     std::cout << " 2. Number of bits in a MHC gene." << std::endl;
     std::cout << " 3. Number of bits in an antigen." << std::endl;
@@ -71,6 +81,69 @@ void printTipsToRun(){
             std::endl;
     std::cout << "17. Alpha factor for the host fitness function ([0,1] range)." << std::endl;
     std::cout << std::endl;
+    std::cout << "Options, given anywhere after the program's name as --key=value:" << std::endl;
+    std::cout << "  --scenario=NAME         one of:";
+    for(auto &name : ScenarioSpec::getPresetNames()){
+        std::cout << " " << name;
+    }
+    std::cout << std::endl;
+    std::cout << "  --scenario-file=FILE    JSON file with the scenario (same keys as the options)" << std::endl;
+    std::cout << "  --infection=one|k|every --exposures=K" << std::endl;
+    std::cout << "  --fitness=JustInfection|PerGene|Drift|AlphaXSqr|ExpFunc|ExpFuncUniqAlleles" << std::endl;
+    std::cout << "  --selection=NoMating|Replace" << std::endl;
+    std::cout << "  --mating=none|MeanOptimalNumber|NoCommonMHC|OneDifferentMHC|MaxDifferentNumber|Random" << std::endl;
+    std::cout << "  --host-mutation=PointMutsDelDupl|AllMhcChangeDelDupl" << std::endl;
+    std::cout << "  --scale-host-mutation, --clonal-hosts, --save-patho-genomes, --save-gene-numbers =true|false"
+              << std::endl;
+    std::cout << "  --save-allele-freqs=true|false  copies of every MHC allele in each generation, to" << std::endl;
+    std::cout << "                          AlleleFrequencies.csv" << std::endl;
+    std::cout << "  --binary-snapshots=true|false  dump genomes as PopulationSnapshot.N.bin instead of the" << std::endl;
+    std::cout << "                          HostGenomesFile.N.csv and PathoGenomesFile.N.csv text files" << std::endl;
+    std::cout << "  --snapshot-to-text=FILE convert a PopulationSnapshot.N.bin back to the text files" << std::endl;
+    std::cout << "  --metrics-store=true|false  write the numbers saved every generation to Metrics.bin, as" << std::endl;
+    std::cout << "                          columns indexed by generation, instead of the text files" << std::endl;
+    std::cout << "  --cadence-diversity, --cadence-presented, --cadence-mating, --cadence-gene-numbers," << std::endl;
+    std::cout << "  --cadence-allele-freqs, --cadence-genomes =every:K|log:N|change:X|ends  when the files are" << std::endl;
+    std::cout << "                          saved: every K generations, N times per tenfold of time, when the" << std::endl;
+    std::cout << "                          Shannon index of MHCs changed by more than X (relative), or at the start" << std::endl;
+    std::cout << "                          and the end of run only. Defaults: every:1, genomes - ends" << std::endl;
+    std::cout << "  --genome-sample=N       write N random hosts (and N pathogens) to the genome dumps, 0 for all" << std::endl;
+    std::cout << "  --memory-every=N        write the bytes held by each part of the populations and the resident" << std::endl;
+    std::cout << "                          set size to MemoryUsage.csv every N generations, 0 for never" << std::endl;
+    std::cout << "  --metrics-compression=none|delta|block  pack the integer columns of Metrics.bin as differences" << std::endl;
+    std::cout << "                          in varints (delta), block compressed on top (block)" << std::endl;
+    std::cout << "  --metrics-to-text=FILE  convert a Metrics.bin back to the text files" << std::endl;
+    std::cout << "  --sweep=FILE            run all the lines of FILE (e.g. ParamParam.csv; 17 parameters and" << std::endl;
+    std::cout << "                          optionally --key=value options per line) side by side, each in" << std::endl;
+    std::cout << "                          its own MHC.N directory. Parameters are not given on the command line." << std::endl;
+    std::cout << "  --sweep-cores=N         number of cores the sweep uses, 0 for all of them (the default)" << std::endl;
+    std::cout << "  --ensemble=R            run R replicates starting from the same initial populations, each in" << std::endl;
+    std::cout << "                          its own Replicate.N directory, plus EnsembleHostsGeneDivers.csv with" << std::endl;
+    std::cout << "                          the mean and variance over the replicates" << std::endl;
+    std::cout << "  --async-output=N        format and write the output files on a background thread, with up to" << std::endl;
+    std::cout << "                          N records waiting (0: write at once, the default)" << std::endl;
+    std::cout << "  --async-output-mb=M     most megabytes of data waiting for the background writer (256)" << std::endl;
+    std::cout << "  --fsync=WHEN            force the output files to the disk: never, checkpoint (at checkpoints" << std::endl;
+    std::cout << "                          and at the end of run, the default) or generation (after each one)" << std::endl;
+    std::cout << "  --checkpoint-every=N    save the whole state every N host generations (0: only on SIGTERM, when" << std::endl;
+    std::cout << "                          the run stops after the current generation)" << std::endl;
+    std::cout << "  --checkpoint-file=FILE  checkpoint file name, Checkpoint.bin by default" << std::endl;
+    std::cout << "  --resume=FILE           continue a run from its checkpoint (no parameters and no scenario" << std::endl;
+    std::cout << "                          options are given then)" << std::endl;
+    std::cout << "  --perf-report-every=N   write PerfReport.json (time spent in each phase of a generation) every" << std::endl;
+    std::cout << "                          N host generations, not only at the end of run" << std::endl;
+    std::cout << "  --trace=N               record when each phase and kernel runs on each OpenMP thread, keeping" << std::endl;
+    std::cout << "                          the last N events per thread, to Trace.json (open it in Perfetto)" << std::endl;
+    std::cout << "  --hw-counters=true|false  count cycles, instructions, cache and branch misses of each phase" << std::endl;
+    std::cout << "                          with the hardware counters (Linux perf_event_open), in PerfReport.json" << std::endl;
+    std::cout << "  --warm-start=FILE       start from the hosts (and pathogens) of an evolved run instead of new" << std::endl;
+    std::cout << "                          ones: a checkpoint, a PopulationSnapshot.N.bin or a HostGenomesFile.N.csv;" << std::endl;
+    std::cout << "                          parameters and the scenario are the ones given now. Works with --sweep" << std::endl;
+    std::cout << "                          and --ensemble." << std::endl;
+    std::cout << "  --warm-start-patho=FILE pathogens to start from: a checkpoint, a PopulationSnapshot.N.bin or a" << std::endl;
+    std::cout << "                          PathoGenomesFile.N.csv (new ones by default, unless --warm-start has" << std::endl;
+    std::cout << "                          pathogens)" << std::endl;
+    std::cout << std::endl;
 
 }
 
@@ -79,14 +152,207 @@ void printTipsToRun(){
  * @brief The main function. Things are happening here.
  *
  * Compile this program with:
- * g++ -O3 -o MHC_model main.cpp nlohmann/json.hpp Gene.cpp Antigen.cpp Host.cpp Pathogen.cpp H2Pinteraction.cpp \
-  Random.cpp Tagging_system.cpp Environment.cpp DataHandler.cpp -fopenmp -std=c++14
+ * g++ -O3 -o MHC_model main.cpp src/Gene.cpp src/Antigen.cpp src/Host.cpp src/Pathogen.cpp \
+ * src/PathoEpitopeIndex.cpp src/H2Pinteraction.cpp src/Random.cpp src/Tagging_system.cpp src/AlleleTable.cpp src/Environment.cpp \
+ * src/DataHandler.cpp src/Diversity.cpp src/Scenario.cpp src/Simulation.cpp src/SweepRunner.cpp \
+ * src/EnsembleRunner.cpp src/Snapshot.cpp src/AsyncWriter.cpp \
+ * src/RecordStream.cpp src/MetricsStore.cpp src/Compression.cpp src/OutputSchedule.cpp \
+ * src/PerfProfiler.cpp src/TraceRecorder.cpp src/HardwareCounters.cpp src/MemoryUsage.cpp -fopenmp -std=c++14
  *
  * @param argc - number of arguments
  * @param argv - list of arguments
  * @return 0
  */
 int main(int argc, char** argv) {
+    // Options (--key=value) are separated from the positional parameters
+    std::vector<std::string> options;
+    std::vector<char*> positional;
+    positional.push_back(argv[0]);
+    for(int a = 1; a < argc; ++a){
+        std::string arg = argv[a];
+        if(arg.size() > 2 and arg.compare(0, 2, "--") == 0)
+            options.push_back(arg.substr(2));
+        else
+            positional.push_back(argv[a]);
+    }
+    argc = (int) positional.size();
+    argv = positional.data();
+    // Run options (sweep, ensemble, checkpoints) are not a part of the scenario
+    std::string sweepFile, resumeFile, warmStartFile, warmStartPathoFile, snapshotFile, metricsFile;
+    std::string checkpointFile = "Checkpoint.bin";
+    unsigned int sweepCores = 0;
+    unsigned int ensembleSize = 0;
+    int checkpointEvery = -1; // no checkpoints unless asked for
+    int perfReportEvery = 0; // PerfReport.json written at the end of run only
+    unsigned long traceEvents = 0; // no timeline unless asked for
+    bool hwCounters = false;
+    unsigned long asyncOutput = 0; // records written at once unless asked for
+    unsigned long asyncOutputMB = 256;
+    FsyncPolicy fsyncPolicy = FsyncPolicy::Checkpoint;
+    bool checkpointFileGiven = false;
+    for(auto it = options.begin(); it != options.end(); ){
+        std::size_t eq = it->find('=');
+        std::string key = it->substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : it->substr(eq + 1);
+        std::replace(key.begin(), key.end(), '_', '-');
+        try {
+            if(key == "sweep"){
+                sweepFile = value;
+            } else if(key == "sweep-cores"){
+                sweepCores = boost::lexical_cast<unsigned int>(value);
+            } else if(key == "ensemble"){
+                ensembleSize = boost::lexical_cast<unsigned int>(value);
+            } else if(key == "resume"){
+                resumeFile = value;
+            } else if(key == "warm-start"){
+                warmStartFile = value;
+            } else if(key == "warm-start-patho"){
+                warmStartPathoFile = value;
+            } else if(key == "snapshot-to-text"){
+                snapshotFile = value;
+            } else if(key == "metrics-to-text"){
+                metricsFile = value;
+            } else if(key == "async-output"){
+                asyncOutput = boost::lexical_cast<unsigned long>(value);
+            } else if(key == "async-output-mb"){
+                asyncOutputMB = boost::lexical_cast<unsigned long>(value);
+            } else if(key == "fsync"){
+                if(value == "never"){
+                    fsyncPolicy = FsyncPolicy::Never;
+                } else if(value == "checkpoint"){
+                    fsyncPolicy = FsyncPolicy::Checkpoint;
+                } else if(value == "generation"){
+                    fsyncPolicy = FsyncPolicy::Generation;
+                } else {
+                    std::cout << std::endl;
+                    std::cout << "Option --fsync takes never, checkpoint or generation." << std::endl;
+                    printTipsToRun();
+                    return 0;
+                }
+            } else if(key == "checkpoint-file"){
+                checkpointFile = value;
+                checkpointFileGiven = true;
+            } else if(key == "checkpoint-every"){
+                checkpointEvery = (int) boost::lexical_cast<unsigned int>(value);
+            } else if(key == "perf-report-every"){
+                perfReportEvery = (int) boost::lexical_cast<unsigned int>(value);
+            } else if(key == "trace"){
+                traceEvents = boost::lexical_cast<unsigned long>(value);
+            } else if(key == "hw-counters"){
+                if(value != "true" and value != "false"){
+                    std::cout << std::endl;
+                    std::cout << "Option --hw-counters takes true or false." << std::endl;
+                    printTipsToRun();
+                    return 0;
+                }
+                hwCounters = value == "true";
+            } else {
+                ++it;
+                continue;
+            }
+        }
+        catch(boost::bad_lexical_cast &e) {
+            std::cout << std::endl;
+            std::cout << "Option --" << *it << " needs a number." << std::endl;
+            printTipsToRun();
+            return 0;
+        }
+        it = options.erase(it);
+    }
+    if(!snapshotFile.empty()){
+        SnapshotReader Snapshot;
+        if(!Snapshot.open(snapshotFile) or !Snapshot.convertToText("")){
+            return 0;
+        }
+        std::cout << "Snapshot of generation " << Snapshot.getHeader().Time << " with "
+                  << Snapshot.getNumbOfHosts() << " hosts and " << Snapshot.getNumbOfPathos()
+                  << " pathogens converted to text." << std::endl;
+        return 0;
+    }
+    if(!metricsFile.empty()){
+        MetricsReader Metrics;
+        if(!Metrics.open(metricsFile) or !Metrics.convertToText("")){
+            return 0;
+        }
+        std::cout << Metrics.getNumbOfGenerations() << " generations of " << metricsFile
+                  << " converted to text." << std::endl;
+        return 0;
+    }
+    RunOptions runOptions = {asyncOutput, asyncOutputMB << 20, fsyncPolicy, perfReportEvery, traceEvents, hwCounters};
+    if(warmStartFile.empty() and !warmStartPathoFile.empty()){
+        std::cout << std::endl;
+        std::cout << "Option --warm-start-patho needs --warm-start too." << std::endl;
+        printTipsToRun();
+        return 0;
+    }
+    if(!resumeFile.empty()){
+        if(argc > 1 or !options.empty() or !warmStartFile.empty()){
+            std::cout << std::endl;
+            std::cout << "A resumed run takes its parameters and scenario from the checkpoint "
+                      << resumeFile << ", do not give them on the command line." << std::endl;
+            printTipsToRun();
+            return 0;
+        }
+        ModelParams Params;
+        ScenarioSpec Scenario;
+        if(!Simulation::readCheckpointHeader(resumeFile, Params, Scenario)){
+            return 0;
+        }
+        Simulation Sim(Params, Scenario);
+        Sim.setRunOptions(runOptions);
+        Sim.setCheckpointing(checkpointFile, checkpointEvery > 0 ? checkpointEvery : 0);
+        Simulation::installSignalHandlers();
+        std::cout << "Scenario " << Scenario.describe() << std::endl;
+        if(!Sim.resume(resumeFile)){
+            return 0;
+        }
+        if(!Sim.wasStopped())
+            std::cout << "Run finished. Check the output files for results." << std::endl;
+        std::cout << std::endl;
+        return 0;
+    }
+    ScenarioSpec Scenario;
+    if(!Scenario.readOptions(options)){
+        std::cout << std::endl;
+        std::cout << "Error in the scenario options. Check them." << std::endl;
+        printTipsToRun();
+        return 0;
+    }
+    if(ensembleSize > 0 and (checkpointEvery >= 0 or checkpointFileGiven)){
+        std::cout << std::endl;
+        std::cout << "Checkpoints are not taken in the ensemble mode, an ensemble cannot be resumed." << std::endl;
+        printTipsToRun();
+        return 0;
+    }
+    if(!sweepFile.empty()){
+        if(argc > 1){
+            std::cout << std::endl;
+            std::cout << "In the sweep mode parameters are read from " << sweepFile
+                      << ", do not give them on the command line." << std::endl;
+            printTipsToRun();
+            return 0;
+        }
+        if(checkpointEvery >= 0 or checkpointFileGiven){
+            std::cout << std::endl;
+            std::cout << "Checkpoints are not taken in the sweep mode, a sweep cannot be resumed." << std::endl;
+            printTipsToRun();
+            return 0;
+        }
+        SweepRunner Sweep(sweepCores, Scenario);
+        Sweep.setWarmStart(warmStartFile, warmStartPathoFile);
+        Sweep.setRunOptions(runOptions);
+        if(!Sweep.readParamFile(sweepFile)){
+            std::cout << std::endl;
+            std::cout << "Error in the sweep file " << sweepFile << ". Check it." << std::endl;
+            printTipsToRun();
+            return 0;
+        }
+        unsigned long failed = Sweep.run();
+        std::cout << "Sweep finished: " << Sweep.getNumberOfJobs() - failed << " of "
+                  << Sweep.getNumberOfJobs() << " runs done. Check the MHC.N directories for results." << std::endl;
+        std::cout << std::endl;
+        return 0;
+    }
 // === Check if the entered parameters make sense ===
     int numbOfArgs = 18; // how many arguments we need to run this model
     if (argc < numbOfArgs) {
@@ -105,78 +371,38 @@ int main(int argc, char** argv) {
         printTipsToRun();
         return 0;
     }
-    unsigned long maxGene, hostGeneNumbb, mhcGeneLength, antigenLength;
-    unsigned int numberOfThreads;
-    int hostPopSize, pathoPopSize, patho_sp, NumbPartners,
-        patoPerHostGeneration, numOfHostGenerations, HeteroHomo;
-    double hostMutationProb, pathoMutationProb, deletion, duplication, alpha;
+    ModelParams Params;
     // Check if input params are numbers
-    try {
-        numberOfThreads = boost::lexical_cast<unsigned int>(argv[1]);
-        mhcGeneLength = boost::lexical_cast<unsigned long>(argv[2]);
-        antigenLength = boost::lexical_cast<unsigned long>(argv[3]);
-        hostPopSize = boost::lexical_cast<int>(argv[4]);
-        pathoPopSize = boost::lexical_cast<int>(argv[5]);
-        patho_sp = boost::lexical_cast<int>(argv[6]);
-        hostGeneNumbb = boost::lexical_cast<unsigned long>(argv[7]);
-        patoPerHostGeneration = boost::lexical_cast<int>(argv[8]);
-        numOfHostGenerations = boost::lexical_cast<int>(argv[9]);
-        hostMutationProb = boost::lexical_cast<double>(argv[10]);
-        pathoMutationProb = boost::lexical_cast<double>(argv[11]);
-        HeteroHomo = boost::lexical_cast<int>(argv[12]);
-        deletion = boost::lexical_cast<double>(argv[13]);
-        duplication = boost::lexical_cast<double>(argv[14]);
-        maxGene = boost::lexical_cast<unsigned long>(argv[15]);
-        NumbPartners = boost::lexical_cast<int>(argv[16]);
-        alpha = boost::lexical_cast<double>(argv[17]);
-    }
-    catch(boost::bad_lexical_cast& e) {
+    if(!readModelParams(std::vector<std::string>(argv + 1, argv + argc), Params)){
         std::cout << std::endl;
         std::cout << "Arguments from 1 to " << numbOfArgs-1 << " should be " <<
             "numbers. Not all are numbers. Check the params list!" << std::endl;
         printTipsToRun();
         return 0;
     }
-    // Load the input params
-    numberOfThreads = (unsigned int) strtol(argv[1], nullptr, 10);
-    mhcGeneLength = (unsigned long) strtol(argv[2], nullptr, 10);
-    antigenLength = (unsigned long) strtol(argv[3], nullptr, 10);
-    hostPopSize = (int) strtol(argv[4], nullptr, 10);
-    pathoPopSize = (int) strtol(argv[5], nullptr, 10);
-    patho_sp = (int) strtol(argv[6], nullptr, 10);
-    hostGeneNumbb = (unsigned long) strtol(argv[7], nullptr, 10);
-    patoPerHostGeneration = (int) strtol(argv[8], nullptr, 10);
-    numOfHostGenerations = (int) strtol(argv[9], nullptr, 10);
-    hostMutationProb = strtod(argv[10], nullptr);
-    pathoMutationProb = strtod(argv[11], nullptr);
-    HeteroHomo = (int) strtol(argv[12], nullptr, 10);
-    deletion = strtod(argv[13], nullptr);
-    duplication = strtod(argv[14], nullptr);
-    maxGene = (unsigned long) strtol(argv[15], nullptr, 10);
-    NumbPartners = (int) strtol(argv[16], nullptr, 10);
-    alpha = strtod(argv[17], nullptr);
 
     unsigned int threadsAvailable = std::thread::hardware_concurrency();
     // Initializing the multi-threaded environment
-    if (numberOfThreads == 0)
+    if (Params.numberOfThreads == 0)
     {
-        numberOfThreads = std::thread::hardware_concurrency();
-        if(numberOfThreads == 0) // if the value is not well defined or not computable, set at least 1 thread
-            numberOfThreads = 1;
-    } else if (numberOfThreads > threadsAvailable) {
-        numberOfThreads = threadsAvailable;
+        Params.numberOfThreads = std::thread::hardware_concurrency();
+        if(Params.numberOfThreads == 0) // if the value is not well defined or not computable, set at least 1 thread
+            Params.numberOfThreads = 1;
+    } else if (Params.numberOfThreads > threadsAvailable) {
+        Params.numberOfThreads = threadsAvailable;
     }
-    std::cout << "We have " << numberOfThreads << " threads" << std::endl;
-    omp_set_num_threads(numberOfThreads);
+    std::cout << "We have " << Params.numberOfThreads << " threads" << std::endl;
+    omp_set_num_threads(Params.numberOfThreads);
 
 
     DataHandler Data2file;  // Initialize the data harvesting mechanism
 
     // Check if input params are of any sense
-    if (Data2file.checkParamsIfWrong(numberOfThreads, mhcGeneLength, antigenLength, hostPopSize,
-            pathoPopSize, patho_sp, hostGeneNumbb, patoPerHostGeneration, numOfHostGenerations,
-            hostMutationProb, pathoMutationProb, HeteroHomo, deletion, duplication,
-            maxGene, alpha, NumbPartners)){
+    if (Data2file.checkParamsIfWrong(Params.numberOfThreads, Params.mhcGeneLength, Params.antigenLength,
+            Params.hostPopSize, Params.pathoPopSize, Params.patho_sp, Params.hostGeneNumbb,
+            Params.patoPerHostGeneration, Params.numOfHostGenerations, Params.hostMutationProb,
+            Params.pathoMutationProb, Params.HeteroHomo, Params.deletion, Params.duplication,
+            Params.maxGene, Params.alpha, Params.NumbPartners)){
         std::cout << std::endl;
         std::cout << "Error in parameters on input. Check them." << std::endl;
         printTipsToRun();
@@ -186,80 +412,43 @@ int main(int argc, char** argv) {
     std::cout << "Everything seems fine. Running the model." << std::endl;
 
     // Save input parameters to file
-    Data2file.inputParamsToFile(numberOfThreads, mhcGeneLength, antigenLength, hostPopSize,
-            pathoPopSize, patho_sp, hostGeneNumbb, patoPerHostGeneration, numOfHostGenerations, hostMutationProb,
-            pathoMutationProb, HeteroHomo, deletion, duplication, maxGene,
-            alpha, NumbPartners);
+    Data2file.inputParamsToFile(Params.numberOfThreads, Params.mhcGeneLength, Params.antigenLength,
+            Params.hostPopSize, Params.pathoPopSize, Params.patho_sp, Params.hostGeneNumbb,
+            Params.patoPerHostGeneration, Params.numOfHostGenerations, Params.hostMutationProb,
+            Params.pathoMutationProb, Params.HeteroHomo, Params.deletion, Params.duplication, Params.maxGene,
+            Params.alpha, Params.NumbPartners);
 
 // === And now doing the calculations! ===
-
-    // Initializing tagging system
-    Tagging_system tag;
-// ======================================
-
-    Environment ENV(numberOfThreads); // Initialize the simulation environment
-    Data2file.setAllFilesAsFirtsTimers();
-    ENV.setHostRandomPopulation(hostPopSize, mhcGeneLength, hostGeneNumbb, 0, tag);
-//    ENV.setHostClonalPopulation(hostPopSize, mhcGeneLength, hostGeneNumbb, 0);
-    std::cout << "Host population all set!" << std::endl;
-    ENV.setPathoPopulatioDivSpecies(pathoPopSize, antigenLength, patho_sp, mhcGeneLength, 0, 0, tag);
-    std::cout << "Pathogen population all set!" << std::endl;
-    hostMutationProb = ENV.MMtoPMscaling(hostMutationProb, mhcGeneLength);
-    Data2file.savePathoNoMuttList(ENV);
-
-    // Adding extra info about the parameters of this simulation
-    std::ifstream inJson("InputParameters.json");
-    jsonf jsonfile;
-    inJson >> jsonfile;
-    jsonfile["separated_species_genomes"] = "YES";
-    // set "NO" when using ENV.setPathoPopulatioUniformGenome()
-//    jsonfile["separated_species_genomes"] = "NO";
-    jsonfile["point_mutation_in_host_is_used"] = hostMutationProb;
-    std::string s = jsonfile.dump(4);
-    std::ofstream InputParams;
-    InputParams.open("InputParameters.json");
-    InputParams << s;
-    InputParams.close();
-    
-    std::cout << "Calculating...." << std::endl;
-    // Heterozygote advantage
-    if(HeteroHomo == 10){
-//        Data2file.savePathoPopulToFile(ENV, 0);
-        Data2file.saveHostPopulToFile(ENV, 0);
-        Data2file.saveHostGeneticDivers(ENV, 0);
-        Data2file.saveMhcNumbersBeforeMating(ENV, 0);
-        Data2file.saveMhcNumbersWhenMating(ENV, 0);
-        Data2file.saveMhcNumbersAfterMating(ENV, 0);
-	Data2file.savePresentedPathos(ENV, 0);
-        for(int i = 1; i <= numOfHostGenerations; ++i){
-            for(int j = 0; j < patoPerHostGeneration; ++j){
-                ENV.infectOneFromOneSpecHetero();
-                ENV.selectAndReproducePathoFixedPopSizes();
-                ENV.mutatePathogensWithRestric(pathoMutationProb, mhcGeneLength, i, tag);
-                ENV.clearPathoInfectionData();
-            }
-            Data2file.savePresentedPathos(ENV, i);
-            ENV.calculateHostsFitnessExpScalingUniqAlleles(alpha); // alpha-bounded fitness
-//            ENV.selectAndReprodHostsReplace();
-            ENV.selectAndReprodHostsNoMating();  // changed for sexual reproduction
-            Data2file.saveMhcNumbersBeforeMating(ENV, i);
-            ENV.matingMeanOptimalNumberMHCsmallSubset(NumbPartners); // changed for sexual reproduction
-            Data2file.saveMhcNumbersWhenMating(ENV, i);
-            Data2file.saveMhcNumbersAfterMating(ENV, i);
-            ENV.mutateHostsWithDelDuplPointMuts(hostMutationProb, deletion, duplication, maxGene, i, tag);
-            Data2file.saveHostGeneticDivers(ENV, i);
-//            Data2file.saveHostGeneNumbers(ENV, i);
-            ENV.clearHostInfectionsData();
-//           std::cout << "Host loop " << i << " finished" << std::endl;
-        }
-        ENV.infectOneFromOneSpecHetero();
-    } else {
-       std::cout << "This instance of the model allows only heterozygote";
-       std::cout << " advantage. Sorry :-(" << std::endl;
-       return 0;
+    if(ensembleSize > 0){
+        EnsembleRunner Ensemble(Params, Scenario, ensembleSize);
+        Ensemble.setWarmStart(warmStartFile, warmStartPathoFile);
+        Ensemble.setRunOptions(runOptions);
+        std::cout << "Scenario " << Scenario.describe() << std::endl;
+        unsigned long failed = Ensemble.run();
+        std::cout << "Ensemble finished: " << ensembleSize - failed << " of " << ensembleSize
+                  << " replicates done. Check the Replicate.N directories and EnsembleHostsGeneDivers.csv"
+                  << " for results." << std::endl;
+        std::cout << std::endl;
+        return 0;
+    }
+    if(checkpointFileGiven and checkpointEvery < 0){
+        std::cout << std::endl;
+        std::cout << "--checkpoint-file needs --checkpoint-every, no checkpoints are taken without it." << std::endl;
+        printTipsToRun();
+        return 0;
+    }
+    Simulation Sim(Params, Scenario); // Initialize the simulation environment
+    Sim.setWarmStart(warmStartFile, warmStartPathoFile);
+    Sim.setRunOptions(runOptions);
+    if(checkpointEvery >= 0){
+        Sim.setCheckpointing(checkpointFile, checkpointEvery);
+        Simulation::installSignalHandlers();
+    }
+    std::cout << "Scenario " << Scenario.describe() << std::endl;
+    std::cout << "Generation: " << Sim.getPipelineDescription() << std::endl;
+    if(!Sim.run() or Sim.wasStopped()){
+        return 0;
     }
-//    Data2file.savePathoPopulToFile(ENV, numOfHostGenerations);
-    Data2file.saveHostPopulToFile(ENV, numOfHostGenerations);
 
     std::cout << "Run finished. Check the output files for results." << std::endl;
 
@@ -0,0 +1,155 @@
+/*
+ * File:   AlleleTable.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "AlleleTable.h"
+#include "MemoryUsage.h"
+
+AlleleTable::AlleleTable() : Total(0), Valid(false) {
+}
+
+AlleleTable::~AlleleTable() {
+}
+
+/**
+ * @brief Data harvesting method. Marks the table as out of date, changes are
+ * not followed until it is rebuilt.
+ */
+void AlleleTable::invalidate(){
+    Counts.clear();
+    Total = 0;
+    Valid = false;
+}
+
+bool AlleleTable::isValid() const {
+    return Valid;
+}
+
+/**
+ * @brief Data harvesting method. Counts the alleles of a host population from
+ * scratch.
+ *
+ * @param hosts - the host population
+ */
+void AlleleTable::rebuild(const std::vector<Host> &hosts){
+    Counts.clear();
+    Total = 0;
+    Valid = true;
+    for(const Host &host : hosts){
+        addChromosome(host.getChromosomeOneRef(), 1);
+        addChromosome(host.getChromosomeTwoRef(), 1);
+    }
+}
+
+/**
+ * @brief Data harvesting method. Changes the number of copies of an allele.
+ * Does nothing if the table is out of date.
+ *
+ * @param allele - the allele
+ * @param copies - copies gained (positive) or lost (negative)
+ */
+void AlleleTable::add(unsigned long allele, long copies){
+    if(!Valid or copies == 0)
+        return;
+    long &count = Counts[allele];
+    count += copies;
+    Total += copies;
+    if(count == 0){
+        Counts.erase(allele);
+    } else if(count < 0){
+        std::cout << "Error in AlleleTable::add(): allele " << allele
+                  << " has less than zero copies, the table will be counted anew." << std::endl;
+        invalidate();
+    }
+}
+
+/**
+ * @brief Data harvesting method. Adds (or removes) copies of all the genes of
+ * a chromosome.
+ *
+ * @param chromosome - the chromosome
+ * @param copies - copies of the chromosome gained (positive) or lost (negative)
+ */
+void AlleleTable::addChromosome(const chromovector &chromosome, long copies){
+    if(!Valid or copies == 0)
+        return;
+    for(const Gene &gene : chromosome){
+        add(gene.getTheRealGene(), copies);
+    }
+}
+
+/**
+ * @brief Data harvesting method. Applies changes collected while hosts mutated.
+ *
+ * @param deltas - alleles and changes of their copy numbers
+ */
+void AlleleTable::addDeltas(const alleleDeltas &deltas){
+    for(const auto &delta : deltas){
+        add(delta.first, delta.second);
+    }
+}
+
+/**
+ * @brief Data harvesting method. Shannon's index, Simpson's index and number
+ * of different alleles. Alleles are taken in ascending order, so results do
+ * not depend on the history of the table.
+ *
+ * @return the diversity
+ */
+DiversityStats AlleleTable::getDiversity() const {
+    std::vector<std::pair<unsigned long, unsigned long> > freqs = getFrequencies();
+    std::vector<unsigned long> abundances;
+    abundances.reserve(freqs.size());
+    for(const auto &freq : freqs){
+        abundances.push_back(freq.second);
+    }
+    return DiversityCounter::fromAbundances(abundances);
+}
+
+/**
+ * @brief Data harvesting method. All alleles present with their numbers of
+ * copies, in ascending order of alleles.
+ *
+ * @return pairs of allele and number of copies
+ */
+std::vector<std::pair<unsigned long, unsigned long> > AlleleTable::getFrequencies() const {
+    std::vector<std::pair<unsigned long, unsigned long> > freqs(Counts.begin(), Counts.end());
+    std::sort(freqs.begin(), freqs.end());
+    return freqs;
+}
+
+unsigned long AlleleTable::getNumbOfAlleles() const {
+    return Counts.size();
+}
+
+unsigned long AlleleTable::getNumbOfCopies() const {
+    return (unsigned long) Total;
+}
+
+/**
+ * @brief Data harvesting method. Bytes held by the table (see MemoryUsage).
+ */
+uint64_t AlleleTable::getMemoryBytes() const {
+    return MemoryAccounting::heapBytes(Counts);
+}
@@ -0,0 +1,66 @@
+/*
+ * File:   AlleleTable.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef ALLELETABLE_H
+#define	ALLELETABLE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Host.h"
+#include "Diversity.h"
+
+/**
+ * @brief Data harvesting class. Numbers of copies of every MHC allele in the
+ * host population (both chromosomes of all hosts). Kept up to date by
+ * Environment with changes: copies of parental chromosomes when a new
+ * generation is made and changed, duplicated or deleted genes when hosts
+ * mutate. Diversity of the population then takes a pass over the distinct
+ * alleles instead of over all the genes.
+ *
+ * Changes of the population that are not followed (a new or a loaded
+ * population, a resize, a restored checkpoint) invalidate the table; it is
+ * then counted anew the next time it is needed (see rebuild()).
+ */
+class AlleleTable {
+public:
+    AlleleTable();
+    virtual ~AlleleTable();
+    void invalidate();
+    bool isValid() const;
+    void rebuild(const std::vector<Host> &hosts);
+    void add(unsigned long allele, long copies);
+    void addChromosome(const chromovector &chromosome, long copies);
+    void addDeltas(const alleleDeltas &deltas);
+    DiversityStats getDiversity() const;
+    std::vector<std::pair<unsigned long, unsigned long> > getFrequencies() const;
+    unsigned long getNumbOfAlleles() const;
+    unsigned long getNumbOfCopies() const;
+    uint64_t getMemoryBytes() const;
+private:
+    std::unordered_map<unsigned long, long> Counts;  // only alleles present
+    long Total;
+    bool Valid;
+};
+
+#endif	/* ALLELETABLE_H */
@@ -19,9 +19,11 @@
  *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  *    MA 02110-1301, USA.
  */
+#include <iterator>
 #include "boost/dynamic_bitset.hpp"
 
 #include "Antigen.h"
+#include "BinaryIO.h"
 
 typedef boost::dynamic_bitset<> antigenstring;
 typedef std::vector<unsigned long int> longIntVec;
@@ -113,6 +115,28 @@ void Antigen::setAntigenFlipedPositions(antigenstring bitgene, unsigned long int
     calculateEpitopes(mhcSize);
 }
 
+/**
+ * @brief Core method. Sets an antigen from a given bit-string, e.g. one read
+ * from a file with pathogen genomes.
+ *
+ * @param bitgene - the antigen
+ * @param Tag - tag of the antigen
+ * @param mhcSize - length of a bit string representing the MHC protein
+ * @param timeStamp - time of origin of the antigen
+ * @param parentTags - tags of the antigen's ancestors
+ */
+void Antigen::setAntigenFromBits(antigenstring bitgene, unsigned long int Tag, unsigned long mhcSize,
+                                 int timeStamp, const std::vector<unsigned long int> &parentTags){
+    TheAntigen = bitgene;
+    timeOfOrigin = timeStamp;
+    TheParentWas = -1;
+    BitStringLength = bitgene.size();
+    AntigenTag = Tag;
+    ParentTags = parentTags;
+    MutationTime.clear();
+    calculateEpitopes(mhcSize);
+}
+
 
 /**
  * @brief Core method. Mutates antigen one bit by one bit.
@@ -188,6 +212,15 @@ antigenstring Antigen::getBitAntigen(){
     return TheAntigen;
 }
 
+/**
+ * @brief Core method. Returns the antigen bit-string without copying it.
+ *
+ * @return read-only reference to the antigen bit-string
+ */
+const antigenstring& Antigen::getBitAntigenRef() const {
+    return TheAntigen;
+}
+
 /**
  * @brief Core method. Returns the epitope with the given index.
  * 
@@ -216,6 +249,16 @@ longIntVec Antigen::getEpitopes(){
     return Epitopes;
 }
 
+/**
+ * @brief Core method. Returns the epitopes without copying them. Same as
+ * getEpitopes(), but meant for hot loops.
+ *
+ * @return read-only reference to the vector of epitopes.
+ */
+const longIntVec& Antigen::getEpitopesRef() const {
+    return Epitopes;
+}
+
 
 /**
  * @brief Auxiliary method. Prints antigens to screen. Useful when debugging.
@@ -227,4 +270,45 @@ void Antigen::printAntigenToScreen(){
       std::cout <<  Epitopes[i] << " ";
     }
     std::cout << std::endl;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Core method. Writes the antigen with its epitopes and history to a
+ * binary stream (see BinaryIO).
+ *
+ * @param out - the stream
+ */
+void Antigen::writeState(std::ostream &out) const {
+    BinaryIO::write(out, timeOfOrigin);
+    BinaryIO::write(out, TheParentWas);
+    BinaryIO::write(out, AntigenTag);
+    BinaryIO::write(out, BitStringLength);
+    BinaryIO::write(out, (uint64_t) TheAntigen.size());
+    std::vector<antigenstring::block_type> blocks;
+    boost::to_block_range(TheAntigen, std::back_inserter(blocks));
+    BinaryIO::writeVector(out, blocks);
+    BinaryIO::writeVector(out, Epitopes);
+    BinaryIO::writeVector(out, ParentTags);
+    BinaryIO::writeVector(out, MutationTime);
+}
+
+/**
+ * @brief Core method. Reads an antigen written by writeState().
+ *
+ * @param in - the stream
+ * @return 'false' if the antigen could not be read
+ */
+bool Antigen::readState(std::istream &in){
+    uint64_t numOfBits;
+    std::vector<antigenstring::block_type> blocks;
+    if(!(BinaryIO::read(in, timeOfOrigin) and BinaryIO::read(in, TheParentWas)
+         and BinaryIO::read(in, AntigenTag) and BinaryIO::read(in, BitStringLength)
+         and BinaryIO::read(in, numOfBits) and BinaryIO::readVector(in, blocks)))
+        return false;
+    TheAntigen = antigenstring(numOfBits);
+    if(blocks.size() != TheAntigen.num_blocks())
+        return false;
+    boost::from_block_range(blocks.begin(), blocks.end(), TheAntigen);
+    return BinaryIO::readVector(in, Epitopes) and BinaryIO::readVector(in, ParentTags)
+           and BinaryIO::readVector(in, MutationTime);
+}
@@ -51,11 +51,15 @@ public:
     void mutateAntgBitByBitWithRes(double pm_mut_probabl, unsigned long mhcSize,
                                    int timeStamp, std::set<unsigned long>& noMutts,
                                    Random& randGen, Tagging_system& tag);
+    void setAntigenFromBits(antigenstring bitgene, unsigned long int Tag, unsigned long mhcSize, int timeStamp,
+                            const std::vector<unsigned long int> &parentTags);
     void setAntigenFlipedPositions(antigenstring bitgene, unsigned long int Tag,
                                    int Nth, unsigned long mhcSize, int timeStamp);
     antigenstring getBitAntigen();
+    const antigenstring& getBitAntigenRef() const;
     unsigned long int getOneEpitope(unsigned long idx);
     longIntVec getEpitopes();
+    const longIntVec& getEpitopesRef() const;
     // === Data harvesting ===
     int timeOfOrigin;
     int TheParentWas;
@@ -63,6 +67,8 @@ public:
     std::vector<int> MutationTime;
     unsigned long int AntigenTag;
     void printAntigenToScreen();
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in);
 private:
     antigenstring TheAntigen;
     longIntVec Epitopes;
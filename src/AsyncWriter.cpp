@@ -0,0 +1,119 @@
+/*
+ * File:   AsyncWriter.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <exception>
+#include <iostream>
+
+#include "AsyncWriter.h"
+
+/**
+ * @brief Data harvesting method. Constructor. Starts the writer thread.
+ *
+ * @param maxTasks - most tasks waiting in the queue (at least 1)
+ * @param maxBytes - most bytes of data held by the waiting tasks; a single
+ * larger task is still accepted when the queue is empty
+ */
+AsyncWriter::AsyncWriter(std::size_t maxTasks, std::size_t maxBytes)
+        : MaxTasks(maxTasks ? maxTasks : 1), MaxBytes(maxBytes), QueuedBytes(0), Busy(false),
+          Finished(false), Waits(0) {
+    Writer = std::thread(&AsyncWriter::worker, this);
+}
+
+/**
+ * @brief Data harvesting method. Destructor. Writes out everything that is
+ * queued and stops the writer thread.
+ */
+AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> lock(QueueMutex);
+        Finished = true;
+    }
+    NotEmpty.notify_all();
+    Writer.join();
+}
+
+/**
+ * @brief Data harvesting method. Queues a write task. Waits if the queue is
+ * full (back-pressure).
+ *
+ * @param task - the task, it has to own all the data it uses
+ * @param bytes - size of the data the task holds
+ */
+void AsyncWriter::submit(Task task, std::size_t bytes){
+    std::unique_lock<std::mutex> lock(QueueMutex);
+    auto hasRoom = [this, bytes]{
+        return Queue.empty() or (Queue.size() < MaxTasks and QueuedBytes + bytes <= MaxBytes);
+    };
+    if(!hasRoom()){
+        ++Waits;
+        NotFull.wait(lock, hasRoom);
+    }
+    Queue.push_back(QueuedTask{std::move(task), bytes});
+    QueuedBytes += bytes;
+    lock.unlock();
+    NotEmpty.notify_one();
+}
+
+/**
+ * @brief Data harvesting method. Waits until all the queued tasks are written
+ * (e.g. before a checkpoint or at the end of run).
+ */
+void AsyncWriter::flush(){
+    std::unique_lock<std::mutex> lock(QueueMutex);
+    AllDone.wait(lock, [this]{ return Queue.empty() and !Busy; });
+}
+
+/**
+ * @brief Data harvesting method. How many times the simulation had to wait for
+ * the writer because the queue was full.
+ *
+ * @return number of waits
+ */
+unsigned long AsyncWriter::getNumbOfWaits() const {
+    std::lock_guard<std::mutex> lock(QueueMutex);
+    return Waits;
+}
+
+void AsyncWriter::worker(){
+    std::unique_lock<std::mutex> lock(QueueMutex);
+    while(true){
+        NotEmpty.wait(lock, [this]{ return !Queue.empty() or Finished; });
+        if(Queue.empty())
+            break;
+        QueuedTask next = std::move(Queue.front());
+        Queue.pop_front();
+        Busy = true;
+        lock.unlock();
+        try {
+            next.Job();
+        }
+        catch(std::exception &e) {
+            std::cout << "Error in AsyncWriter::worker(): a write task failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+        Busy = false;
+        QueuedBytes -= next.Bytes;
+        NotFull.notify_all();
+        if(Queue.empty())
+            AllDone.notify_all();
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * File:   AsyncWriter.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef ASYNCWRITER_H
+#define	ASYNCWRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Data harvesting class. Background output stage of DataHandler: a
+ * single writer thread runs write tasks (formatting and file I/O) in the order
+ * they were submitted, while the simulation goes on. Each task owns a copy of
+ * the data it writes, harvested from the Environment at submit time.
+ *
+ * The queue is bounded by a number of tasks and by the bytes of data they
+ * hold. A submit that would go over either limit waits for the writer, so a
+ * slow file system slows the simulation down instead of eating the memory.
+ */
+class AsyncWriter {
+public:
+    typedef std::function<void()> Task;
+    AsyncWriter(std::size_t maxTasks, std::size_t maxBytes);
+    virtual ~AsyncWriter();
+    void submit(Task task, std::size_t bytes);
+    void flush();
+    unsigned long getNumbOfWaits() const;
+private:
+    struct QueuedTask {
+        Task Job;
+        std::size_t Bytes;
+    };
+    void worker();
+    std::size_t MaxTasks;
+    std::size_t MaxBytes;
+    std::deque<QueuedTask> Queue;
+    std::size_t QueuedBytes;
+    bool Busy;                        // the writer is running a task
+    bool Finished;
+    unsigned long Waits;              // submits that had to wait for the writer
+    mutable std::mutex QueueMutex;
+    std::condition_variable NotEmpty;
+    std::condition_variable NotFull;
+    std::condition_variable AllDone;
+    std::thread Writer;
+};
+
+#endif	/* ASYNCWRITER_H */
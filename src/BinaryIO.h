@@ -0,0 +1,104 @@
+/*
+ * File:   BinaryIO.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef BINARYIO_H
+#define	BINARYIO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Helpers for the binary files of the model (checkpoints, snapshots).
+ * Values are written as they are in memory (native byte order), vectors and
+ * strings are preceded by their length as a 64-bit number. Reading functions
+ * return 'false' when the stream ends too early or a length is not believable.
+ * Vectors and strings are read in parts of at most ReadStep bytes, so a
+ * damaged length makes the read fail at the end of the stream instead of
+ * allocating what the length says.
+ */
+namespace BinaryIO {
+
+    const uint64_t MaxLength = 1ull << 40;  // sanity limit of a vector/string length
+    const uint64_t ReadStep = 1 << 20;      // bytes read (and allocated) at once
+
+    template <typename T>
+    inline void write(std::ostream &out, const T &value){
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::write() needs a plain type");
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    inline bool read(std::istream &in, T &value){
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::read() needs a plain type");
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return (bool) in;
+    }
+
+    template <typename T>
+    inline void writeVector(std::ostream &out, const std::vector<T> &vec){
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::writeVector() needs a plain type");
+        write(out, (uint64_t) vec.size());
+        if(!vec.empty())
+            out.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+    }
+
+    template <typename T>
+    inline bool readVector(std::istream &in, std::vector<T> &vec){
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::readVector() needs a plain type");
+        uint64_t size;
+        if(!read(in, size) or size > MaxLength)
+            return false;
+        const uint64_t step = ReadStep / sizeof(T) + 1;
+        vec.clear();
+        for(uint64_t done = 0; done < size; done += step){
+            uint64_t part = std::min(step, size - done);
+            vec.resize(done + part);
+            if(!in.read(reinterpret_cast<char*>(vec.data() + done), part * sizeof(T)))
+                return false;
+        }
+        return true;
+    }
+
+    inline void writeString(std::ostream &out, const std::string &str){
+        write(out, (uint64_t) str.size());
+        out.write(str.data(), str.size());
+    }
+
+    inline bool readString(std::istream &in, std::string &str){
+        uint64_t size;
+        if(!read(in, size) or size > MaxLength)
+            return false;
+        str.clear();
+        for(uint64_t done = 0; done < size; done += ReadStep){
+            uint64_t part = std::min(ReadStep, size - done);
+            str.resize(done + part);
+            if(!in.read(&str[done], part))
+                return false;
+        }
+        return true;
+    }
+}
+
+#endif	/* BINARYIO_H */
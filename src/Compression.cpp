@@ -0,0 +1,167 @@
+/*
+ * File:   Compression.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cstring>
+
+#include "Compression.h"
+
+namespace {
+
+    const unsigned HashBits = 12;
+    const std::size_t MinMatch = 4;
+    const std::size_t MaxOffset = 65535;
+
+    inline uint32_t read32(const uint8_t *p){
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t hashOf(uint32_t sequence){
+        return (sequence * 2654435761u) >> (32 - HashBits);
+    }
+
+    /**
+     * @brief Appends a length that did not fit into its 4 bits of the token:
+     * bytes of 255 and the rest.
+     */
+    inline void appendLength(std::vector<uint8_t> &out, std::size_t length){
+        while(length >= 255){
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back((uint8_t) length);
+    }
+
+    inline bool readLength(const uint8_t *&in, const uint8_t *end, std::size_t &length){
+        uint8_t byte;
+        do {
+            if(in == end)
+                return false;
+            byte = *in++;
+            length += byte;
+        } while(byte == 255);
+        return true;
+    }
+
+    /**
+     * @brief Appends a sequence: a token (number of literals in the high 4
+     * bits, match length - MinMatch in the low ones, 15 meaning "more bytes
+     * follow"), the literals, and the match: its distance back (2 bytes, low
+     * one first) and the rest of its length. The last sequence has no match.
+     */
+    void appendSequence(std::vector<uint8_t> &out, const uint8_t *literals, std::size_t numbOfLiterals,
+                        std::size_t offset, std::size_t matchLength){
+        std::size_t matchCode = matchLength >= MinMatch ? matchLength - MinMatch : 0;
+        out.push_back((uint8_t) ((numbOfLiterals < 15 ? numbOfLiterals : 15) << 4
+                                 | (matchCode < 15 ? matchCode : 15)));
+        if(numbOfLiterals >= 15)
+            appendLength(out, numbOfLiterals - 15);
+        out.insert(out.end(), literals, literals + numbOfLiterals);
+        if(matchLength < MinMatch)
+            return;
+        out.push_back((uint8_t) (offset & 0xFF));
+        out.push_back((uint8_t) (offset >> 8));
+        if(matchCode >= 15)
+            appendLength(out, matchCode - 15);
+    }
+}
+
+namespace Compression {
+
+    /**
+     * @brief Compresses a block of bytes: repeats of at least 4 bytes within
+     * the last 64 KiB are replaced by references back (LZ77, greedy, one
+     * candidate per 4-byte hash). Fast rather than tight; it is meant for the
+     * varint streams of the metrics store, where the same runs of small
+     * numbers come again and again.
+     *
+     * @param data - the block
+     * @param size - its size
+     * @param out - the compressed block is appended to it
+     */
+    void compressBlock(const uint8_t *data, std::size_t size, std::vector<uint8_t> &out){
+        std::vector<uint32_t> table(1u << HashBits, 0);  // last place + 1 of each hash, 0 - none
+        std::size_t anchor = 0;
+        std::size_t pos = 0;
+        while(pos + MinMatch <= size){
+            uint32_t sequence = read32(data + pos);
+            uint32_t &slot = table[hashOf(sequence)];
+            std::size_t candidate = slot;
+            slot = (uint32_t) (pos + 1);
+            if(candidate == 0 or pos + 1 - candidate > MaxOffset or read32(data + candidate - 1) != sequence){
+                ++pos;
+                continue;
+            }
+            --candidate;
+            std::size_t length = MinMatch;
+            while(pos + length < size and data[candidate + length] == data[pos + length])
+                ++length;
+            appendSequence(out, data + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        }
+        appendSequence(out, data + anchor, size - anchor, 0, 0);
+    }
+
+    /**
+     * @brief Decompresses a block made by compressBlock().
+     *
+     * @param data - the compressed block
+     * @param size - its size
+     * @param out - gets the bytes
+     * @param rawSize - size of the block before compression
+     * @return 'false' if the block is broken or does not give rawSize bytes
+     */
+    bool decompressBlock(const uint8_t *data, std::size_t size, std::vector<uint8_t> &out, std::size_t rawSize){
+        out.resize(rawSize);
+        const uint8_t *in = data;
+        const uint8_t *end = data + size;
+        std::size_t pos = 0;
+        while(in < end){
+            uint8_t token = *in++;
+            std::size_t numbOfLiterals = token >> 4;
+            if(numbOfLiterals == 15 and !readLength(in, end, numbOfLiterals))
+                return false;
+            if(numbOfLiterals > (std::size_t) (end - in) or numbOfLiterals > rawSize - pos)
+                return false;
+            std::memcpy(out.data() + pos, in, numbOfLiterals);
+            in += numbOfLiterals;
+            pos += numbOfLiterals;
+            if(in == end)
+                break;
+            if(end - in < 2)
+                return false;
+            std::size_t offset = in[0] | (std::size_t) in[1] << 8;
+            in += 2;
+            std::size_t length = (token & 15) + MinMatch;
+            if((token & 15) == 15 and !readLength(in, end, length))
+                return false;
+            if(offset == 0 or offset > pos or length > rawSize - pos)
+                return false;
+            for(std::size_t b = 0; b < length; ++b, ++pos){  // byte by byte, the match may overlap itself
+                out[pos] = out[pos - offset];
+            }
+        }
+        return pos == rawSize;
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * File:   Compression.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef COMPRESSION_H
+#define	COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Helpers packing columns of integers for the metrics store: zigzag
+ * coding of signed differences, variable length integers (7 bits per byte, the
+ * low ones first, the high bit set in all bytes but the last) and a byte
+ * oriented LZ77 block compressor (see compressBlock()). Everything is done in
+ * memory, with no external library.
+ */
+namespace Compression {
+
+    /**
+     * @brief Maps a signed difference to an unsigned number, small in absolute
+     * value to small: 0, -1, 1, -2, ... to 0, 1, 2, 3, ...
+     */
+    inline uint64_t zigzag(int64_t value){
+        return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+    }
+
+    inline int64_t unzigzag(uint64_t value){
+        return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+    }
+
+    /**
+     * @brief Appends a variable length integer.
+     */
+    inline void appendVarint(std::vector<uint8_t> &out, uint64_t value){
+        while(value >= 0x80){
+            out.push_back((uint8_t) (value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t) value);
+    }
+
+    /**
+     * @brief Reads a variable length integer.
+     *
+     * @param in - where it starts, moved past it
+     * @param end - end of the data
+     * @param value - gets the integer
+     * @return 'false' if the data ends before the integer does or it is too long
+     */
+    inline bool readVarint(const uint8_t *&in, const uint8_t *end, uint64_t &value){
+        value = 0;
+        for(unsigned shift = 0; shift < 64 and in < end; shift += 7){
+            uint8_t byte = *in++;
+            value |= (uint64_t) (byte & 0x7F) << shift;
+            if(byte < 0x80)
+                return true;
+        }
+        return false;
+    }
+
+    void compressBlock(const uint8_t *data, std::size_t size, std::vector<uint8_t> &out);
+    bool decompressBlock(const uint8_t *data, std::size_t size, std::vector<uint8_t> &out, std::size_t rawSize);
+}
+
+#endif	/* COMPRESSION_H */
@@ -23,62 +23,345 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
-#include <tuple>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <omp.h>
 
 #include "DataHandler.h"
+#include "BinaryIO.h"
+#include "Diversity.h"
+#include "PerfProfiler.h"
+#include "Snapshot.h"
+#include "TextFormat.h"
 #include "nlohmann/json.hpp"
 
 using jsonf = nlohmann::json;
 typedef std::string sttr;
 
-DataHandler::DataHandler() {
+DataHandler::DataHandler() : MetricsOn(false), MetricsPacking(MetricsCompression::None),
+    Fsync(FsyncPolicy::Checkpoint) {
 }
 
 //DataHarvester::DataHarvester(const DataHarvester& orig) {
 //}
 
 DataHandler::~DataHandler() {
+    Writer.reset();
+    commitRecords(Fsync != FsyncPolicy::Never);
 }
 
 /**
- * @brief Data harvesting method. Calculates some stats of population genetics:
- * Shannon's index, number of MHC/antigen types, total number of MHC copies. 
- * Runs internally within DataHarvester class.
- * 
- * @return <a href="http://en.cppreference.com/w/cpp/utility/tuple/make_tuple">
- * STD Touple object</a> with 3 numbers: Shannon's index, number of MHC/antigen 
- * types, total number of MHC copies
- */
-auto getShannonIndx(std::vector<unsigned long> GeneVals){
-    int Types = 0;
-    double Summ = 0.0;
-    double tot_gene_numb = (double) GeneVals.size();
-    if(GeneVals.size()){
-        unsigned long GeneCounter = GeneVals.size();
-        bool IfCountedLyst[GeneCounter];
-        for (unsigned long w = 0; w < GeneCounter; ++w) {
-            IfCountedLyst[w] = false;
-        }
-        double abundance;
-        for (unsigned long i = 0; i < GeneCounter; ++i) {
-            if (!IfCountedLyst[i]) {
-                Types += 1;
-                abundance = 1.0;
-                for (unsigned long j = i + 1; j < GeneCounter; ++j) {
-                    if (i != j && !IfCountedLyst[j] && GeneVals[i] == GeneVals[j]){
-                        abundance += 1.0;
-                        IfCountedLyst[j] = true;
-                    }
-                }
-                // the proper calculations
-                Summ = Summ - ((abundance / tot_gene_numb) 
-                        * std::log(abundance / tot_gene_numb));
+ * @brief Data harvesting method. Adds a record of one time step to a file: the
+ * time stamp and one value per individual (or species), space separated.
+ *
+ * @param recordFile - the file, see DataHandler::openRecord()
+ * @param tayme - time stamp (hosts generation number)
+ * @param values - the values
+ */
+template <typename T>
+void writeRecord(std::ostream &recordFile, int tayme, const std::vector<T> &values){
+    std::vector<char> line;
+    TextFormat::appendRecord(line, tayme, values);
+    recordFile.write(line.data(), line.size());
+}
+
+/**
+ * @brief Data harvesting method. Record of one time step made of a number of
+ * every host, formatted straight from the host population (see
+ * Environment::appendHostColumn()).
+ *
+ * @param EnvObj - the Environment object
+ * @param column - which number
+ * @param tayme - time stamp (hosts generation number)
+ * @return the record line, with its end of line
+ */
+std::vector<char> hostColumnRecord(Environment &EnvObj, HostColumn column, int tayme){
+    std::vector<char> line(TextFormat::MaxDigits + 1);
+    line.resize(TextFormat::write(line.data(), tayme) - line.data());
+    EnvObj.appendHostColumn(column, line);
+    line.push_back('\n');
+    return line;
+}
+
+/**
+ * @brief Data harvesting method. A number of every host, as a metrics store
+ * column (see Environment::forEachHostValue()).
+ *
+ * @param EnvObj - the Environment object
+ * @param column - which number
+ * @return the numbers, in the order of hosts
+ */
+template <typename T>
+std::vector<T> hostColumnValues(Environment &EnvObj, HostColumn column){
+    std::vector<T> values;
+    values.reserve(EnvObj.getHostsPopSize());
+    EnvObj.forEachHostValue(column, [&values](unsigned long value){
+        values.push_back((T) value);
+    });
+    return values;
+}
+
+/**
+ * @brief Data harvesting method. Writes a list of individuals to a file as
+ * text. The list goes in batches; each thread turns a contiguous slice of a
+ * batch into text in its own buffer and the buffers are written in the order
+ * of the slices, so the file is the same whatever the number of threads.
+ *
+ * @param file - the file
+ * @param individuals - hosts or pathogens
+ * @param buffers - text buffers, one per thread, kept between calls
+ * @param appendText - appends the text of an individual to a buffer
+ */
+template <typename Individual, typename AppendText>
+void writeIndividualsText(std::ostream &file, const std::vector<const Individual*> &individuals,
+                          std::vector<std::vector<char> > &buffers, AppendText appendText){
+    const std::size_t perThread = 256;  // individuals per thread in a batch
+    int numberOfThreads = omp_get_max_threads();
+    if(buffers.size() < (std::size_t) numberOfThreads)
+        buffers.resize(numberOfThreads);
+    std::size_t size = individuals.size();
+    std::size_t batch = perThread * numberOfThreads;
+    for(std::size_t start = 0; start < size; start += batch){
+        std::size_t stop = std::min(start + batch, size);
+        int usedThreads = numberOfThreads;
+        #pragma omp parallel num_threads(numberOfThreads) default(none) \
+                shared(individuals, buffers, appendText, start, stop, usedThreads)
+        {
+            int thread = omp_get_thread_num();
+            int threads = omp_get_num_threads();
+            #pragma omp single
+            usedThreads = threads;
+            std::size_t slice = (stop - start + threads - 1) / threads;
+            std::size_t first = std::min(start + thread * slice, stop);
+            std::size_t last = std::min(first + slice, stop);
+            buffers[thread].clear();
+            for(std::size_t i = first; i < last; ++i){
+                appendText(*individuals[i], buffers[thread]);
             }
         }
+        for(int thread = 0; thread < usedThreads; ++thread){
+            file.write(buffers[thread].data(), buffers[thread].size());
+        }
+    }
+}
+
+/**
+ * @brief Data harvesting method. Makes the save*() methods hand the harvested
+ * data to a background writer thread (see AsyncWriter) instead of formatting
+ * and writing it while the simulation waits.
+ *
+ * @param maxTasks - most records waiting to be written; 0 turns the background
+ * writer off (everything is written at once, the default)
+ * @param maxBytes - most bytes of data waiting to be written
+ */
+void DataHandler::setAsyncOutput(std::size_t maxTasks, std::size_t maxBytes){
+    Writer.reset();
+    if(maxTasks > 0)
+        Writer.reset(new AsyncWriter(maxTasks, maxBytes));
+}
+
+/**
+ * @brief Data harvesting method. Writes out everything: waits until the
+ * background writer (if any) is done and writes out the buffers of the record
+ * files, forcing them to the disk unless the fsync policy is "never". Called at
+ * checkpoints and at the end of run.
+ */
+void DataHandler::flushOutput(){
+    bool toDisk = Fsync != FsyncPolicy::Never;
+    submitWrite([this, toDisk]{ commitRecords(toDisk); }, 0);
+    if(Writer)
+        Writer->flush();
+}
+
+/**
+ * @brief Data harvesting method. Sets when the record files are forced to the
+ * disk (fsync): never, at checkpoints and at the end of run (the default) or
+ * after every generation. Forcing them more often makes less data lost when
+ * the machine crashes, and makes the run slower.
+ *
+ * @param policy - the policy
+ */
+void DataHandler::setFsyncPolicy(FsyncPolicy policy){
+    Fsync = policy;
+}
+
+/**
+ * @brief Data harvesting method. Makes the per-generation numbers go to a
+ * columnar metrics store, Metrics.bin (see MetricsWriter), instead of the
+ * per-generation text files. MetricsReader reads the store and converts it
+ * back to the text files. The per-host columns, which make most of the store,
+ * can be packed as differences in varints and block compressed on top (see
+ * MetricsWriter::setCompression()).
+ *
+ * @param metricsOn - 'true' for the metrics store, 'false' for the text files (the default)
+ * @param compression - how much the integer columns are packed
+ */
+void DataHandler::setMetricsStore(bool metricsOn, MetricsCompression compression){
+    MetricsOn = metricsOn;
+    MetricsPacking = compression;
+}
+
+OutputSchedule& DataHandler::getSchedule(){
+    return Schedule;
+}
+
+/**
+ * @brief Data harvesting method. Call it at the start of every host
+ * generation (and before generation zero is saved). Decides which groups of
+ * files are saved in the generation, see OutputSchedule. The save methods of
+ * files that are not due do nothing.
+ *
+ * @param EnvObj - the environment, for the diversity of hosts
+ * @param tayme - time stamp (hosts generation number)
+ */
+void DataHandler::planGeneration(Environment &EnvObj, int tayme){
+    double shannon = Schedule.needsDiversity() ? EnvObj.getHostAlleles().getDiversity().Shannon : 0.0;
+    Schedule.planGeneration(tayme, shannon);
+}
+
+/**
+ * @brief Data harvesting method. Is a group of files saved in the current
+ * generation?
+ */
+bool DataHandler::isDue(Harvester harvester) const {
+    return Schedule.isDue(harvester);
+}
+
+/**
+ * @brief Data harvesting method. Call it at the end of every host generation.
+ * Writes the generation to the metrics store, if it is used. Writes out and
+ * forces to the disk the record files if the fsync policy says so, otherwise
+ * they stay buffered.
+ */
+void DataHandler::endGeneration(){
+    if(MetricsOn)
+        submitWrite([this]{ if(Metrics) Metrics->endGeneration(); }, 0);
+    if(Fsync == FsyncPolicy::Generation)
+        submitWrite([this]{ commitRecords(true); }, 0);
+}
+
+/**
+ * @brief Data harvesting method. Runs a write task: on the background writer
+ * if there is one, at once otherwise.
+ *
+ * @param task - the task, owning the data it writes
+ * @param bytes - size of the data
+ */
+void DataHandler::submitWrite(AsyncWriter::Task task, std::size_t bytes){
+    if(Writer)
+        Writer->submit(std::move(task), bytes);
+    else
+        task();
+}
+
+/**
+ * @brief Data harvesting method. Gives the stream of a per-generation record
+ * file. The file stays open, with a large buffer, until the end of run, so
+ * records of many generations are written at once. On the first record of the
+ * run the file is started anew with its header line, otherwise records are
+ * appended to it.
+ *
+ * @param fileName - name of the file in the output directory
+ * @param firstTime - is it the first record of the run?
+ * @param header - header line of the file
+ * @return the stream
+ */
+std::ostream& DataHandler::openRecord(const std::string &fileName, bool firstTime, const char *header){
+    std::unique_ptr<RecordStream> &recordFile = Records[fileName];
+    if(!recordFile)
+        recordFile.reset(new RecordStream(1 << 20));
+    if(firstTime or !recordFile->isOpen()){
+        recordFile->open(getOutputPath(fileName), firstTime);
+        if(firstTime)
+            *recordFile << header << '\n';
+    }
+    return *recordFile;
+}
+
+/**
+ * @brief Data harvesting method. Hands a column of the current generation to
+ * be written to the metrics store.
+ *
+ * @param tayme - time stamp (hosts generation number)
+ * @param column - the column
+ * @param values - its values
+ */
+template <typename T>
+void DataHandler::submitMetric(int tayme, MetricColumn column, std::vector<T> values){
+    bool firstTime = takeFirstMetrics();
+    std::size_t bytes = values.size() * sizeof(T);
+    submitWrite([this, tayme, column, firstTime, values = std::move(values)]{
+        openMetrics(firstTime).add(tayme, column, values);
+    }, bytes);
+}
+
+/**
+ * @brief Data harvesting method. Is it the first use of the metrics store in
+ * the run? Only the first call gives 'true'.
+ */
+bool DataHandler::takeFirstMetrics(){
+    bool firstTime = ifFirstMetrics;
+    ifFirstMetrics = false;
+    return firstTime;
+}
+
+/**
+ * @brief Data harvesting method. Gives the metrics store, Metrics.bin. It
+ * stays open until the end of run; on its first use in the run it is started
+ * anew, otherwise it is continued.
+ *
+ * @param firstTime - is it the first use of the run?
+ * @return the store
+ */
+MetricsWriter& DataHandler::openMetrics(bool firstTime){
+    if(!Metrics){
+        Metrics.reset(new MetricsWriter());
+        Metrics->setCompression(MetricsPacking);
+    }
+    if(firstTime or !Metrics->isOpen())
+        Metrics->open(getOutputPath("Metrics.bin"), firstTime);
+    return *Metrics;
+}
+
+/**
+ * @brief Data harvesting method. Writes out the buffers of all record files
+ * and of the metrics store.
+ *
+ * @param toDisk - 'true' to force them to the disk too (fsync)
+ */
+void DataHandler::commitRecords(bool toDisk){
+    for(auto &record : Records){
+        record.second->commit(toDisk);
     }
-    // ShannIndx (double), typesOfGenes (int), numberOfAllGenes (double)
-    auto RTRN = std::make_tuple( Summ, Types, tot_gene_numb );
-    return RTRN;
+    if(Metrics)
+        Metrics->commit(toDisk);
+}
+
+/**
+ * @brief Data harvesting method. Writes out and closes all record files and
+ * the metrics store.
+ */
+void DataHandler::closeRecords(){
+    flushOutput();
+    Records.clear();
+    Metrics.reset();
+}
+
+/**
+ * @brief Data harvesting method. Hands a formatted record line to be written
+ * to a record file (see openRecord()).
+ *
+ * @param fileName - name of the file in the output directory
+ * @param firstTime - is it the first record of the run?
+ * @param header - header line of the file
+ * @param line - the record line
+ */
+void DataHandler::submitRecord(const char *fileName, bool firstTime, const char *header, std::vector<char> line){
+    std::size_t bytes = line.size();
+    submitWrite([this, fileName, firstTime, header, line = std::move(line)]{
+        openRecord(fileName, firstTime, header).write(line.data(), line.size());
+    }, bytes);
 }
 
 /**
@@ -95,6 +378,115 @@ void DataHandler::setAllFilesAsFirtsTimers(){
     ifNumberOfMhcWhenMating = true;
     ifNumberOfMhcBeforeMating = true;
     ifNumberOfMhcAfterMating = true;
+    ifFirstAlleleFreqs = true;
+    ifFirstMetrics = true;
+    ifFirstMemoryUsage = true;
+}
+
+/**
+ * @brief Data harvesting method. Sets the directory all the output files go
+ * to. By default it is the current working directory. The directory has to
+ * exist already.
+ *
+ * @param dirName - path to the directory; empty string means the working directory
+ */
+void DataHandler::setOutputDirectory(const std::string &dirName){
+    OutputDir = dirName;
+    if(!OutputDir.empty() and OutputDir.back() != '/')
+        OutputDir += '/';
+}
+
+/**
+ * @brief Data harvesting method. Path of an output file in the output
+ * directory (see setOutputDirectory()).
+ *
+ * @param fileName - name of the file
+ * @return path to the file
+ */
+std::string DataHandler::getOutputPath(const std::string &fileName) const {
+    return OutputDir + fileName;
+}
+
+/**
+ * @brief Data harvesting method. Writes the state of the data handler (which
+ * files were started already) to a binary stream, see BinaryIO.
+ *
+ * @param out - the stream
+ */
+void DataHandler::writeState(std::ostream &out) const {
+    const bool flags[] = {ifFirstSpecToFileRun, ifFirstHostClonesRun, ifFirstHostGeneDivRun,
+                          ifFirstGeneNumbersTotal, ifFirstGeneNumbersUnique, ifNoMuttPathoListUnique,
+                          ifNumberOfPresentedPatho, ifNumberOfMhcWhenMating, ifNumberOfMhcBeforeMating,
+                          ifNumberOfMhcAfterMating, ifFirstAlleleFreqs, ifFirstMetrics, ifFirstMemoryUsage};
+    BinaryIO::writeVector(out, std::vector<char>(std::begin(flags), std::end(flags)));
+    Schedule.writeState(out);
+}
+
+/**
+ * @brief Data harvesting method. Reads the state written by writeState().
+ *
+ * @param in - the stream
+ * @return 'false' if the state could not be read
+ */
+bool DataHandler::readState(std::istream &in){
+    bool *flagFields[] = {&ifFirstSpecToFileRun, &ifFirstHostClonesRun, &ifFirstHostGeneDivRun,
+                          &ifFirstGeneNumbersTotal, &ifFirstGeneNumbersUnique, &ifNoMuttPathoListUnique,
+                          &ifNumberOfPresentedPatho, &ifNumberOfMhcWhenMating, &ifNumberOfMhcBeforeMating,
+                          &ifNumberOfMhcAfterMating, &ifFirstAlleleFreqs, &ifFirstMetrics, &ifFirstMemoryUsage};
+    std::vector<char> flags;
+    if(!BinaryIO::readVector(in, flags) or flags.size() != sizeof(flagFields) / sizeof(flagFields[0]))
+        return false;
+    for(unsigned long i = 0; i < flags.size(); ++i)
+        *flagFields[i] = flags[i];
+    return Schedule.readState(in);
+}
+
+/**
+ * @brief Data harvesting method. Removes records of time steps later than
+ * tayme from the files written every generation (lines in them start with the
+ * time stamp) and from the metrics store. Used when a run continues from a
+ * checkpoint, so the generations done after the checkpoint by the run that was
+ * stopped are not there twice.
+ *
+ * @param tayme - time stamp of the last generation to keep
+ */
+void DataHandler::dropRecordsAfter(int tayme){
+    const char *fileNames[] = {"HostsGeneDivers.csv", "HostGeneNumbTotal_ChrOne.csv",
+                               "HostMHCsNumbUniq_ChrOne.csv", "PresentedPathogenNumbers.csv",
+                               "NumberOfMhcInMother.csv", "NumberOfMhcInFather.csv",
+                               "NumberOfMhcBeforeMating.csv", "NumberOfMhcAfterMating.csv",
+                               "AlleleFrequencies.csv", "MemoryUsage.csv"};
+    closeRecords();
+    for(const char *fileName : fileNames){
+        std::ifstream inFile(getOutputPath(fileName));
+        if(!inFile.good())
+            continue;
+        std::string kept;
+        std::string line;
+        bool dropped = false;
+        while(std::getline(inFile, line)){
+            if(inFile.eof()){
+                // no end of line - cut short by the run that was stopped
+                dropped = true;
+                break;
+            }
+            std::stringstream ss(line);
+            int lineTime;
+            if(!line.empty() and line[0] != '#' and ss >> lineTime and lineTime > tayme){
+                dropped = true;
+                continue;
+            }
+            kept += line;
+            kept += '\n';
+        }
+        inFile.close();
+        if(dropped){
+            std::ofstream outFile(getOutputPath(fileName), std::ios::out | std::ios::trunc);
+            outFile << kept;
+        }
+    }
+    if(MetricsOn)
+        MetricsWriter::dropAfter(getOutputPath("Metrics.bin"), tayme);
 }
 
 /** 
@@ -250,7 +642,7 @@ void DataHandler::inputParamsToFile(unsigned int numberOfThreads, unsigned long
 
     std::string s = jsonfile.dump(4); // making it look human-readable instead of one long line in a file
     std::ofstream InputParams;
-    InputParams.open("InputParameters.json");
+    InputParams.open(getOutputPath("InputParameters.json"));
     InputParams << s;
     InputParams.close();
 }
@@ -264,68 +656,176 @@ void DataHandler::inputParamsToFile(unsigned int numberOfThreads, unsigned long
  * @param tayme - time stamp (hosts generation number) 
  */
 void DataHandler::saveNumOfPathoSpeciesToFile(Environment& EnvObj, int tayme){
-    if(ifFirstSpecToFileRun){
-        std::ofstream PathoPopulFile;
-        PathoPopulFile.open("PathoPopSizes.csv");
-        PathoPopulFile << "#time subsequent_species_pop_size" << std::endl;
-        PathoPopulFile.close();
-        ifFirstSpecToFileRun = false;
-    }
-    std::ofstream PathoPopulFile;
-    PathoPopulFile.open("PathoPopSizes.csv",
-            std::ios::out | std::ios::ate | std::ios::app);
-    PathoPopulFile << tayme;
+    std::vector<unsigned long> SpeciesSizes;
     for(unsigned j = 0; j < EnvObj.getPathoNumOfSpecies(); ++j){
-        PathoPopulFile << " " << EnvObj.getPathoSpeciesPopSize(j);      
+        SpeciesSizes.push_back(EnvObj.getPathoSpeciesPopSize(j));
     }
-    PathoPopulFile << std::endl;
-    PathoPopulFile.close();
+    bool firstTime = ifFirstSpecToFileRun;
+    ifFirstSpecToFileRun = false;
+    std::size_t bytes = SpeciesSizes.size() * sizeof(unsigned long);
+    submitWrite([this, tayme, firstTime, SpeciesSizes]{
+        writeRecord(openRecord("PathoPopSizes.csv", firstTime, "#time subsequent_species_pop_size"),
+                    tayme, SpeciesSizes);
+    }, bytes);
 }
 
 /**
  * @brief Data harvesting method. Writes to a file all pathogens with their
- * genomes in a human-readable format.
+ * genomes in a human-readable format. With a genome sample set in the output
+ * schedule only a random sample of them (from all species together) is written.
+ * With the background writer the pathogens are handed over as a binary
+ * snapshot (see takeSnapshot()), which the writer thread turns into the text.
  * 
  * @param EnvObj - the Environment object
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::savePathoPopulToFile(Environment& EnvObj, int tayme){
-    sttr theFilename = sttr("PathoGenomesFile.") + std::to_string(tayme) + sttr(".csv");
+    PERF_PHASE(PerfPhase::SaveGenomes);
+    const std::vector<std::vector<Pathogen> > &pathogens = EnvObj.getPathoPopulationRef();
+    std::size_t numbOfPathos = 0;
+    for(auto &species : pathogens)
+        numbOfPathos += species.size();
+    std::size_t sampleSize = Schedule.getGenomeSample();
+    std::vector<std::size_t> sample;
+    if(sampleSize > 0 and sampleSize < numbOfPathos)
+        sample = Schedule.drawSample(numbOfPathos, sampleSize);
+    sttr theFilename = getOutputPath(sttr("PathoGenomesFile.") + std::to_string(tayme) + sttr(".csv"));
+    if(Writer){
+        std::shared_ptr<const std::string> snapshot = takeSnapshot(EnvObj, tayme, false, true);
+        submitWrite([snapshot, sample, theFilename]{
+            SnapshotReader reader;
+            std::ofstream PathogGenomeFile(theFilename);
+            if(reader.open(snapshot->data(), snapshot->size()))
+                reader.writePathoText(PathogGenomeFile, sample);
+        }, snapshot->size());
+        return;
+    }
+    // a sample from all species together, each sampled pathogen stays in its species
+    std::vector<const Pathogen*> PathPopulation;
+    PathPopulation.reserve(sample.empty() ? numbOfPathos : sample.size());
+    std::size_t speciesStart = 0, sp = 0;
+    for(std::size_t n = 0; n < (sample.empty() ? numbOfPathos : sample.size()); ++n){
+        std::size_t i = sample.empty() ? n : sample[n];
+        while(i >= speciesStart + pathogens[sp].size()){
+            speciesStart += pathogens[sp].size();
+            ++sp;
+        }
+        PathPopulation.push_back(&pathogens[sp][i - speciesStart]);
+    }
     std::ofstream PathogGenomeFile;
     PathogGenomeFile.open(theFilename);
-    PathogGenomeFile << "#Genomes_of_all_pathogens_at_time = " << tayme << std::endl;
+    if(!sample.empty()){
+        PathogGenomeFile << "#Genomes_of_" << sample.size() << "_of_" << numbOfPathos
+                         << "_pathogens_sampled_at_time = " << tayme << std::endl;
+    } else {
+        PathogGenomeFile << "#Genomes_of_all_pathogens_at_time = " << tayme << std::endl;
+    }
     PathogGenomeFile << "#bit-gene\tchromosome\ttime_of_origin\tgene_own_tag\tAll_parental_tags"
             << std::endl;
-    for(unsigned long i = 0; i < EnvObj.getPathoNumOfSpecies(); ++i){
-        for(unsigned long j = 0; j < EnvObj.getPathoSpeciesPopSize(i); ++j){
-            PathogGenomeFile << EnvObj.getPathoGenesToString(i, j);
-        }
-    }
+    writeIndividualsText(PathogGenomeFile, PathPopulation, TextBuffers,
+            [](const Pathogen &patho, std::vector<char> &text){
+                patho.appendGenesFromGenome(text);
+            });
     PathogGenomeFile.close();
 }
 
 /**
  * @brief Data harvesting method. Writes to a file all hosts with their
- * genomes in a human-readable format.
+ * genomes in a human-readable format. With a genome sample set in the output
+ * schedule only a random sample of them is written. With the background
+ * writer the hosts are handed over as a binary snapshot (see takeSnapshot()),
+ * which the writer thread turns into the text.
  * 
  * @param EnvObj - the Environment object
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::saveHostPopulToFile(Environment& EnvObj, int tayme){
-    sttr theFilename = sttr("HostGenomesFile.") + std::to_string(tayme) + sttr(".csv");
+    PERF_PHASE(PerfPhase::SaveGenomes);
+    const std::vector<Host> &hosts = EnvObj.getHostPopulationRef();
+    std::size_t sampleSize = Schedule.getGenomeSample();
+    std::size_t numbOfHosts = hosts.size();
+    std::vector<std::size_t> sample;
+    if(sampleSize > 0 and sampleSize < numbOfHosts)
+        sample = Schedule.drawSample(numbOfHosts, sampleSize);
+    sttr theFilename = getOutputPath(sttr("HostGenomesFile.") + std::to_string(tayme) + sttr(".csv"));
+    if(Writer){
+        std::shared_ptr<const std::string> snapshot = takeSnapshot(EnvObj, tayme, true, false);
+        submitWrite([snapshot, sample, theFilename]{
+            SnapshotReader reader;
+            std::ofstream HostGenomesFile(theFilename);
+            if(reader.open(snapshot->data(), snapshot->size()))
+                reader.writeHostText(HostGenomesFile, sample);
+        }, snapshot->size());
+        return;
+    }
+    std::vector<const Host*> HostPopulation;
+    HostPopulation.reserve(sample.empty() ? numbOfHosts : sample.size());
+    if(sample.empty()){
+        for(const Host &host : hosts)
+            HostPopulation.push_back(&host);
+    } else {
+        for(std::size_t i : sample)
+            HostPopulation.push_back(&hosts[i]);
+    }
     std::ofstream HostGenomesFile;
     HostGenomesFile.open(theFilename);
-    HostGenomesFile << "#Genomes_of_all_host_at_time = " << tayme << std::endl;
+    if(!sample.empty())
+        HostGenomesFile << "#Genomes_of_" << sample.size() << "_of_" << numbOfHosts
+                        << "_hosts_sampled_at_time = " << tayme << std::endl;
+    else
+        HostGenomesFile << "#Genomes_of_all_host_at_time = " << tayme << std::endl;
     HostGenomesFile << "#bit-gene\tchromosome\ttime_of_origin\tgene_own_tag" <<
             "\tTime_of_parental_mutation\tAll_parental_tags etc."
             << std::endl;
-    for(int i = 0; i < EnvObj.getHostsPopSize(); ++i){
-        HostGenomesFile << EnvObj.getHostGenesToString(i);
-//        HostGenomesFile << EnvObj.getHostUniqMHCtoString(i);
-    }
+    writeIndividualsText(HostGenomesFile, HostPopulation, TextBuffers,
+            [](const Host &host, std::vector<char> &text){
+                host.appendChromosomes(text);
+//                host.appendUniqMHCs(text);
+            });
     HostGenomesFile.close();
 }
 
+/**
+ * @brief Data harvesting method. Takes a binary snapshot of the populations
+ * (see Environment::writeSnapshot()) to hand over to the background writer.
+ * The snapshot is a few flat columns, so it is much cheaper than a copy of the
+ * hosts and pathogens, and it stays as it is while the simulation goes on.
+ *
+ * @param EnvObj - the Environment object
+ * @param tayme - time stamp (hosts generation number)
+ * @param withHosts - 'true' to take the hosts
+ * @param withPathogens - 'true' to take the pathogens
+ * @return the snapshot
+ */
+std::shared_ptr<const std::string> DataHandler::takeSnapshot(Environment &EnvObj, int tayme, bool withHosts,
+                                                             bool withPathogens){
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    EnvObj.writeSnapshot(out, tayme, withHosts, withPathogens);
+    return std::make_shared<const std::string>(out.str());
+}
+
+/**
+ * @brief Data harvesting method. Writes to a file all hosts (and pathogens)
+ * with their genomes as a binary snapshot, PopulationSnapshot.N.bin. It holds
+ * the same data as HostGenomesFile.N.csv and PathoGenomesFile.N.csv in a
+ * fraction of their size; SnapshotReader reads it and converts it back to text.
+ *
+ * @param EnvObj - the Environment object
+ * @param tayme - time stamp (hosts generation number)
+ * @param withPathogens - 'true' to save pathogens too
+ * @return 'false' if the file could not be written
+ */
+bool DataHandler::savePopulSnapshot(Environment& EnvObj, int tayme, bool withPathogens){
+    PERF_PHASE(PerfPhase::SaveSnapshot);
+    sttr theFilename = sttr("PopulationSnapshot.") + std::to_string(tayme) + sttr(".bin");
+    std::ofstream SnapshotFile(getOutputPath(theFilename), std::ios::out | std::ios::binary);
+    if(!SnapshotFile.good() or !EnvObj.writeSnapshot(SnapshotFile, tayme, true, withPathogens)){
+        std::cout << "Error in DataHandler::savePopulSnapshot(): cannot write " << theFilename << std::endl;
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief Data harvesting method. Calculates and writes to a file some stats 
  * about the hosts population genetic. Will create one file per run. First column
@@ -340,52 +840,51 @@ void DataHandler::saveHostPopulToFile(Environment& EnvObj, int tayme){
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::saveHostGeneticDivers(Environment& EnvObj, int tayme){
-    if(ifFirstHostGeneDivRun){
-        std::ofstream HostGeneDivFile;
-        HostGeneDivFile.open("HostsGeneDivers.csv");
-        HostGeneDivFile << "#time pop_size tot_num_of_genes num_of_MHC_types" <<
-                " Shannon_indx mean_fitness std_fitness" << std::endl;
-        HostGeneDivFile.close();
-        ifFirstHostGeneDivRun = false;
-    }
-    std::vector<unsigned long> AllTheGeneVals;
+    if(!Schedule.isDue(Harvester::Diversity))
+        return;
+    PERF_PHASE(PerfPhase::SaveDiversity);
     std::vector<double> Fitness;
     double popSize = (double) EnvObj.getHostsPopSize();
 //    int homoLociNum = -1; // not applicable at the moment!
-//    double tot_gene_numb = 0;
     Fitness.clear();
     for(unsigned long i = 0; i < EnvObj.getHostsPopSize(); ++i){
-//        tot_gene_numb += EnvObj.getSingleHostGenomeSize(i);
         Fitness.push_back(EnvObj.getHostFitness(i));
-        // Harvesting genes from Chromosome One in all hosts
-        for(unsigned long j = 0; j < EnvObj.getSingleHostChromoOneSize(i); ++j){
-            AllTheGeneVals.push_back(EnvObj.getSingleHostRealGeneOne(i, j));
-        }
-        // Harvesting genes from Chromosome Two in all Phosts
-        for(unsigned long m = 0; m < EnvObj.getSingleHostChromoTwoSize(i); ++m){
-            AllTheGeneVals.push_back(EnvObj.getSingleHostRealGeneTwo(i, m));
-        }
     }
-    // Calculating the Shannon index et al. plus extracting it from the tuple
-    auto ShOut = getShannonIndx(AllTheGeneVals);
-    double Summ = std::get < 0 >( ShOut );
-    int mhcTypes = std::get < 1 >( ShOut );
-    double tot_gene_numb = std::get < 2 >( ShOut );
-    
-    // calculating for coefficient of variation of hosts fitness
-    double cv_sum = std::accumulate(Fitness.begin(), Fitness.end(), 0.0);
-    double fit_mean = cv_sum / Fitness.size();
-    double sq_sum = std::inner_product(Fitness.begin(), Fitness.end(), 
-                                       Fitness.begin(), 0.0);
-    double stdev = std::sqrt(sq_sum / Fitness.size() - fit_mean * fit_mean);
-    
-    std::ofstream HostGenomesFile;
-    HostGenomesFile.open("HostsGeneDivers.csv",
-            std::ios::out | std::ios::ate | std::ios::app);
-    HostGenomesFile << tayme << " " << popSize << " " << tot_gene_numb << " " <<
-            mhcTypes << " " << Summ << " " << fit_mean <<
-            " " << stdev << std::endl;
-    HostGenomesFile.close();
+    // The Shannon index et al. from the allele table kept by the Environment
+    DiversityStats Divers = EnvObj.getHostAlleles().getDiversity();
+    bool metrics = MetricsOn;
+    bool firstMetrics = metrics and takeFirstMetrics();
+    bool firstTime = ifFirstHostGeneDivRun;
+    ifFirstHostGeneDivRun = false;
+    std::size_t bytes = Fitness.size() * sizeof(double);
+    submitWrite([this, tayme, metrics, firstMetrics, firstTime, popSize, Divers, Fitness]{
+        double Summ = Divers.Shannon;
+        unsigned long mhcTypes = Divers.Richness;
+        double tot_gene_numb = (double) Divers.Total;
+
+        // calculating for coefficient of variation of hosts fitness
+        double cv_sum = std::accumulate(Fitness.begin(), Fitness.end(), 0.0);
+        double fit_mean = cv_sum / Fitness.size();
+        double sq_sum = std::inner_product(Fitness.begin(), Fitness.end(),
+                                           Fitness.begin(), 0.0);
+        double stdev = std::sqrt(sq_sum / Fitness.size() - fit_mean * fit_mean);
+
+        if(metrics){
+            MetricsWriter &store = openMetrics(firstMetrics);
+            store.add(tayme, HostPopSize, std::vector<double>{popSize});
+            store.add(tayme, HostTotalGenes, std::vector<double>{tot_gene_numb});
+            store.add(tayme, HostMhcTypes, std::vector<uint64_t>{mhcTypes});
+            store.add(tayme, HostShannon, std::vector<double>{Summ});
+            store.add(tayme, HostMeanFitness, std::vector<double>{fit_mean});
+            store.add(tayme, HostStdFitness, std::vector<double>{stdev});
+            return;
+        }
+        std::ostream &HostGenomesFile = openRecord("HostsGeneDivers.csv", firstTime,
+                "#time pop_size tot_num_of_genes num_of_MHC_types Shannon_indx mean_fitness std_fitness");
+        HostGenomesFile << tayme << " " << popSize << " " << tot_gene_numb << " " <<
+                mhcTypes << " " << Summ << " " << fit_mean <<
+                " " << stdev << '\n';
+    }, bytes);
 }
 
 /**
@@ -397,65 +896,83 @@ void DataHandler::saveHostGeneticDivers(Environment& EnvObj, int tayme){
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::saveHostGeneNumbers(Environment& EnvObj, int tayme){
-    if(ifFirstGeneNumbersTotal){
-        std::ofstream HostGeneNumbTotal;
-        HostGeneNumbTotal.open("HostGeneRecord the total number of genes and types\n"
-                                       " * of MHCs in hosts. All the freaking hosts!\n"
-                                       " * \n"
-                                       " * Writes to separate files (a) the number of  genes of all the host in each \n"
-                                       " * time step, (b) the number of unique MHC types corresponding to the numbers\n"
-                                       " *  in the first file. All together you get two files witch data sync to each\n"
-                                       " * other.NumbTotal_ChrOne.csv");
-        HostGeneNumbTotal << "#time total_number_of_genes_in_all_host_cells"
-                << std::endl;
-        HostGeneNumbTotal.close();
-        ifFirstGeneNumbersTotal = false;
-    }
-    if(ifFirstGeneNumbersUnique){
-        std::ofstream HostMHCNumbUnique;
-        HostMHCNumbUnique.open("HostMHCsNumbUniq_ChrOne.csv");
-        HostMHCNumbUnique << "#time number_of_unique_MHCs_in_all_host_cells" 
-                << std::endl;
-        HostMHCNumbUnique.close();
-        ifFirstGeneNumbersUnique = false;
-    }
-    std::vector<unsigned int> AllGenomesSize;
-    std::vector<int> UniqueMHCs;
-    std::vector<unsigned long> TheGeneVals;
-    for(unsigned long i = 0; i < EnvObj.getHostsPopSize(); ++i){
-        TheGeneVals.clear();
-        // Harvesting genes from Chromosome One in all hosts
-        for(unsigned long j = 0; j < EnvObj.getSingleHostChromoOneSize(i); ++j){
-            TheGeneVals.push_back(EnvObj.getSingleHostRealGeneOne(i, j));
+    if(!Schedule.isDue(Harvester::GeneNumbers))
+        return;
+    PERF_PHASE(PerfPhase::SaveGeneNumbers);
+    std::vector<unsigned long> TheGeneVals;     // genes of Chromosome One of all hosts, one after another
+    std::vector<unsigned long> AllGenomesSize;
+    EnvObj.forEachHost([&TheGeneVals, &AllGenomesSize](const Host &host){
+        for(const Gene &gene : host.getChromosomeOneRef()){
+            TheGeneVals.push_back(gene.getTheRealGene());
         }
-        // Harvesting genes from Chromosome Two in all hosts
-//        for(int m = 0; m < EnvObj.getSingleHostChromoTwoSize(i); ++m){
-//            TheGeneVals.push_back(EnvObj.getSingleHostRealGeneTwo(i, m));
-//        }
-        AllGenomesSize.push_back((int) TheGeneVals.size());
-        auto ShOut = getShannonIndx(TheGeneVals);
-        int mhcTypes = std::get < 1 >( ShOut );
-        UniqueMHCs.push_back(mhcTypes);
-    }
-    std::ofstream HostGeneNumbTotal;
-    HostGeneNumbTotal.open("HostGeneNumbTotal_ChrOne.csv",
-                            std::ios::out | std::ios::ate | std::ios::app);
-    HostGeneNumbTotal << tayme;
-    for(unsigned long ii = 0; ii < AllGenomesSize.size(); ++ii){
-        HostGeneNumbTotal << " " << AllGenomesSize[ii];
-    }
-    HostGeneNumbTotal << std::endl;
-    HostGeneNumbTotal.close();
-    
-    std::ofstream HostMHCNumbUnique;
-    HostMHCNumbUnique.open("HostMHCsNumbUniq_ChrOne.csv",
-                            std::ios::out | std::ios::ate | std::ios::app);
-    HostMHCNumbUnique << tayme;
-    for(unsigned long jj = 0; jj < UniqueMHCs.size(); ++jj){
-        HostMHCNumbUnique << " " << UniqueMHCs[jj];
-    }
-    HostMHCNumbUnique << std::endl;
-    HostMHCNumbUnique.close();
+        AllGenomesSize.push_back(host.getChromosomeOneRef().size());
+    });
+    bool metrics = MetricsOn;
+    bool firstMetrics = metrics and takeFirstMetrics();
+    bool firstTotal = ifFirstGeneNumbersTotal;
+    bool firstUnique = ifFirstGeneNumbersUnique;
+    ifFirstGeneNumbersTotal = false;
+    ifFirstGeneNumbersUnique = false;
+    std::size_t bytes = (TheGeneVals.size() + AllGenomesSize.size()) * sizeof(unsigned long);
+    submitWrite([this, tayme, metrics, firstMetrics, firstTotal, firstUnique, TheGeneVals, AllGenomesSize]{
+        std::vector<unsigned long> UniqueMHCs;
+        const unsigned long *first = TheGeneVals.data();
+        for(unsigned long genomeSize : AllGenomesSize){
+            UniqueMHCs.push_back(DiversityCounter::countTypes(first, genomeSize));
+            first += genomeSize;
+        }
+        if(metrics){
+            MetricsWriter &store = openMetrics(firstMetrics);
+            store.add(tayme, GeneNumbTotal, AllGenomesSize);
+            store.add(tayme, GeneNumbUnique, UniqueMHCs);
+            return;
+        }
+        writeRecord(openRecord("HostGeneNumbTotal_ChrOne.csv", firstTotal,
+                               "#time total_number_of_genes_in_all_host_cells"), tayme, AllGenomesSize);
+        writeRecord(openRecord("HostMHCsNumbUniq_ChrOne.csv", firstUnique,
+                               "#time number_of_unique_MHCs_in_all_host_cells"), tayme, UniqueMHCs);
+    }, bytes);
+}
+
+/**
+ * @brief Data harvesting method. Saves the number of copies of each MHC allele
+ * in the host population (both chromosomes of all hosts), taken from the
+ * allele table kept by the Environment. One line per time step: the time stamp
+ * followed by allele:copies pairs in ascending order of alleles.
+ *
+ * @param EnvObj - the Environment class object
+ * @param tayme - time stamp (hosts generation number)
+ */
+void DataHandler::saveAlleleFrequencies(Environment &EnvObj, int tayme){
+    if(!Schedule.isDue(Harvester::AlleleFreqs))
+        return;
+    PERF_PHASE(PerfPhase::SaveAlleleFreqs);
+    std::vector<std::pair<unsigned long, unsigned long> > Freqs = EnvObj.getHostAlleles().getFrequencies();
+    bool metrics = MetricsOn;
+    bool firstMetrics = metrics and takeFirstMetrics();
+    bool firstTime = ifFirstAlleleFreqs;
+    ifFirstAlleleFreqs = false;
+    std::size_t bytes = Freqs.size() * sizeof(Freqs[0]);
+    submitWrite([this, tayme, metrics, firstMetrics, firstTime, Freqs]{
+        if(metrics){
+            std::vector<uint64_t> Alleles, Copies;
+            for(const auto &freq : Freqs){
+                Alleles.push_back(freq.first);
+                Copies.push_back(freq.second);
+            }
+            MetricsWriter &store = openMetrics(firstMetrics);
+            store.add(tayme, AlleleValues, Alleles);
+            store.add(tayme, AlleleCopies, Copies);
+            return;
+        }
+        std::ostream &FreqsFile = openRecord("AlleleFrequencies.csv", firstTime,
+                                             "#time MHC_allele:number_of_copies_in_all_hosts");
+        FreqsFile << tayme;
+        for(const auto &freq : Freqs){
+            FreqsFile << " " << freq.first << ":" << freq.second;
+        }
+        FreqsFile << '\n';
+    }, bytes);
 }
 
 /**
@@ -465,19 +982,14 @@ void DataHandler::saveHostGeneNumbers(Environment& EnvObj, int tayme){
  * @param EnvObj - the Environment class object
  */
 void DataHandler::savePathoNoMuttList(Environment& EnvObj){
-    if(ifNoMuttPathoListUnique){
-        std::ofstream NoMuttPathoList;
-        NoMuttPathoList.open("NoMutationInPathoList.csv");
-        NoMuttPathoList << "#list_of_bits_excluded_from_mutating_Each_line_is_a_spp"
-                << std::endl;
-        NoMuttPathoList.close();
-        ifNoMuttPathoListUnique = false;
-    }
-    std::ofstream NoMuttPathoList;
-    NoMuttPathoList.open("NoMutationInPathoList.csv",
-                            std::ios::out | std::ios::ate | std::ios::app);
-    NoMuttPathoList << EnvObj.getFixedBitsInAntigens();
-    NoMuttPathoList.close();
+    std::string FixedBits = EnvObj.getFixedBitsInAntigens();
+    bool firstTime = ifNoMuttPathoListUnique;
+    ifNoMuttPathoListUnique = false;
+    std::size_t bytes = FixedBits.size();
+    submitWrite([this, firstTime, FixedBits]{
+        openRecord("NoMutationInPathoList.csv", firstTime, "#list_of_bits_excluded_from_mutating_Each_line_is_a_spp")
+                << FixedBits;
+    }, bytes);
 }
 
 /**
@@ -488,20 +1000,17 @@ void DataHandler::savePathoNoMuttList(Environment& EnvObj){
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::savePresentedPathos(Environment &EnvObj, int tayme) {
-    if(ifNumberOfPresentedPatho){
-        std::ofstream PresentedPathoNumb;
-        PresentedPathoNumb.open("PresentedPathogenNumbers.csv");
-        PresentedPathoNumb << "#time number_of_pathogens_presented_by_hosts"
-                << std::endl;
-        PresentedPathoNumb.close();
-    ifNumberOfPresentedPatho = false;
+    if(!Schedule.isDue(Harvester::Presented))
+        return;
+    PERF_PHASE(PerfPhase::SavePresented);
+    if(MetricsOn){
+        submitMetric(tayme, PresentedPathogens, hostColumnValues<uint32_t>(EnvObj, HostColumn::PresentedPathogens));
+        return;
     }
-    std::ofstream PresentedPathoNumb;
-    PresentedPathoNumb.open("PresentedPathogenNumbers.csv",
-                            std::ios::out | std::ios::ate | std::ios::app);
-    PresentedPathoNumb << tayme;
-    PresentedPathoNumb << EnvObj.getNumbersOfPathogensPresented();
-    PresentedPathoNumb.close();
+    bool firstTime = ifNumberOfPresentedPatho;
+    ifNumberOfPresentedPatho = false;
+    submitRecord("PresentedPathogenNumbers.csv", firstTime, "#time number_of_pathogens_presented_by_hosts",
+                 hostColumnRecord(EnvObj, HostColumn::PresentedPathogens, tayme));
 }
 
 
@@ -519,31 +1028,20 @@ void DataHandler::savePresentedPathos(Environment &EnvObj, int tayme) {
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::saveMhcNumbersWhenMating(Environment &EnvObj, int tayme) {
-    if(ifNumberOfMhcWhenMating){
-        std::ofstream NumberOfMhcInMotherWnenMating;
-        NumberOfMhcInMotherWnenMating.open("NumberOfMhcInMother.csv");
-        NumberOfMhcInMotherWnenMating << "#time number_of_MHCs_in_mother"
-                                      << std::endl;
-        NumberOfMhcInMotherWnenMating.close();
-        std::ofstream NumberOfMhcInFatherWhenMating;
-        NumberOfMhcInFatherWhenMating.open("NumberOfMhcInFather.csv");
-        NumberOfMhcInFatherWhenMating <<"#time number_of_MHCs_in_father"
-                                      << std::endl;
-        NumberOfMhcInFatherWhenMating.close();
-        ifNumberOfMhcWhenMating = false;
+    if(!Schedule.isDue(Harvester::Mating))
+        return;
+    PERF_PHASE(PerfPhase::SaveMhcWhenMating);
+    if(MetricsOn){
+        submitMetric(tayme, MhcInMother, hostColumnValues<uint64_t>(EnvObj, HostColumn::MhcInMother));
+        submitMetric(tayme, MhcInFather, hostColumnValues<uint64_t>(EnvObj, HostColumn::MhcInFather));
+        return;
     }
-    std::ofstream NumberOfMhcInMotherWnenMating;
-    NumberOfMhcInMotherWnenMating.open("NumberOfMhcInMother.csv",
-                                       std::ios::out | std::ios::ate | std::ios::app);
-    NumberOfMhcInMotherWnenMating << tayme;
-    NumberOfMhcInMotherWnenMating << EnvObj.getNumbersOfMhcInMother();
-    NumberOfMhcInMotherWnenMating.close();
-    std::ofstream NumberOfMhcInFatherWhenMating;
-    NumberOfMhcInFatherWhenMating.open("NumberOfMhcInFather.csv",
-                                       std::ios::out | std::ios::ate | std::ios::app);
-    NumberOfMhcInFatherWhenMating << tayme;
-    NumberOfMhcInFatherWhenMating << EnvObj.getNumbersOfMhcInFather();
-    NumberOfMhcInFatherWhenMating.close();
+    bool firstTime = ifNumberOfMhcWhenMating;
+    ifNumberOfMhcWhenMating = false;
+    submitRecord("NumberOfMhcInMother.csv", firstTime, "#time number_of_MHCs_in_mother",
+                 hostColumnRecord(EnvObj, HostColumn::MhcInMother, tayme));
+    submitRecord("NumberOfMhcInFather.csv", firstTime, "#time number_of_MHCs_in_father",
+                 hostColumnRecord(EnvObj, HostColumn::MhcInFather, tayme));
 }
 
 /**
@@ -554,21 +1052,17 @@ void DataHandler::saveMhcNumbersWhenMating(Environment &EnvObj, int tayme) {
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::saveMhcNumbersBeforeMating(Environment &EnvObj, int tayme) {
-    if(ifNumberOfMhcBeforeMating){
-        std::ofstream NumberOfMhcBeforeMating;
-        NumberOfMhcBeforeMating.open("NumberOfMhcBeforeMating.csv");
-        NumberOfMhcBeforeMating << "#time number_of_MHCs_before_mating"
-                                      << std::endl;
-        NumberOfMhcBeforeMating.close();
-        ifNumberOfMhcBeforeMating = false;
+    if(!Schedule.isDue(Harvester::Mating))
+        return;
+    PERF_PHASE(PerfPhase::SaveMhcBeforeMating);
+    if(MetricsOn){
+        submitMetric(tayme, MhcBeforeMating, hostColumnValues<uint64_t>(EnvObj, HostColumn::UniqueMhcs));
+        return;
     }
-    std::ofstream NumberOfMhcBeforeMating;
-    NumberOfMhcBeforeMating.open("NumberOfMhcBeforeMating.csv",
-                                       std::ios::out | std::ios::ate | std::ios::app);
-    NumberOfMhcBeforeMating << tayme;
-    NumberOfMhcBeforeMating << EnvObj.getNumbersOfUniqueMHCs();
-    NumberOfMhcBeforeMating.close();
-
+    bool firstTime = ifNumberOfMhcBeforeMating;
+    ifNumberOfMhcBeforeMating = false;
+    submitRecord("NumberOfMhcBeforeMating.csv", firstTime, "#time number_of_MHCs_before_mating",
+                 hostColumnRecord(EnvObj, HostColumn::UniqueMhcs, tayme));
 }
 
 /**
@@ -579,18 +1073,140 @@ void DataHandler::saveMhcNumbersBeforeMating(Environment &EnvObj, int tayme) {
  * @param tayme - time stamp (hosts generation number)
  */
 void DataHandler::saveMhcNumbersAfterMating(Environment &EnvObj, int tayme) {
-    if(ifNumberOfMhcAfterMating){
-        std::ofstream NumberOfMhcBeforeMating;
-        NumberOfMhcBeforeMating.open("NumberOfMhcAfterMating.csv");
-        NumberOfMhcBeforeMating << "#time number_of_MHCs_after_mating"
-                                << std::endl;
-        NumberOfMhcBeforeMating.close();
-        ifNumberOfMhcAfterMating = false;
+    if(!Schedule.isDue(Harvester::Mating))
+        return;
+    PERF_PHASE(PerfPhase::SaveMhcAfterMating);
+    if(MetricsOn){
+        submitMetric(tayme, MhcAfterMating, hostColumnValues<uint64_t>(EnvObj, HostColumn::UniqueMhcs));
+        return;
     }
-    std::ofstream NumberOfMhcBeforeMating;
-    NumberOfMhcBeforeMating.open("NumberOfMhcAfterMating.csv",
-                                 std::ios::out | std::ios::ate | std::ios::app);
-    NumberOfMhcBeforeMating << tayme;
-    NumberOfMhcBeforeMating << EnvObj.getNumbersOfUniqueMHCs();
-    NumberOfMhcBeforeMating.close();
-}
\ No newline at end of file
+    bool firstTime = ifNumberOfMhcAfterMating;
+    ifNumberOfMhcAfterMating = false;
+    submitRecord("NumberOfMhcAfterMating.csv", firstTime, "#time number_of_MHCs_after_mating",
+                 hostColumnRecord(EnvObj, HostColumn::UniqueMhcs, tayme));
+}
+
+/**
+ * @brief Data harvesting method. Saves the bytes held by each part of the
+ * simulation (host chromosomes, unique alleles, lineage history, pathogen
+ * antigens and epitopes, working buffers) and the current and peak resident
+ * set size of the process to MemoryUsage.csv, see MemoryUsage.
+ *
+ * @param EnvObj - the Environment class object
+ * @param tayme - time stamp (hosts generation number)
+ */
+void DataHandler::saveMemoryUsage(Environment &EnvObj, int tayme){
+    PERF_PHASE(PerfPhase::SaveMemoryUsage);
+    MemoryUsage usage = EnvObj.getMemoryUsage();
+    usage.readRss();
+    std::vector<uint64_t> values = usage.toVector();
+    if(MetricsOn){
+        submitMetric(tayme, MemoryBytes, std::move(values));
+        return;
+    }
+    bool firstTime = ifFirstMemoryUsage;
+    ifFirstMemoryUsage = false;
+    std::vector<char> line;
+    TextFormat::appendRecord(line, tayme, values);
+    submitRecord("MemoryUsage.csv", firstTime, MemoryUsageHeader, std::move(line));
+}
+
+/**
+ * @brief Data harvesting method. Summary of an ensemble of replicates: mean and
+ * variance (unbiased, over replicates) of each column of HostsGeneDivers.csv,
+ * time step by time step. Written to EnsembleHostsGeneDivers.csv, the columns
+ * are the time and then a mean and a variance for every other column of
+ * HostsGeneDivers.csv. Replaces averaging many runs afterwards. Replicates
+ * that wrote a metrics store (Metrics.bin) are read from it.
+ *
+ * @param replicateDirs - output directories of the replicates
+ * @return 'false' if a HostsGeneDivers.csv file could not be read
+ */
+bool DataHandler::saveEnsembleSummary(const std::vector<std::string> &replicateDirs){
+    std::vector<std::string> colNames;
+    std::vector<std::vector<std::vector<double> > > allRows; // replicate x time step x column
+    for(const std::string &dir : replicateDirs){
+        std::string inName = dir + "/HostsGeneDivers.csv";
+        std::ifstream inFile(inName);
+        if(!inFile.good() and std::ifstream(dir + "/Metrics.bin").good()){
+            MetricsReader store;
+            if(!store.open(dir + "/Metrics.bin"))
+                return false;
+            if(colNames.empty()){
+                colNames = {"time", "pop_size", "tot_num_of_genes", "num_of_MHC_types", "Shannon_indx",
+                            "mean_fitness", "std_fitness"};
+            }
+            allRows.emplace_back();
+            std::vector<double> row;
+            for(std::size_t g = 0; g < store.getNumbOfGenerations(); ++g){
+                if(store.getGeneDiversity(g, row)){
+                    row.insert(row.begin(), (double) store.getTime(g));
+                    allRows.back().push_back(row);
+                }
+            }
+            continue;
+        }
+        if(!inFile.good()){
+            std::cout << "Error in DataHandler::saveEnsembleSummary(): cannot open the file "
+                      << inName << std::endl;
+            return false;
+        }
+        allRows.emplace_back();
+        std::string line;
+        while(std::getline(inFile, line)){
+            if(line.empty())
+                continue;
+            std::stringstream ss(line);
+            if(line[0] == '#'){
+                if(colNames.empty()){
+                    ss.ignore(1);
+                    std::string name;
+                    while(ss >> name)
+                        colNames.push_back(name);
+                }
+                continue;
+            }
+            std::vector<double> row;
+            double val;
+            while(ss >> val)
+                row.push_back(val);
+            allRows.back().push_back(row);
+        }
+    }
+    if(allRows.empty())
+        return false;
+    std::size_t numbOfSteps = allRows[0].size();
+    for(auto &rows : allRows)
+        numbOfSteps = std::min(numbOfSteps, rows.size());
+    double numbOfReps = (double) allRows.size();
+
+    std::ofstream SummaryFile;
+    SummaryFile.open(getOutputPath("EnsembleHostsGeneDivers.csv"));
+    SummaryFile << "#" << (colNames.empty() ? "time" : colNames[0]);
+    for(std::size_t c = 1; c < colNames.size(); ++c){
+        SummaryFile << " " << colNames[c] << "_mean " << colNames[c] << "_var";
+    }
+    SummaryFile << std::endl;
+    for(std::size_t t = 0; t < numbOfSteps; ++t){
+        std::size_t numbOfCols = allRows[0][t].size();
+        for(auto &rows : allRows)
+            numbOfCols = std::min(numbOfCols, rows[t].size());
+        if(numbOfCols == 0)
+            continue;
+        SummaryFile << allRows[0][t][0];
+        for(std::size_t c = 1; c < numbOfCols; ++c){
+            double mean = 0.0;
+            for(auto &rows : allRows)
+                mean += rows[t][c];
+            mean /= numbOfReps;
+            double var = 0.0;
+            for(auto &rows : allRows)
+                var += (rows[t][c] - mean) * (rows[t][c] - mean);
+            var = numbOfReps > 1.0 ? var / (numbOfReps - 1.0) : 0.0;
+            SummaryFile << " " << mean << " " << var;
+        }
+        SummaryFile << std::endl;
+    }
+    SummaryFile.close();
+    return true;
+}
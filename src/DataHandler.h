@@ -24,11 +24,19 @@
 #define	DATAHARVESTER_H
 
 #include <cstdlib>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
 #include <vector>
 #include <boost/lexical_cast.hpp>
 //#include "boost/dynamic_bitset.hpp"
 
 #include "Environment.h"
+#include "AsyncWriter.h"
+#include "RecordStream.h"
+#include "MetricsStore.h"
+#include "OutputSchedule.h"
 
 /**
  * @brief Data harvesting class. A class that has methods to collect data and
@@ -52,17 +60,46 @@ public:
                            double hostDeletion, double hostDuplication, unsigned long maxGene, double alpha,
                            int numberOfMates); // for alpha and optimal mating scenario
     void setAllFilesAsFirtsTimers();
+    void setOutputDirectory(const std::string &dirName);
+    std::string getOutputPath(const std::string &fileName) const;
+    void setAsyncOutput(std::size_t maxTasks, std::size_t maxBytes);
+    void flushOutput();
+    void setFsyncPolicy(FsyncPolicy policy);
+    void setMetricsStore(bool metricsOn, MetricsCompression compression);
+    OutputSchedule& getSchedule();
+    void planGeneration(Environment &EnvObj, int tayme);
+    bool isDue(Harvester harvester) const;
+    void endGeneration();
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in);
+    void dropRecordsAfter(int tayme);
     void saveNumOfPathoSpeciesToFile(Environment &EnvObj, int tayme);
     void savePathoPopulToFile(Environment &EnvObj, int tayme);
     void saveHostPopulToFile(Environment &EnvObj, int tayme);
+    bool savePopulSnapshot(Environment &EnvObj, int tayme, bool withPathogens);
     void saveHostGeneticDivers(Environment &EnvObj, int tayme);
     void saveHostGeneNumbers(Environment &EnvObj, int tayme);
+    void saveAlleleFrequencies(Environment &EnvObj, int tayme);
     void savePathoNoMuttList(Environment &EnvObj);
     void savePresentedPathos(Environment &EnvObj, int tayme);
     void saveMhcNumbersWhenMating(Environment &EnvObj, int tayme);
     void saveMhcNumbersBeforeMating(Environment &EnvObj, int tayme);
     void saveMhcNumbersAfterMating(Environment &EnvObj, int tayme);
+    void saveMemoryUsage(Environment &EnvObj, int tayme);
+    bool saveEnsembleSummary(const std::vector<std::string> &replicateDirs);
 private:
+    void submitWrite(AsyncWriter::Task task, std::size_t bytes);
+    std::shared_ptr<const std::string> takeSnapshot(Environment &EnvObj, int tayme, bool withHosts,
+                                                    bool withPathogens);
+    void submitRecord(const char *fileName, bool firstTime, const char *header, std::vector<char> line);
+    std::ostream& openRecord(const std::string &fileName, bool firstTime, const char *header);
+    template <typename T>
+    void submitMetric(int tayme, MetricColumn column, std::vector<T> values);
+    bool takeFirstMetrics();
+    MetricsWriter& openMetrics(bool firstTime);
+    void commitRecords(bool toDisk);
+    void closeRecords();
+    std::string OutputDir;
     bool ifFirstSpecToFileRun;
     bool ifFirstHostClonesRun;
     bool ifFirstHostGeneDivRun;
@@ -73,6 +110,17 @@ private:
     bool ifNumberOfMhcWhenMating;
     bool ifNumberOfMhcBeforeMating;
     bool ifNumberOfMhcAfterMating;
+    bool ifFirstAlleleFreqs;
+    bool ifFirstMetrics;
+    bool ifFirstMemoryUsage;
+    bool MetricsOn;                       // per-generation numbers go to Metrics.bin instead of the text files
+    MetricsCompression MetricsPacking;
+    FsyncPolicy Fsync;
+    OutputSchedule Schedule;
+    std::map<std::string, std::unique_ptr<RecordStream> > Records;  // open record files, by file name
+    std::vector<std::vector<char> > TextBuffers;  // per-thread text of genome dumps
+    std::unique_ptr<MetricsWriter> Metrics;
+    std::unique_ptr<AsyncWriter> Writer;  // background writer, none - records are written at once
 };
 
 #endif	/* DATAHARVESTER_H */
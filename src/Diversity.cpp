@@ -0,0 +1,76 @@
+/*
+ * File:   Diversity.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Diversity.h"
+
+namespace {
+    /**
+     * @brief Data harvesting method. Adds an allele of given abundance to the
+     * sums of the diversity indices.
+     */
+    inline void addAllele(DiversityStats &stats, double &sumSqr, unsigned long abundance, double total){
+        double p = (double) abundance / total;
+        stats.Shannon = stats.Shannon - (p * std::log(p));
+        sumSqr += p * p;
+        stats.Richness += 1;
+    }
+}
+
+/**
+ * @brief Data harvesting method. Number of different alleles in a small set,
+ * e.g. in one host.
+ *
+ * @param alleles - the alleles
+ * @param size - number of alleles
+ * @return number of different alleles
+ */
+unsigned long DiversityCounter::countTypes(const unsigned long *alleles, std::size_t size){
+    std::vector<unsigned long> types(alleles, alleles + size);
+    std::sort(types.begin(), types.end());
+    return std::unique(types.begin(), types.end()) - types.begin();
+}
+
+/**
+ * @brief Data harvesting method. Diversity from numbers of copies of the
+ * alleles, e.g. kept in AlleleTable.
+ *
+ * @param abundances - number of copies of each allele, zeros are skipped
+ * @return the diversity; all zeros for no alleles
+ */
+DiversityStats DiversityCounter::fromAbundances(const std::vector<unsigned long> &abundances){
+    unsigned long size = 0;
+    for(unsigned long abundance : abundances){
+        size += abundance;
+    }
+    DiversityStats stats{0.0, 0.0, 0, size};
+    double total = (double) size;
+    double sumSqr = 0.0;
+    for(unsigned long abundance : abundances){
+        if(abundance)
+            addAllele(stats, sumSqr, abundance, total);
+    }
+    stats.Simpson = size ? 1.0 - sumSqr : 0.0;
+    return stats;
+}
@@ -0,0 +1,49 @@
+/*
+ * File:   Diversity.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef DIVERSITY_H
+#define	DIVERSITY_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Diversity of a set of alleles (MHC genes or antigens).
+ */
+struct DiversityStats {
+    double Shannon;          // -sum p ln p, p - frequency of an allele
+    double Simpson;          // 1 - sum p^2, probability that two alleles drawn at random differ
+    unsigned long Richness;  // number of different alleles
+    unsigned long Total;     // number of all alleles
+};
+
+/**
+ * @brief Data harvesting class. Diversity of a population from the numbers of
+ * copies of its alleles (kept up to date by AlleleTable), and the number of
+ * different alleles in a small set.
+ */
+class DiversityCounter {
+public:
+    static unsigned long countTypes(const unsigned long *alleles, std::size_t size);
+    static DiversityStats fromAbundances(const std::vector<unsigned long> &abundances);
+};
+
+#endif	/* DIVERSITY_H */
@@ -0,0 +1,169 @@
+/*
+ * File:   EnsembleRunner.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <sys/stat.h>
+
+#include "EnsembleRunner.h"
+
+/**
+ * @brief Core method. Constructor.
+ *
+ * @param params - input parameters, the same for all the replicates
+ * @param spec - the scenario, the same for all the replicates
+ * @param numberOfReplicates - number of replicates
+ */
+EnsembleRunner::EnsembleRunner(const ModelParams &params, const ScenarioSpec &spec,
+                               unsigned int numberOfReplicates)
+        : Params(params), Spec(spec), Replicates(numberOfReplicates), NextReplicate(1), FailedReplicates(0) {
+    Options = {0, 0, FsyncPolicy::Checkpoint, 0, 0, false};
+}
+
+EnsembleRunner::~EnsembleRunner() = default;
+
+/**
+ * @brief Core method. Loads the initial state of all the replicates from a
+ * snapshot of an evolved run (see Simulation::setWarmStart()).
+ *
+ * @param hostSource - checkpoint or host genomes file
+ * @param pathoSource - checkpoint or pathogen genomes file, may be empty
+ */
+void EnsembleRunner::setWarmStart(const std::string &hostSource, const std::string &pathoSource){
+    WarmStartHosts = hostSource;
+    WarmStartPathos = pathoSource;
+}
+
+/**
+ * @brief Data harvesting method. Output and reporting options given to every
+ * replicate (see Simulation::setRunOptions()).
+ *
+ * @param options - the options
+ */
+void EnsembleRunner::setRunOptions(const RunOptions &options){
+    Options = options;
+}
+
+/**
+ * @brief Core method. Builds the initial state, runs all the replicates and
+ * writes the ensemble summary.
+ *
+ * @return number of replicates that failed
+ */
+unsigned long EnsembleRunner::run(){
+    Simulation Origin(Params, Spec);
+    Origin.setWarmStart(WarmStartHosts, WarmStartPathos);
+    if(!Origin.setUpPopulations())
+        return Replicates;
+
+    unsigned int threadsAvailable = std::thread::hardware_concurrency();
+    if(threadsAvailable == 0) // if the value is not well defined or not computable, set at least 1 core
+        threadsAvailable = 1;
+    unsigned int threadsPerRun = Params.numberOfThreads ? Params.numberOfThreads : threadsAvailable;
+    unsigned int numbOfWorkers = threadsAvailable / threadsPerRun;
+    if(numbOfWorkers == 0)
+        numbOfWorkers = 1;
+    if(numbOfWorkers > Replicates)
+        numbOfWorkers = Replicates;
+    std::cout << "Ensemble of " << Replicates << " replicates, " << numbOfWorkers
+              << " at a time." << std::endl;
+
+    NextReplicate = 1;
+    FailedReplicates = 0;
+    std::vector<std::thread> workers;
+    for(unsigned int w = 0; w < numbOfWorkers; ++w){
+        workers.emplace_back(&EnsembleRunner::worker, this, std::cref(Origin));
+    }
+    for(auto &wrk : workers){
+        wrk.join();
+    }
+    if(FailedReplicates == 0){
+        DataHandler Summary;
+        Summary.saveEnsembleSummary(getReplicateDirs());
+    }
+    return FailedReplicates;
+}
+
+/**
+ * @brief Core method. Loop of a worker thread: runs replicates until there are
+ * none left.
+ *
+ * @param origin - the simulation holding the initial state
+ */
+void EnsembleRunner::worker(const Simulation &origin){
+    unsigned int replicate;
+    while((replicate = NextReplicate++) <= Replicates){
+        if(!runReplicate(origin, replicate))
+            ++FailedReplicates;
+    }
+}
+
+/**
+ * @brief Core method. Runs one replicate in its own directory.
+ *
+ * @param origin - the simulation holding the initial state
+ * @param replicate - number of the replicate, from 1
+ * @return 'true' if the replicate went through
+ */
+bool EnsembleRunner::runReplicate(const Simulation &origin, unsigned int replicate){
+    std::string dirName = "Replicate." + std::to_string(replicate);
+    mkdir(dirName.c_str(), 0755);
+    struct stat dirStat;
+    if(stat(dirName.c_str(), &dirStat) != 0 or !S_ISDIR(dirStat.st_mode)){
+        std::cout << "Error in EnsembleRunner::runReplicate(): cannot create the directory "
+                  << dirName << std::endl;
+        return false;
+    }
+    try {
+        Simulation Sim(Params, Spec);
+        Sim.setRunOptions(Options);
+        DataHandler &Data2file = Sim.getDataHandler();
+        Data2file.setOutputDirectory(dirName);
+        Data2file.inputParamsToFile(Params.numberOfThreads, Params.mhcGeneLength, Params.antigenLength,
+                Params.hostPopSize, Params.pathoPopSize, Params.patho_sp, Params.hostGeneNumbb,
+                Params.patoPerHostGeneration, Params.numOfHostGenerations, Params.hostMutationProb,
+                Params.pathoMutationProb, Params.HeteroHomo, Params.deletion, Params.duplication,
+                Params.maxGene, Params.alpha, Params.NumbPartners);
+        bool ok = Sim.runReplicate(origin);
+        std::cout << "Replicate No. " << replicate << (ok ? " finished." : " FAILED.") << std::endl;
+        return ok;
+    }
+    catch(std::exception &e) {
+        std::cout << "Error in EnsembleRunner::runReplicate(): replicate No. " << replicate
+                  << " stopped: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Data harvesting method. Output directories of all the replicates.
+ *
+ * @return list of directories
+ */
+std::vector<std::string> EnsembleRunner::getReplicateDirs() const {
+    std::vector<std::string> dirs;
+    for(unsigned int r = 1; r <= Replicates; ++r){
+        dirs.push_back("Replicate." + std::to_string(r));
+    }
+    return dirs;
+}
@@ -0,0 +1,64 @@
+/*
+ * File:   EnsembleRunner.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef ENSEMBLERUNNER_H
+#define	ENSEMBLERUNNER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "Scenario.h"
+#include "Simulation.h"
+
+/**
+ * @brief Core class. Runs an ensemble of replicates of one parameter set. The
+ * initial host and pathogen populations (and the no-mutation sites of
+ * pathogens) are built once; every replicate starts from a copy of them with
+ * its own, freshly seeded random number generators (see
+ * Simulation::runReplicate()). Replicate number N writes its output to the
+ * Replicate.N directory and the ensemble summary (see
+ * DataHandler::saveEnsembleSummary()) goes to the working directory.
+ *
+ * Replicates run side by side, as many as there are cores for their threads.
+ */
+class EnsembleRunner {
+public:
+    EnsembleRunner(const ModelParams &params, const ScenarioSpec &spec, unsigned int numberOfReplicates);
+    virtual ~EnsembleRunner();
+    unsigned long run();
+    std::vector<std::string> getReplicateDirs() const;
+    void setWarmStart(const std::string &hostSource, const std::string &pathoSource);
+    void setRunOptions(const RunOptions &options);
+private:
+    void worker(const Simulation &origin);
+    bool runReplicate(const Simulation &origin, unsigned int replicate);
+    ModelParams Params;
+    ScenarioSpec Spec;
+    unsigned int Replicates;
+    std::atomic<unsigned int> NextReplicate;
+    std::atomic<unsigned long> FailedReplicates;
+    std::string WarmStartHosts;     // snapshot the initial state is loaded from, see Simulation::setWarmStart()
+    std::string WarmStartPathos;
+    RunOptions Options;             // output and reporting options of every replicate
+};
+
+#endif	/* ENSEMBLERUNNER_H */
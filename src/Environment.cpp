@@ -29,9 +29,18 @@
 #include <thread>
 #include <functional>   // std::bind
 #include <iomanip>      // std::setprecision(n);
+#include <climits>      // UINT_MAX
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <iterator>
 
 #include "Environment.h"
 #include "H2Pinteraction.h"
+#include "BinaryIO.h"
+#include "Snapshot.h"
+#include "PerfProfiler.h"
+#include "TextFormat.h"
 
 typedef std::string sttr;
 typedef boost::dynamic_bitset<> antigenstring;
@@ -54,10 +63,53 @@ Environment::Environment(unsigned int numberOfThreads) {
     seedEnvsRNG();
 }
 
-//Environment::Environment(const Environment& orig) {
-//}
+/**
+ * @brief Core method. Copy constructor. Copies the populations and the rest
+ * of the state, random number generators included (each one gets its own
+ * copy, so call seedEnvsRNG() if the copy should draw different numbers).
+ *
+ * @param orig - the environment to copy
+ */
+Environment::Environment(const Environment& orig)
+        : HostPopulation(orig.HostPopulation), PathPopulation(orig.PathPopulation), NoMutsVec(orig.NoMutsVec),
+          mRandGenArrSize(orig.mRandGenArrSize), PathoIndxMatrix(orig.PathoIndxMatrix),
+          EpitopeIndex(orig.EpitopeIndex), HostFitnessCumul(orig.HostFitnessCumul), FitnessLUT(orig.FitnessLUT),
+          HostAlleles(orig.HostAlleles) {
+    mRandGenArr = new Random[mRandGenArrSize];
+    for(unsigned int i = 0; i < mRandGenArrSize; ++i)
+        mRandGenArr[i] = orig.mRandGenArr[i];
+}
+
+/**
+ * @brief Core method. Copy assignment, see the copy constructor.
+ *
+ * @param orig - the environment to copy
+ * @return this environment
+ */
+Environment& Environment::operator=(const Environment& orig) {
+    if(this == &orig)
+        return *this;
+    HostPopulation = orig.HostPopulation;
+    PathPopulation = orig.PathPopulation;
+    NoMutsVec = orig.NoMutsVec;
+    PathoIndxMatrix = orig.PathoIndxMatrix;
+    EpitopeIndex = orig.EpitopeIndex;
+    HostFitnessCumul = orig.HostFitnessCumul;
+    FitnessLUT = orig.FitnessLUT;
+    HostAlleles = orig.HostAlleles;
+    if(mRandGenArrSize != orig.mRandGenArrSize){
+        delete[] mRandGenArr;
+        mRandGenArrSize = orig.mRandGenArrSize;
+        mRandGenArr = new Random[mRandGenArrSize];
+    }
+    for(unsigned int i = 0; i < mRandGenArrSize; ++i)
+        mRandGenArr[i] = orig.mRandGenArr[i];
+    return *this;
+}
 
-Environment::~Environment() = default;
+Environment::~Environment() {
+    delete[] mRandGenArr;
+}
 
 void Environment::seedEnvsRNG() {
     for(unsigned int i = 0; i < mRandGenArrSize; ++i)
@@ -113,6 +165,7 @@ void Environment::setNoMutsVector(int numb_of_species, unsigned long antigen_siz
 void Environment::setHostRandomPopulation(int pop_size, unsigned long gene_size,
                                           unsigned long chrom_size, int timeStamp,
                                            Tagging_system &tag){
+    HostAlleles.invalidate();
     for(int i = 0; i < pop_size; ++i) {
         HostPopulation.emplace_back(Host());
     }
@@ -143,6 +196,7 @@ void Environment::setHostRandomPopulation(int pop_size, unsigned long gene_size,
 void Environment::setHostRandomPopulation(int pop_size, unsigned long gene_size, unsigned long chrom_size_lower,
                                           unsigned long chrom_size_uper, int timeStamp,
                                            Tagging_system &tag){
+    HostAlleles.invalidate();
     if(chrom_size_lower > chrom_size_uper){
         unsigned long tmp_size = chrom_size_lower;
         chrom_size_lower = chrom_size_uper;
@@ -178,6 +232,7 @@ void Environment::setHostRandomPopulation(int pop_size, unsigned long gene_size,
 void Environment::setHostClonalPopulation(int pop_size, unsigned long gene_size,
                                           unsigned long chrom_size, int timeStamp,
                                            Tagging_system &tag){
+    HostAlleles.invalidate();
     std::vector<Host> tmpPopulation;
     tmpPopulation.emplace_back(Host());
     Random * rngGenPtr = mRandGenArr;
@@ -247,6 +302,7 @@ void Environment::setPathoPopulatioUniformGenome(int pop_size, unsigned long ant
  * genes in a genome and desired number of pathogen species it generates
  * random population of pathogens. Number of individuals will be evenly
  * distributed between species and each species consists of identical clones.
+ * Pathogens already in the environment are replaced.
  *
  * @param pop_size - total number of individuals
  * @param antigenSize - number of bits per gene
@@ -261,6 +317,8 @@ void Environment::setPathoPopulatioDivSpecies(int pop_size, unsigned long antige
         int numb_of_species, unsigned long mhcSize, int timeStamp,
         double fixedAntigenFrac, Tagging_system &tag)
 {
+    PathPopulation.clear();
+    NoMutsVec.clear();
     Environment::setNoMutsVector(numb_of_species, antigenSize, fixedAntigenFrac);
     if (numb_of_species > pop_size) numb_of_species = pop_size;
     int indiv_per_species = pop_size / numb_of_species;
@@ -305,6 +363,7 @@ void Environment::setPathoPopulatioDivSpecies(int pop_size, unsigned long antige
  *
  */
 void Environment::infectOneFromOneSpecHetero(){
+    PERF_PHASE(PerfPhase::Infection);
     H2Pinteraction H2P;
     unsigned long j;
     unsigned long HostPopulationSize = HostPopulation.size();
@@ -322,95 +381,599 @@ void Environment::infectOneFromOneSpecHetero(){
 }
 
 /**
- * @brief Core method. Iterates through the host population and calculates the
- * Fitness for each single individual by calling
- * Host::calculateFitnessAccChromSize(), which takes the number of MHC genes
- * under account.
+ * @brief Core method. Same infection procedure as infectOneFromOneSpecHetero(),
+ * but split into two separate phases: drawing of random pathogens for all the
+ * hosts (drawPathoIndicesForHosts()) and then evaluating the presentation
+ * (infectWithDrawnPathoIndices()).
  */
-void Environment::calculateHostsFitnessPerGene(){
+void Environment::infectOneFromOneSpecHeteroBatched(){
+    PERF_PHASE(PerfPhase::Infection);
+    drawPathoIndicesForHosts();
+    infectWithDrawnPathoIndices();
+}
+
+/**
+ * @brief Core method. Fills the hosts x species matrix of pathogen indices,
+ * one randomly selected pathogen of each species for each host.
+ *
+ * The matrix is filled column by column within each thread's share of hosts
+ * using Random::fillBoundedLemire(), so drawing random numbers is one tight
+ * loop per species and no presentation checks are interleaved with it. Empty
+ * species get the index equal to UINT_MAX, which is later skipped.
+ */
+void Environment::drawPathoIndicesForHosts(){
+    drawPathoIndicesForHosts(1);
+}
+
+/**
+ * @brief Core method. Fills the hosts x species x exposuresPerSpec matrix of
+ * pathogen indices: exposuresPerSpec randomly selected pathogens (drawn with
+ * replacement) of each species for each host. The k-th pathogen of species sp
+ * for host i sits at (i * species + sp) * exposuresPerSpec + k. See
+ * drawPathoIndicesForHosts().
+ *
+ * @param exposuresPerSpec - number of pathogens of each species a host meets
+ */
+void Environment::drawPathoIndicesForHosts(unsigned int exposuresPerSpec){
     unsigned long HostPopulationSize = HostPopulation.size();
-    #pragma omp parallel for default(none) shared(HostPopulationSize)
-    for(unsigned long i = 0; i < HostPopulationSize; ++i){
-        HostPopulation[i].calculateFitnessAccChromSize();
+    unsigned long PathPopulationSize = PathPopulation.size();
+    unsigned long rowSize = PathPopulationSize * exposuresPerSpec;
+    PathoIndxMatrix.resize(HostPopulationSize * rowSize);
+    unsigned int *indxPtr = PathoIndxMatrix.data();
+    Random * rngGenPtr = mRandGenArr;
+    #pragma omp parallel default(none) shared(rngGenPtr, indxPtr, HostPopulationSize, PathPopulationSize, \
+        rowSize, exposuresPerSpec)
+    {
+        int nThreads = omp_get_num_threads();
+        int thr = omp_get_thread_num();
+        unsigned long chunk = (HostPopulationSize + nThreads - 1) / nThreads;
+        unsigned long first = std::min(HostPopulationSize, chunk * thr);
+        unsigned long last = std::min(HostPopulationSize, first + chunk);
+        for(unsigned long col = 0; col < rowSize; ++col){
+            unsigned long sp = col / exposuresPerSpec;
+            unsigned int *column = indxPtr + first * rowSize + col;
+            if(PathPopulation[sp].empty()){
+                for(unsigned long i = first; i < last; ++i){
+                    column[(i - first) * rowSize] = UINT_MAX;
+                }
+            } else if (last > first){
+                rngGenPtr[thr].fillBoundedLemire(column, last - first, rowSize,
+                                                 (unsigned int) PathPopulation[sp].size());
+            }
+        }
     }
 }
 
 /**
- * @brief Core method. Iterates through the host population and calculates the
- * Fitness for each single individual by calling
- * Host::calculateHostsFitnessPlainInfect(), which is the plain-and-lame sum
- * of presented pathogens.
+ * @brief Core method. Evaluates infections of all the hosts with the pathogens
+ * pre-drawn by drawPathoIndicesForHosts(). Rules are the same as in
+ * infectOneFromOneSpecHetero(): heterozygote advantage and one infection per
+ * pathogen species.
+ *
+ * Host's unique MHC values are gathered once per host into a thread-local
+ * vector and then compared with each drawn pathogen's epitopes by
+ * H2Pinteraction::doesInfectedHeteroOnePerSpecBatch().
  */
-void Environment::calculateHostsFitnessPlainPresent(){
+void Environment::infectWithDrawnPathoIndices(){
     unsigned long HostPopulationSize = HostPopulation.size();
-    #pragma omp parallel for default(none) shared(HostPopulationSize)
+    unsigned long PathPopulationSize = PathPopulation.size();
+    if(PathoIndxMatrix.size() != HostPopulationSize * PathPopulationSize){
+        std::cout << "Error in Environment::infectWithDrawnPathoIndices(): the matrix "
+                  << "of pathogen indices does not fit the populations. Draw them first." << std::endl;
+        return;
+    }
+    const unsigned int *indxPtr = PathoIndxMatrix.data();
+    H2Pinteraction H2P;
+    longIntVec hostMHCs;
+    PERF_PROFILER();
+    #pragma omp parallel default(none) shared(indxPtr, HostPopulationSize, PathPopulationSize) \
+        PERF_PROFILER_SHARED private(H2P, hostMHCs)
+    {
+        PERF_KERNEL(PerfKernel::InfectHosts);
+        #pragma omp for nowait
+        for(unsigned long i = 0; i < HostPopulationSize; ++i){
+            hostMHCs.clear();
+            for(auto &gene : HostPopulation[i].getUniqueMHCsRef()){
+                hostMHCs.push_back(gene.getTheRealGene());
+            }
+            const unsigned int *row = indxPtr + i * PathPopulationSize;
+            for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+                if(row[sp] != UINT_MAX){
+                    H2P.doesInfectedHeteroOnePerSpecBatch(HostPopulation[i], hostMHCs, PathPopulation[sp][row[sp]]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Core method. Each host is exposed to exposuresPerSpec randomly selected
+ * pathogens of each species (instead of one as in infectOneFromOneSpecHetero()).
+ * Raises selection intensity without repeating the whole pathogen generation.
+ *
+ * @param exposuresPerSpec - number of pathogens of each species a host meets
+ */
+void Environment::infectKFromOneSpecHeteroBatched(unsigned int exposuresPerSpec){
+    PERF_PHASE(PerfPhase::Infection);
+    if(exposuresPerSpec == 0){
+        std::cout << "Error in Environment::infectKFromOneSpecHeteroBatched(): "
+                  << "number of exposures per species has to be positive." << std::endl;
+        return;
+    }
+    drawPathoIndicesForHosts(exposuresPerSpec);
+    infectWithDrawnKPathoIndices(exposuresPerSpec);
+}
+
+/**
+ * @brief Core method. Evaluates infections of all the hosts with the k pathogens
+ * per species pre-drawn by drawPathoIndicesForHosts(unsigned int). With
+ * heterozygote advantage.
+ *
+ * For each host and species the species membership is checked once: a species
+ * that has already infected the host (in an earlier pathogen generation) is
+ * skipped altogether. The k pathogens of the species are then evaluated as a
+ * batch in one pass over the host's unique alleles
+ * (H2Pinteraction::presentAntigensManyPatho()). The host's NumOfPathogesPresented
+ * grows by the number of presented pathogens and NumOfPathogesInfecting by the
+ * number of the infecting ones; the species is recorded once in
+ * PathogesPresented and/or PathoSpecInfecting. Pathogen infection counts are
+ * accumulated per thread and reduced at the end, no atomics.
+ *
+ * @param exposuresPerSpec - number of pathogens of each species a host meets
+ */
+void Environment::infectWithDrawnKPathoIndices(unsigned int exposuresPerSpec){
+    unsigned long HostPopulationSize = HostPopulation.size();
+    unsigned long PathPopulationSize = PathPopulation.size();
+    unsigned long rowSize = PathPopulationSize * exposuresPerSpec;
+    if(exposuresPerSpec == 0 or PathoIndxMatrix.size() != HostPopulationSize * rowSize){
+        std::cout << "Error in Environment::infectWithDrawnKPathoIndices(): the matrix "
+                  << "of pathogen indices does not fit the populations. Draw them first." << std::endl;
+        return;
+    }
+    std::vector<unsigned long> PathoOffset(PathPopulationSize + 1, 0);
+    for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+        PathoOffset[sp + 1] = PathoOffset[sp] + PathPopulation[sp].size();
+    }
+    int nThreads = omp_get_max_threads();
+    std::vector<std::vector<unsigned> > PathoInfectedThr((unsigned long) nThreads);
+    const unsigned int *indxPtr = PathoIndxMatrix.data();
+    #pragma omp parallel default(none) shared(indxPtr, HostPopulationSize, PathPopulationSize, rowSize, \
+        exposuresPerSpec, PathoOffset, PathoInfectedThr)
+    {
+        H2Pinteraction H2P;
+        longIntVec hostMHCs;
+        std::vector<const longIntVec*> antigens;
+        std::vector<char> presented;
+        std::vector<unsigned> &pathoInfected = PathoInfectedThr[omp_get_thread_num()];
+        pathoInfected.assign(PathoOffset.back(), 0);
+        #pragma omp for
+        for(unsigned long i = 0; i < HostPopulationSize; ++i){
+            Host &host = HostPopulation[i];
+            hostMHCs.clear();
+            for(auto &gene : host.getUniqueMHCsRef()){
+                hostMHCs.push_back(gene.getTheRealGene());
+            }
+            const unsigned int *row = indxPtr + i * rowSize;
+            for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+                const unsigned int *drawn = row + sp * exposuresPerSpec;
+                if(drawn[0] == UINT_MAX) continue;
+                int species = PathPopulation[sp][drawn[0]].getSpeciesTag();
+                if(std::find(host.PathoSpecInfecting.begin(), host.PathoSpecInfecting.end(), species)
+                   != host.PathoSpecInfecting.end()) continue;
+                antigens.clear();
+                for(unsigned int k = 0; k < exposuresPerSpec; ++k){
+                    antigens.push_back(&PathPopulation[sp][drawn[k]].getEpitopesRef());
+                }
+                unsigned long numPresented = H2P.presentAntigensManyPatho(hostMHCs, antigens, presented);
+                for(unsigned int k = 0; k < exposuresPerSpec; ++k){
+                    if(!presented[k]) pathoInfected[PathoOffset[sp] + drawn[k]] += 1;
+                }
+                host.NumOfPathogesPresented += (unsigned) numPresented;
+                host.NumOfPathogesInfecting += (unsigned) (exposuresPerSpec - numPresented);
+                if(numPresented)
+                    host.PathogesPresented.push_back(species);
+                if(numPresented < exposuresPerSpec)
+                    host.PathoSpecInfecting.push_back(species);
+            }
+        }
+    }
+    #pragma omp parallel for default(none) shared(PathoInfectedThr, PathoOffset, PathPopulationSize, nThreads)
+    for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+        unsigned long PathPopulationIthSize = PathPopulation[sp].size();
+        for(unsigned long j = 0; j < PathPopulationIthSize; ++j){
+            for(int thr = 0; thr < nThreads; ++thr){
+                if(!PathoInfectedThr[thr].empty())
+                    PathPopulation[sp][j].NumOfHostsInfected += PathoInfectedThr[thr][PathoOffset[sp] + j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Core method. (Re)builds the transposed epitope -> pathogens index of
+ * the pathogen population. Has to be called after each change in the pathogen
+ * population and before the index is used for infecting hosts.
+ */
+void Environment::buildPathoEpitopeIndex(){
+    EpitopeIndex.buildIndex(PathPopulation);
+}
+
+/**
+ * @brief Core method. Finds all pathogens of a species presented by a host using
+ * the epitope index, see PathoEpitopeIndex. Call buildPathoEpitopeIndex() first.
+ *
+ * @param hostIndx - index of the host
+ * @param spec - index of the pathogen species
+ * @param mask - output bit-set; bit j is set if the j-th pathogen is presented
+ * @return number of pathogens of this species presented by the host
+ */
+unsigned long Environment::getPresentedPathoMask(unsigned long hostIndx, unsigned long spec, bitWordsVec &mask){
+    longIntVec hostMHCs;
+    for(auto &gene : HostPopulation[hostIndx].getUniqueMHCsRef()){
+        hostMHCs.push_back(gene.getTheRealGene());
+    }
+    return EpitopeIndex.countPresented(hostMHCs, spec, mask);
+}
+
+/**
+ * @brief Core method. Exposes every host to every pathogen (deterministic
+ * exposure). With heterozygote advantage, as in infectOneFromOneSpecHetero().
+ *
+ * Builds the epitope index (see buildPathoEpitopeIndex()) and evaluates the
+ * whole hosts x pathogens presented / not-presented matrix without storing it.
+ * The matrix is cut into tiles of 64 hosts x 4096 pathogens of one species,
+ * which are shared between threads. Within a tile each host's presented set is
+ * the OR of its MHC rows; the number of hosts presenting each pathogen is summed
+ * with a bit-sliced (carry-save) counter, 64 pathogens per instruction. Host
+ * and pathogen counters are accumulated per thread and reduced at the end.
+ *
+ * Unlike in the one-pathogen-per-species mode the counters count pathogen
+ * individuals: a host's NumOfPathogesPresented grows by the number of pathogens
+ * it presented and its NumOfPathogesInfecting by the number of pathogens that
+ * infected it, a pathogen's NumOfHostsInfected by the number of hosts it
+ * infected. A species is listed once in host's PathoSpecInfecting (or
+ * PathogesPresented) if at least one of its individuals infected (or was
+ * presented by) the host.
+ */
+void Environment::infectEveryOne(){
+    PERF_PHASE(PerfPhase::Infection);
+    const unsigned long hostsPerTile = 64;    // one bit-slice counter per pathogen covers up to 127 hosts
+    const unsigned long wordsPerTile = 64;    // 4096 pathogens, 512 bytes of a row
+    const unsigned long counterPlanes = 7;
+    buildPathoEpitopeIndex();
+    unsigned long HostPopulationSize = HostPopulation.size();
+    unsigned long PathPopulationSize = PathPopulation.size();
+    if(HostPopulationSize == 0 or PathPopulationSize == 0)
+        return;
+    // Host MHCs gathered once, pathogens of all species laid out one after another
+    std::vector<longIntVec> HostMHCs(HostPopulationSize);
+    #pragma omp parallel for default(none) shared(HostMHCs, HostPopulationSize)
+    for(unsigned long i = 0; i < HostPopulationSize; ++i){
+        for(auto &gene : HostPopulation[i].getUniqueMHCsRef()){
+            HostMHCs[i].push_back(gene.getTheRealGene());
+        }
+    }
+    std::vector<unsigned long> PathoOffset(PathPopulationSize + 1, 0);
+    for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+        PathoOffset[sp + 1] = PathoOffset[sp] + EpitopeIndex.getSpeciesPopSize(sp);
+    }
+    // List of tiles: (species, first host, first word)
+    struct Tile { unsigned long sp, host, word; };
+    std::vector<Tile> Tiles;
+    for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+        unsigned long numWords = EpitopeIndex.getNumOfWords(sp);
+        for(unsigned long h = 0; h < HostPopulationSize; h += hostsPerTile){
+            for(unsigned long w = 0; w < numWords; w += wordsPerTile){
+                Tiles.push_back(Tile{sp, h, w});
+            }
+        }
+    }
+    unsigned long TilesSize = Tiles.size();
+    int nThreads = omp_get_max_threads();
+    std::vector<std::vector<unsigned long> > HostPresentedThr((unsigned long) nThreads);
+    std::vector<std::vector<unsigned long> > PathoPresentedThr((unsigned long) nThreads);
+    #pragma omp parallel default(none) shared(Tiles, TilesSize, HostMHCs, PathoOffset, HostPresentedThr, \
+        PathoPresentedThr, HostPopulationSize, PathPopulationSize, hostsPerTile, wordsPerTile, counterPlanes)
+    {
+        std::vector<unsigned long> &hostPresented = HostPresentedThr[omp_get_thread_num()];
+        std::vector<unsigned long> &pathoPresented = PathoPresentedThr[omp_get_thread_num()];
+        hostPresented.assign(HostPopulationSize * PathPopulationSize, 0);
+        pathoPresented.assign(PathoOffset.back(), 0);
+        bitWordsVec mask(wordsPerTile);
+        bitWordsVec planes(counterPlanes * wordsPerTile);
+        #pragma omp for schedule(dynamic)
+        for(unsigned long t = 0; t < TilesSize; ++t){
+            unsigned long sp = Tiles[t].sp;
+            unsigned long firstWord = Tiles[t].word;
+            unsigned long lastWord = std::min(firstWord + wordsPerTile, EpitopeIndex.getNumOfWords(sp));
+            unsigned long numWords = lastWord - firstWord;
+            unsigned long lastHost = std::min(Tiles[t].host + hostsPerTile, HostPopulationSize);
+            std::fill(planes.begin(), planes.end(), 0);
+            for(unsigned long i = Tiles[t].host; i < lastHost; ++i){
+                std::fill(mask.begin(), mask.begin() + numWords, 0);
+                EpitopeIndex.orPresentedWords(HostMHCs[i], sp, mask.data(), firstWord, lastWord);
+                hostPresented[i * PathPopulationSize + sp] += PathoEpitopeIndex::popcountWords(mask.data(), numWords);
+                // add the host's bits to the vertical counters
+                for(unsigned long w = 0; w < numWords; ++w){
+                    uint64_t carry = mask[w];
+                    for(unsigned long k = 0; k < counterPlanes and carry; ++k){
+                        uint64_t plane = planes[k * wordsPerTile + w];
+                        planes[k * wordsPerTile + w] = plane ^ carry;
+                        carry &= plane;
+                    }
+                }
+            }
+            // read the vertical counters out: how many hosts of the tile presented each pathogen
+            unsigned long firstPatho = PathoOffset[sp] + firstWord * 64;
+            unsigned long lastPatho = std::min(PathoOffset[sp] + lastWord * 64, PathoOffset[sp + 1]);
+            for(unsigned long p = firstPatho; p < lastPatho; ++p){
+                unsigned long bit = p - firstPatho;
+                unsigned long count = 0;
+                for(unsigned long k = 0; k < counterPlanes; ++k){
+                    count |= ((planes[k * wordsPerTile + bit / 64] >> (bit % 64)) & 1) << k;
+                }
+                pathoPresented[p] += count;
+            }
+        }
+    }
+    // Reduction of per-thread counters and update of the populations
+    #pragma omp parallel for default(none) shared(HostPresentedThr, HostPopulationSize, PathPopulationSize, nThreads)
     for(unsigned long i = 0; i < HostPopulationSize; ++i){
-        HostPopulation[i].calculateFitnessJustInfection();
+        for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+            unsigned long presented = 0;
+            for(int thr = 0; thr < nThreads; ++thr){
+                if(!HostPresentedThr[thr].empty())
+                    presented += HostPresentedThr[thr][i * PathPopulationSize + sp];
+            }
+            unsigned long infecting = EpitopeIndex.getSpeciesPopSize(sp) - presented;
+            HostPopulation[i].NumOfPathogesPresented += (unsigned) presented;
+            HostPopulation[i].NumOfPathogesInfecting += (unsigned) infecting;
+            if(presented)
+                HostPopulation[i].PathogesPresented.push_back(PathPopulation[sp].front().getSpeciesTag());
+            if(infecting)
+                HostPopulation[i].PathoSpecInfecting.push_back(PathPopulation[sp].front().getSpeciesTag());
+        }
+    }
+    #pragma omp parallel for default(none) shared(PathoPresentedThr, PathoOffset, HostPopulationSize, PathPopulationSize, nThreads)
+    for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+        unsigned long PathPopulationIthSize = PathPopulation[sp].size();
+        for(unsigned long j = 0; j < PathPopulationIthSize; ++j){
+            unsigned long presented = 0;
+            for(int thr = 0; thr < nThreads; ++thr){
+                if(!PathoPresentedThr[thr].empty())
+                    presented += PathoPresentedThr[thr][PathoOffset[sp] + j];
+            }
+            PathPopulation[sp][j].NumOfHostsInfected += (unsigned) (HostPopulationSize - presented);
+        }
     }
 }
 
 /**
- * @brief Core method. Iterates through the host population and calculates the
- * Fitness for each single individual by calling
- * Host::calculateFitnessForDrift(), which assigns "1" for each cell to make
- * the genetic driff work.
+ * @brief Core method. Fills the lookup table of the fitness function's
+ * size-dependent factor (see FitnessTable). A host has two chromosomes of at
+ * most maxGene genes each, so sizes up to 2 * maxGene are tabulated. When
+ * maxGene is 0 the largest size in the current host population is used.
+ *
+ * @param fitFun - fitness function the Policy stands for
+ * @param alpha - scaling parameter of the fitness function
+ * @param maxGene - maximal allowed number of genes in a chromosome
  */
-void Environment::calculateHostsFitnessForDrift(){
+template <class Policy>
+void Environment::buildFitnessTable(FitnessFunction fitFun, double alpha, unsigned long maxGene){
+    unsigned long maxSize = 2 * maxGene;
+    if(maxGene == 0){
+        unsigned long HostPopulationSize = HostPopulation.size();
+        #pragma omp parallel for default(none) shared(HostPopulationSize) reduction(max:maxSize)
+        for(unsigned long i = 0; i < HostPopulationSize; ++i){
+            maxSize = std::max(maxSize, Policy::sizeOf(HostPopulation[i]));
+        }
+    }
+    FitnessLUT.build<Policy>(fitFun, alpha, maxSize);
+}
+
+/**
+ * @brief Core method. Calculates fitness of every host with a fitness policy,
+ * see FitnessPolicy. A gather from the lookup table and a multiply per host.
+ *
+ * @param fitFun - fitness function the Policy stands for
+ * @param alpha - scaling parameter of the fitness function
+ * @param maxGene - maximal allowed number of genes in a chromosome (0 if unknown)
+ */
+template <class Policy>
+void Environment::calculateHostsFitnessWith(FitnessFunction fitFun, double alpha, unsigned long maxGene){
+    buildFitnessTable<Policy>(fitFun, alpha, maxGene);
     unsigned long HostPopulationSize = HostPopulation.size();
-    #pragma omp parallel for default(none) shared(HostPopulationSize)
+    const FitnessTable &table = FitnessLUT;
+    #pragma omp parallel for default(none) shared(HostPopulationSize, table)
     for(unsigned long i = 0; i < HostPopulationSize; ++i){
-        HostPopulation[i].calculateFitnessForDrift();
+        HostPopulation[i].setFitness(table.fitness<Policy>(HostPopulation[i]));
     }
 }
 
 /**
  * @brief Core method. Iterates through the host population and calculates the
- * Fitness for each single individual by calling
- * Host::calculateHostsFitnessAlphaXsqr(), which uses one over the square on
+ * Fitness for each single individual with the chosen fitness function. The
+ * function is picked at run time, the loop over hosts is compiled separately
+ * for each of them.
+ *
+ * @param fitFun - fitness function
+ * @param alpha - scaling parameter of the fitness function (ignored by some)
+ * @param maxGene - maximal allowed number of genes in a chromosome (0 if unknown)
+ */
+void Environment::calculateHostsFitness(FitnessFunction fitFun, double alpha, unsigned long maxGene){
+    PERF_PHASE(PerfPhase::Fitness);
+    switch(fitFun){
+        case FitnessFunction::JustInfection:
+            calculateHostsFitnessWith<FitnessPolicy::JustInfection>(fitFun, alpha, maxGene);
+            break;
+        case FitnessFunction::PerGene:
+            calculateHostsFitnessWith<FitnessPolicy::PerGene>(fitFun, alpha, maxGene);
+            break;
+        case FitnessFunction::Drift:
+            calculateHostsFitnessWith<FitnessPolicy::Drift>(fitFun, alpha, maxGene);
+            break;
+        case FitnessFunction::AlphaXSqr:
+            calculateHostsFitnessWith<FitnessPolicy::AlphaXSqr>(fitFun, alpha, maxGene);
+            break;
+        case FitnessFunction::ExpFunc:
+            calculateHostsFitnessWith<FitnessPolicy::ExpFunc>(fitFun, alpha, maxGene);
+            break;
+        case FitnessFunction::ExpFuncUniqAlleles:
+            calculateHostsFitnessWith<FitnessPolicy::ExpFuncUniqAlleles>(fitFun, alpha, maxGene);
+            break;
+    }
+}
+
+/**
+ * @brief Core method. Calculates the Fitness of each host the way
+ * Host::calculateFitnessAccChromSize() does, which takes the number of MHC
+ * genes under account.
+ */
+void Environment::calculateHostsFitnessPerGene(){
+    calculateHostsFitness(FitnessFunction::PerGene, 0.0, 0);
+}
+
+/**
+ * @brief Core method. Calculates the Fitness of each host the way
+ * Host::calculateFitnessJustInfection() does, which is the plain-and-lame sum
+ * of presented pathogens.
+ */
+void Environment::calculateHostsFitnessPlainPresent(){
+    calculateHostsFitness(FitnessFunction::JustInfection, 0.0, 0);
+}
+
+/**
+ * @brief Core method. Calculates the Fitness of each host the way
+ * Host::calculateFitnessForDrift() does, which assigns "1" for each cell to make
+ * the genetic driff work.
+ */
+void Environment::calculateHostsFitnessForDrift(){
+    calculateHostsFitness(FitnessFunction::Drift, 0.0, 0);
+}
+
+/**
+ * @brief Core method. Calculates the Fitness of each host the way
+ * Host::calculateFitnessAlphaXSqr() does, which uses one over the square on
  * number of genes as a fitness cost.
  *
  * @param alpha - penalty for having too many MHC types factor for the host fitness function
  */
 void Environment::calculateHostsFitnessAlphaXsqr(double alpha){
-    unsigned long HostPopulationSize = HostPopulation.size();
-    #pragma omp parallel for default(none) shared(HostPopulationSize, alpha)
-    for(unsigned long i = 0; i < HostPopulationSize; ++i){
-        HostPopulation[i].calculateFitnessAlphaXSqr(alpha);
-    }
+    calculateHostsFitness(FitnessFunction::AlphaXSqr, alpha, 0);
 }
 
 /**
- * @brief Core method. Iterates through the host population and calculates the
- * Fitness for each single individual by calling
- * Host::calculateFitnessExpFunc(), which uses a Gaussian function to accommodate
- * the costs of having lots of genes.
+ * @brief Core method. Calculates the Fitness of each host the way
+ * Host::calculateFitnessExpFunc() does, which uses a Gaussian function to
+ * accommodate the costs of having lots of genes.
  *
  * @param alpha - penalty for having too many MHC types factor for the host fitness function
  */
 void Environment::calculateHostsFitnessExpScaling(double alpha){
-    unsigned long HostPopulationSize = HostPopulation.size();
-    #pragma omp parallel for default(none) shared(HostPopulationSize, alpha)
-    for(unsigned long i = 0; i < HostPopulationSize; ++i){
-        HostPopulation[i].calculateFitnessExpFunc(alpha);
-    }
+    calculateHostsFitness(FitnessFunction::ExpFunc, alpha, 0);
 }
 
 /**
- * @brief Core method. Iterates through the host population and calculates the
- * Fitness for each single individual by calling
- * Host::calculateFitnessExpFuncUniqAlleles(), which uses a Gaussian function
- * to accommodate the costs of having lots of unique MHC alleles in chromosomes.
+ * @brief Core method. Calculates the Fitness of each host the way
+ * Host::calculateFitnessExpFuncUniqAlleles() does, which uses a Gaussian
+ * function to accommodate the costs of having lots of unique MHC alleles in
+ * chromosomes.
  *
  * @param alpha - penalty for having too many MHC types factor for the host fitness function
  */
 void Environment::calculateHostsFitnessExpScalingUniqAlleles(double alpha){
+    calculateHostsFitness(FitnessFunction::ExpFuncUniqAlleles, alpha, 0);
+}
+
+/**
+ * @brief Core method. Fused host pass done just before the selection: in one
+ * parallel sweep over the host population it calculates the fitness with the
+ * chosen fitness policy (see calculateHostsFitness()), fills the roulette wheel
+ * (running sums of fitness) used by selectAndReprodHostsNoMatingWeighted() and
+ * resets the per-host state that is not needed any more: lists of infecting
+ * and presented pathogen species and the reproduction counter. The numbers of
+ * presented pathogens are kept, they are still harvested after the selection.
+ *
+ * Each thread takes a contiguous chunk of hosts and sums its fitness locally,
+ * chunk offsets are added after a barrier. The total fitness is reduced with
+ * an OpenMP reduction.
+ *
+ * @param fitFun - fitness function the Policy stands for
+ * @param alpha - scaling parameter of the fitness function
+ * @param maxGene - maximal allowed number of genes in a chromosome (0 if unknown)
+ * @return sum of fitness of all hosts
+ */
+template <class Policy>
+double Environment::calculateHostsFitnessAndSelectionWeightsWith(FitnessFunction fitFun, double alpha,
+                                                                 unsigned long maxGene){
+    buildFitnessTable<Policy>(fitFun, alpha, maxGene);
+    const FitnessTable &table = FitnessLUT;
     unsigned long HostPopulationSize = HostPopulation.size();
-    #pragma omp parallel for default(none) shared(HostPopulationSize, alpha)
-    for(unsigned long i = 0; i < HostPopulationSize; ++i){
-        HostPopulation[i].calculateFitnessExpFuncUniqAlleles(alpha);
+    HostFitnessCumul.resize(HostPopulationSize);
+    double *cumulPtr = HostFitnessCumul.data();
+    std::vector<double> ChunkSums((unsigned long) omp_get_max_threads(), 0.0);
+    double sum_of_fit = 0.0;
+    #pragma omp parallel default(none) shared(HostPopulationSize, table, cumulPtr, ChunkSums) reduction(+:sum_of_fit)
+    {
+        int nThreads = omp_get_num_threads();
+        int thr = omp_get_thread_num();
+        unsigned long chunk = (HostPopulationSize + nThreads - 1) / nThreads;
+        unsigned long first = std::min(HostPopulationSize, chunk * thr);
+        unsigned long last = std::min(HostPopulationSize, first + chunk);
+        double partial = 0.0;
+        for(unsigned long i = first; i < last; ++i){
+            Host &host = HostPopulation[i];
+            host.setFitness(table.fitness<Policy>(host));
+            host.PathoSpecInfecting.clear();
+            host.PathogesPresented.clear();
+            host.SelectedForReproduction = 0;
+            partial += host.getFitness();
+            cumulPtr[i] = partial;
+        }
+        ChunkSums[thr] = partial;
+        sum_of_fit += partial;
+        #pragma omp barrier
+        double offset = 0.0;
+        for(int t = 0; t < thr; ++t){
+            offset += ChunkSums[t];
+        }
+        for(unsigned long i = first; i < last; ++i){
+            cumulPtr[i] += offset;
+        }
     }
+    return sum_of_fit;
 }
 
+/**
+ * @brief Core method. Fused fitness, roulette wheel and reset pass with the
+ * fitness function picked at run time, see
+ * calculateHostsFitnessAndSelectionWeightsWith().
+ *
+ * @param fitFun - fitness function
+ * @param alpha - scaling parameter of the fitness function (ignored by some)
+ * @param maxGene - maximal allowed number of genes in a chromosome (0 if unknown)
+ * @return sum of fitness of all hosts
+ */
+double Environment::calculateHostsFitnessAndSelectionWeights(FitnessFunction fitFun, double alpha,
+                                                             unsigned long maxGene){
+    PERF_PHASE(PerfPhase::Fitness);
+    switch(fitFun){
+        case FitnessFunction::JustInfection:
+            return calculateHostsFitnessAndSelectionWeightsWith<FitnessPolicy::JustInfection>(fitFun, alpha, maxGene);
+        case FitnessFunction::PerGene:
+            return calculateHostsFitnessAndSelectionWeightsWith<FitnessPolicy::PerGene>(fitFun, alpha, maxGene);
+        case FitnessFunction::Drift:
+            return calculateHostsFitnessAndSelectionWeightsWith<FitnessPolicy::Drift>(fitFun, alpha, maxGene);
+        case FitnessFunction::AlphaXSqr:
+            return calculateHostsFitnessAndSelectionWeightsWith<FitnessPolicy::AlphaXSqr>(fitFun, alpha, maxGene);
+        case FitnessFunction::ExpFunc:
+            return calculateHostsFitnessAndSelectionWeightsWith<FitnessPolicy::ExpFunc>(fitFun, alpha, maxGene);
+        case FitnessFunction::ExpFuncUniqAlleles:
+            return calculateHostsFitnessAndSelectionWeightsWith<FitnessPolicy::ExpFuncUniqAlleles>(fitFun, alpha,
+                                                                                                   maxGene);
+    }
+    return 0.0;
+}
 
 /**
  * @brief Core method. Forms the next generation of hosts using the fitness
@@ -424,9 +987,12 @@ void Environment::calculateHostsFitnessExpScalingUniqAlleles(double alpha){
  * between sexes.
  */
 void Environment::selectAndReprodHostsReplace(){
+    PERF_PHASE(PerfPhase::HostSelection);
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
     unsigned long pop_size = HostPopulation.size();
+    std::vector<int> ChromOneCopies(pop_size, 0), ChromTwoCopies(pop_size, 0);
+    unsigned long chromTwoFrom = 0;  // host the last new one has Chromosome Two from
 //    int tot_exposed = 0;
     double sum_of_fit = 0;
     double rnd;
@@ -451,6 +1017,9 @@ void Environment::selectAndReprodHostsReplace(){
                 if (rnd <= 0) {
                     HostPopulation[k].SelectedForReproduction += 1;
                     NewHostsVec.push_back(HostPopulation[k]);
+                    ChromOneCopies[k] += 1;
+                    ChromTwoCopies[k] += 1;
+                    chromTwoFrom = k;
                     NewHostsVec.back().setMotherMhcNumber(HostPopulation[k].getUniqueMHCs().size());
                     n += 1;
                     goto second_parent;
@@ -464,6 +1033,9 @@ void Environment::selectAndReprodHostsReplace(){
                 if (rnd <= 0) {
                     HostPopulation[p].SelectedForReproduction += 1;
                     NewHostsVec.back().assignChromTwo(HostPopulation[p].getChromosomeTwo());
+                    ChromTwoCopies[chromTwoFrom] -= 1;
+                    ChromTwoCopies[p] += 1;
+                    chromTwoFrom = p;
                     NewHostsVec.back().setFatherMhcNumber(HostPopulation[p].getUniqueMHCs().size());
 
                     // Randomly swaps places of chromosomes to avoid situation when
@@ -475,6 +1047,7 @@ void Environment::selectAndReprodHostsReplace(){
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()){
+        addParentalCopies(ChromOneCopies, ChromTwoCopies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     }else{
@@ -497,9 +1070,11 @@ void Environment::selectAndReprodHostsReplace(){
  * selection). Successful individuals are simply cloned replacing the weak ones.
  */
 void Environment::selectAndReprodHostsNoMating() {
+    PERF_PHASE(PerfPhase::HostSelection);
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
     unsigned long pop_size = HostPopulation.size();
+    std::vector<int> Copies(pop_size, 0);
     double sum_of_fit = 0;
     double rnd;
     for(unsigned long i = 0; i < pop_size; ++i){
@@ -521,6 +1096,7 @@ void Environment::selectAndReprodHostsNoMating() {
                 if (rnd <= 0) {
                     HostPopulation[k].SelectedForReproduction += 1;
                     NewHostsVec.push_back(HostPopulation[k]);
+                    Copies[k] += 1;
                     n += 1;
                     goto aley_oop;
                 }
@@ -528,6 +1104,7 @@ void Environment::selectAndReprodHostsNoMating() {
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()){
+        addParentalCopies(Copies, Copies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     }else{
@@ -538,6 +1115,45 @@ void Environment::selectAndReprodHostsNoMating() {
     }
 }
 
+/**
+ * @brief Core method. Same selection as selectAndReprodHostsNoMating(), but the
+ * roulette wheel is taken from calculateHostsFitnessAndSelectionWeights(), so
+ * there is no extra pass summing fitness and each draw is a binary search in
+ * the running sums instead of a walk through the host population. The wheel
+ * is used only once; without it the plain selectAndReprodHostsNoMating() is
+ * called.
+ */
+void Environment::selectAndReprodHostsNoMatingWeighted() {
+    PERF_PHASE(PerfPhase::HostSelection);
+    unsigned long pop_size = HostPopulation.size();
+    if(HostFitnessCumul.size() != pop_size or pop_size == 0){
+        HostFitnessCumul.clear();
+        selectAndReprodHostsNoMating();
+        return;
+    }
+    double sum_of_fit = HostFitnessCumul.back();
+    if(sum_of_fit == 0){
+        HostFitnessCumul.clear();
+        return;
+    }
+    std::vector<Host> NewHostsVec;
+    NewHostsVec.reserve(pop_size);
+    std::vector<int> Copies(pop_size, 0);
+    Random &rngGen = mRandGenArr[omp_get_thread_num()];
+    for(unsigned long n = 0; n < pop_size; ++n){
+        double rnd = rngGen.getRealDouble(0, sum_of_fit);
+        unsigned long k = (unsigned long) (std::lower_bound(HostFitnessCumul.begin(),
+                                                           HostFitnessCumul.end(), rnd) - HostFitnessCumul.begin());
+        if(k == pop_size) k = pop_size - 1;
+        HostPopulation[k].SelectedForReproduction += 1;
+        NewHostsVec.push_back(HostPopulation[k]);
+        Copies[k] += 1;
+    }
+    addParentalCopies(Copies, Copies);
+    HostPopulation.swap(NewHostsVec);
+    HostFitnessCumul.clear();
+}
+
 
 /**
  * @brief Core method. Forms the next generation of hosts using the fitness
@@ -549,6 +1165,7 @@ void Environment::selectAndReprodHostsNoMating() {
  * wheel selection).
  */
 void Environment::selectAndReproducePathoFixedPopSizes(){
+    PERF_PHASE(PerfPhase::PathoSelection);
     std::vector<Pathogen> TmpPathVec;
     int rnd;
     unsigned long PopSizes[(int) PathPopulation.size()];
@@ -567,24 +1184,29 @@ void Environment::selectAndReproducePathoFixedPopSizes(){
         return;
     PathPopulationSize = PathPopulation.size();
     Random * rngGenPtr = mRandGenArr;
+    PERF_PROFILER();
     #pragma omp parallel for ordered default(none) \
-        shared(rngGenPtr, PathPopulationSize, PopSizes, SpecTotInfected, std::cout) private(rnd, TmpPathVec)
+        shared(rngGenPtr, PathPopulationSize, PopSizes, SpecTotInfected, std::cout) PERF_PROFILER_SHARED \
+        private(rnd, TmpPathVec)
     for (int k = 0; k < PathPopulationSize; ++k){
         TmpPathVec.clear();
-        int n = 0;
-        aley_oop:
-        while(n < PopSizes[k]){
-           rnd = rngGenPtr[omp_get_thread_num()].getRandomFromUniform(0, (unsigned int) SpecTotInfected[k]);
-           unsigned long PathPopulationKthSize = PathPopulation[k].size();
-           for(unsigned long l = 0; l < PathPopulationKthSize; ++l){
-               rnd = rnd - PathPopulation[k][l].NumOfHostsInfected;
-               if(rnd <= 0){
-                  PathPopulation[k][l].SelectedToReproduct += 1;
-                  TmpPathVec.push_back(PathPopulation[k][l]);
-                  n += 1;
-                  goto aley_oop;
+        {
+            PERF_KERNEL(PerfKernel::SelectPathoSpecies);
+            int n = 0;
+            aley_oop:
+            while(n < PopSizes[k]){
+               rnd = rngGenPtr[omp_get_thread_num()].getRandomFromUniform(0, (unsigned int) SpecTotInfected[k]);
+               unsigned long PathPopulationKthSize = PathPopulation[k].size();
+               for(unsigned long l = 0; l < PathPopulationKthSize; ++l){
+                   rnd = rnd - PathPopulation[k][l].NumOfHostsInfected;
+                   if(rnd <= 0){
+                      PathPopulation[k][l].SelectedToReproduct += 1;
+                      TmpPathVec.push_back(PathPopulation[k][l]);
+                      n += 1;
+                      goto aley_oop;
+                   }
                }
-           }
+            }
         }
         #pragma omp ordered
         {
@@ -649,13 +1271,22 @@ void Environment::clearHostInfectionsData(){
 void Environment::mutateHostsWithDelDuplPointMuts(double pm_mut_probabl,
         double del, double dupl, unsigned long maxGene, int timeStamp,
          Tagging_system &tag){
+    PERF_PHASE(PerfPhase::HostMutation);
     unsigned long HostPopulationSzie = HostPopulation.size();
     Random * rngGenPtr = mRandGenArr;
+    std::vector<alleleDeltas> ThreadDeltas(HostAlleles.isValid() ? mRandGenArrSize : 0);
+    PERF_PROFILER();
     #pragma omp parallel for default(none) \
-        shared(HostPopulationSzie, pm_mut_probabl, del, dupl, maxGene, timeStamp, rngGenPtr, tag)
+        shared(HostPopulationSzie, pm_mut_probabl, del, dupl, maxGene, timeStamp, rngGenPtr, tag, ThreadDeltas) \
+        PERF_PROFILER_SHARED
     for(int k = 0; k < HostPopulationSzie; ++k){
+        PERF_KERNEL(PerfKernel::MutateHost);
         HostPopulation[k].chromoMutProcessWithDelDuplPointMuts(pm_mut_probabl,
-                del, dupl, maxGene, timeStamp, rngGenPtr[omp_get_thread_num()], tag);
+                del, dupl, maxGene, timeStamp, rngGenPtr[omp_get_thread_num()], tag,
+                ThreadDeltas.empty() ? nullptr : &ThreadDeltas[omp_get_thread_num()]);
+    }
+    for(const alleleDeltas &deltas : ThreadDeltas){
+        HostAlleles.addDeltas(deltas);
     }
 }
 
@@ -675,17 +1306,44 @@ void Environment::mutateHostsWithDelDuplPointMuts(double pm_mut_probabl,
  */
 void Environment::mutateHostWithDelDuplAllMHCchange(double mut_probabl, double del, double dupl, unsigned long maxGene,
                                                     int timeStamp, Tagging_system &tag) {
+    PERF_PHASE(PerfPhase::HostMutation);
     unsigned long HostPopulationSzie = HostPopulation.size();
     Random * rngGenPtr = mRandGenArr;
+    std::vector<alleleDeltas> ThreadDeltas(HostAlleles.isValid() ? mRandGenArrSize : 0);
+    PERF_PROFILER();
     #pragma omp parallel for default(none) \
-        shared(HostPopulationSzie, mut_probabl, del, dupl, maxGene, timeStamp, rngGenPtr, tag)
+        shared(HostPopulationSzie, mut_probabl, del, dupl, maxGene, timeStamp, rngGenPtr, tag, ThreadDeltas) \
+        PERF_PROFILER_SHARED
     for(int k = 0; k < HostPopulationSzie; ++k){
+        PERF_KERNEL(PerfKernel::MutateHost);
         HostPopulation[k].chromoMutProcessWithDelDupl(mut_probabl, del, dupl, maxGene,
-                timeStamp, rngGenPtr[omp_get_thread_num()], tag);
+                timeStamp, rngGenPtr[omp_get_thread_num()], tag,
+                ThreadDeltas.empty() ? nullptr : &ThreadDeltas[omp_get_thread_num()]);
+    }
+    for(const alleleDeltas &deltas : ThreadDeltas){
+        HostAlleles.addDeltas(deltas);
     }
 }
 
 
+/**
+ * @brief Core method. Updates the allele table (see AlleleTable) when a new
+ * host generation replaces the old one: each chromosome of an old host gains
+ * as many copies as the new generation got from it, less the one it had.
+ * Call it before the old population is replaced.
+ *
+ * @param chromOneCopies - copies of Chromosome One of each old host in the new generation
+ * @param chromTwoCopies - same for Chromosome Two
+ */
+void Environment::addParentalCopies(const std::vector<int> &chromOneCopies, const std::vector<int> &chromTwoCopies){
+    if(!HostAlleles.isValid())
+        return;
+    for(unsigned long k = 0; k < HostPopulation.size(); ++k){
+        HostAlleles.addChromosome(HostPopulation[k].getChromosomeOneRef(), chromOneCopies[k] - 1);
+        HostAlleles.addChromosome(HostPopulation[k].getChromosomeTwoRef(), chromTwoCopies[k] - 1);
+    }
+}
+
 /**
  * @brief Core method. When given micro-recombination mutation probability it
  * returns point-mutation probability calculated the way that it the average
@@ -723,6 +1381,7 @@ double Environment::MMtoPMscaling(double MM_prob_mut, unsigned long geneLength){
  * @param timeStamp - current time (number of the model iteration)
  *
 void Environment::mutatePathogens(double mut_probabl, unsigned long mhcSize, int timeStamp){
+    PERF_PHASE(PerfPhase::PathoMutation);
     unsigned long PathPopulationSize = PathPopulation.size();
     for (int i = 0; i < PathPopulationSize; ++i){
         unsigned long PathPopulationIthSize = PathPopulation[i].size();
@@ -747,16 +1406,23 @@ void Environment::mutatePathogens(double mut_probabl, unsigned long mhcSize, int
  */
 void Environment::mutatePathogensWithRestric(double mut_probabl, unsigned long mhcSize,
         int timeStamp, Tagging_system &tag){
+    PERF_PHASE(PerfPhase::PathoMutation);
     if (PathPopulation.size() == NoMutsVec.size()){
         Random * rngGenPtr = mRandGenArr;
+        PERF_PROFILER();
 //    #pragma omp parallel for default(none) shared(
         unsigned long PathPopulationSize = PathPopulation.size();
         for(unsigned long i = 0; i < PathPopulationSize; ++i){
             unsigned long PathPopulationIthSize = PathPopulation[i].size();
-            #pragma omp parallel for default(none) shared(rngGenPtr, tag, mut_probabl, mhcSize, timeStamp, i, PathPopulationIthSize)
-            for(unsigned long j = 0; j < PathPopulationIthSize; ++j){
-                PathPopulation[i][j].chromoMutProcessWithRestric(mut_probabl,
-                        mhcSize, timeStamp, NoMutsVec[i], rngGenPtr[omp_get_thread_num()], tag);
+            #pragma omp parallel default(none) shared(rngGenPtr, tag, mut_probabl, mhcSize, timeStamp, i, \
+                PathPopulationIthSize) PERF_PROFILER_SHARED
+            {
+                PERF_KERNEL(PerfKernel::MutatePathogens);
+                #pragma omp for nowait
+                for(unsigned long j = 0; j < PathPopulationIthSize; ++j){
+                    PathPopulation[i][j].chromoMutProcessWithRestric(mut_probabl,
+                            mhcSize, timeStamp, NoMutsVec[i], rngGenPtr[omp_get_thread_num()], tag);
+                }
             }
         }
     } else {
@@ -811,13 +1477,15 @@ unsigned long Environment::getHostsPopSize(){
  * will checks out eventually selecting one best to mate with.
  */
 void Environment::matingWithNoCommonMHCsmallSubset(unsigned long matingPartnerNumber){
+    PERF_PHASE(PerfPhase::Mating);
     unsigned long popSize = HostPopulation.size();
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
+    std::vector<int> ChromOneCopies(popSize, 0), ChromTwoCopies(popSize, 0);
     unsigned long i, maxGenomeSize, highScore, geneIndCount;
     int theBestMatch;
     maxGenomeSize = 0;
-    for(auto indvidual : HostPopulation){
+    for(Host &indvidual : HostPopulation){
         if(indvidual.getGenomeSize() > maxGenomeSize){
             maxGenomeSize = indvidual.getUniqueMhcSize();
         }
@@ -862,12 +1530,15 @@ void Environment::matingWithNoCommonMHCsmallSubset(unsigned long matingPartnerNu
                 NewHostsVec.push_back(HostPopulation[i]);
                 NewHostsVec.back().setMotherMhcNumber(HostPopulation[i].getUniqueMHCs().size());
                 NewHostsVec.back().assignChromTwo(HostPopulation[theBestMatch].getChromosomeTwo());
+                ChromOneCopies[i] += 1;
+                ChromTwoCopies[theBestMatch] += 1;
                 NewHostsVec.back().setFatherMhcNumber(HostPopulation[theBestMatch].getUniqueMHCs().size());
                 NewHostsVec.back().swapChromosomes(rngGenPtr[omp_get_thread_num()]);
             }
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()) {
+        addParentalCopies(ChromOneCopies, ChromTwoCopies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     } else {
@@ -901,14 +1572,16 @@ void Environment::matingWithNoCommonMHCsmallSubset(unsigned long matingPartnerNu
  * will checks out eventually selecting one best to mate with.
  */
 void  Environment::matingWithOneDifferentMHCsmallSubset(int matingPartnerNumber) {
+    PERF_PHASE(PerfPhase::Mating);
     unsigned long popSize = HostPopulation.size();
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
+    std::vector<int> ChromOneCopies(popSize, 0), ChromTwoCopies(popSize, 0);
     unsigned long i, maxGenomeSize;
     int theBestMatch;
     bool differentGene;
     maxGenomeSize = 0;
-    for(auto indvidual : HostPopulation){
+    for(Host &indvidual : HostPopulation){
         if(indvidual.getGenomeSize() > maxGenomeSize){
             maxGenomeSize = indvidual.getUniqueMhcSize();
         }
@@ -952,6 +1625,8 @@ void  Environment::matingWithOneDifferentMHCsmallSubset(int matingPartnerNumber)
                 NewHostsVec.push_back(HostPopulation[i]);
                 NewHostsVec.back().setMotherMhcNumber(HostPopulation[i].getUniqueMHCs().size());
                 NewHostsVec.back().assignChromTwo(HostPopulation[theBestMatch].getChromosomeTwo());
+                ChromOneCopies[i] += 1;
+                ChromTwoCopies[theBestMatch] += 1;
                 NewHostsVec.back().setFatherMhcNumber(HostPopulation[theBestMatch].getUniqueMHCs().size());
                 NewHostsVec.back().swapChromosomes(rngGenPtr[omp_get_thread_num()]);
             }
@@ -959,6 +1634,7 @@ void  Environment::matingWithOneDifferentMHCsmallSubset(int matingPartnerNumber)
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()){
+        addParentalCopies(ChromOneCopies, ChromTwoCopies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     }else{
@@ -978,9 +1654,11 @@ void  Environment::matingWithOneDifferentMHCsmallSubset(int matingPartnerNumber)
  * will checks out eventually selecting one best to mate with.
  */
 void Environment::matingMeanOptimalNumberMHCsmallSubset(int matingPartnerNumber) {
+    PERF_PHASE(PerfPhase::Mating);
     unsigned long popSize = HostPopulation.size();
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
+    std::vector<int> ChromOneCopies(popSize, 0), ChromTwoCopies(popSize, 0);
     unsigned long i;
     int theBestMatch;
     double sameGeneCount, highScore, uniqueMHCcount, score;
@@ -1027,6 +1705,8 @@ void Environment::matingMeanOptimalNumberMHCsmallSubset(int matingPartnerNumber)
                 NewHostsVec.push_back(HostPopulation[i]);
                 NewHostsVec.back().setMotherMhcNumber(HostPopulation[i].getUniqueMHCs().size());
                 NewHostsVec.back().assignChromTwo(HostPopulation[theBestMatch].getChromosomeTwo());
+                ChromOneCopies[i] += 1;
+                ChromTwoCopies[theBestMatch] += 1;
                 NewHostsVec.back().setFatherMhcNumber(HostPopulation[theBestMatch].getUniqueMHCs().size());
                 NewHostsVec.back().swapChromosomes(rngGenPtr[omp_get_thread_num()]);
             }
@@ -1034,6 +1714,7 @@ void Environment::matingMeanOptimalNumberMHCsmallSubset(int matingPartnerNumber)
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()){
+        addParentalCopies(ChromOneCopies, ChromTwoCopies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     }else{
@@ -1054,9 +1735,11 @@ void Environment::matingMeanOptimalNumberMHCsmallSubset(int matingPartnerNumber)
  * will checks out eventually selecting one that is the best to mate with.
  */
 void Environment::matingMaxDifferentNumber(int matingPartnerNumber) {
+    PERF_PHASE(PerfPhase::Mating);
     unsigned long popSize = HostPopulation.size();
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
+    std::vector<int> ChromOneCopies(popSize, 0), ChromTwoCopies(popSize, 0);
     unsigned long i;
     int theBestMatch;
     double sameGeneCount, highScore, score;
@@ -1101,6 +1784,8 @@ void Environment::matingMaxDifferentNumber(int matingPartnerNumber) {
                 NewHostsVec.push_back(HostPopulation[i]);
                 NewHostsVec.back().setMotherMhcNumber(HostPopulation[i].getUniqueMHCs().size());
                 NewHostsVec.back().assignChromTwo(HostPopulation[theBestMatch].getChromosomeTwo());
+                ChromOneCopies[i] += 1;
+                ChromTwoCopies[theBestMatch] += 1;
                 NewHostsVec.back().setFatherMhcNumber(HostPopulation[theBestMatch].getUniqueMHCs().size());
                 NewHostsVec.back().swapChromosomes(rngGenPtr[omp_get_thread_num()]);
             }
@@ -1108,6 +1793,7 @@ void Environment::matingMaxDifferentNumber(int matingPartnerNumber) {
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()){
+        addParentalCopies(ChromOneCopies, ChromTwoCopies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     }else{
@@ -1128,9 +1814,11 @@ void Environment::matingMaxDifferentNumber(int matingPartnerNumber) {
  *
  */
 void Environment::matingRandom() {
+    PERF_PHASE(PerfPhase::Mating);
     unsigned long popSize = HostPopulation.size();
     std::vector<Host> NewHostsVec;
     NewHostsVec.clear();
+    std::vector<int> ChromOneCopies(popSize, 0), ChromTwoCopies(popSize, 0);
     unsigned long i;
     int theMatch;
     // the random mating procedure
@@ -1149,12 +1837,15 @@ void Environment::matingRandom() {
                 NewHostsVec.push_back(HostPopulation[i]);
                 NewHostsVec.back().setMotherMhcNumber(HostPopulation[i].getUniqueMHCs().size());
                 NewHostsVec.back().assignChromTwo(HostPopulation[theMatch].getChromosomeTwo());
+                ChromOneCopies[i] += 1;
+                ChromTwoCopies[theMatch] += 1;
                 NewHostsVec.back().setFatherMhcNumber(HostPopulation[theMatch].getUniqueMHCs().size());
                 NewHostsVec.back().swapChromosomes(rngGenPtr[omp_get_thread_num()]);
             }
         }
     }
     if (HostPopulation.size() == NewHostsVec.size()){
+        addParentalCopies(ChromOneCopies, ChromTwoCopies);
         HostPopulation.clear();
         HostPopulation = NewHostsVec;
     }else{
@@ -1220,12 +1911,10 @@ std::string Environment::getFixedBitsInAntigens(){
  * @return a string listing how many pathogens hosts presented
  */
 std::string Environment::getNumbersOfPathogensPresented() {
-    sttr presentedPatho;
-    for(auto indvidual : HostPopulation){
-            presentedPatho += sttr(" ") + std::to_string(indvidual.getNumberOfPresentedPatho());
-    }
-    presentedPatho +=  sttr("\n");
-    return presentedPatho;
+    std::vector<char> buffer;
+    appendHostColumn(HostColumn::PresentedPathogens, buffer);
+    buffer.push_back('\n');
+    return std::string(buffer.begin(), buffer.end());
 }
 
 /**
@@ -1235,12 +1924,10 @@ std::string Environment::getNumbersOfPathogensPresented() {
  * @return a string listing how many MHCs a "mother" had
  */
 std::string Environment::getNumbersOfMhcInMother() {
-    sttr mhcsInMother;
-    for(auto indvidual : HostPopulation){
-        mhcsInMother += sttr(" ") + std::to_string(indvidual.getMotherMhcNumber());
-    }
-    mhcsInMother +=  sttr("\n");
-    return mhcsInMother;
+    std::vector<char> buffer;
+    appendHostColumn(HostColumn::MhcInMother, buffer);
+    buffer.push_back('\n');
+    return std::string(buffer.begin(), buffer.end());
 }
 
 /**
@@ -1250,22 +1937,55 @@ std::string Environment::getNumbersOfMhcInMother() {
  * @return a string listing how many MHCs a "father" had
  */
 std::string Environment::getNumbersOfMhcInFather()  {
-    sttr mhcsInFather;
-    for(auto individual : HostPopulation){
-        mhcsInFather += sttr(" ") + std::to_string(individual.getFatherMhcNumber());
-    }
-    mhcsInFather +=  sttr("\n");
-    return mhcsInFather;
+    std::vector<char> buffer;
+    appendHostColumn(HostColumn::MhcInFather, buffer);
+    buffer.push_back('\n');
+    return std::string(buffer.begin(), buffer.end());
 }
 
 
 std::string Environment::getNumbersOfUniqueMHCs() {
-    sttr uniqueMHCs;
-    for(auto individual : HostPopulation){
-        uniqueMHCs += sttr(" ") + std::to_string(individual.getNumbOfUniqMHCgenes());
-    }
-    uniqueMHCs +=  sttr("\n");
-    return uniqueMHCs;
+    std::vector<char> buffer;
+    appendHostColumn(HostColumn::UniqueMhcs, buffer);
+    buffer.push_back('\n');
+    return std::string(buffer.begin(), buffer.end());
+}
+
+/**
+ * @brief Data harvesting method. Appends a number of every host to a text
+ * buffer, each one preceded by a space, formatted in place (see TextFormat).
+ * Hosts are not copied and no strings are made on the way.
+ *
+ * @param column - which number
+ * @param buffer - the buffer
+ */
+void Environment::appendHostColumn(HostColumn column, std::vector<char> &buffer) const {
+    std::size_t used = buffer.size();
+    buffer.resize(used + HostPopulation.size() * (TextFormat::MaxDigits + 1));
+    char *p = buffer.data() + used;
+    forEachHostValue(column, [&p](unsigned long value){
+        *p++ = ' ';
+        p = TextFormat::write(p, value);
+    });
+    buffer.resize(p - buffer.data());
+}
+
+/**
+ * @brief Data harvesting method. The host population, read-only.
+ *
+ * @return reference to the vector of hosts
+ */
+const std::vector<Host>& Environment::getHostPopulationRef() const {
+    return HostPopulation;
+}
+
+/**
+ * @brief Data harvesting method. The pathogen population, read-only.
+ *
+ * @return reference to the vector of pathogen species
+ */
+const std::vector<std::vector<Pathogen> >& Environment::getPathoPopulationRef() const {
+    return PathPopulation;
 }
 
 
@@ -1296,3 +2016,712 @@ double Environment::getHostFitness(unsigned long indx){
     return (double) HostPopulation[indx].NumOfPathogesPresented;
 }
 
+/**
+ * @brief Data harvesting method. Numbers of copies of all MHC alleles in the
+ * host population. Counted anew if the table is out of date, kept up to date
+ * by selection, mating and mutation otherwise.
+ *
+ * @return the allele table
+ */
+const AlleleTable& Environment::getHostAlleles(){
+    if(!HostAlleles.isValid())
+        HostAlleles.rebuild(HostPopulation);
+    return HostAlleles;
+}
+
+/**
+ * @brief Data harvesting method. Bytes held by the populations, the allele
+ * table and the working buffers, part by part (see MemoryUsage). The resident
+ * set size is not read here. The new host generation built by selection and
+ * mating (NewHostsVec) is not counted: it exists only inside those stages, in
+ * between the population is the only copy. It shows in the peak resident set
+ * size.
+ *
+ * @return the memory usage
+ */
+MemoryUsage Environment::getMemoryUsage() const {
+    using MemoryAccounting::heapBytes;
+    MemoryUsage usage;
+    auto geneLineage = [](const chromovector &genes){
+        uint64_t bytes = 0;
+        for(const Gene &gene : genes){
+            bytes += heapBytes(gene.ParentTags) + heapBytes(gene.MutationTime);
+        }
+        return bytes;
+    };
+    usage[MemoryComponent::HostChromosomes] = heapBytes(HostPopulation);
+    for(const Host &individual : HostPopulation){
+        usage[MemoryComponent::HostChromosomes] += heapBytes(individual.getChromosomeOneRef())
+                                                   + heapBytes(individual.getChromosomeTwoRef());
+        usage[MemoryComponent::HostUniqueAlleles] += heapBytes(individual.getUniqueMHCsRef());
+        usage[MemoryComponent::HostLineage] += geneLineage(individual.getChromosomeOneRef())
+                                               + geneLineage(individual.getChromosomeTwoRef())
+                                               + geneLineage(individual.getUniqueMHCsRef());
+        usage[MemoryComponent::HostInfections] += heapBytes(individual.PathoSpecInfecting)
+                                                  + heapBytes(individual.PathogesPresented);
+    }
+    usage[MemoryComponent::PathoAntigens] = heapBytes(PathPopulation) + heapBytes(NoMutsVec);
+    for(const std::set<unsigned long> &noMutts : NoMutsVec){
+        usage[MemoryComponent::PathoAntigens] += noMutts.size() * (sizeof(unsigned long) + 4 * sizeof(void*));
+    }
+    for(const std::vector<Pathogen> &species : PathPopulation){
+        usage[MemoryComponent::PathoAntigens] += heapBytes(species);
+        for(const Pathogen &patho : species){
+            const Antigen &antigen = patho.getAntigenRef();
+            usage[MemoryComponent::PathoAntigens] += heapBytes(antigen.getBitAntigenRef());
+            usage[MemoryComponent::PathoEpitopes] += heapBytes(antigen.getEpitopesRef());
+            usage[MemoryComponent::PathoLineage] += heapBytes(antigen.ParentTags) + heapBytes(antigen.MutationTime);
+        }
+    }
+    usage[MemoryComponent::AlleleCounts] = HostAlleles.getMemoryBytes();
+    usage[MemoryComponent::Buffers] = heapBytes(PathoIndxMatrix) + EpitopeIndex.getMemoryBytes()
+                                      + heapBytes(HostFitnessCumul) + mRandGenArrSize * sizeof(Random);
+    return usage;
+}
+
+/**
+ * @brief Core method. Writes the state of the environment which carries over
+ * from one generation to the next to a binary stream (see BinaryIO): states of
+ * the random number generators, no-mutation sites, host and pathogen
+ * populations. Working buffers rebuilt in each generation (pre-drawn pathogen
+ * indices, epitope index, roulette wheel) are not written.
+ *
+ * @param out - the stream
+ */
+void Environment::writeState(std::ostream &out) const {
+    BinaryIO::write(out, (uint64_t) mRandGenArrSize);
+    for(unsigned int i = 0; i < mRandGenArrSize; ++i){
+        mRandGenArr[i].writeState(out);
+    }
+    BinaryIO::write(out, (uint64_t) NoMutsVec.size());
+    for(const auto &noMuts : NoMutsVec){
+        BinaryIO::writeVector(out, std::vector<unsigned long>(noMuts.begin(), noMuts.end()));
+    }
+    BinaryIO::write(out, (uint64_t) HostPopulation.size());
+    for(const Host &host : HostPopulation){
+        host.writeState(out);
+    }
+    BinaryIO::write(out, (uint64_t) PathPopulation.size());
+    for(const auto &species : PathPopulation){
+        BinaryIO::write(out, (uint64_t) species.size());
+        for(const Pathogen &patho : species){
+            patho.writeState(out);
+        }
+    }
+}
+
+/**
+ * @brief Core method. Reads the state written by writeState(). When the
+ * states of the random number generators are restored, their number (threads)
+ * has to be the same as in the environment that wrote the state; otherwise
+ * they are skipped and the generators keep their own seeds.
+ *
+ * @param in - the stream
+ * @param restoreRNG - restore the random number generators ('true' to continue a run exactly)
+ * @return 'false' if the state could not be read
+ */
+bool Environment::readState(std::istream &in, bool restoreRNG){
+    uint64_t size;
+    if(!BinaryIO::read(in, size))
+        return false;
+    if(!restoreRNG){
+        Random skipped;
+        for(uint64_t i = 0; i < size; ++i){
+            if(!skipped.readState(in))
+                return false;
+        }
+    } else if(size != mRandGenArrSize){
+        std::cout << "Error in Environment::readState(): the state was saved with " << size
+                  << " random number generators (threads), this environment has " << mRandGenArrSize
+                  << "." << std::endl;
+        return false;
+    } else {
+        for(unsigned int i = 0; i < mRandGenArrSize; ++i){
+            if(!mRandGenArr[i].readState(in))
+                return false;
+        }
+    }
+    if(!BinaryIO::read(in, size) or size > BinaryIO::MaxLength)
+        return false;
+    NoMutsVec.assign(size, std::set<unsigned long>());
+    for(auto &noMuts : NoMutsVec){
+        std::vector<unsigned long> sites;
+        if(!BinaryIO::readVector(in, sites))
+            return false;
+        noMuts.insert(sites.begin(), sites.end());
+    }
+    if(!BinaryIO::read(in, size) or size > BinaryIO::MaxLength)
+        return false;
+    HostPopulation.assign(size, Host());
+    HostAlleles.invalidate();
+    for(Host &host : HostPopulation){
+        if(!host.readState(in))
+            return false;
+    }
+    if(!BinaryIO::read(in, size) or size > BinaryIO::MaxLength)
+        return false;
+    PathPopulation.assign(size, std::vector<Pathogen>());
+    for(auto &species : PathPopulation){
+        if(!BinaryIO::read(in, size) or size > BinaryIO::MaxLength)
+            return false;
+        species.assign(size, Pathogen());
+        for(Pathogen &patho : species){
+            if(!patho.readState(in))
+                return false;
+        }
+    }
+    PathoIndxMatrix.clear();
+    HostFitnessCumul.clear();
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Writes the populations as a binary snapshot
+ * (see SnapshotWriter), the compact equivalent of HostGenomesFile.N.csv and
+ * PathoGenomesFile.N.csv. The columns are streamed straight from the
+ * populations: one pass counts, then each column is one pass.
+ *
+ * @param out - binary stream
+ * @param tayme - time stamp (host generation number)
+ * @param withHosts - 'false' leaves the host sections empty
+ * @param withPathogens - 'false' leaves the pathogen sections empty
+ * @return 'false' if writing failed
+ */
+bool Environment::writeSnapshot(std::ostream &out, int tayme, bool withHosts, bool withPathogens) const {
+    const std::vector<Host> noHosts;
+    const std::vector<Host> &hosts = withHosts ? HostPopulation : noHosts;
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.Time = tayme;
+    header.HasPathogens = withPathogens ? 1 : 0;
+    header.NumbOfHosts = hosts.size();
+    for(const Host &host : hosts){
+        header.NumbOfPresented += host.PathogesPresented.size();
+        for(const chromovector *chromo : {&host.getChromosomeOneRef(), &host.getChromosomeTwoRef()}){
+            header.NumbOfGenes += chromo->size();
+            for(const Gene &gene : *chromo){
+                header.NumbOfGeneLineage += gene.ParentTags.size();
+                header.GeneBits = gene.getBitStringLength();
+            }
+        }
+    }
+    if(withPathogens){
+        header.NumbOfSpecies = PathPopulation.size();
+        for(const auto &species : PathPopulation){
+            header.NumbOfPathos += species.size();
+            for(const Pathogen &patho : species){
+                header.NumbOfAntigenLineage += patho.getAntigenRef().ParentTags.size();
+                header.AntigenBits = patho.getAntigenRef().getBitAntigenRef().size();
+            }
+        }
+        header.AntigenWords = (header.AntigenBits + 63) / 64;
+    }
+    SnapshotWriter writer(out);
+    writer.writeHeader(header);
+
+    uint64_t offset = 0;
+    writer.beginSection(HostGeneOffsets);
+    for(const Host &host : hosts){
+        writer.put(offset);
+        offset += host.getChromosomeOneRef().size() + host.getChromosomeTwoRef().size();
+    }
+    writer.put(offset);
+    writer.beginSection(HostChromoOneSizes);
+    for(const Host &host : hosts)
+        writer.put((uint32_t) host.getChromosomeOneRef().size());
+    writer.beginSection(HostInfecting);
+    for(const Host &host : hosts)
+        writer.put((uint32_t) host.NumOfPathogesInfecting);
+    writer.beginSection(HostPresented);
+    for(const Host &host : hosts)
+        writer.put((uint32_t) host.NumOfPathogesPresented);
+    offset = 0;
+    writer.beginSection(HostPresentedOffsets);
+    for(const Host &host : hosts){
+        writer.put(offset);
+        offset += host.PathogesPresented.size();
+    }
+    writer.put(offset);
+    writer.beginSection(PresentedSpecies);
+    for(const Host &host : hosts){
+        for(int species : host.PathogesPresented)
+            writer.put((int32_t) species);
+    }
+
+    // Gene columns, chromosome one and then two of each host
+    writer.beginSection(GeneAlleles);
+    for(const Host &host : hosts){
+        for(const Gene &gene : host.getChromosomeOneRef())
+            writer.put((uint64_t) gene.getTheRealGene());
+        for(const Gene &gene : host.getChromosomeTwoRef())
+            writer.put((uint64_t) gene.getTheRealGene());
+    }
+    writer.beginSection(GeneTimes);
+    for(const Host &host : hosts){
+        for(const Gene &gene : host.getChromosomeOneRef())
+            writer.put((int32_t) gene.timeOfOrigin);
+        for(const Gene &gene : host.getChromosomeTwoRef())
+            writer.put((int32_t) gene.timeOfOrigin);
+    }
+    writer.beginSection(GeneTags);
+    for(const Host &host : hosts){
+        for(const Gene &gene : host.getChromosomeOneRef())
+            writer.put((uint64_t) gene.GenesTag);
+        for(const Gene &gene : host.getChromosomeTwoRef())
+            writer.put((uint64_t) gene.GenesTag);
+    }
+    offset = 0;
+    writer.beginSection(GeneLineageOffsets);
+    for(const Host &host : hosts){
+        for(const chromovector *chromo : {&host.getChromosomeOneRef(), &host.getChromosomeTwoRef()}){
+            for(const Gene &gene : *chromo){
+                writer.put(offset);
+                offset += gene.ParentTags.size();
+            }
+        }
+    }
+    writer.put(offset);
+    writer.beginSection(GeneMutationTimes);
+    for(const Host &host : hosts){
+        for(const chromovector *chromo : {&host.getChromosomeOneRef(), &host.getChromosomeTwoRef()}){
+            for(const Gene &gene : *chromo){
+                for(unsigned long k = 0; k < gene.ParentTags.size(); ++k)
+                    writer.put((int32_t) (k < gene.MutationTime.size() ? gene.MutationTime[k] : -1));
+            }
+        }
+    }
+    writer.beginSection(GeneParentTags);
+    for(const Host &host : hosts){
+        for(const chromovector *chromo : {&host.getChromosomeOneRef(), &host.getChromosomeTwoRef()}){
+            for(const Gene &gene : *chromo){
+                for(unsigned long parentTag : gene.ParentTags)
+                    writer.put((uint64_t) parentTag);
+            }
+        }
+    }
+    if(!withPathogens){
+        writer.beginSection(SpeciesOffsets);
+        writer.put((uint64_t) 0);
+        writer.beginSection(AntigenLineageOffsets);
+        writer.put((uint64_t) 0);
+        return writer.finish();
+    }
+
+    // Pathogen columns, species after species
+    offset = 0;
+    writer.beginSection(SpeciesOffsets);
+    for(const auto &species : PathPopulation){
+        writer.put(offset);
+        offset += species.size();
+    }
+    writer.put(offset);
+    writer.beginSection(PathoSpecies);
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species)
+            writer.put((int32_t) patho.getSpeciesTag());
+    }
+    writer.beginSection(PathoInfected);
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species)
+            writer.put((uint32_t) patho.NumOfHostsInfected);
+    }
+    writer.beginSection(AntigenBits);
+    static_assert(sizeof(antigenstring::block_type) == sizeof(uint64_t), "antigen blocks have to be 64-bit words");
+    std::vector<antigenstring::block_type> blocks;
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species){
+            blocks.clear();
+            boost::to_block_range(patho.getAntigenRef().getBitAntigenRef(), std::back_inserter(blocks));
+            blocks.resize(header.AntigenWords, 0);
+            for(antigenstring::block_type block : blocks)
+                writer.put((uint64_t) block);
+        }
+    }
+    writer.beginSection(AntigenTimes);
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species)
+            writer.put((int32_t) patho.getAntigenRef().timeOfOrigin);
+    }
+    writer.beginSection(AntigenTags);
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species)
+            writer.put((uint64_t) patho.getAntigenRef().AntigenTag);
+    }
+    offset = 0;
+    writer.beginSection(AntigenLineageOffsets);
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species){
+            writer.put(offset);
+            offset += patho.getAntigenRef().ParentTags.size();
+        }
+    }
+    writer.put(offset);
+    writer.beginSection(AntigenParentTags);
+    for(const auto &species : PathPopulation){
+        for(const Pathogen &patho : species){
+            for(unsigned long parentTag : patho.getAntigenRef().ParentTags)
+                writer.put((uint64_t) parentTag);
+        }
+    }
+    return writer.finish();
+}
+
+/**
+ * @brief Core method. Sets the host population from a file with host genomes
+ * written by DataHandler::saveHostPopulToFile() (HostGenomesFile.N.csv). Genes
+ * keep their tags, times of origin and history. The tagging system continues
+ * after the largest tag found.
+ *
+ * @param fileName - the file with host genomes
+ * @param gene_size - number of bits in a MHC gene, has to match the file
+ * @param tag - the tagging system
+ * @return 'false' if the file could not be read or does not fit the parameters
+ */
+bool Environment::setHostPopulationFromFile(const std::string &fileName, unsigned long gene_size,
+                                            Tagging_system &tag){
+    std::ifstream inFile(fileName);
+    if(!inFile.good()){
+        std::cout << "Error in Environment::setHostPopulationFromFile(): cannot open the file "
+                  << fileName << std::endl;
+        return false;
+    }
+    std::vector<chromovector> ChromosOne;
+    std::vector<chromovector> ChromosTwo;
+    unsigned long maxTag = tag.getLastTag();
+    std::string line;
+    unsigned long lineNumb = 0;
+    while(std::getline(inFile, line)){
+        ++lineNumb;
+        if(line.empty() or line[0] == '#')
+            continue;
+        if(line.compare(0, 4, " ===") == 0){
+            ChromosOne.emplace_back();
+            ChromosTwo.emplace_back();
+            continue;
+        }
+        std::stringstream ss(line);
+        std::string bits, chromo;
+        int timeOfOrigin;
+        unsigned long geneTag;
+        if(ChromosOne.empty() or !(ss >> bits >> chromo >> timeOfOrigin >> geneTag)
+           or bits.size() != gene_size or (chromo != "ch_one" and chromo != "ch_two")){
+            std::cout << "Error in Environment::setHostPopulationFromFile(): wrong line " << lineNumb
+                      << " in " << fileName << " (genes should have " << gene_size << " bits)." << std::endl;
+            return false;
+        }
+        Gene newGene;
+        newGene.setNewFixedGene(gene_size, timeOfOrigin, genestring(bits).to_ulong(), geneTag);
+        long mutTime;
+        unsigned long parentTag;
+        while(ss >> mutTime and mutTime != -1 and ss >> parentTag){
+            newGene.MutationTime.push_back((int) mutTime);
+            newGene.ParentTags.push_back(parentTag);
+            maxTag = std::max(maxTag, parentTag);
+        }
+        maxTag = std::max(maxTag, geneTag);
+        if(chromo == "ch_one")
+            ChromosOne.back().push_back(newGene);
+        else
+            ChromosTwo.back().push_back(newGene);
+    }
+    if(ChromosOne.empty()){
+        std::cout << "Error in Environment::setHostPopulationFromFile(): no hosts in " << fileName << std::endl;
+        return false;
+    }
+    HostPopulation.assign(ChromosOne.size(), Host());
+    HostAlleles.invalidate();
+    for(unsigned long i = 0; i < HostPopulation.size(); ++i){
+        HostPopulation[i].assignChromOne(ChromosOne[i]);
+        HostPopulation[i].assignChromTwo(ChromosTwo[i]);
+        HostPopulation[i].evalUniqueMHCs();
+        HostPopulation[i].clearInfections();
+        HostPopulation[i].setMotherMhcNumber(0);
+        HostPopulation[i].setFatherMhcNumber(0);
+    }
+    tag.setLastTag(maxTag);
+    return true;
+}
+
+/**
+ * @brief Core method. Sets the pathogen population from a file with pathogen
+ * genomes written by DataHandler::savePathoPopulToFile() (PathoGenomesFile.N.csv).
+ * Species are numbered as in the file, antigens keep their tags, parental tags
+ * and times of origin. No-mutation sites are not stored in the file, so there are none.
+ *
+ * @param fileName - the file with pathogen genomes
+ * @param antigenSize - number of bits in an antigen, has to match the file
+ * @param mhcSize - number of bits in a MHC gene
+ * @param tag - the tagging system
+ * @return 'false' if the file could not be read or does not fit the parameters
+ */
+bool Environment::setPathoPopulationFromFile(const std::string &fileName, unsigned long antigenSize,
+                                             unsigned long mhcSize, Tagging_system &tag){
+    std::ifstream inFile(fileName);
+    if(!inFile.good()){
+        std::cout << "Error in Environment::setPathoPopulationFromFile(): cannot open the file "
+                  << fileName << std::endl;
+        return false;
+    }
+    std::vector<std::vector<Pathogen> > NewPopulation;
+    unsigned long maxTag = tag.getLastTag();
+    int species = -1;
+    std::string line;
+    unsigned long lineNumb = 0;
+    while(std::getline(inFile, line)){
+        ++lineNumb;
+        if(line.empty() or line[0] == '#')
+            continue;
+        if(line.compare(0, 4, " ===") == 0){
+            std::stringstream hs(line.substr(line.find("No.") + 3));
+            if(line.find("No.") == std::string::npos or !(hs >> species) or species < 0){
+                std::cout << "Error in Environment::setPathoPopulationFromFile(): wrong line " << lineNumb
+                          << " in " << fileName << std::endl;
+                return false;
+            }
+            if((unsigned long) species >= NewPopulation.size())
+                NewPopulation.resize(species + 1);
+            continue;
+        }
+        std::stringstream ss(line);
+        std::string bits, chromo;
+        int timeOfOrigin;
+        unsigned long antigenTag;
+        if(species < 0 or !(ss >> bits >> chromo >> timeOfOrigin >> antigenTag) or bits.size() != antigenSize){
+            std::cout << "Error in Environment::setPathoPopulationFromFile(): wrong line " << lineNumb
+                      << " in " << fileName << " (antigens should have " << antigenSize << " bits)." << std::endl;
+            return false;
+        }
+        std::vector<unsigned long> parentTags;
+        unsigned long parentTag;
+        while(ss >> parentTag){
+            parentTags.push_back(parentTag);
+            maxTag = std::max(maxTag, parentTag);
+        }
+        Pathogen newPatho;
+        newPatho.setPathogenFromAntigen(antigenstring(bits), antigenTag, mhcSize, species, timeOfOrigin, parentTags);
+        maxTag = std::max(maxTag, antigenTag);
+        NewPopulation[species].push_back(newPatho);
+    }
+    for(unsigned long sp = 0; sp < NewPopulation.size(); ++sp){
+        if(NewPopulation[sp].empty()){
+            std::cout << "Error in Environment::setPathoPopulationFromFile(): species " << sp
+                      << " has no pathogens in " << fileName << std::endl;
+            return false;
+        }
+    }
+    if(NewPopulation.empty()){
+        std::cout << "Error in Environment::setPathoPopulationFromFile(): no pathogens in " << fileName << std::endl;
+        return false;
+    }
+    PathPopulation = NewPopulation;
+    NoMutsVec.assign(PathPopulation.size(), std::set<unsigned long>());
+    tag.setLastTag(maxTag);
+    return true;
+}
+
+/**
+ * @brief Core method. Sets the host population from a binary population
+ * snapshot (PopulationSnapshot.N.bin, see writeSnapshot()). Genes keep their
+ * tags, times of origin and history. The tagging system continues after the
+ * largest tag found.
+ *
+ * @param snapshot - an open snapshot
+ * @param gene_size - number of bits in a MHC gene, has to match the snapshot
+ * @param tag - the tagging system
+ * @return 'false' if the snapshot does not fit the parameters
+ */
+bool Environment::setHostPopulationFromSnapshot(const SnapshotReader &snapshot, unsigned long gene_size,
+                                                Tagging_system &tag){
+    const SnapshotHeader &header = snapshot.getHeader();
+    if(header.NumbOfHosts == 0 or header.GeneBits != gene_size){
+        std::cout << "Error in Environment::setHostPopulationFromSnapshot(): the snapshot has "
+                  << header.NumbOfHosts << " hosts with genes of " << header.GeneBits
+                  << " bits, genes should have " << gene_size << " bits." << std::endl;
+        return false;
+    }
+    const int32_t *times = snapshot.getColumn<int32_t>(GeneTimes);
+    const uint64_t *geneTags = snapshot.getColumn<uint64_t>(GeneTags);
+    const uint64_t *lineage = snapshot.getColumn<uint64_t>(GeneLineageOffsets);
+    const int32_t *mutationTimes = snapshot.getColumn<int32_t>(GeneMutationTimes);
+    const uint64_t *parentTags = snapshot.getColumn<uint64_t>(GeneParentTags);
+    unsigned long maxTag = tag.getLastTag();
+    HostPopulation.assign(header.NumbOfHosts, Host());
+    HostAlleles.invalidate();
+    for(unsigned long i = 0; i < HostPopulation.size(); ++i){
+        chromovector chromoOne, chromoTwo;
+        unsigned long first = snapshot.getHostFirstGene(i);
+        unsigned long chromoOneEnd = first + snapshot.getHostChromoOneSize(i);
+        unsigned long last = chromoOneEnd + snapshot.getHostChromoTwoSize(i);
+        for(unsigned long g = first; g < last; ++g){
+            Gene newGene;
+            newGene.setNewFixedGene(gene_size, times[g], snapshot.getGeneAllele(g), geneTags[g]);
+            for(uint64_t k = lineage[g]; k < lineage[g + 1]; ++k){
+                if(mutationTimes[k] != -1)  // written for parental tags with no mutation time
+                    newGene.MutationTime.push_back(mutationTimes[k]);
+                newGene.ParentTags.push_back(parentTags[k]);
+                maxTag = std::max(maxTag, (unsigned long) parentTags[k]);
+            }
+            maxTag = std::max(maxTag, (unsigned long) geneTags[g]);
+            if(g < chromoOneEnd)
+                chromoOne.push_back(newGene);
+            else
+                chromoTwo.push_back(newGene);
+        }
+        HostPopulation[i].assignChromOne(chromoOne);
+        HostPopulation[i].assignChromTwo(chromoTwo);
+        HostPopulation[i].evalUniqueMHCs();
+        HostPopulation[i].clearInfections();
+        HostPopulation[i].setMotherMhcNumber(0);
+        HostPopulation[i].setFatherMhcNumber(0);
+    }
+    tag.setLastTag(maxTag);
+    return true;
+}
+
+/**
+ * @brief Core method. Sets the pathogen population from a binary population
+ * snapshot written with pathogens (see writeSnapshot()). Species are numbered
+ * as in the snapshot, antigens keep their tags, parental tags and times of
+ * origin. No-mutation sites are not stored in the snapshot, so there are none.
+ *
+ * @param snapshot - an open snapshot
+ * @param antigenSize - number of bits in an antigen, has to match the snapshot
+ * @param mhcSize - number of bits in a MHC gene
+ * @param tag - the tagging system
+ * @return 'false' if the snapshot has no pathogens or does not fit the parameters
+ */
+bool Environment::setPathoPopulationFromSnapshot(const SnapshotReader &snapshot, unsigned long antigenSize,
+                                                 unsigned long mhcSize, Tagging_system &tag){
+    const SnapshotHeader &header = snapshot.getHeader();
+    if(!header.HasPathogens or header.NumbOfSpecies == 0 or header.AntigenBits != antigenSize){
+        std::cout << "Error in Environment::setPathoPopulationFromSnapshot(): the snapshot has "
+                  << (header.HasPathogens ? header.NumbOfSpecies : 0) << " pathogen species with antigens of "
+                  << header.AntigenBits << " bits, antigens should have " << antigenSize << " bits." << std::endl;
+        return false;
+    }
+    const uint64_t *speciesOffsets = snapshot.getColumn<uint64_t>(SpeciesOffsets);
+    const int32_t *times = snapshot.getColumn<int32_t>(AntigenTimes);
+    const uint64_t *antigenTags = snapshot.getColumn<uint64_t>(AntigenTags);
+    const uint64_t *lineage = snapshot.getColumn<uint64_t>(AntigenLineageOffsets);
+    const uint64_t *parentTags = snapshot.getColumn<uint64_t>(AntigenParentTags);
+    std::vector<std::vector<Pathogen> > NewPopulation(header.NumbOfSpecies);
+    unsigned long maxTag = tag.getLastTag();
+    for(unsigned long sp = 0; sp < NewPopulation.size(); ++sp){
+        if(speciesOffsets[sp] == speciesOffsets[sp + 1]){
+            std::cout << "Error in Environment::setPathoPopulationFromSnapshot(): species " << sp
+                      << " has no pathogens in the snapshot." << std::endl;
+            return false;
+        }
+        NewPopulation[sp].resize(speciesOffsets[sp + 1] - speciesOffsets[sp]);
+        for(uint64_t p = speciesOffsets[sp]; p < speciesOffsets[sp + 1]; ++p){
+            const uint64_t *words = snapshot.getAntigenWords(p);
+            antigenstring bits(words, words + header.AntigenWords);
+            bits.resize(antigenSize);
+            std::vector<unsigned long> ancestors(parentTags + lineage[p], parentTags + lineage[p + 1]);
+            NewPopulation[sp][p - speciesOffsets[sp]].setPathogenFromAntigen(bits, antigenTags[p], mhcSize,
+                                                                            (int) sp, times[p], ancestors);
+            for(unsigned long ancestor : ancestors)
+                maxTag = std::max(maxTag, ancestor);
+            maxTag = std::max(maxTag, (unsigned long) antigenTags[p]);
+        }
+    }
+    PathPopulation = NewPopulation;
+    NoMutsVec.assign(PathPopulation.size(), std::set<unsigned long>());
+    tag.setLastTag(maxTag);
+    return true;
+}
+
+/**
+ * @brief Core method. Takes the pathogen population (with the no-mutation
+ * sites) of another environment.
+ *
+ * @param source - the environment to copy pathogens from
+ */
+void Environment::copyPathoPopulation(const Environment &source){
+    PathPopulation = source.PathPopulation;
+    NoMutsVec = source.NoMutsVec;
+}
+
+/**
+ * @brief Core method. Changes the size of the host population loaded from a
+ * snapshot: hosts are drawn at random (with replacement) from it. Nothing
+ * happens if the size is right already.
+ *
+ * @param pop_size - new size of the host population
+ */
+void Environment::resizeHostPopulation(int pop_size){
+    if(HostPopulation.empty() or HostPopulation.size() == (unsigned long) pop_size)
+        return;
+    std::vector<Host> NewPopulation;
+    NewPopulation.reserve(pop_size);
+    unsigned int lastIndx = (unsigned int) HostPopulation.size() - 1;
+    for(int i = 0; i < pop_size; ++i){
+        NewPopulation.push_back(HostPopulation[mRandGenArr[0].getRandomFromUniform(0, lastIndx)]);
+    }
+    HostPopulation.swap(NewPopulation);
+    HostAlleles.invalidate();
+}
+
+/**
+ * @brief Core method. Changes the size of the pathogen population loaded from
+ * a snapshot: each species gets an equal share of the new size (the first
+ * species get one more when it does not divide), drawn at random (with
+ * replacement) from the species. Nothing happens if the total size is right
+ * already.
+ *
+ * @param pop_size - new size of the pathogen population
+ */
+void Environment::resizePathoPopulation(int pop_size){
+    unsigned long totalSize = 0;
+    for(auto &species : PathPopulation)
+        totalSize += species.size();
+    if(PathPopulation.empty() or totalSize == (unsigned long) pop_size)
+        return;
+    unsigned long numbOfSpecies = PathPopulation.size();
+    for(unsigned long sp = 0; sp < numbOfSpecies; ++sp){
+        unsigned long newSize = pop_size / numbOfSpecies + (sp < pop_size % numbOfSpecies ? 1 : 0);
+        std::vector<Pathogen> NewSpecies;
+        NewSpecies.reserve(newSize);
+        unsigned int lastIndx = (unsigned int) PathPopulation[sp].size() - 1;
+        for(unsigned long j = 0; j < newSize; ++j){
+            NewSpecies.push_back(PathPopulation[sp][mRandGenArr[0].getRandomFromUniform(0, lastIndx)]);
+        }
+        PathPopulation[sp].swap(NewSpecies);
+    }
+}
+
+/**
+ * @brief Core method. Checks if populations loaded from a snapshot fit the
+ * parameters of the run.
+ *
+ * @param gene_size - number of bits in a MHC gene
+ * @param antigenSize - number of bits in an antigen
+ * @param numb_of_species - number of pathogen species
+ * @return 'false' if they do not (and says why)
+ */
+bool Environment::checkLoadedPopulations(unsigned long gene_size, unsigned long antigenSize, int numb_of_species){
+    for(Host &host : HostPopulation){
+        for(Gene &gene : host.getChromosomeOne()){
+            if(gene.getBitGene().size() != gene_size){
+                std::cout << "Error: host genes in the snapshot have " << gene.getBitGene().size()
+                          << " bits, the run needs " << gene_size << "." << std::endl;
+                return false;
+            }
+        }
+    }
+    if(PathPopulation.size() != (unsigned long) numb_of_species){
+        std::cout << "Error: there are " << PathPopulation.size() << " pathogen species in the snapshot, "
+                  << "the run needs " << numb_of_species << "." << std::endl;
+        return false;
+    }
+    for(auto &species : PathPopulation){
+        for(Pathogen &patho : species){
+            if(patho.getAntigenProt().getBitAntigen().size() != antigenSize){
+                std::cout << "Error: antigens in the snapshot have " << patho.getAntigenProt().getBitAntigen().size()
+                          << " bits, the run needs " << antigenSize << "." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -30,6 +30,23 @@
 #include "Tagging_system.h"
 #include "Host.h"
 #include "Pathogen.h"
+#include "PathoEpitopeIndex.h"
+#include "FitnessPolicies.h"
+#include "AlleleTable.h"
+#include "MemoryUsage.h"
+
+class SnapshotReader;
+
+/**
+ * @brief Per-host numbers that can be exported as a column, see
+ * Environment::appendHostColumn() and Environment::forEachHostValue().
+ */
+enum class HostColumn {
+    PresentedPathogens,  // Host::getNumberOfPresentedPatho()
+    MhcInMother,         // Host::getMotherMhcNumber()
+    MhcInFather,         // Host::getFatherMhcNumber()
+    UniqueMhcs           // Host::getNumbOfUniqMHCgenes()
+};
 
 /**
  * @brief Core class. Stores and handles the environment object that is the 
@@ -46,10 +63,23 @@ private:
     std::vector<std::set<unsigned long>> NoMutsVec;
     Random* mRandGenArr;      //array of random generators: one for each thread
     unsigned int mRandGenArrSize;
+    std::vector<unsigned int> PathoIndxMatrix; // hosts x species, pre-drawn pathogen indices
+    PathoEpitopeIndex EpitopeIndex;           // epitope -> pathogens bit-sets, one per species
+    std::vector<double> HostFitnessCumul;     // running sums of host fitness, the roulette wheel
+    FitnessTable FitnessLUT;                  // size-dependent factors of the fitness function
+    AlleleTable HostAlleles;                  // copies of each MHC allele in the host population
+    void addParentalCopies(const std::vector<int> &chromOneCopies, const std::vector<int> &chromTwoCopies);
+    template <class Policy>
+    void calculateHostsFitnessWith(FitnessFunction fitFun, double alpha, unsigned long maxGene);
+    template <class Policy>
+    double calculateHostsFitnessAndSelectionWeightsWith(FitnessFunction fitFun, double alpha, unsigned long maxGene);
+    template <class Policy>
+    void buildFitnessTable(FitnessFunction fitFun, double alpha, unsigned long maxGene);
 public:
     // === Core methods ===
     explicit Environment(unsigned int numberOfThreads);
-//    Environment(const Environment& orig);
+    Environment(const Environment& orig);
+    Environment& operator=(const Environment& orig);
     virtual ~Environment();
     void seedEnvsRNG();
     void setNoMutsVector(int numb_of_species, unsigned long antigen_size, double fixedAntigenFrac);
@@ -68,15 +98,26 @@ public:
         int numb_of_species, unsigned long mhcSize, int timeStamp, double fixedAntigenFrac,
          Tagging_system &tag);
     void infectOneFromOneSpecHetero();
-    //void infectEveryOne(int simil_mesure);
+    void infectOneFromOneSpecHeteroBatched();
+    void drawPathoIndicesForHosts();
+    void drawPathoIndicesForHosts(unsigned int exposuresPerSpec);
+    void infectWithDrawnPathoIndices();
+    void infectKFromOneSpecHeteroBatched(unsigned int exposuresPerSpec);
+    void infectWithDrawnKPathoIndices(unsigned int exposuresPerSpec);
+    void buildPathoEpitopeIndex();
+    unsigned long getPresentedPathoMask(unsigned long hostIndx, unsigned long spec, bitWordsVec &mask);
+    void infectEveryOne();
+    void calculateHostsFitness(FitnessFunction fitFun, double alpha, unsigned long maxGene);
     void calculateHostsFitnessPerGene();
     void calculateHostsFitnessPlainPresent();
     void calculateHostsFitnessForDrift();
     void calculateHostsFitnessAlphaXsqr(double alpha);
     void calculateHostsFitnessExpScaling(double alpha);
     void calculateHostsFitnessExpScalingUniqAlleles(double alpha);
+    double calculateHostsFitnessAndSelectionWeights(FitnessFunction fitFun, double alpha, unsigned long maxGene);
     void selectAndReprodHostsReplace();
     void selectAndReprodHostsNoMating();
+    void selectAndReprodHostsNoMatingWeighted();
     void selectAndReproducePathoFixedPopSizes();
     void clearHostInfectionsData();
     void clearPathoInfectionData();
@@ -94,6 +135,19 @@ public:
     void matingMeanOptimalNumberMHCsmallSubset(int matingPartnerNumber);
     void matingMaxDifferentNumber(int matingPartnerNumber);
     void matingRandom();
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in, bool restoreRNG);
+    bool writeSnapshot(std::ostream &out, int tayme, bool withHosts, bool withPathogens) const;
+    bool setHostPopulationFromFile(const std::string &fileName, unsigned long gene_size, Tagging_system &tag);
+    bool setPathoPopulationFromFile(const std::string &fileName, unsigned long antigenSize, unsigned long mhcSize,
+                                    Tagging_system &tag);
+    bool setHostPopulationFromSnapshot(const SnapshotReader &snapshot, unsigned long gene_size, Tagging_system &tag);
+    bool setPathoPopulationFromSnapshot(const SnapshotReader &snapshot, unsigned long antigenSize,
+                                        unsigned long mhcSize, Tagging_system &tag);
+    void copyPathoPopulation(const Environment &source);
+    void resizeHostPopulation(int pop_size);
+    void resizePathoPopulation(int pop_size);
+    bool checkLoadedPopulations(unsigned long gene_size, unsigned long antigenSize, int numb_of_species);
 
     // === Data harvesting methods ===
     unsigned long getPathoNumOfSpecies();
@@ -108,12 +162,55 @@ public:
     std::string getNumbersOfMhcInMother();
     std::string getNumbersOfMhcInFather();
     std::string getNumbersOfUniqueMHCs();
+    const std::vector<Host>& getHostPopulationRef() const;
+    const std::vector<std::vector<Pathogen> >& getPathoPopulationRef() const;
     unsigned long getSingleHostGenomeSize(unsigned long indx);
     unsigned long getSingleHostChromoOneSize(unsigned long indx);
     unsigned long getSingleHostChromoTwoSize(unsigned long indx);
     unsigned long getSingleHostRealGeneOne(unsigned long i, unsigned long j);
     unsigned long getSingleHostRealGeneTwo(unsigned long i, unsigned long j);
     double getHostFitness(unsigned long indx);
+    const AlleleTable& getHostAlleles();
+    MemoryUsage getMemoryUsage() const;
+    void appendHostColumn(HostColumn column, std::vector<char> &buffer) const;
+
+    /**
+     * @brief Data harvesting method. Calls a visitor with every host, in
+     * order, without copying them.
+     *
+     * @param visit - callable taking (const Host&)
+     */
+    template <class Visitor>
+    void forEachHost(Visitor &&visit) const {
+        for(const Host &individual : HostPopulation){
+            visit(individual);
+        }
+    }
+
+    /**
+     * @brief Data harvesting method. Calls a visitor with a number of every
+     * host, in order. The column is picked once, not for each host.
+     *
+     * @param column - which number
+     * @param visit - callable taking (unsigned long)
+     */
+    template <class Visitor>
+    void forEachHostValue(HostColumn column, Visitor &&visit) const {
+        switch(column){
+            case HostColumn::PresentedPathogens:
+                forEachHost([&visit](const Host &individual){ visit(individual.getNumberOfPresentedPatho()); });
+                break;
+            case HostColumn::MhcInMother:
+                forEachHost([&visit](const Host &individual){ visit(individual.getMotherMhcNumber()); });
+                break;
+            case HostColumn::MhcInFather:
+                forEachHost([&visit](const Host &individual){ visit(individual.getFatherMhcNumber()); });
+                break;
+            case HostColumn::UniqueMhcs:
+                forEachHost([&visit](const Host &individual){ visit(individual.getNumbOfUniqMHCgenes()); });
+                break;
+        }
+    }
     
 };
 
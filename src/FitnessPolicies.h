@@ -0,0 +1,154 @@
+/*
+ * File:   FitnessPolicies.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef FITNESSPOLICIES_H
+#define	FITNESSPOLICIES_H
+
+#include <cmath>
+#include <vector>
+
+#include "Host.h"
+
+/**
+ * @brief Host fitness functions available at run time. Each one has its
+ * compile-time policy in the FitnessPolicy namespace.
+ */
+enum class FitnessFunction {
+    JustInfection,      // F = P
+    PerGene,            // F = P / N
+    Drift,              // F = 1
+    AlphaXSqr,          // F = P / (alpha N)^2
+    ExpFunc,            // F = P exp[-(alpha N)^2]
+    ExpFuncUniqAlleles  // F = P exp[-(alpha U)^2]
+};
+
+/**
+ * @brief Fitness functions as policies. A fitness is P (pathogens presented)
+ * combined with a factor that depends only on alpha and on a size of the host
+ * genome: the number of genes N or the number of unique alleles U. The factor
+ * is what gets tabulated in FitnessTable, so the transcendental functions are
+ * called once per possible size and not once per host.
+ *
+ * Each policy has:
+ *  - sizeOf(host) - the size the fitness depends on,
+ *  - factor(n, alpha) - the size-dependent factor,
+ *  - fitness(P, n, factor) - the final value; same arithmetic as the
+ *    corresponding Host::calculateFitness*() method, so results are identical.
+ */
+namespace FitnessPolicy {
+
+    struct JustInfection {
+        static unsigned long sizeOf(Host & /*host*/){ return 0; }
+        static double factor(unsigned long /*n*/, double /*alpha*/){ return 1.0; }
+        static double fitness(unsigned presented, unsigned long /*n*/, double /*factor*/){
+            return (double) presented;
+        }
+    };
+
+    struct PerGene {
+        static unsigned long sizeOf(Host &host){ return host.getGenomeSize(); }
+        static double factor(unsigned long n, double /*alpha*/){ return (double) n; }
+        static double fitness(unsigned presented, unsigned long n, double factor){
+            return n ? (double) presented / factor : 0.0;
+        }
+    };
+
+    struct Drift {
+        static unsigned long sizeOf(Host & /*host*/){ return 0; }
+        static double factor(unsigned long /*n*/, double /*alpha*/){ return 1.0; }
+        static double fitness(unsigned /*presented*/, unsigned long /*n*/, double /*factor*/){
+            return 1.0;
+        }
+    };
+
+    struct AlphaXSqr {
+        static unsigned long sizeOf(Host &host){ return host.getGenomeSize(); }
+        static double factor(unsigned long n, double alpha){ return std::pow(alpha * (double) n, 2.0); }
+        static double fitness(unsigned presented, unsigned long n, double factor){
+            return n ? (double) presented / factor : 0.0;
+        }
+    };
+
+    struct ExpFunc {
+        static unsigned long sizeOf(Host &host){ return host.getGenomeSize(); }
+        static double factor(unsigned long n, double alpha){ return std::exp( - std::pow(alpha * (double) n, 2.0)); }
+        static double fitness(unsigned presented, unsigned long n, double factor){
+            return n ? (double) presented * factor : 0.0;
+        }
+    };
+
+    struct ExpFuncUniqAlleles {
+        static unsigned long sizeOf(Host &host){ return host.getNumbOfUniqMHCgenes(); }
+        static double factor(unsigned long n, double alpha){ return std::exp( - std::pow(alpha * (double) n, 2.0)); }
+        static double fitness(unsigned presented, unsigned long n, double factor){
+            return n ? (double) presented * factor : 0.0;
+        }
+    };
+}
+
+/**
+ * @brief Core class. Lookup table of the size-dependent factor of a fitness
+ * policy, one entry for every possible size from 0 to maxSize. Sizes beyond
+ * the table are calculated on the fly.
+ */
+class FitnessTable {
+public:
+    /**
+     * @brief Core method. Fills the table for a policy unless it is already
+     * filled for the same function, alpha and size.
+     *
+     * @param fitFun - fitness function the Policy stands for
+     * @param alpha - scaling parameter of the fitness function
+     * @param maxSize - largest size to tabulate
+     */
+    template <class Policy>
+    void build(FitnessFunction fitFun, double alpha, unsigned long maxSize){
+        if(!Factors.empty() and fitFun == Function and alpha == Alpha and maxSize + 1 == Factors.size())
+            return;
+        Function = fitFun;
+        Alpha = alpha;
+        Factors.resize(maxSize + 1);
+        for(unsigned long n = 0; n <= maxSize; ++n){
+            Factors[n] = Policy::factor(n, alpha);
+        }
+    }
+
+    /**
+     * @brief Core method. Calculates fitness of a host: one gather from the
+     * table and one multiply (or divide).
+     *
+     * @param host - a host with its pathogens presented already counted
+     * @return fitness of the host
+     */
+    template <class Policy>
+    double fitness(Host &host) const {
+        unsigned long n = Policy::sizeOf(host);
+        double factor = n < Factors.size() ? Factors[n] : Policy::factor(n, Alpha);
+        return Policy::fitness(host.NumOfPathogesPresented, n, factor);
+    }
+
+private:
+    FitnessFunction Function = FitnessFunction::JustInfection;
+    double Alpha = 0.0;
+    std::vector<double> Factors;
+};
+
+#endif	/* FITNESSPOLICIES_H */
@@ -25,6 +25,7 @@
 #include "boost/dynamic_bitset.hpp"
 
 #include "Gene.h"
+#include "BinaryIO.h"
 
 typedef boost::dynamic_bitset<> genestring;
 
@@ -237,10 +238,19 @@ genestring Gene::getBitGene(){
  *
  * @return integer representation of a gene.
  */
-unsigned long int Gene::getTheRealGene(){
+unsigned long int Gene::getTheRealGene() const {
     return TheGene;
 }
 
+/**
+ * @brief Core method. Returns the number of bits in the gene.
+ *
+ * @return length of the gene bit-string
+ */
+unsigned long Gene::getBitStringLength() const {
+    return BitStringLength;
+}
+
 /**
  * @brief Auxiliary method useful for debugging. Prints a gene to the screen.
  */
@@ -248,3 +258,32 @@ void Gene::printGeneToScreen(std::string tagLine){
     boost::dynamic_bitset<> bitgene(BitStringLength, TheGene);
     std::cout << bitgene << " :: " << GenesTag << " :: " << tagLine << std::endl;
 }
+
+/**
+ * @brief Core method. Writes the gene with its history to a binary stream
+ * (see BinaryIO).
+ *
+ * @param out - the stream
+ */
+void Gene::writeState(std::ostream &out) const {
+    BinaryIO::write(out, timeOfOrigin);
+    BinaryIO::write(out, TheParentWas);
+    BinaryIO::write(out, GenesTag);
+    BinaryIO::write(out, TheGene);
+    BinaryIO::write(out, BitStringLength);
+    BinaryIO::writeVector(out, ParentTags);
+    BinaryIO::writeVector(out, MutationTime);
+}
+
+/**
+ * @brief Core method. Reads a gene written by writeState().
+ *
+ * @param in - the stream
+ * @return 'false' if the gene could not be read
+ */
+bool Gene::readState(std::istream &in){
+    return BinaryIO::read(in, timeOfOrigin) and BinaryIO::read(in, TheParentWas)
+           and BinaryIO::read(in, GenesTag) and BinaryIO::read(in, TheGene)
+           and BinaryIO::read(in, BitStringLength) and BinaryIO::readVector(in, ParentTags)
+           and BinaryIO::readVector(in, MutationTime);
+}
@@ -56,7 +56,8 @@ public:
     void mutateBitByBitWithRestric(double pm_mut_probabl, int timeStamp,
                                    std::set<unsigned long>& noMutts, Random& randGen, Tagging_system& tag);
     genestring getBitGene();
-    unsigned long int getTheRealGene();
+    unsigned long int getTheRealGene() const;
+    unsigned long getBitStringLength() const;
     // === Data harvesting ===
     int timeOfOrigin;
     int TheParentWas;
@@ -64,6 +65,8 @@ public:
     std::vector<int> MutationTime;
     unsigned long int GenesTag;
     void printGeneToScreen(std::string tagLine);
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in);
 private:
     unsigned long TheGene;
     unsigned long BitStringLength;
@@ -98,3 +98,97 @@ void H2Pinteraction::doesInfectedHeteroOnePerSpec(Host& host, Pathogen& patho){
     patho.NumOfHostsInfected = patho.NumOfHostsInfected + 1;
     host.PathoSpecInfecting.push_back(patho.getSpeciesTag());
 }
+
+
+/**
+ * @brief Core method. Checks if any of the host's MHCs presents the antigen.
+ *
+ * Branch-light version of presentAntigen(): instead of returning on the first
+ * hit it ORs the comparison results over the whole contiguous epitope vector,
+ * so the inner loop can be vectorised by the compiler. MHCs and epitopes are
+ * given as plain long unsigned integers.
+ *
+ * @param hostMHCs - values of the unique MHC alleles of a host
+ * @param antigen - vector of epitopes in a form of long unsigned integers
+ * @return 'true' if at least one MHC presents the antigen, 'false' if none does
+ */
+bool H2Pinteraction::presentAntigenAnyMHC(const longIntVec &hostMHCs, const longIntVec &antigen){
+    const unsigned long *epis = antigen.data();
+    unsigned long episSize = antigen.size();
+    for (unsigned long mhc : hostMHCs) {
+        bool hit = false;
+        for (unsigned long e = 0; e < episSize; ++e) {
+            hit |= (epis[e] == mhc);
+        }
+        if(hit){ return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief Core method. Same as doesInfectedHeteroOnePerSpec() but takes the
+ * values of host's unique MHCs prepared beforehand, so they are gathered only
+ * once per host and not once per pathogen. The pathogen's infection counter is
+ * updated atomically, so many hosts can be evaluated in parallel against the
+ * same pathogen.
+ *
+ * @param host - a Host-class object
+ * @param hostMHCs - values of the unique MHC alleles of that host
+ * @param patho - a Pathogen-class object
+ */
+void H2Pinteraction::doesInfectedHeteroOnePerSpecBatch(Host &host, const longIntVec &hostMHCs, Pathogen &patho){
+    int species = patho.getSpeciesTag();
+    for (int w : host.PathoSpecInfecting) {
+        // Making sure a pathogen species infects only ones
+        if(w == species) return;
+    }
+    if(presentAntigenAnyMHC(hostMHCs, patho.getEpitopesRef())){
+        // the pathogen gets presented, the host evades infection:
+        host.NumOfPathogesPresented = host.NumOfPathogesPresented + 1;
+        host.PathogesPresented.push_back(species);
+        return;
+    }
+    // The host gets infected:
+    host.NumOfPathogesInfecting = host.NumOfPathogesInfecting + 1;
+    #pragma omp atomic
+    patho.NumOfHostsInfected += 1;
+    host.PathoSpecInfecting.push_back(species);
+}
+
+/**
+ * @brief Core method. Checks which of a batch of antigens are presented by a
+ * host, in one pass over the host's MHCs.
+ *
+ * For each MHC allele all the antigens not yet presented are searched, so
+ * every allele is loaded only once for the whole batch. Heterozygote advantage
+ * as in presentAntigenAnyMHC().
+ *
+ * @param hostMHCs - values of the unique MHC alleles of a host
+ * @param antigens - pointers to epitope vectors of the pathogens in the batch
+ * @param presented - output flags, one per antigen: 1 if presented, 0 if not
+ * @return number of presented antigens
+ */
+unsigned long H2Pinteraction::presentAntigensManyPatho(const longIntVec &hostMHCs,
+                                                       const std::vector<const longIntVec*> &antigens,
+                                                       std::vector<char> &presented){
+    unsigned long antigensSize = antigens.size();
+    unsigned long numPresented = 0;
+    presented.assign(antigensSize, 0);
+    for (unsigned long mhc : hostMHCs) {
+        for (unsigned long q = 0; q < antigensSize; ++q) {
+            if(presented[q]) continue;
+            const unsigned long *epis = antigens[q]->data();
+            unsigned long episSize = antigens[q]->size();
+            bool hit = false;
+            for (unsigned long e = 0; e < episSize; ++e) {
+                hit |= (epis[e] == mhc);
+            }
+            if(hit){
+                presented[q] = 1;
+                ++numPresented;
+            }
+        }
+        if(numPresented == antigensSize) break;
+    }
+    return numPresented;
+}
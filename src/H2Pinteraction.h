@@ -40,6 +40,11 @@ public:
     virtual ~H2Pinteraction();
     bool presentAntigen(unsigned long int hostgen, longIntVec antigen);
     void doesInfectedHeteroOnePerSpec(Host &host, Pathogen &patho);
+    bool presentAntigenAnyMHC(const longIntVec &hostMHCs, const longIntVec &antigen);
+    void doesInfectedHeteroOnePerSpecBatch(Host &host, const longIntVec &hostMHCs, Pathogen &patho);
+    unsigned long presentAntigensManyPatho(const longIntVec &hostMHCs,
+                                           const std::vector<const longIntVec*> &antigens,
+                                           std::vector<char> &presented);
 };
 
 #endif	/* H2PINTERACTION_H */
@@ -0,0 +1,164 @@
+/*
+ * File:   HardwareCounters.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "HardwareCounters.h"
+
+namespace {
+
+    const char* const CounterNames[NumbOfHwCounters] = {
+        "cycles", "instructions", "llc_misses", "branch_misses"
+    };
+
+#ifdef __linux__
+    const uint64_t CounterConfigs[NumbOfHwCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    int openCounter(uint64_t config, long threadId){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int) syscall(SYS_perf_event_open, &attr, (pid_t) threadId, -1, -1, 0);
+    }
+#endif
+}
+
+/**
+ * @brief Data harvesting method. Name of a counter as it is written to
+ * PerfReport.json.
+ */
+const char* getHwCounterName(HwCounter counter){
+    return CounterNames[(int) counter];
+}
+
+/**
+ * @brief Data harvesting method. Constructor. Nothing is counted until open().
+ */
+HardwareCounters::HardwareCounters() : NumbOfThreads(0) {
+}
+
+HardwareCounters::~HardwareCounters(){
+    close();
+}
+
+/**
+ * @brief Data harvesting method. Opens and starts the counters of given
+ * threads.
+ *
+ * @param threadIds - kernel thread ids (gettid()), by OpenMP thread number
+ * @return 'false' if no counter could be opened (see getError())
+ */
+bool HardwareCounters::open(const std::vector<long> &threadIds){
+    close();
+    NumbOfThreads = threadIds.size();
+    Fds.assign(NumbOfThreads * NumbOfHwCounters, -1);
+    bool anyOpen = false;
+#ifdef __linux__
+    for(std::size_t t = 0; t < NumbOfThreads; ++t){
+        for(int c = 0; c < NumbOfHwCounters; ++c){
+            int fd = openCounter(CounterConfigs[c], threadIds[t]);
+            if(fd < 0){
+                if(Error.empty())
+                    Error = std::string(CounterNames[c]) + ": " + std::strerror(errno);
+                continue;
+            }
+            Fds[t * NumbOfHwCounters + c] = fd;
+            anyOpen = true;
+        }
+    }
+#else
+    Error = "hardware counters are read with perf_event_open, which only Linux has";
+#endif
+    return anyOpen;
+}
+
+/**
+ * @brief Data harvesting method. Closes all the counters.
+ */
+void HardwareCounters::close(){
+    for(int fd : Fds){
+        if(fd >= 0)
+            ::close(fd);
+    }
+    Fds.clear();
+    NumbOfThreads = 0;
+    Error.clear();
+}
+
+/**
+ * @brief Data harvesting method. Is a counter counted (on all the threads)?
+ */
+bool HardwareCounters::isCounting(HwCounter counter) const {
+    if(NumbOfThreads == 0)
+        return false;
+    for(std::size_t t = 0; t < NumbOfThreads; ++t){
+        if(Fds[t * NumbOfHwCounters + (int) counter] < 0)
+            return false;
+    }
+    return true;
+}
+
+std::size_t HardwareCounters::getNumbOfThreads() const {
+    return NumbOfThreads;
+}
+
+/**
+ * @brief Data harvesting method. Reads all the counters, scaled for
+ * multiplexing. A counter that is not counting reads as 0.
+ *
+ * @param values - the counts, [thread * NumbOfHwCounters + counter]
+ */
+void HardwareCounters::read(std::vector<uint64_t> &values) const {
+    values.assign(Fds.size(), 0);
+    for(std::size_t i = 0; i < Fds.size(); ++i){
+        uint64_t count[3];  // value, time enabled, time running
+        if(Fds[i] < 0 or ::read(Fds[i], count, sizeof(count)) != (ssize_t) sizeof(count))
+            continue;
+        if(count[2] > 0 and count[2] < count[1])
+            values[i] = (uint64_t) ((double) count[0] * count[1] / count[2]);
+        else
+            values[i] = count[0];
+    }
+}
+
+/**
+ * @brief Data harvesting method. Why a counter could not be opened.
+ *
+ * @return the first error met, empty if all the counters were opened
+ */
+const std::string& HardwareCounters::getError() const {
+    return Error;
+}
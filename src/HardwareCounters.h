@@ -0,0 +1,74 @@
+/*
+ * File:   HardwareCounters.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef HARDWARECOUNTERS_H
+#define	HARDWARECOUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Hardware events counted by HardwareCounters.
+ */
+enum class HwCounter {
+    Cycles,
+    Instructions,
+    LlcMisses,           // last level cache misses
+    BranchMisses
+};
+
+const int NumbOfHwCounters = 4;
+
+const char* getHwCounterName(HwCounter counter);
+
+/**
+ * @brief Data harvesting class. Hardware performance counters (perf_event_open,
+ * Linux only) of a set of threads: cycles, instructions, last level cache
+ * misses and branch mispredictions, user space only. Each counter of each
+ * thread is opened on its own, so a counter the processor (or the virtual
+ * machine) does not have is left out and the others still count. When the
+ * kernel multiplexes the counters, the values are scaled by the time each one
+ * was running.
+ *
+ * Counters follow their thread wherever it runs and can be read from any
+ * thread of the process, so the simulation thread reads the counters of all
+ * its OpenMP threads between parallel regions.
+ */
+class HardwareCounters {
+public:
+    HardwareCounters();
+    virtual ~HardwareCounters();
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+    bool open(const std::vector<long> &threadIds);
+    void close();
+    bool isCounting(HwCounter counter) const;
+    std::size_t getNumbOfThreads() const;
+    void read(std::vector<uint64_t> &values) const;
+    const std::string& getError() const;
+private:
+    std::vector<int> Fds;            // [thread * NumbOfHwCounters + counter], -1 - not counting
+    std::size_t NumbOfThreads;
+    std::string Error;               // why a counter could not be opened, empty if all were
+};
+
+#endif	/* HARDWARECOUNTERS_H */
@@ -21,12 +21,15 @@
  */
 
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
 #include "boost/dynamic_bitset.hpp"
 
 #include "Host.h"
+#include "BinaryIO.h"
+#include "TextFormat.h"
 
 typedef boost::dynamic_bitset<> genestring;
 typedef std::vector<Gene> chromovector;
@@ -146,29 +149,49 @@ void Host::chromoMutProcess(double mut_probabl, int timeStamp, Random& randGen,
  * @param timeStamp - current time (current number of the model iteration)
  * @param randGen - pointer to random number generator
  * @param tag - pointer to the tagging system
+ * @param deltas - if given, changes of allele copy numbers are added to it
  */
 void Host::chromoMutProcessWithDelDupl(double mut_probabl, double del, 
-        double dupli, unsigned long maxGene, int timeStamp, Random& randGen, Tagging_system& tag){
+        double dupli, unsigned long maxGene, int timeStamp, Random& randGen, Tagging_system& tag,
+        alleleDeltas *deltas){
     if(!ChromosomeOne.empty()){
         for(int i = (int) (ChromosomeOne.size() - 1); i >= 0; --i){
+            unsigned long before = ChromosomeOne[i].getTheRealGene();
             ChromosomeOne[i].mutateGeneWhole(mut_probabl, timeStamp, randGen, tag);
+            if(deltas and ChromosomeOne[i].getTheRealGene() != before){
+                deltas->emplace_back(before, -1);
+                deltas->emplace_back(ChromosomeOne[i].getTheRealGene(), 1);
+            }
             if(!ChromosomeOne.empty() and ChromosomeOne.size() < maxGene
                     and randGen.getUni() < dupli){
                 ChromosomeOne.push_back(ChromosomeOne[i]);
+                if(deltas)
+                    deltas->emplace_back(ChromosomeOne[i].getTheRealGene(), 1);
             }
             if(ChromosomeOne.size() > 1 and randGen.getUni() < del){
+                if(deltas)
+                    deltas->emplace_back(ChromosomeOne[i].getTheRealGene(), -1);
                 ChromosomeOne.erase(ChromosomeOne.begin() + i);
             }
         }
     }
     if(!ChromosomeTwo.empty()){
         for(int i = (int) (ChromosomeTwo.size() - 1); i >= 0; --i){
+            unsigned long before = ChromosomeTwo[i].getTheRealGene();
             ChromosomeTwo[i].mutateGeneWhole(mut_probabl, timeStamp, randGen, tag);
+            if(deltas and ChromosomeTwo[i].getTheRealGene() != before){
+                deltas->emplace_back(before, -1);
+                deltas->emplace_back(ChromosomeTwo[i].getTheRealGene(), 1);
+            }
             if(!ChromosomeTwo.empty() and ChromosomeTwo.size() < maxGene
                     and randGen.getUni() < dupli){
                 ChromosomeTwo.push_back(ChromosomeTwo[i]);
+                if(deltas)
+                    deltas->emplace_back(ChromosomeTwo[i].getTheRealGene(), 1);
             }
             if(ChromosomeTwo.size() > 1 and randGen.getUni() < del){
+                if(deltas)
+                    deltas->emplace_back(ChromosomeTwo[i].getTheRealGene(), -1);
                 ChromosomeTwo.erase(ChromosomeTwo.begin() + i);
             }
         }
@@ -195,30 +218,50 @@ void Host::chromoMutProcessWithDelDupl(double mut_probabl, double del,
  * @param timeStamp - current time (current number of the model iteration)
  * @param randGen - pointer to random number generator
  * @param tag - pointer to the tagging system
+ * @param deltas - if given, changes of allele copy numbers are added to it
  */
 void Host::chromoMutProcessWithDelDuplPointMuts(double pm_mut_probabl,
         double del, double dupli, unsigned long maxGene, int timeStamp,
-        Random& randGen, Tagging_system& tag){
+        Random& randGen, Tagging_system& tag,
+        alleleDeltas *deltas){
     if(!ChromosomeOne.empty()){
         for(int i = (int) ChromosomeOne.size() - 1; i >= 0; --i){
+            unsigned long before = ChromosomeOne[i].getTheRealGene();
             ChromosomeOne[i].mutateGeneBitByBit(pm_mut_probabl, timeStamp, randGen, tag);
+            if(deltas and ChromosomeOne[i].getTheRealGene() != before){
+                deltas->emplace_back(before, -1);
+                deltas->emplace_back(ChromosomeOne[i].getTheRealGene(), 1);
+            }
             if(!ChromosomeOne.empty() and ChromosomeOne.size() < maxGene
                     and randGen.getUni() < dupli){
                 ChromosomeOne.push_back(ChromosomeOne[i]);
+                if(deltas)
+                    deltas->emplace_back(ChromosomeOne[i].getTheRealGene(), 1);
             }
             if(ChromosomeOne.size() > 1 and randGen.getUni() < del){
+                if(deltas)
+                    deltas->emplace_back(ChromosomeOne[i].getTheRealGene(), -1);
                 ChromosomeOne.erase(ChromosomeOne.begin() + i);
             }
         }
     }
     if(!ChromosomeTwo.empty()){
         for(int i = (int) ChromosomeTwo.size() - 1; i >= 0; --i){
+            unsigned long before = ChromosomeTwo[i].getTheRealGene();
             ChromosomeTwo[i].mutateGeneBitByBit(pm_mut_probabl, timeStamp, randGen, tag);
+            if(deltas and ChromosomeTwo[i].getTheRealGene() != before){
+                deltas->emplace_back(before, -1);
+                deltas->emplace_back(ChromosomeTwo[i].getTheRealGene(), 1);
+            }
             if(!ChromosomeTwo.empty() and ChromosomeTwo.size() < maxGene
                     and randGen.getUni() < dupli){
                 ChromosomeTwo.push_back(ChromosomeTwo[i]);
+                if(deltas)
+                    deltas->emplace_back(ChromosomeTwo[i].getTheRealGene(), 1);
             }
             if(ChromosomeTwo.size() > 1 and randGen.getUni() < del){
+                if(deltas)
+                    deltas->emplace_back(ChromosomeTwo[i].getTheRealGene(), -1);
                 ChromosomeTwo.erase(ChromosomeTwo.begin() + i);
             }
         }
@@ -500,6 +543,24 @@ chromovector Host::getChromosomeTwo(){
     return ChromosomeTwo;
 }
 
+/**
+ * @brief Core method. Returns the first chromosome without copying it.
+ *
+ * @return read-only reference to Chromosome One
+ */
+const chromovector& Host::getChromosomeOneRef() const {
+    return ChromosomeOne;
+}
+
+/**
+ * @brief Core method. Returns the second chromosome without copying it.
+ *
+ * @return read-only reference to Chromosome Two
+ */
+const chromovector& Host::getChromosomeTwoRef() const {
+    return ChromosomeTwo;
+}
+
 /**
  * @brief Data harvesting method. Merges both chromosomes to create an object
  * easier to handle is some situations.
@@ -523,6 +584,16 @@ chromovector Host::getUniqueMHCs() {
     return UniqueAlleles;
 }
 
+/**
+ * @brief Core method. Returns unique MHC alleles from the host without copying
+ * them. Use it in hot loops where getUniqueMHCs() would copy the whole vector.
+ *
+ * @return read-only reference to the chromosome-like vector of the unique MHC alleles.
+ */
+const chromovector& Host::getUniqueMHCsRef() const {
+    return UniqueAlleles;
+}
+
 /**
  * @brief Core method. Assigns a new chromosome to host's Chromosome ONE.
  * 
@@ -680,7 +751,7 @@ void Host::calculateFitnessExpFuncUniqAlleles(double alpha){
  *
  * @return number of presented pathogen species
  */
-unsigned Host::getNumberOfPresentedPatho() {
+unsigned Host::getNumberOfPresentedPatho() const {
     return NumOfPathogesPresented;
 }
 
@@ -694,6 +765,15 @@ double Host::getFitness(){
     return Fitness;
 }
 
+/**
+ * @brief Core method. Sets host's fitness calculated elsewhere (see FitnessTable).
+ *
+ * @param fitness - new value of host's fitness
+ */
+void Host::setFitness(double fitness){
+    Fitness = fitness;
+}
+
 /**
  * @brief Core method. Zeroes all data regarding infections and fitness.
  */
@@ -717,6 +797,99 @@ void Host::setFatherMhcNumber(unsigned long int theMhcNumber) {
 }
 
 
+namespace {
+    // most characters a gene line takes, see writeGeneLine()
+    std::size_t geneLineSize(const Gene &gene){
+        return std::max(gene.getBitStringLength(), 64ul) + 16
+                + (gene.ParentTags.size() + 1) * 2 * (TextFormat::MaxDigits + 2);
+    }
+
+    template <std::size_t N>
+    char* writeGeneLine(char *p, const Gene &gene, const char (&chromoName)[N]){
+        p = TextFormat::writeBits(p, gene.getTheRealGene(), gene.getBitStringLength());
+        p = TextFormat::writeText(p, chromoName);
+        p = TextFormat::write(p, gene.timeOfOrigin);
+        *p++ = '\t';
+        p = TextFormat::write(p, gene.GenesTag);
+        if (!gene.ParentTags.empty()){
+            for (std::size_t j = 0; j < gene.ParentTags.size(); ++j){
+                *p++ = '\t';
+                p = TextFormat::write(p, gene.MutationTime[j]);
+                *p++ = '\t';
+                p = TextFormat::write(p, gene.ParentTags[j]);
+            }
+            *p++ = '\n';
+        } else {
+            p = TextFormat::writeText(p, "\t-1\n");
+        }
+        return p;
+    }
+}
+
+/**
+ * @brief Data harvesting method. Appends the host's infection line and the
+ * lines of a set of its genes to a text buffer.
+ *
+ * @param text - the buffer
+ * @param genes - the genes to write
+ * @param chromoName - name of the set with the tabs around it, e.g. "\tch_one\t"
+ */
+template <std::size_t N>
+void Host::appendGenesText(std::vector<char> &text, const chromovector &genes, const char (&chromoName)[N]) const {
+    std::size_t bound = 96 + (PathogesPresented.size() + 2) * (TextFormat::MaxDigits + 2);
+    for(const Gene &gene : genes){
+        bound += geneLineSize(gene);
+    }
+    std::size_t used = text.size();
+    text.resize(used + bound);
+    char *p = text.data() + used;
+    p = TextFormat::writeText(p, " === Host has ");
+    p = TextFormat::write(p, NumOfPathogesInfecting);
+    p = TextFormat::writeText(p, " parasites and presented ");
+    p = TextFormat::write(p, NumOfPathogesPresented);
+    p = TextFormat::writeText(p, " - these are: ");
+    for(int presented : PathogesPresented){
+        p = TextFormat::write(p, presented);
+        *p++ = ' ';
+    }
+    p = TextFormat::writeText(p, "===\n");
+    for(const Gene &gene : genes){
+        p = writeGeneLine(p, gene, chromoName);
+    }
+    text.resize(p - text.data());
+}
+
+/**
+ * @brief Data harvesting method. Appends the host's genome to a text buffer,
+ * in the same format as Host::stringChromosomes() gives it.
+ *
+ * @param text - the buffer
+ */
+void Host::appendChromosomes(std::vector<char> &text) const {
+    appendGenesText(text, ChromosomeOne, "\tch_one\t");
+    std::size_t used = text.size();
+    std::size_t bound = 0;
+    for(const Gene &gene : ChromosomeTwo){
+        bound += geneLineSize(gene);
+    }
+    text.resize(used + bound);
+    char *p = text.data() + used;
+    for(const Gene &gene : ChromosomeTwo){
+        p = writeGeneLine(p, gene, "\tch_two\t");
+    }
+    text.resize(p - text.data());
+}
+
+/**
+ * @brief Data harvesting method. Appends the host's unique MHC genes to a text
+ * buffer, in the same format as Host::stringUniqMHCs() gives them.
+ *
+ * @param text - the buffer
+ */
+void Host::appendUniqMHCs(std::vector<char> &text) const {
+    appendGenesText(text, UniqueAlleles, "\tunique\t");
+}
+
 /**
  * @brief Data harvesting method. Gives a host's genome in a human-readable 
  * format. With all the gene specs.
@@ -724,52 +897,10 @@ void Host::setFatherMhcNumber(unsigned long int theMhcNumber) {
  * @return a STL string containing the host's genome and its annotations in
  *  a human-readable format.
  */
- std::string Host::stringChromosomes(){
-    std::string pathoSppString = sttr(" ");
-    unsigned long PathogesPresentedSize = PathogesPresented.size();
-    for(unsigned long ll = 0; ll < PathogesPresentedSize; ++ll){
-        pathoSppString += std::to_string(PathogesPresented[ll]) + sttr(" ");
-    }
-    std::string outString;
-    outString = sttr(" === Host has ") +  std::to_string(NumOfPathogesInfecting) +
-        sttr(" parasites and presented ") + std::to_string(NumOfPathogesPresented) +
-        sttr(" - these are:") + pathoSppString + sttr("===\n");
-    sttr g1;
-    sttr g2;
-    unsigned long ChromosomeOneSize = ChromosomeOne.size();
-    for(unsigned long i = 0; i < ChromosomeOneSize; ++i){
-        boost::to_string(ChromosomeOne[i].getBitGene(), g1);
-        outString += sttr(g1) + sttr("\tch_one\t") 
-                   + std::to_string(ChromosomeOne[i].timeOfOrigin) + sttr("\t")
-                   + std::to_string(ChromosomeOne[i].GenesTag);
-        if (!ChromosomeOne[i].ParentTags.empty()){
-            for (int j = 0; j < ChromosomeOne[i].ParentTags.size(); ++j){
-                outString += sttr("\t") + std::to_string(ChromosomeOne[i].MutationTime[j])
-                        + sttr("\t") + std::to_string(ChromosomeOne[i].ParentTags[j]);
-            }
-            outString += sttr("\n");
-        } else {
-            outString += sttr("\t-1\n");
-        }
-    }
-//    outString += sttr("-----\n");
-    unsigned long ChromosomeTwoSize = ChromosomeTwo.size();
-    for(unsigned long k = 0; k < ChromosomeTwoSize; ++k){
-        boost::to_string(ChromosomeTwo[k].getBitGene(), g2);
-        outString += sttr(g2) + sttr("\tch_two\t") 
-                   + std::to_string(ChromosomeTwo[k].timeOfOrigin) + sttr("\t")
-                   + std::to_string(ChromosomeTwo[k].GenesTag);
-        if (!ChromosomeTwo[k].ParentTags.empty()){
-            for (unsigned long l = 0; l < ChromosomeTwo[k].ParentTags.size(); ++l){
-                outString += sttr("\t") + std::to_string(ChromosomeTwo[k].MutationTime[l])
-                        + sttr("\t") + std::to_string(ChromosomeTwo[k].ParentTags[l]);
-            }
-            outString += sttr("\n");
-        } else {
-            outString += sttr("\t-1\n");
-        }       
-    } 
-    return outString;
+std::string Host::stringChromosomes(){
+    std::vector<char> text;
+    appendChromosomes(text);
+    return std::string(text.begin(), text.end());
 }
 
 /**
@@ -777,7 +908,7 @@ void Host::setFatherMhcNumber(unsigned long int theMhcNumber) {
  *
  * @return number of unique MHC genes in individual host's genome.
  */
-unsigned long Host::getNumbOfUniqMHCgenes() {
+unsigned long Host::getNumbOfUniqMHCgenes() const {
     return UniqueAlleles.size();
 }
 
@@ -800,40 +931,71 @@ unsigned long Host::getUniqueMhcSize() {
  * a human-readable format.
  */
 std::string Host::stringUniqMHCs() {
-    std::string pathoSppString = sttr(" ");
-    unsigned long PathogesPresentedSize = PathogesPresented.size();
-    for(unsigned long ll = 0; ll < PathogesPresentedSize; ++ll){
-        pathoSppString += std::to_string(PathogesPresented[ll]) + sttr(" ");
-    }
-    std::string outString;
-    outString = sttr(" === Host has ") +  std::to_string(NumOfPathogesInfecting) +
-                sttr(" parasites and presented ") + std::to_string(NumOfPathogesPresented) +
-                sttr(" - these are:") + pathoSppString + sttr("===\n");
-    sttr g1;
-    unsigned long uniqMHCsize = UniqueAlleles.size();
-    for(unsigned long i = 0; i < uniqMHCsize; ++i){
-        boost::to_string(UniqueAlleles[i].getBitGene(), g1);
-        outString += sttr(g1) + sttr("\tunique\t")
-                     + std::to_string(UniqueAlleles[i].timeOfOrigin) + sttr("\t")
-                     + std::to_string(UniqueAlleles[i].GenesTag);
-        if (!UniqueAlleles[i].ParentTags.empty()){
-            for (int j = 0; j < UniqueAlleles[i].ParentTags.size(); ++j){
-                outString += sttr("\t") + std::to_string(UniqueAlleles[i].MutationTime[j])
-                             + sttr("\t") + std::to_string(UniqueAlleles[i].ParentTags[j]);
-            }
-            outString += sttr("\n");
-        } else {
-            outString += sttr("\t-1\n");
-        }
-    }
-    return outString;
+    std::vector<char> text;
+    appendUniqMHCs(text);
+    return std::string(text.begin(), text.end());
 }
 
 
-unsigned long int Host::getMotherMhcNumber() {
+unsigned long int Host::getMotherMhcNumber() const {
     return MotherMhcNumber;
 }
 
-unsigned long int Host::getFatherMhcNumber() {
+unsigned long int Host::getFatherMhcNumber() const {
     return FatherMhcNumber;
 }
+
+namespace {
+    void writeChromosome(std::ostream &out, const chromovector &chromo){
+        BinaryIO::write(out, (uint64_t) chromo.size());
+        for(const Gene &gene : chromo)
+            gene.writeState(out);
+    }
+
+    bool readChromosome(std::istream &in, chromovector &chromo){
+        uint64_t size;
+        if(!BinaryIO::read(in, size) or size > BinaryIO::MaxLength)
+            return false;
+        chromo.resize(size);
+        for(Gene &gene : chromo){
+            if(!gene.readState(in))
+                return false;
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief Core method. Writes the host (both chromosomes, unique alleles,
+ * infections, fitness) to a binary stream (see BinaryIO).
+ *
+ * @param out - the stream
+ */
+void Host::writeState(std::ostream &out) const {
+    writeChromosome(out, ChromosomeOne);
+    writeChromosome(out, ChromosomeTwo);
+    writeChromosome(out, UniqueAlleles);
+    BinaryIO::writeVector(out, PathoSpecInfecting);
+    BinaryIO::writeVector(out, PathogesPresented);
+    BinaryIO::write(out, NumOfPathogesInfecting);
+    BinaryIO::write(out, NumOfPathogesPresented);
+    BinaryIO::write(out, SelectedForReproduction);
+    BinaryIO::write(out, Fitness);
+    BinaryIO::write(out, MotherMhcNumber);
+    BinaryIO::write(out, FatherMhcNumber);
+}
+
+/**
+ * @brief Core method. Reads a host written by writeState().
+ *
+ * @param in - the stream
+ * @return 'false' if the host could not be read
+ */
+bool Host::readState(std::istream &in){
+    return readChromosome(in, ChromosomeOne) and readChromosome(in, ChromosomeTwo)
+           and readChromosome(in, UniqueAlleles) and BinaryIO::readVector(in, PathoSpecInfecting)
+           and BinaryIO::readVector(in, PathogesPresented) and BinaryIO::read(in, NumOfPathogesInfecting)
+           and BinaryIO::read(in, NumOfPathogesPresented) and BinaryIO::read(in, SelectedForReproduction)
+           and BinaryIO::read(in, Fitness) and BinaryIO::read(in, MotherMhcNumber)
+           and BinaryIO::read(in, FatherMhcNumber);
+}
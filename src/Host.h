@@ -24,6 +24,7 @@
 
 #include <cstdlib>
 #include <string>
+#include <utility>
 #include <vector>
 #include "boost/dynamic_bitset.hpp"
 
@@ -33,6 +34,7 @@
 
 typedef boost::dynamic_bitset<> genestring;
 typedef std::vector<Gene> chromovector;
+typedef std::vector<std::pair<unsigned long, long> > alleleDeltas;  // allele and change of its copy number
 
 /**
  * @brief Core class. Stores and handles a single host object. Each host
@@ -58,21 +60,26 @@ public:
                            Random& randGen, Tagging_system& tag);
     void chromoMutProcess(double mut_probabl, int timeStamp, Random& randGen, Tagging_system& tag);
     void chromoMutProcessWithDelDupl(double mut_probabl, double del,
-        double dupli, unsigned long maxGene, int timeStamp, Random& randGen, Tagging_system& tag);
+        double dupli, unsigned long maxGene, int timeStamp, Random& randGen, Tagging_system& tag,
+        alleleDeltas *deltas = nullptr);
     void chromoMutProcessWithDelDuplPointMuts(double mut_probabl, double del,
-        double dupli, unsigned long maxGene, int timeStamp, Random& randGen, Tagging_system& tag);
+        double dupli, unsigned long maxGene, int timeStamp, Random& randGen, Tagging_system& tag,
+        alleleDeltas *deltas = nullptr);
     void chromoRecombination(double recomb_prob, Random& randGen);
     void clearInfections();
     chromovector doCrossAndMeiosis(double corssing_prob, Random& randGen);
     chromovector getChromosomeOne();
     chromovector getChromosomeTwo();
+    const chromovector& getChromosomeOneRef() const;
+    const chromovector& getChromosomeTwoRef() const;
     chromovector mergeChromosomes();
     chromovector getUniqueMHCs();
+    const chromovector& getUniqueMHCsRef() const;
     unsigned long getGenomeSize();
     unsigned long getChromoOneSize();
     unsigned long getChromoTwoSize();
     unsigned long getUniqueMhcSize();
-    unsigned long getNumbOfUniqMHCgenes();
+    unsigned long getNumbOfUniqMHCgenes() const;
     double getNumbOfChromoOneUniqAlleles();
     double getNumbOfChromoTwoUniqAlleles();
     void assignChromOne(chromovector One);
@@ -92,18 +99,23 @@ public:
     void calculateFitnessExpFunc(double alpha);
     void calculateFitnessExpFuncUniqAlleles(double alpha);
     double getFitness();
+    void setFitness(double fitness);
     void setMotherMhcNumber(unsigned long int theMhcNumber);
     void setFatherMhcNumber(unsigned long int theMhcNumber);
     // === Data harvesting methods ===
     std::string stringChromosomes();
     std::string stringUniqMHCs();
+    void appendChromosomes(std::vector<char> &text) const;
+    void appendUniqMHCs(std::vector<char> &text) const;
     unsigned long int getOneGeneFromOne(unsigned long indx);
     unsigned long int getOneGeneFromTwo(unsigned long indx);
     unsigned long int getOneGeneFromUniqVect(unsigned long indx);
-    unsigned getNumberOfPresentedPatho();
-    unsigned long int getMotherMhcNumber();
-    unsigned long int getFatherMhcNumber();
+    unsigned getNumberOfPresentedPatho() const;
+    unsigned long int getMotherMhcNumber() const;
+    unsigned long int getFatherMhcNumber() const;
     void printGenes(std::string aTag);
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in);
 private:
     // === Very core methods ===
     std::vector<Gene> ChromosomeOne;
@@ -112,6 +124,8 @@ private:
     double Fitness;
     unsigned long int MotherMhcNumber;
     unsigned long int FatherMhcNumber;
+    template <std::size_t N>
+    void appendGenesText(std::vector<char> &text, const chromovector &genes, const char (&chromoName)[N]) const;
 };
 
 #endif	/* HOST_H */
@@ -0,0 +1,61 @@
+/*
+ * File:   MemoryUsage.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "MemoryUsage.h"
+
+/**
+ * @brief Data harvesting method. Constructor. All parts at zero.
+ */
+MemoryUsage::MemoryUsage(){
+    for(int c = 0; c < NumbOfMemoryComponents; ++c){
+        Bytes[c] = 0;
+    }
+}
+
+/**
+ * @brief Data harvesting method. Reads the current resident set size (from
+ * /proc/self/statm) and the peak one (getrusage()) of the process. What cannot
+ * be read stays 0.
+ */
+void MemoryUsage::readRss(){
+    std::ifstream statm("/proc/self/statm");
+    uint64_t totalPages, residentPages;
+    if(statm >> totalPages >> residentPages)
+        (*this)[MemoryComponent::CurrentRss] = residentPages * (uint64_t) sysconf(_SC_PAGESIZE);
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        (*this)[MemoryComponent::PeakRss] = (uint64_t) usage.ru_maxrss * 1024;  // kilobytes on Linux
+    // the kernel updates the peak lazily, it may lag behind the current size
+    if((*this)[MemoryComponent::PeakRss] < (*this)[MemoryComponent::CurrentRss])
+        (*this)[MemoryComponent::PeakRss] = (*this)[MemoryComponent::CurrentRss];
+}
+
+/**
+ * @brief Data harvesting method. The parts in the order of MemoryComponent.
+ */
+std::vector<uint64_t> MemoryUsage::toVector() const {
+    return std::vector<uint64_t>(Bytes, Bytes + NumbOfMemoryComponents);
+}
@@ -0,0 +1,99 @@
+/*
+ * File:   MemoryUsage.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef MEMORYUSAGE_H
+#define	MEMORYUSAGE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <boost/dynamic_bitset.hpp>
+
+/**
+ * @brief Parts of the memory of a simulation, as accounted by MemoryUsage.
+ */
+enum class MemoryComponent {
+    HostChromosomes,     // host objects and the genes of both chromosomes
+    HostUniqueAlleles,   // the unique MHC alleles kept by each host
+    HostLineage,         // mutation times and parental tags of host genes
+    HostInfections,      // lists of infecting and presented pathogens of each host
+    PathoAntigens,       // pathogen objects, antigen bit-strings and no-mutation sites
+    PathoEpitopes,       // epitopes cut from the antigens
+    PathoLineage,        // mutation times and parental tags of antigens
+    AlleleCounts,        // copies of each MHC allele (AlleleTable)
+    Buffers,             // pre-drawn pathogens, epitope index, roulette wheel, random number generators;
+                         // not the new generation of selection and mating, which lives within them
+    CurrentRss,          // resident set size of the process
+    PeakRss              // the largest resident set size of the process so far
+};
+
+const int NumbOfMemoryComponents = 11;
+
+/**
+ * @brief Header of MemoryUsage.csv: time and the components, in bytes.
+ */
+const char* const MemoryUsageHeader = "#time host_chromosomes host_unique_alleles host_lineage host_infections "
+                                      "patho_antigens patho_epitopes patho_lineage allele_counts buffers "
+                                      "current_rss peak_rss";
+
+/**
+ * @brief Data harvesting class. Bytes held by each part of a simulation and the
+ * resident set size of the process. Heap parts count the capacity of the
+ * containers, not what the allocator adds to them; the resident set size is
+ * the real footprint (of the whole process, so of all the simulations of a
+ * sweep), transient copies of the population made during selection and mating
+ * included.
+ */
+struct MemoryUsage {
+    uint64_t Bytes[NumbOfMemoryComponents];
+    MemoryUsage();
+    uint64_t& operator[](MemoryComponent component){ return Bytes[(int) component]; }
+    uint64_t operator[](MemoryComponent component) const { return Bytes[(int) component]; }
+    void readRss();
+    std::vector<uint64_t> toVector() const;
+};
+
+/**
+ * @brief Heap bytes of containers, for the memory accounting.
+ */
+namespace MemoryAccounting {
+
+    template <class T>
+    inline uint64_t heapBytes(const std::vector<T> &vec){
+        return vec.capacity() * sizeof(T);
+    }
+
+    inline uint64_t heapBytes(const boost::dynamic_bitset<> &bits){
+        return bits.num_blocks() * sizeof(boost::dynamic_bitset<>::block_type);
+    }
+
+    /**
+     * @brief Estimate for a hash map: the bucket array and one node (a pointer
+     * and the value) per element.
+     */
+    template <class K, class V>
+    inline uint64_t heapBytes(const std::unordered_map<K, V> &map){
+        return map.bucket_count() * sizeof(void*)
+               + map.size() * (sizeof(void*) + sizeof(typename std::unordered_map<K, V>::value_type));
+    }
+}
+
+#endif	/* MEMORYUSAGE_H */
@@ -0,0 +1,795 @@
+/*
+ * File:   MetricsStore.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Compression.h"
+#include "MemoryUsage.h"
+#include "MetricsStore.h"
+#include "TextFormat.h"
+
+const char MetricsWriter::Magic[8] = {'M', 'H', 'C', 'M', 'E', 'T', 'R', 'S'};
+
+namespace {
+
+    const char ChunkMagic[4] = {'G', 'E', 'N', 'R'};
+    const char IndexMagic[8] = {'M', 'H', 'C', 'I', 'N', 'D', 'E', 'X'};
+
+    inline uint64_t roundUpTo8(uint64_t bytes){
+        return (bytes + 7) & ~((uint64_t) 7);
+    }
+
+    inline uint64_t widthOf(uint32_t type){
+        return type == MetricUInt32 ? 4 : 8;
+    }
+
+    const std::size_t NoGeneration = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * @brief Appends the differences of the values, as zigzag varints: from
+     * the previous value (the first one from 0) or, if given, from the values
+     * of the previous generation.
+     */
+    void appendDeltas(const std::vector<uint64_t> &values, const uint64_t *previous, std::vector<uint8_t> &stream){
+        stream.clear();
+        uint64_t last = 0;
+        for(std::size_t i = 0; i < values.size(); ++i){
+            uint64_t base = previous ? previous[i] : last;
+            Compression::appendVarint(stream, Compression::zigzag((int64_t) (values[i] - base)));
+            last = values[i];
+        }
+    }
+
+    bool readAt(int fd, uint64_t offset, void *data, std::size_t size){
+        char *bytes = static_cast<char*>(data);
+        while(size > 0){
+            ssize_t got = pread(fd, bytes, size, offset);
+            if(got < 0 and errno == EINTR)
+                continue;
+            if(got <= 0)
+                return false;
+            bytes += got;
+            offset += got;
+            size -= got;
+        }
+        return true;
+    }
+
+    bool isStore(int fd, uint64_t fileSize){
+        MetricsFileHeader header;
+        return fileSize >= sizeof(header) and readAt(fd, 0, &header, sizeof(header))
+               and std::equal(MetricsWriter::Magic, MetricsWriter::Magic + 8, header.Magic)
+               and header.Version == MetricsWriter::Version;
+    }
+
+    /**
+     * @brief Walks the chunks of a store from the beginning, up to the first
+     * one that is incomplete or of a generation later than lastTime.
+     *
+     * @param fd - the file
+     * @param fileSize - its size
+     * @param lastTime - last generation to take
+     * @param index - gets the chunks taken
+     * @return end of the last chunk taken
+     */
+    uint64_t scanChunks(int fd, uint64_t fileSize, int64_t lastTime, std::vector<MetricsIndexEntry> &index){
+        uint64_t offset = sizeof(MetricsFileHeader);
+        MetricsChunkHeader chunk;
+        while(offset + sizeof(chunk) <= fileSize and readAt(fd, offset, &chunk, sizeof(chunk))){
+            if(!std::equal(ChunkMagic, ChunkMagic + 4, chunk.Magic) or chunk.Size < sizeof(chunk)
+               or chunk.Size > fileSize - offset or chunk.Time > lastTime
+               or (!index.empty() and chunk.Time <= index.back().Time))
+                break;
+            index.push_back({chunk.Time, offset, chunk.Size});
+            offset += chunk.Size;
+        }
+        return offset;
+    }
+
+    /**
+     * @brief A per-generation text file and the column it is made of.
+     */
+    struct TextRecordFile {
+        const char *FileName;
+        const char *Header;
+        MetricColumn Column;
+    };
+
+    const TextRecordFile ValueFiles[] = {
+        {"HostGeneNumbTotal_ChrOne.csv", "#time total_number_of_genes_in_all_host_cells", GeneNumbTotal},
+        {"HostMHCsNumbUniq_ChrOne.csv", "#time number_of_unique_MHCs_in_all_host_cells", GeneNumbUnique},
+        {"PresentedPathogenNumbers.csv", "#time number_of_pathogens_presented_by_hosts", PresentedPathogens},
+        {"NumberOfMhcInMother.csv", "#time number_of_MHCs_in_mother", MhcInMother},
+        {"NumberOfMhcInFather.csv", "#time number_of_MHCs_in_father", MhcInFather},
+        {"NumberOfMhcBeforeMating.csv", "#time number_of_MHCs_before_mating", MhcBeforeMating},
+        {"NumberOfMhcAfterMating.csv", "#time number_of_MHCs_after_mating", MhcAfterMating},
+        {"MemoryUsage.csv", MemoryUsageHeader, MemoryBytes}
+    };
+}
+
+/**
+ * @brief Data harvesting method. Constructor. No file is open yet.
+ */
+MetricsWriter::MetricsWriter() : Fd(-1), Good(true), DataEnd(0), IndexWritten(false), ChunkTime(0),
+    Packing(MetricsCompression::None), Previous(NumbOfMetricColumns),
+    PreviousChunk(NumbOfMetricColumns, -1), ChainLength(NumbOfMetricColumns, 0) {
+}
+
+/**
+ * @brief Data harvesting method. Destructor. Writes out the last generation
+ * and the index.
+ */
+MetricsWriter::~MetricsWriter() {
+    close();
+}
+
+/**
+ * @brief Data harvesting method. Opens a store, closing the one open before.
+ * An existing store is continued after its last complete chunk.
+ *
+ * @param fileName - path to the file
+ * @param truncate - 'true' to start the store anew
+ * @return 'false' if the file cannot be opened or is not a metrics store
+ */
+bool MetricsWriter::open(const std::string &fileName, bool truncate){
+    close();
+    Good = true;
+    Index.clear();
+    IndexWritten = false;
+    forgetPrevious();
+    Fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    if(Fd < 0){
+        std::cout << "Error in MetricsWriter::open(): cannot open the file " << fileName << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat fileStat;
+    uint64_t fileSize = fstat(Fd, &fileStat) == 0 ? fileStat.st_size : 0;
+    if(fileSize == 0){
+        MetricsFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.Magic, Magic, sizeof(Magic));
+        header.Version = Version;
+        header.NumbOfColumnKinds = NumbOfMetricColumns;
+        DataEnd = sizeof(header);
+        return writeAt(0, &header, sizeof(header));
+    }
+    if(!isStore(Fd, fileSize)){
+        std::cout << "Error in MetricsWriter::open(): " << fileName << " is not a metrics store." << std::endl;
+        ::close(Fd);
+        Fd = -1;
+        return false;
+    }
+    DataEnd = scanChunks(Fd, fileSize, std::numeric_limits<int64_t>::max(), Index);
+    return true;
+}
+
+bool MetricsWriter::isOpen() const {
+    return Fd >= 0;
+}
+
+/**
+ * @brief Data harvesting method. Sets how much the integer columns added from
+ * now on are packed: not at all (the default), as differences stored in
+ * varints, or as differences block compressed on top. A column is packed only
+ * when it gets smaller, so the short ones stay raw.
+ *
+ * @param compression - the compression
+ */
+void MetricsWriter::setCompression(MetricsCompression compression){
+    Packing = compression;
+}
+
+void MetricsWriter::forgetPrevious(){
+    for(int c = 0; c < NumbOfMetricColumns; ++c){
+        Previous[c].clear();
+        PreviousChunk[c] = -1;
+        ChainLength[c] = 0;
+    }
+}
+
+/**
+ * @brief Data harvesting method. Adds a column to the chunk of a generation.
+ * A column of another generation ends the chunk gathered so far.
+ */
+void MetricsWriter::addColumn(int tayme, MetricColumn column, MetricType type, const void *values,
+                              std::size_t count, std::size_t width){
+    if(!ChunkColumns.empty() and tayme != ChunkTime)
+        endGeneration();
+    ChunkTime = tayme;
+    uint8_t encoding = MetricRaw;
+    bool blockCompressed = false;
+    if(Packing != MetricsCompression::None and type != MetricFloat64)
+        encoding = packColumn(column, values, count, width, blockCompressed);
+    ChunkColumns.push_back({(uint32_t) column, (uint16_t) type, encoding, (uint8_t) blockCompressed, count,
+                            ChunkData.size()});
+    if(encoding == MetricRaw){
+        const char *bytes = static_cast<const char*>(values);
+        ChunkData.insert(ChunkData.end(), bytes, bytes + count * width);
+    } else {
+        const std::vector<uint8_t> &packed = blockCompressed ? Packed : Stream;
+        MetricsPackedColumn header = {packed.size(), Stream.size()};
+        const char *bytes = reinterpret_cast<const char*>(&header);
+        ChunkData.insert(ChunkData.end(), bytes, bytes + sizeof(header));
+        ChunkData.insert(ChunkData.end(), packed.begin(), packed.end());
+    }
+    ChunkData.resize(roundUpTo8(ChunkData.size()), 0);
+}
+
+/**
+ * @brief Data harvesting method. Packs an integer column into Stream (and
+ * Packed, when block compressed): as differences from the previous value, or
+ * from the values of the previous generation if that is smaller and the
+ * previous chunk has the column with as many values.
+ *
+ * @param blockCompressed - gets 'true' when Packed holds the column
+ * @return encoding of the column, MetricRaw when packing does not make it smaller
+ */
+uint8_t MetricsWriter::packColumn(MetricColumn column, const void *values, std::size_t count, std::size_t width,
+                                  bool &blockCompressed){
+    std::vector<uint64_t> current(count);
+    if(width == sizeof(uint32_t)){
+        const uint32_t *narrow = static_cast<const uint32_t*>(values);
+        std::copy(narrow, narrow + count, current.begin());
+    } else {
+        std::memcpy(current.data(), values, count * width);
+    }
+    uint8_t encoding = MetricDelta;
+    appendDeltas(current, nullptr, Stream);
+    if(PreviousChunk[column] + 1 == (int64_t) Index.size() and Previous[column].size() == count
+       and ChainLength[column] + 1 < KeyframeEvery){
+        appendDeltas(current, Previous[column].data(), OtherStream);
+        if(OtherStream.size() < Stream.size()){
+            Stream.swap(OtherStream);
+            encoding = MetricGenerationDelta;
+        }
+    }
+    std::size_t packedSize = Stream.size();
+    if(Packing == MetricsCompression::Block){
+        Packed.clear();
+        Compression::compressBlock(Stream.data(), Stream.size(), Packed);
+        if(Packed.size() < Stream.size()){
+            blockCompressed = true;
+            packedSize = Packed.size();
+        }
+    }
+    if(sizeof(MetricsPackedColumn) + packedSize >= count * width){
+        encoding = MetricRaw;
+        blockCompressed = false;
+    }
+    ChainLength[column] = encoding == MetricGenerationDelta ? ChainLength[column] + 1 : 0;
+    Previous[column].swap(current);
+    PreviousChunk[column] = Index.size();
+    return encoding;
+}
+
+/**
+ * @brief Data harvesting method. Writes the chunk of the current generation,
+ * if it has any columns.
+ */
+void MetricsWriter::endGeneration(){
+    if(ChunkColumns.empty())
+        return;
+    if(Fd < 0){
+        ChunkColumns.clear();
+        ChunkData.clear();
+        return;
+    }
+    MetricsChunkHeader header;
+    std::memcpy(header.Magic, ChunkMagic, sizeof(ChunkMagic));
+    header.NumbOfColumns = ChunkColumns.size();
+    header.Time = ChunkTime;
+    uint64_t columnsStart = sizeof(header) + ChunkColumns.size() * sizeof(MetricsColumnEntry);
+    header.Size = columnsStart + ChunkData.size();
+    for(MetricsColumnEntry &entry : ChunkColumns){
+        entry.Offset += columnsStart;
+    }
+    writeAt(DataEnd, &header, sizeof(header));
+    writeAt(DataEnd + sizeof(header), ChunkColumns.data(), ChunkColumns.size() * sizeof(MetricsColumnEntry));
+    writeAt(DataEnd + columnsStart, ChunkData.data(), ChunkData.size());
+    Index.push_back({ChunkTime, DataEnd, header.Size});
+    DataEnd += header.Size;
+    IndexWritten = false;
+    ChunkColumns.clear();
+    ChunkData.clear();
+}
+
+/**
+ * @brief Data harvesting method. Writes the current chunk and the index after
+ * the last chunk and, if asked, forces the file to the disk (fsync).
+ *
+ * @param toDisk - 'true' to call fsync
+ * @return 'false' if writing failed
+ */
+bool MetricsWriter::commit(bool toDisk){
+    if(Fd < 0)
+        return true;
+    endGeneration();
+    if(!IndexWritten){
+        MetricsTrailer trailer;
+        trailer.NumbOfGenerations = Index.size();
+        trailer.IndexOffset = DataEnd;
+        std::memcpy(trailer.Magic, IndexMagic, sizeof(IndexMagic));
+        uint64_t indexSize = Index.size() * sizeof(MetricsIndexEntry);
+        writeAt(DataEnd, Index.data(), indexSize);
+        writeAt(DataEnd + indexSize, &trailer, sizeof(trailer));
+        if(ftruncate(Fd, DataEnd + indexSize + sizeof(trailer)) != 0)
+            Good = false;
+        IndexWritten = true;
+    }
+    if(Good and toDisk and fsync(Fd) != 0){
+        std::cout << "Error in MetricsWriter::commit(): fsync failed: " << std::strerror(errno) << std::endl;
+        Good = false;
+    }
+    return Good;
+}
+
+/**
+ * @brief Data harvesting method. Writes out everything and closes the file.
+ */
+void MetricsWriter::close(){
+    if(Fd < 0)
+        return;
+    commit(false);
+    ::close(Fd);
+    Fd = -1;
+}
+
+/**
+ * @brief Data harvesting method. Removes from a store the chunks of
+ * generations later than tayme, and the index, which is written anew when the
+ * store is continued. Used when a run continues from a checkpoint.
+ *
+ * @param fileName - path to the file
+ * @param tayme - last generation to keep
+ * @return 'false' if the file exists and could not be cut
+ */
+bool MetricsWriter::dropAfter(const std::string &fileName, int tayme){
+    int fd = ::open(fileName.c_str(), O_RDWR);
+    if(fd < 0)
+        return true;
+    struct stat fileStat;
+    uint64_t fileSize = fstat(fd, &fileStat) == 0 ? fileStat.st_size : 0;
+    bool ok = isStore(fd, fileSize);
+    if(ok){
+        std::vector<MetricsIndexEntry> index;
+        ok = ftruncate(fd, scanChunks(fd, fileSize, tayme, index)) == 0;
+    }
+    ::close(fd);
+    if(!ok)
+        std::cout << "Error in MetricsWriter::dropAfter(): cannot cut " << fileName << std::endl;
+    return ok;
+}
+
+bool MetricsWriter::writeAt(uint64_t offset, const void *data, std::size_t size){
+    const char *bytes = static_cast<const char*>(data);
+    while(size > 0 and Good){
+        ssize_t written = pwrite(Fd, bytes, size, offset);
+        if(written < 0){
+            if(errno == EINTR)
+                continue;
+            std::cout << "Error in MetricsWriter::writeAt(): cannot write the metrics store: "
+                      << std::strerror(errno) << std::endl;
+            Good = false;
+            break;
+        }
+        bytes += written;
+        offset += written;
+        size -= written;
+    }
+    return Good;
+}
+
+/**
+ * @brief Data harvesting method. Constructor. Nothing is open yet, see open().
+ */
+MetricsReader::MetricsReader() : Data(nullptr), Size(0), CachedGeneration(NumbOfMetricColumns, NoGeneration),
+    CachedValues(NumbOfMetricColumns) {
+}
+
+MetricsReader::~MetricsReader() {
+    close();
+}
+
+/**
+ * @brief Data harvesting method. Maps a metrics store to memory and reads its
+ * index. A store without a valid index (the run was killed) is indexed by
+ * walking its chunks.
+ *
+ * @param fileName - the store
+ * @return 'false' if the file cannot be mapped or is not a metrics store
+ */
+bool MetricsReader::open(const std::string &fileName){
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0){
+        std::cout << "Error in MetricsReader::open(): cannot open the file " << fileName << std::endl;
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 or !isStore(fd, fileStat.st_size)){
+        std::cout << "Error in MetricsReader::open(): " << fileName << " is not a metrics store." << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED){
+        std::cout << "Error in MetricsReader::open(): cannot map the file " << fileName << std::endl;
+        return false;
+    }
+    Data = static_cast<const char*>(mapped);
+    Size = fileStat.st_size;
+    if(!readIndex()){
+        std::cout << "Error in MetricsReader::open(): " << fileName << " has broken chunks." << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MetricsReader::close(){
+    if(Data)
+        munmap(const_cast<char*>(Data), Size);
+    Data = nullptr;
+    Size = 0;
+    Index.clear();
+    std::fill(CachedGeneration.begin(), CachedGeneration.end(), NoGeneration);
+}
+
+/**
+ * @brief Data harvesting method. Takes the index from the end of the file, or
+ * makes it by walking the chunks when there is no valid one.
+ *
+ * @return 'false' if a chunk the index points to is not valid
+ */
+bool MetricsReader::readIndex(){
+    Index.clear();
+    if(Size >= sizeof(MetricsFileHeader) + sizeof(MetricsTrailer)){
+        const MetricsTrailer *trailer = reinterpret_cast<const MetricsTrailer*>(Data + Size - sizeof(MetricsTrailer));
+        uint64_t indexEnd = Size - sizeof(MetricsTrailer);
+        if(std::equal(IndexMagic, IndexMagic + 8, trailer->Magic) and trailer->IndexOffset <= indexEnd
+           and trailer->NumbOfGenerations == (indexEnd - trailer->IndexOffset) / sizeof(MetricsIndexEntry)
+           and trailer->IndexOffset + trailer->NumbOfGenerations * sizeof(MetricsIndexEntry) == indexEnd){
+            const MetricsIndexEntry *entries = reinterpret_cast<const MetricsIndexEntry*>(Data + trailer->IndexOffset);
+            Index.assign(entries, entries + trailer->NumbOfGenerations);
+            for(std::size_t g = 0; g < Index.size(); ++g){
+                if(!checkChunk(Index[g].Offset, Index[g].Size) or (g > 0 and Index[g].Time <= Index[g - 1].Time))
+                    return false;
+            }
+            return true;
+        }
+    }
+    uint64_t offset = sizeof(MetricsFileHeader);
+    while(offset + sizeof(MetricsChunkHeader) <= Size){
+        const MetricsChunkHeader *chunk = reinterpret_cast<const MetricsChunkHeader*>(Data + offset);
+        if(!checkChunk(offset, chunk->Size) or (!Index.empty() and chunk->Time <= Index.back().Time))
+            break;
+        Index.push_back({chunk->Time, offset, chunk->Size});
+        offset += chunk->Size;
+    }
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Is there a whole, consistent chunk at the
+ * given place of the file?
+ */
+bool MetricsReader::checkChunk(uint64_t offset, uint64_t size) const {
+    if(offset % 8 != 0 or offset > Size or size > Size - offset or size < sizeof(MetricsChunkHeader))
+        return false;
+    const MetricsChunkHeader *chunk = reinterpret_cast<const MetricsChunkHeader*>(Data + offset);
+    if(!std::equal(ChunkMagic, ChunkMagic + 4, chunk->Magic) or chunk->Size != size
+       or chunk->NumbOfColumns > (size - sizeof(MetricsChunkHeader)) / sizeof(MetricsColumnEntry))
+        return false;
+    const MetricsColumnEntry *entries = reinterpret_cast<const MetricsColumnEntry*>(chunk + 1);
+    for(uint32_t c = 0; c < chunk->NumbOfColumns; ++c){
+        const MetricsColumnEntry &entry = entries[c];
+        if(entry.Type > MetricFloat64 or entry.Offset % 8 != 0 or entry.Offset > size)
+            return false;
+        if(entry.Encoding == MetricRaw){
+            if(entry.Count > (size - entry.Offset) / widthOf(entry.Type))
+                return false;
+            continue;
+        }
+        if(entry.Type == MetricFloat64 or (entry.Encoding != MetricDelta and entry.Encoding != MetricGenerationDelta)
+           or entry.BlockCompressed > 1 or size - entry.Offset < sizeof(MetricsPackedColumn))
+            return false;
+        const MetricsPackedColumn *packed = reinterpret_cast<const MetricsPackedColumn*>(Data + offset + entry.Offset);
+        // a value takes at least a byte of varint, a byte of compressed block at most 255 bytes of varints
+        if(packed->Size > size - entry.Offset - sizeof(MetricsPackedColumn) or entry.Count > packed->StreamSize
+           or packed->StreamSize / 256 > packed->Size
+           or (!entry.BlockCompressed and packed->StreamSize != packed->Size))
+            return false;
+    }
+    return true;
+}
+
+std::size_t MetricsReader::getNumbOfGenerations() const {
+    return Index.size();
+}
+
+/**
+ * @brief Data harvesting method. Time stamp (host generation number) of the
+ * n-th generation in the store.
+ */
+int64_t MetricsReader::getTime(std::size_t generation) const {
+    return Index[generation].Time;
+}
+
+/**
+ * @brief Data harvesting method. Finds a generation in the index.
+ *
+ * @param tayme - time stamp (host generation number)
+ * @param generation - gets the place of the generation in the store
+ * @return 'false' if the store has no such generation
+ */
+bool MetricsReader::findGeneration(int64_t tayme, std::size_t &generation) const {
+    auto found = std::lower_bound(Index.begin(), Index.end(), tayme,
+                                  [](const MetricsIndexEntry &entry, int64_t t){ return entry.Time < t; });
+    if(found == Index.end() or found->Time != tayme)
+        return false;
+    generation = found - Index.begin();
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Finds a column in the chunk of a generation.
+ *
+ * @param generation - place of the generation in the store
+ * @param column - the column
+ * @return the column entry, nullptr when the generation has no such column
+ */
+const MetricsColumnEntry* MetricsReader::findColumn(std::size_t generation, MetricColumn column) const {
+    const MetricsChunkHeader *chunk = reinterpret_cast<const MetricsChunkHeader*>(Data + Index[generation].Offset);
+    const MetricsColumnEntry *entries = reinterpret_cast<const MetricsColumnEntry*>(chunk + 1);
+    for(uint32_t c = 0; c < chunk->NumbOfColumns; ++c){
+        if(entries[c].Column == (uint32_t) column)
+            return entries + c;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Data harvesting method. Reads an integer column of a generation,
+ * raw or packed. A column packed as differences from the previous generation
+ * is unpacked starting from the last generation packed on its own (or the one
+ * read last, when it is on the way).
+ *
+ * @param generation - place of the generation in the store
+ * @param column - the column
+ * @param values - gets its values
+ * @return 'false' if the generation has no such integer column or it is broken
+ */
+bool MetricsReader::readColumn(std::size_t generation, MetricColumn column, std::vector<uint64_t> &values) const {
+    values.clear();
+    if(generation >= Index.size())
+        return false;
+    std::size_t &cachedGeneration = CachedGeneration[column];
+    std::vector<uint64_t> &cachedValues = CachedValues[column];
+    if(cachedGeneration == generation){
+        values = cachedValues;
+        return true;
+    }
+    std::vector<uint64_t> previous;
+    std::size_t first = generation;
+    while(true){
+        const MetricsColumnEntry *entry = findColumn(first, column);
+        if(!entry or entry->Type == MetricFloat64)
+            return false;
+        if(entry->Encoding != MetricGenerationDelta)
+            break;
+        if(first == 0)
+            return false;
+        --first;
+        if(cachedGeneration == first){
+            previous = cachedValues;
+            ++first;
+            break;
+        }
+    }
+    for(std::size_t g = first; g <= generation; ++g){
+        if(!unpackColumn(g, *findColumn(g, column), previous, values)){
+            cachedGeneration = NoGeneration;
+            values.clear();
+            return false;
+        }
+        previous.swap(values);
+    }
+    values.swap(previous);
+    cachedValues = values;
+    cachedGeneration = generation;
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Unpacks one column.
+ *
+ * @param generation - place of the generation in the store
+ * @param entry - the column in the chunk of the generation
+ * @param previous - values of the column in the generation before, for MetricGenerationDelta
+ * @param values - gets the values
+ * @return 'false' if the column is broken
+ */
+bool MetricsReader::unpackColumn(std::size_t generation, const MetricsColumnEntry &entry,
+                                 const std::vector<uint64_t> &previous, std::vector<uint64_t> &values) const {
+    const char *data = Data + Index[generation].Offset + entry.Offset;
+    values.resize(entry.Count);
+    if(entry.Encoding == MetricRaw){
+        if(entry.Type == MetricUInt32){
+            const uint32_t *narrow = reinterpret_cast<const uint32_t*>(data);
+            std::copy(narrow, narrow + entry.Count, values.begin());
+        } else {
+            std::memcpy(values.data(), data, entry.Count * sizeof(uint64_t));
+        }
+        return true;
+    }
+    const MetricsPackedColumn *packed = reinterpret_cast<const MetricsPackedColumn*>(data);
+    const uint8_t *in = reinterpret_cast<const uint8_t*>(packed + 1);
+    const uint8_t *end = in + packed->Size;
+    if(entry.BlockCompressed){
+        if(!Compression::decompressBlock(in, packed->Size, Unpacked, packed->StreamSize))
+            return false;
+        in = Unpacked.data();
+        end = in + Unpacked.size();
+    }
+    bool fromPrevious = entry.Encoding == MetricGenerationDelta;
+    if(fromPrevious and previous.size() != entry.Count)
+        return false;
+    uint64_t last = 0;
+    for(uint64_t i = 0; i < entry.Count; ++i){
+        uint64_t delta;
+        if(!Compression::readVarint(in, end, delta))
+            return false;
+        last = (fromPrevious ? previous[i] : last) + (uint64_t) Compression::unzigzag(delta);
+        values[i] = last;
+    }
+    return in == end;
+}
+
+/**
+ * @brief Data harvesting method. The numbers of a line of HostsGeneDivers.csv:
+ * pop_size tot_num_of_genes num_of_MHC_types Shannon_indx mean_fitness
+ * std_fitness, without the time.
+ *
+ * @param generation - place of the generation in the store
+ * @param row - gets the numbers
+ * @return 'false' if the generation does not have them
+ */
+bool MetricsReader::getGeneDiversity(std::size_t generation, std::vector<double> &row) const {
+    const MetricColumn columns[] = {HostPopSize, HostTotalGenes, HostMhcTypes, HostShannon,
+                                    HostMeanFitness, HostStdFitness};
+    row.clear();
+    std::vector<uint64_t> mhcTypes;
+    for(MetricColumn column : columns){
+        uint64_t count = 0;
+        if(column == HostMhcTypes){
+            if(readColumn(generation, column, mhcTypes))
+                count = mhcTypes.size();
+            if(count == 1)
+                row.push_back((double) mhcTypes[0]);
+        } else {
+            const double *value = getColumn<double>(generation, column, count);
+            if(count == 1)
+                row.push_back(*value);
+        }
+        if(count != 1)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Writes the per-generation text files the
+ * store stands in for, the same as the run would have written them. Only the
+ * files of the columns found in the store are written.
+ *
+ * @param outputDir - directory to write to, empty or ending with '/'
+ * @return 'false' if a file could not be written
+ */
+bool MetricsReader::convertToText(const std::string &outputDir) const {
+    bool ok = true;
+    std::vector<char> line;
+    std::vector<uint64_t> values;
+    for(const TextRecordFile &file : ValueFiles){
+        std::ofstream out;
+        for(std::size_t g = 0; g < Index.size(); ++g){
+            if(!readColumn(g, file.Column, values))
+                continue;
+            if(!out.is_open()){
+                out.open(outputDir + file.FileName);
+                out << file.Header << '\n';
+            }
+            line.clear();
+            TextFormat::appendRecord(line, (int) Index[g].Time, values.data(), values.size());
+            out.write(line.data(), line.size());
+        }
+        if(out.is_open()){
+            out.close();
+            ok = ok and out.good();
+        }
+    }
+
+    const MetricColumn diversColumns[] = {HostPopSize, HostTotalGenes, HostMhcTypes, HostShannon,
+                                          HostMeanFitness, HostStdFitness};
+    std::ofstream diversFile;
+    for(std::size_t g = 0; g < Index.size(); ++g){
+        const double *numbers[6];
+        uint64_t count = 0;
+        bool complete = true;
+        for(int c = 0; c < 6; ++c){
+            if(diversColumns[c] == HostMhcTypes){
+                count = readColumn(g, HostMhcTypes, values) ? values.size() : 0;
+            } else {
+                numbers[c] = getColumn<double>(g, diversColumns[c], count);
+            }
+            complete = complete and count == 1;
+        }
+        if(!complete)
+            continue;
+        if(!diversFile.is_open()){
+            diversFile.open(outputDir + "HostsGeneDivers.csv");
+            diversFile << "#time pop_size tot_num_of_genes num_of_MHC_types Shannon_indx mean_fitness std_fitness\n";
+        }
+        diversFile << Index[g].Time << " " << *numbers[0] << " " << *numbers[1] << " " << values[0] << " "
+                   << *numbers[3] << " " << *numbers[4] << " " << *numbers[5] << '\n';
+    }
+    if(diversFile.is_open()){
+        diversFile.close();
+        ok = ok and diversFile.good();
+    }
+
+    std::ofstream freqsFile;
+    std::vector<uint64_t> alleles, copies;
+    for(std::size_t g = 0; g < Index.size(); ++g){
+        if(!readColumn(g, AlleleValues, alleles) or !readColumn(g, AlleleCopies, copies)
+           or alleles.size() != copies.size())
+            continue;
+        uint64_t numbOfAlleles = alleles.size();
+        if(!freqsFile.is_open()){
+            freqsFile.open(outputDir + "AlleleFrequencies.csv");
+            freqsFile << "#time MHC_allele:number_of_copies_in_all_hosts\n";
+        }
+        freqsFile << Index[g].Time;
+        for(uint64_t a = 0; a < numbOfAlleles; ++a){
+            freqsFile << " " << alleles[a] << ":" << copies[a];
+        }
+        freqsFile << '\n';
+    }
+    if(freqsFile.is_open()){
+        freqsFile.close();
+        ok = ok and freqsFile.good();
+    }
+    if(!ok)
+        std::cout << "Error in MetricsReader::convertToText(): cannot write the text files to '"
+                  << outputDir << "'." << std::endl;
+    return ok;
+}
@@ -0,0 +1,238 @@
+/*
+ * File:   MetricsStore.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef METRICSSTORE_H
+#define	METRICSSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Columns of the metrics store, one for each number written every host
+ * generation. Each stands in for (a part of) a per-generation text file.
+ */
+enum MetricColumn {
+    HostPopSize,           // float64 x 1, HostsGeneDivers.csv
+    HostTotalGenes,        // float64 x 1
+    HostMhcTypes,          // uint64 x 1
+    HostShannon,           // float64 x 1
+    HostMeanFitness,       // float64 x 1
+    HostStdFitness,        // float64 x 1
+    GeneNumbTotal,         // uint64 x hosts, HostGeneNumbTotal_ChrOne.csv
+    GeneNumbUnique,        // uint64 x hosts, HostMHCsNumbUniq_ChrOne.csv
+    AlleleValues,          // uint64 x alleles, AlleleFrequencies.csv
+    AlleleCopies,          // uint64 x alleles
+    PresentedPathogens,    // uint32 x hosts, PresentedPathogenNumbers.csv
+    MhcInMother,           // uint64 x hosts, NumberOfMhcInMother.csv
+    MhcInFather,           // uint64 x hosts, NumberOfMhcInFather.csv
+    MhcBeforeMating,       // uint64 x hosts, NumberOfMhcBeforeMating.csv
+    MhcAfterMating,        // uint64 x hosts, NumberOfMhcAfterMating.csv
+    MemoryBytes,           // uint64 x memory components, MemoryUsage.csv
+    NumbOfMetricColumns
+};
+
+/**
+ * @brief Types of the values of a column.
+ */
+enum MetricType {
+    MetricUInt32,
+    MetricUInt64,
+    MetricFloat64
+};
+
+/**
+ * @brief How the values of a column are stored. Packed columns (all but
+ * MetricRaw) are integer ones, written as a MetricsPackedColumn followed by the
+ * differences of the values (zigzag varints, see Compression.h), block
+ * compressed when the column entry says so.
+ */
+enum MetricEncoding {
+    MetricRaw = 0,                 // the values as they are
+    MetricDelta = 1,               // differences from the previous value of the column
+    MetricGenerationDelta = 2      // differences from the same value of the previous generation
+};
+
+/**
+ * @brief How much the writer packs integer columns, see MetricsWriter::setCompression().
+ */
+enum class MetricsCompression {
+    None,           // all columns raw
+    Delta,          // differences as varints
+    Block           // differences as varints, block compressed
+};
+
+template <typename T> struct MetricTypeOf;
+template <> struct MetricTypeOf<uint32_t> { static const MetricType Type = MetricUInt32; };
+template <> struct MetricTypeOf<uint64_t> { static const MetricType Type = MetricUInt64; };
+template <> struct MetricTypeOf<double> { static const MetricType Type = MetricFloat64; };
+
+/*
+ * Layout of a metrics store file (Metrics.bin). Values are in the native byte
+ * order, every part starts at a multiple of 8 bytes.
+ *
+ *   MetricsFileHeader
+ *   chunk of generation 0: MetricsChunkHeader, MetricsColumnEntry x columns, column data
+ *   chunk of generation 1 ...
+ *   index: MetricsIndexEntry x generations
+ *   MetricsTrailer
+ *
+ * Column data is either raw values or a packed column (see MetricEncoding).
+ * The index and the trailer are rewritten after the last chunk each time the store is committed. A file
+ * without them (the run was killed) is still read, by walking the chunks from
+ * the beginning.
+ */
+struct MetricsFileHeader {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t NumbOfColumnKinds;   // NumbOfMetricColumns of the writer
+};
+
+struct MetricsChunkHeader {
+    char Magic[4];
+    uint32_t NumbOfColumns;
+    int64_t Time;
+    uint64_t Size;                // of the whole chunk, header included
+};
+
+struct MetricsColumnEntry {
+    uint32_t Column;              // MetricColumn
+    uint16_t Type;                // MetricType
+    uint8_t Encoding;             // MetricEncoding
+    uint8_t BlockCompressed;      // 1: the differences are compressed with Compression::compressBlock()
+    uint64_t Count;               // number of values
+    uint64_t Offset;              // of the values, from the beginning of the chunk
+};
+
+struct MetricsPackedColumn {
+    uint64_t Size;                // of the packed values that follow
+    uint64_t StreamSize;          // of the varints, before the block compression
+};
+
+struct MetricsIndexEntry {
+    int64_t Time;
+    uint64_t Offset;              // of the chunk, from the beginning of the file
+    uint64_t Size;
+};
+
+struct MetricsTrailer {
+    uint64_t NumbOfGenerations;
+    uint64_t IndexOffset;
+    char Magic[8];
+};
+
+/**
+ * @brief Data harvesting class. Writes the per-generation numbers as typed
+ * columns, one chunk per host generation, plus an index of the chunks by
+ * generation (see the layout above). Columns of a generation are gathered in
+ * memory and the chunk is written in one go when the generation ends.
+ *
+ * With compression on, integer columns are packed as differences: from the
+ * previous value of the column, or from the same column of the previous
+ * generation, whichever is smaller. The latter makes reading a generation
+ * depend on the one before, so every KeyframeEvery generations (and after
+ * opening a store) a column is packed on its own again.
+ */
+class MetricsWriter {
+public:
+    MetricsWriter();
+    virtual ~MetricsWriter();
+    bool open(const std::string &fileName, bool truncate);
+    bool isOpen() const;
+    template <typename T>
+    void add(int tayme, MetricColumn column, const std::vector<T> &values){
+        addColumn(tayme, column, MetricTypeOf<T>::Type, values.data(), values.size(), sizeof(T));
+    }
+    void setCompression(MetricsCompression compression);
+    void endGeneration();
+    bool commit(bool toDisk);
+    void close();
+    static bool dropAfter(const std::string &fileName, int tayme);
+    static const char Magic[8];
+    static const uint32_t Version = 1;
+    static const unsigned KeyframeEvery = 32;
+private:
+    void addColumn(int tayme, MetricColumn column, MetricType type, const void *values,
+                   std::size_t count, std::size_t width);
+    uint8_t packColumn(MetricColumn column, const void *values, std::size_t count, std::size_t width,
+                       bool &blockCompressed);
+    void forgetPrevious();
+    bool writeAt(uint64_t offset, const void *data, std::size_t size);
+    int Fd;
+    bool Good;
+    uint64_t DataEnd;                           // end of the last chunk
+    bool IndexWritten;
+    std::vector<MetricsIndexEntry> Index;
+    int64_t ChunkTime;
+    std::vector<MetricsColumnEntry> ChunkColumns;
+    std::vector<char> ChunkData;                // values of the columns, offsets from its beginning
+    MetricsCompression Packing;
+    std::vector<std::vector<uint64_t> > Previous;  // last values of each column
+    std::vector<int64_t> PreviousChunk;         // chunk (place in Index) of the last values, -1 - none
+    std::vector<unsigned> ChainLength;          // generations since the column was packed on its own
+    std::vector<uint8_t> Stream, OtherStream, Packed;
+};
+
+/**
+ * @brief Data harvesting class. Reads a metrics store through a memory map:
+ * finds the chunk of a generation in the index and gives its columns where they
+ * lie in the file, so only the pages of the columns used are read. Packed
+ * columns are unpacked by readColumn(); the last column unpacked of each kind
+ * is kept, so reading the generations in order unpacks each of them once. Can
+ * convert the store back to the per-generation text files.
+ */
+class MetricsReader {
+public:
+    MetricsReader();
+    virtual ~MetricsReader();
+    bool open(const std::string &fileName);
+    void close();
+    std::size_t getNumbOfGenerations() const;
+    int64_t getTime(std::size_t generation) const;
+    bool findGeneration(int64_t tayme, std::size_t &generation) const;
+    const MetricsColumnEntry* findColumn(std::size_t generation, MetricColumn column) const;
+    template <typename T>
+    const T* getColumn(std::size_t generation, MetricColumn column, uint64_t &count) const {
+        const MetricsColumnEntry *entry = findColumn(generation, column);
+        if(!entry or entry->Type != MetricTypeOf<T>::Type or entry->Encoding != MetricRaw){
+            count = 0;
+            return nullptr;
+        }
+        count = entry->Count;
+        return reinterpret_cast<const T*>(Data + Index[generation].Offset + entry->Offset);
+    }
+    bool readColumn(std::size_t generation, MetricColumn column, std::vector<uint64_t> &values) const;
+    bool getGeneDiversity(std::size_t generation, std::vector<double> &row) const;
+    bool convertToText(const std::string &outputDir) const;
+private:
+    bool readIndex();
+    bool checkChunk(uint64_t offset, uint64_t size) const;
+    bool unpackColumn(std::size_t generation, const MetricsColumnEntry &entry,
+                      const std::vector<uint64_t> &previous, std::vector<uint64_t> &values) const;
+    const char *Data;
+    std::size_t Size;
+    std::vector<MetricsIndexEntry> Index;
+    mutable std::vector<std::size_t> CachedGeneration;      // of the last column unpacked of each kind
+    mutable std::vector<std::vector<uint64_t> > CachedValues;
+    mutable std::vector<uint8_t> Unpacked;
+};
+
+#endif	/* METRICSSTORE_H */
@@ -0,0 +1,244 @@
+/*
+ * File:   OutputSchedule.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "boost/lexical_cast.hpp"
+
+#include "BinaryIO.h"
+#include "OutputSchedule.h"
+
+/**
+ * @brief Data harvesting method. Reads a cadence from its text form: "ends",
+ * "every:K" (K >= 1), "log:N" (N >= 1) or "change:X" (X >= 0).
+ *
+ * @param text - the cadence
+ * @return 'false' if the text is not a cadence (nothing changes)
+ */
+bool OutputCadence::fromString(const std::string &text){
+    if(text == "ends"){
+        Kind = CadenceKind::Ends;
+        Value = 0.0;
+        return true;
+    }
+    std::size_t colon = text.find(':');
+    if(colon == std::string::npos)
+        return false;
+    std::string name = text.substr(0, colon);
+    double value;
+    try {
+        value = boost::lexical_cast<double>(text.substr(colon + 1));
+    }
+    catch(boost::bad_lexical_cast &e) {
+        return false;
+    }
+    if(name == "every" and value >= 1.0 and value == std::floor(value)){
+        Kind = CadenceKind::Every;
+    } else if(name == "log" and value >= 1.0){
+        Kind = CadenceKind::LogSpaced;
+    } else if(name == "change" and value >= 0.0){
+        Kind = CadenceKind::OnChange;
+    } else {
+        return false;
+    }
+    Value = value;
+    return true;
+}
+
+std::string OutputCadence::toString() const {
+    std::stringstream ss;
+    switch(Kind){
+        case CadenceKind::Ends:
+            return "ends";
+        case CadenceKind::Every:
+            ss << "every:" << Value;
+            break;
+        case CadenceKind::LogSpaced:
+            ss << "log:" << Value;
+            break;
+        case CadenceKind::OnChange:
+            ss << "change:" << Value;
+            break;
+    }
+    return ss.str();
+}
+
+/**
+ * @brief Data harvesting method. Constructor. Everything is saved on the
+ * default cadences (getDefaultCadence()), genomes in full.
+ */
+OutputSchedule::OutputSchedule() : LastGeneration(std::numeric_limits<int>::max()), GenomeSample(0) {
+    for(int h = 0; h < NumbOfHarvesters; ++h){
+        Cadences[h] = getDefaultCadence((Harvester) h);
+        Due[h] = true;
+        LastShannon[h] = std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+OutputSchedule::~OutputSchedule() = default;
+
+void OutputSchedule::setCadence(Harvester harvester, const OutputCadence &cadence){
+    Cadences[(int) harvester] = cadence;
+}
+
+/**
+ * @brief Data harvesting method. The cadence of a group of files when none is
+ * given: every generation, genomes at the start and the end of run only.
+ */
+OutputCadence OutputSchedule::getDefaultCadence(Harvester harvester){
+    if(harvester == Harvester::Genomes)
+        return {CadenceKind::Ends, 0.0};
+    return {CadenceKind::Every, 1.0};
+}
+
+/**
+ * @brief Data harvesting method. Sets the last host generation of the run,
+ * which is saved on every cadence.
+ */
+void OutputSchedule::setLastGeneration(int tayme){
+    LastGeneration = tayme;
+}
+
+/**
+ * @brief Data harvesting method. Sets how many hosts (and how many pathogens)
+ * the genome dumps have: a sample drawn anew for each dump, or all of them.
+ *
+ * @param sampleSize - size of the sample, 0 for all
+ */
+void OutputSchedule::setGenomeSample(unsigned long sampleSize){
+    GenomeSample = sampleSize;
+}
+
+unsigned long OutputSchedule::getGenomeSample() const {
+    return GenomeSample;
+}
+
+/**
+ * @brief Data harvesting method. Does any cadence depend on the diversity of
+ * hosts? When none does, planGeneration() can be given anything as shannon.
+ */
+bool OutputSchedule::needsDiversity() const {
+    for(const OutputCadence &cadence : Cadences){
+        if(cadence.Kind == CadenceKind::OnChange)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Data harvesting method. Decides which groups of files are saved in a
+ * host generation. Call it before the generation is harvested.
+ *
+ * @param tayme - time stamp (host generation number)
+ * @param shannon - Shannon index of MHC alleles of the hosts at the start of the generation
+ */
+void OutputSchedule::planGeneration(int tayme, double shannon){
+    for(int h = 0; h < NumbOfHarvesters; ++h){
+        Due[h] = isDueAt(h, tayme, shannon);
+        if(Due[h] and Cadences[h].Kind == CadenceKind::OnChange)
+            LastShannon[h] = shannon;
+    }
+}
+
+bool OutputSchedule::isDueAt(int harvester, int tayme, double shannon) const {
+    if(tayme <= 0 or tayme >= LastGeneration)
+        return true;
+    const OutputCadence &cadence = Cadences[harvester];
+    switch(cadence.Kind){
+        case CadenceKind::Ends:
+            return false;
+        case CadenceKind::Every:
+            return tayme % (long) cadence.Value == 0;
+        case CadenceKind::LogSpaced:
+            return tayme == 1 or std::floor(cadence.Value * std::log10((double) tayme))
+                                 > std::floor(cadence.Value * std::log10((double) (tayme - 1)));
+        case CadenceKind::OnChange:
+            return std::isnan(LastShannon[harvester])
+                   or std::fabs(shannon - LastShannon[harvester]) > cadence.Value * LastShannon[harvester];
+    }
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Is a group of files saved in the current
+ * generation (see planGeneration())?
+ */
+bool OutputSchedule::isDue(Harvester harvester) const {
+    return Due[(int) harvester];
+}
+
+/**
+ * @brief Data harvesting method. Draws a sample without replacement by
+ * reservoir sampling (Algorithm R): one pass, memory of the size of the sample.
+ *
+ * @param populationSize - number of individuals
+ * @param sampleSize - number of them to draw
+ * @return places of the drawn individuals, in ascending order; all of them if
+ * the sample is not smaller than the population
+ */
+std::vector<std::size_t> OutputSchedule::drawSample(std::size_t populationSize, std::size_t sampleSize){
+    std::vector<std::size_t> reservoir;
+    reservoir.reserve(std::min(populationSize, sampleSize));
+    for(std::size_t i = 0; i < populationSize; ++i){
+        if(i < sampleSize){
+            reservoir.push_back(i);
+        } else {
+            std::size_t j = SampleRng.getRandomFromUniform(0, (unsigned int) i);
+            if(j < sampleSize)
+                reservoir[j] = i;
+        }
+    }
+    std::sort(reservoir.begin(), reservoir.end());
+    return reservoir;
+}
+
+/**
+ * @brief Data harvesting method. Writes what the schedule carries over from
+ * one generation to the next (for checkpoints): the diversity at the last
+ * save of each group of files and the state of the sampling generator, so a
+ * resumed run saves the same generations and draws the same samples.
+ *
+ * @param out - binary stream
+ */
+void OutputSchedule::writeState(std::ostream &out) const {
+    BinaryIO::writeVector(out, std::vector<double>(LastShannon, LastShannon + NumbOfHarvesters));
+    SampleRng.writeState(out);
+}
+
+/**
+ * @brief Data harvesting method. Reads the state written by writeState().
+ *
+ * @param in - binary stream
+ * @return 'false' if it could not be read
+ */
+bool OutputSchedule::readState(std::istream &in){
+    std::vector<double> lastShannon;
+    if(!BinaryIO::readVector(in, lastShannon) or !SampleRng.readState(in))
+        return false;
+    for(std::size_t h = 0; h < lastShannon.size() and h < (std::size_t) NumbOfHarvesters; ++h){
+        LastShannon[h] = lastShannon[h];
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+/*
+ * File:   OutputSchedule.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef OUTPUTSCHEDULE_H
+#define	OUTPUTSCHEDULE_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+
+/**
+ * @brief Groups of output files, each saved on its own cadence.
+ */
+enum class Harvester {
+    Diversity,      // HostsGeneDivers.csv
+    Presented,      // PresentedPathogenNumbers.csv
+    Mating,         // NumberOfMhcBeforeMating.csv, NumberOfMhcInMother.csv, NumberOfMhcInFather.csv, NumberOfMhcAfterMating.csv
+    GeneNumbers,    // HostGeneNumbTotal_ChrOne.csv, HostMHCsNumbUniq_ChrOne.csv
+    AlleleFreqs,    // AlleleFrequencies.csv
+    Genomes         // genome dumps (or snapshots) between the start and the end of run
+};
+
+const int NumbOfHarvesters = 6;
+
+/**
+ * @brief Kinds of cadence. The start and the end of run are saved on all of them.
+ */
+enum class CadenceKind {
+    Ends,           // only the start and the end of run
+    Every,          // every Value host generations
+    LogSpaced,      // Value generations per tenfold of time: 1, 2, 3, 4, 6, 7, 8, 10, 13, 16, 20, ... for 10
+    OnChange        // when the Shannon index of host MHCs changed by more than Value (relative) since the last save
+};
+
+/**
+ * @brief When a group of output files is saved. Written as text as "ends",
+ * "every:K", "log:N" or "change:X".
+ */
+struct OutputCadence {
+    CadenceKind Kind;
+    double Value;
+    bool fromString(const std::string &text);
+    std::string toString() const;
+};
+
+/**
+ * @brief Data harvesting class. Decides, once per host generation, which
+ * groups of output files (Harvester) are saved in it, and draws the samples of
+ * hosts and pathogens written to the genome dumps. Keeps the output cost
+ * bounded however large the population is and however long the run is.
+ */
+class OutputSchedule {
+public:
+    OutputSchedule();
+    virtual ~OutputSchedule();
+    void setCadence(Harvester harvester, const OutputCadence &cadence);
+    static OutputCadence getDefaultCadence(Harvester harvester);
+    void setLastGeneration(int tayme);
+    void setGenomeSample(unsigned long sampleSize);
+    unsigned long getGenomeSample() const;
+    bool needsDiversity() const;
+    void planGeneration(int tayme, double shannon);
+    bool isDue(Harvester harvester) const;
+    std::vector<std::size_t> drawSample(std::size_t populationSize, std::size_t sampleSize);
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in);
+private:
+    bool isDueAt(int harvester, int tayme, double shannon) const;
+    OutputCadence Cadences[NumbOfHarvesters];
+    bool Due[NumbOfHarvesters];                // in the current generation
+    double LastShannon[NumbOfHarvesters];      // at the last save, OnChange only; NaN - none yet
+    int LastGeneration;
+    unsigned long GenomeSample;                // hosts (and pathogens) in a genome dump, 0 - all of them
+    Random SampleRng;                          // not the model's generators, sampling does not change the run
+};
+
+#endif	/* OUTPUTSCHEDULE_H */
@@ -0,0 +1,208 @@
+/*
+ * File:   PathoEpitopeIndex.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <omp.h>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "PathoEpitopeIndex.h"
+#include "MemoryUsage.h"
+
+PathoEpitopeIndex::PathoEpitopeIndex() = default;
+
+PathoEpitopeIndex::~PathoEpitopeIndex() = default;
+
+/**
+ * @brief Core method. (Re)builds the index from the current pathogen population.
+ *
+ * Has to be called every time the pathogen population changes (after selection
+ * or mutation of pathogens). Species are indexed in parallel.
+ *
+ * @param PathPopulation - the pathogen population, one vector per species
+ */
+void PathoEpitopeIndex::buildIndex(std::vector<std::vector<Pathogen> > &PathPopulation){
+    unsigned long PathPopulationSize = PathPopulation.size();
+    SpeciesIndex.resize(PathPopulationSize);
+    #pragma omp parallel for default(none) shared(PathPopulation, PathPopulationSize) schedule(dynamic)
+    for(unsigned long sp = 0; sp < PathPopulationSize; ++sp){
+        SpeciesRows &spp = SpeciesIndex[sp];
+        spp.PopSize = PathPopulation[sp].size();
+        spp.NumOfWords = (spp.PopSize + 63) / 64;
+        spp.RowOfEpitope.clear();
+        spp.Rows.clear();
+        for(unsigned long j = 0; j < spp.PopSize; ++j){
+            for(unsigned long epi : PathPopulation[sp][j].getEpitopesRef()){
+                auto found = spp.RowOfEpitope.find(epi);
+                unsigned long row;
+                if(found == spp.RowOfEpitope.end()){
+                    row = spp.RowOfEpitope.size();
+                    spp.RowOfEpitope.emplace(epi, row);
+                    spp.Rows.resize(spp.Rows.size() + spp.NumOfWords, 0);
+                } else {
+                    row = found->second;
+                }
+                spp.Rows[row * spp.NumOfWords + j / 64] |= (uint64_t) 1 << (j % 64);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Core method. Gets the number of indexed pathogen species.
+ *
+ * @return number of species
+ */
+unsigned long PathoEpitopeIndex::getNumOfSpecies(){
+    return SpeciesIndex.size();
+}
+
+/**
+ * @brief Core method. Gets the number of individuals of a species at the time
+ * the index was built.
+ *
+ * @param spec - species index
+ * @return number of pathogens (bits) in this species
+ */
+unsigned long PathoEpitopeIndex::getSpeciesPopSize(unsigned long spec){
+    return SpeciesIndex[spec].PopSize;
+}
+
+/**
+ * @brief Core method. Gets the number of 64-bit words in one row of a species.
+ *
+ * @param spec - species index
+ * @return number of words per row
+ */
+unsigned long PathoEpitopeIndex::getNumOfWords(unsigned long spec){
+    return SpeciesIndex[spec].NumOfWords;
+}
+
+/**
+ * @brief Core method. Gets the number of distinct epitope values (rows) in a species.
+ *
+ * @param spec - species index
+ * @return number of rows
+ */
+unsigned long PathoEpitopeIndex::getNumOfRows(unsigned long spec){
+    return SpeciesIndex[spec].RowOfEpitope.size();
+}
+
+/**
+ * @brief Data harvesting method. Bytes held by the index (see MemoryUsage).
+ *
+ * @return bytes of the rows and of the epitope maps of all species
+ */
+uint64_t PathoEpitopeIndex::getMemoryBytes() const {
+    uint64_t bytes = MemoryAccounting::heapBytes(SpeciesIndex);
+    for(const SpeciesRows &species : SpeciesIndex){
+        bytes += MemoryAccounting::heapBytes(species.RowOfEpitope) + MemoryAccounting::heapBytes(species.Rows);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Core method. ORs into the mask the bits of pathogens presented by a host,
+ * limited to the range of words [firstWord, lastWord) of a species row.
+ *
+ * The mask is not cleared here, so the caller can accumulate. `mask` points at
+ * the word `firstWord` of the host's presented set.
+ *
+ * @param hostMHCs - values of the unique MHC alleles of a host
+ * @param spec - species index
+ * @param mask - output words, (lastWord - firstWord) of them
+ * @param firstWord - first word of the row to use
+ * @param lastWord - one past the last word of the row to use
+ */
+void PathoEpitopeIndex::orPresentedWords(const longIntVec &hostMHCs, unsigned long spec,
+                                         uint64_t *mask, unsigned long firstWord, unsigned long lastWord){
+    SpeciesRows &spp = SpeciesIndex[spec];
+    for(unsigned long mhc : hostMHCs){
+        auto found = spp.RowOfEpitope.find(mhc);
+        if(found != spp.RowOfEpitope.end()){
+            orWords(mask, spp.Rows.data() + found->second * spp.NumOfWords + firstWord, lastWord - firstWord);
+        }
+    }
+}
+
+/**
+ * @brief Core method. Builds the whole presented set of a host for one species and
+ * counts the pathogens in it.
+ *
+ * @param hostMHCs - values of the unique MHC alleles of a host
+ * @param spec - species index
+ * @param mask - output bit-set of presented pathogens (resized and cleared here)
+ * @return number of pathogens of this species presented by the host
+ */
+unsigned long PathoEpitopeIndex::countPresented(const longIntVec &hostMHCs, unsigned long spec,
+                                                bitWordsVec &mask){
+    unsigned long numWords = SpeciesIndex[spec].NumOfWords;
+    mask.assign(numWords, 0);
+    orPresentedWords(hostMHCs, spec, mask.data(), 0, numWords);
+    return popcountWords(mask.data(), numWords);
+}
+
+/**
+ * @brief Core method. dst |= src over a number of 64-bit words. Uses AVX-512 or
+ * AVX2 when the code is compiled for them (e.g. with -march=native), plain
+ * 64-bit words otherwise.
+ *
+ * @param dst - destination words
+ * @param src - source words
+ * @param numWords - number of words
+ */
+void PathoEpitopeIndex::orWords(uint64_t *dst, const uint64_t *src, unsigned long numWords){
+    unsigned long w = 0;
+#if defined(__AVX512F__)
+    for(; w + 8 <= numWords; w += 8){
+        __m512i a = _mm512_loadu_si512((const void *) (dst + w));
+        __m512i b = _mm512_loadu_si512((const void *) (src + w));
+        _mm512_storeu_si512((void *) (dst + w), _mm512_or_si512(a, b));
+    }
+#elif defined(__AVX2__)
+    for(; w + 4 <= numWords; w += 4){
+        __m256i a = _mm256_loadu_si256((const __m256i *) (dst + w));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (src + w));
+        _mm256_storeu_si256((__m256i *) (dst + w), _mm256_or_si256(a, b));
+    }
+#endif
+    for(; w < numWords; ++w){
+        dst[w] |= src[w];
+    }
+}
+
+/**
+ * @brief Core method. Counts set bits over a number of 64-bit words.
+ *
+ * @param src - the words
+ * @param numWords - number of words
+ * @return number of set bits
+ */
+unsigned long PathoEpitopeIndex::popcountWords(const uint64_t *src, unsigned long numWords){
+    unsigned long count = 0;
+    for(unsigned long w = 0; w < numWords; ++w){
+        count += (unsigned long) __builtin_popcountll(src[w]);
+    }
+    return count;
+}
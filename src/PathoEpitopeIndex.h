@@ -0,0 +1,70 @@
+/*
+ * File:   PathoEpitopeIndex.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef PATHOEPITOPEINDEX_H
+#define	PATHOEPITOPEINDEX_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "Pathogen.h"
+
+typedef std::vector<unsigned long int> longIntVec;
+typedef std::vector<uint64_t> bitWordsVec;
+
+/**
+ * @brief Core class. Transposed (epitope -> pathogens) view of the pathogen
+ * population used when every host meets every pathogen.
+ *
+ * For each pathogen species and each epitope value present in that species it
+ * keeps a bit-set over the pathogen individuals of the species: bit j is set if
+ * the j-th pathogen carries this epitope. The set of pathogens presented by
+ * a host is then the OR of the rows of its unique MHC alleles, which handles 64
+ * pathogens per machine word (more with AVX2 / AVX-512 when compiled for them).
+ * Only the epitope values that actually occur get a row.
+ */
+class PathoEpitopeIndex {
+public:
+    PathoEpitopeIndex();
+    virtual ~PathoEpitopeIndex();
+    void buildIndex(std::vector<std::vector<Pathogen> > &PathPopulation);
+    unsigned long getNumOfSpecies();
+    unsigned long getSpeciesPopSize(unsigned long spec);
+    unsigned long getNumOfWords(unsigned long spec);
+    unsigned long getNumOfRows(unsigned long spec);
+    uint64_t getMemoryBytes() const;
+    void orPresentedWords(const longIntVec &hostMHCs, unsigned long spec,
+                          uint64_t *mask, unsigned long firstWord, unsigned long lastWord);
+    unsigned long countPresented(const longIntVec &hostMHCs, unsigned long spec, bitWordsVec &mask);
+    static void orWords(uint64_t *dst, const uint64_t *src, unsigned long numWords);
+    static unsigned long popcountWords(const uint64_t *src, unsigned long numWords);
+private:
+    struct SpeciesRows {
+        unsigned long PopSize;
+        unsigned long NumOfWords;
+        std::unordered_map<unsigned long, unsigned long> RowOfEpitope;
+        bitWordsVec Rows;  // row r occupies words [r * NumOfWords, (r + 1) * NumOfWords)
+    };
+    std::vector<SpeciesRows> SpeciesIndex;
+};
+
+#endif	/* PATHOEPITOPEINDEX_H */
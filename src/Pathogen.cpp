@@ -25,6 +25,8 @@
 #include "boost/dynamic_bitset.hpp"
 
 #include "Pathogen.h"
+#include "BinaryIO.h"
+#include "TextFormat.h"
 
 typedef boost::dynamic_bitset<> antigenstring;
 typedef std::string sttr;
@@ -81,6 +83,25 @@ void Pathogen::setNewPathogenNthSwap(anigenstring antigen, unsigned long int Tag
     PathoProtein.setAntigenFlipedPositions(antigen, Tag, Nth, mhcSize, timeStamp);
 }
 
+/**
+ * @brief Core method. Sets a pathogen with a given antigen, e.g. one read from
+ * a file with pathogen genomes.
+ *
+ * @param antigen - the antigen as a bit-string
+ * @param Tag - tag of the antigen
+ * @param mhcSize - length of a bit string representing the MHC protein
+ * @param species - species of the pathogen
+ * @param timeStamp - time of origin of the antigen
+ * @param parentTags - tags of the antigen's ancestors
+ */
+void Pathogen::setPathogenFromAntigen(anigenstring antigen, unsigned long int Tag, unsigned long mhcSize,
+                                      int species, int timeStamp, const std::vector<unsigned long int> &parentTags){
+    Species = species;
+    NumOfHostsInfected = 0;
+    SelectedToReproduct = 0;
+    PathoProtein.setAntigenFromBits(antigen, Tag, mhcSize, timeStamp, parentTags);
+}
+
 /**
  * @brief Core method. Decides (on a random basis) if there will be any mutations
  * in the genome.
@@ -132,12 +153,31 @@ Antigen Pathogen::getAntigenProt(){
     return PathoProtein;
 }
 
+/**
+ * @brief Core method. Fetches the antigen without copying it.
+ *
+ * @return read-only reference to the antigen
+ */
+const Antigen& Pathogen::getAntigenRef() const {
+    return PathoProtein;
+}
+
+/**
+ * @brief Core method. Fetches the epitopes of the pathogen's antigen without
+ * copying the whole Antigen object.
+ *
+ * @return read-only reference to the vector of epitopes.
+ */
+const longIntVec& Pathogen::getEpitopesRef() const {
+    return PathoProtein.getEpitopesRef();
+}
+
 /**
  * @brief Core method. Fetches a species tag.
  *
  * @return - integer being the species tag.
  */
-int Pathogen::getSpeciesTag(){
+int Pathogen::getSpeciesTag() const {
     return Species;
 }
 
@@ -157,22 +197,38 @@ void Pathogen::clearInfections(){
  * @return STD string being in human readable format.
  */
 std::string Pathogen::stringGenesFromGenome(){
-    sttr genomeString;
-    genomeString = sttr(" === Patho. sp. No. ") + std::to_string(Species) +
-            sttr(" has infected ") + std::to_string(NumOfHostsInfected) +
-            sttr(" hosts ===\n");
-    sttr bitAntigen;
-    boost::to_string(PathoProtein.getBitAntigen(), bitAntigen);
-    genomeString += sttr(bitAntigen) + sttr("\tch_pat\t")
-               + std::to_string(PathoProtein.timeOfOrigin) + sttr("\t")
-               + std::to_string(PathoProtein.AntigenTag);
-    unsigned long PathoProtsIthParentTagsSize = PathoProtein.ParentTags.size();
-    for (unsigned long j = 0; j < PathoProtsIthParentTagsSize; ++j){
-        genomeString += sttr("\t") + std::to_string(PathoProtein.ParentTags[j]);
-    }
-    genomeString += sttr("\n");
+    std::vector<char> text;
+    appendGenesFromGenome(text);
+    return std::string(text.begin(), text.end());
+}
 
-    return genomeString;
+/**
+ * @brief Data harvesting method. Appends the whole pathogen genome to a text
+ * buffer, in the same format as Pathogen::stringGenesFromGenome() gives it.
+ *
+ * @param text - the buffer
+ */
+void Pathogen::appendGenesFromGenome(std::vector<char> &text) const {
+    const antigenstring &bitAntigen = PathoProtein.getBitAntigenRef();
+    std::size_t used = text.size();
+    text.resize(used + 64 + bitAntigen.size() + (PathoProtein.ParentTags.size() + 4) * (TextFormat::MaxDigits + 2));
+    char *p = text.data() + used;
+    p = TextFormat::writeText(p, " === Patho. sp. No. ");
+    p = TextFormat::write(p, Species);
+    p = TextFormat::writeText(p, " has infected ");
+    p = TextFormat::write(p, NumOfHostsInfected);
+    p = TextFormat::writeText(p, " hosts ===\n");
+    p = TextFormat::writeBits(p, bitAntigen);
+    p = TextFormat::writeText(p, "\tch_pat\t");
+    p = TextFormat::write(p, PathoProtein.timeOfOrigin);
+    *p++ = '\t';
+    p = TextFormat::write(p, PathoProtein.AntigenTag);
+    for (unsigned long parentTag : PathoProtein.ParentTags){
+        *p++ = '\t';
+        p = TextFormat::write(p, parentTag);
+    }
+    *p++ = '\n';
+    text.resize(p - text.data());
 }
 
 /**
@@ -183,3 +239,26 @@ void Pathogen::printGenesFromGenome(){
               << NumOfHostsInfected << " hosts ===" << std::endl;
     std::cout << PathoProtein.getBitAntigen() << std::endl;
 }
+
+/**
+ * @brief Core method. Writes the pathogen to a binary stream (see BinaryIO).
+ *
+ * @param out - the stream
+ */
+void Pathogen::writeState(std::ostream &out) const {
+    BinaryIO::write(out, Species);
+    BinaryIO::write(out, NumOfHostsInfected);
+    BinaryIO::write(out, SelectedToReproduct);
+    PathoProtein.writeState(out);
+}
+
+/**
+ * @brief Core method. Reads a pathogen written by writeState().
+ *
+ * @param in - the stream
+ * @return 'false' if the pathogen could not be read
+ */
+bool Pathogen::readState(std::istream &in){
+    return BinaryIO::read(in, Species) and BinaryIO::read(in, NumOfHostsInfected)
+           and BinaryIO::read(in, SelectedToReproduct) and PathoProtein.readState(in);
+}
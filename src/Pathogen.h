@@ -48,19 +48,26 @@ public:
     int SelectedToReproduct;
     void setNewPathogen(unsigned long antigen_size, unsigned long mhcSize,
                         int species, int timeStamp, Random& randGen, Tagging_system& tag);
+    void setPathogenFromAntigen(anigenstring antigen, unsigned long int Tag, unsigned long mhcSize,
+                                int species, int timeStamp, const std::vector<unsigned long int> &parentTags);
     void setNewPathogenNthSwap(anigenstring antigen, unsigned long int Tag, unsigned long mhcSize,
                                int species, int timeStamp, int Nth);
     Antigen getAntigenProt();
+    const Antigen& getAntigenRef() const;
+    const longIntVec& getEpitopesRef() const;
     void chromoMutProcess(double mut_probabl, unsigned long mhcSize, int timeStamp, Random& randGen, Tagging_system& tag);
     void chromoMutProcessWithRestric(double mut_probabl, unsigned long mhcSize, int timeStamp,
                                      std::set<unsigned long>& noMutts, Random& randGen, Tagging_system& tag);
     void setNewSpeciesNumber(int new_spp_num);
-    int getSpeciesTag();
+    int getSpeciesTag() const;
     void clearInfections();
     // === Data harvesting methods ===
     std::string stringGenesFromGenome();
+    void appendGenesFromGenome(std::vector<char> &text) const;
     // === Auxiliary methods ===
     void printGenesFromGenome();
+    void writeState(std::ostream &out) const;
+    bool readState(std::istream &in);
 private:
     Antigen PathoProtein;
     int Species;
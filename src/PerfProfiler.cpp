@@ -0,0 +1,384 @@
+/*
+ * File:   PerfProfiler.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <omp.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "PerfProfiler.h"
+#include "HardwareCounters.h"
+#include "TraceRecorder.h"
+
+using jsonf = nlohmann::json;
+
+namespace {
+
+    thread_local PerfProfiler *CurrentProfiler = nullptr;
+
+    const char* const PhaseNames[NumbOfPerfPhases] = {
+        "infection", "patho_selection", "patho_mutation", "fitness", "host_selection", "mating",
+        "host_mutation", "save_presented_pathogens", "save_mhc_before_mating", "save_mhc_when_mating",
+        "save_mhc_after_mating", "save_gene_diversity", "save_gene_numbers", "save_allele_frequencies",
+        "save_genomes", "save_snapshot", "checkpoint", "save_memory_usage"
+    };
+
+    const char* const KernelNames[NumbOfPerfKernels] = {
+        "mutate_host", "select_patho_species", "mutate_pathogens", "infect_hosts"
+    };
+
+    inline double secondsSince(std::chrono::steady_clock::time_point since){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    }
+}
+
+/**
+ * @brief Data harvesting method. Name of a phase as it is written to PerfReport.json.
+ */
+const char* getPerfPhaseName(PerfPhase phase){
+    return PhaseNames[(int) phase];
+}
+
+/**
+ * @brief Data harvesting method. Constructor. Nothing is timed until start().
+ */
+PerfProfiler::PerfProfiler() : Started(std::chrono::steady_clock::now()), FirstGeneration(0),
+    LastGeneration(0), NumbOfGenerations(0), TraceEvents(0), CountersOn(false), NumbOfHosts(0),
+    NumbOfPathos(0) {
+    for(int p = 0; p < NumbOfPerfPhases; ++p){
+        Calls[p] = 0;
+        Wall[p] = 0.0;
+        Depth[p] = 0;
+    }
+}
+
+PerfProfiler::~PerfProfiler() = default;
+
+/**
+ * @brief Data harvesting method. Switches tracing on (see TraceRecorder), from
+ * the next start() on.
+ *
+ * @param eventsPerThread - events kept per thread (the last ones), 0 - no tracing
+ */
+void PerfProfiler::setTracing(std::size_t eventsPerThread){
+    TraceEvents = eventsPerThread;
+}
+
+/**
+ * @brief Data harvesting method. Switches the hardware counters on (see
+ * HardwareCounters), from the next start() on.
+ *
+ * @param countersOn - 'true' to count
+ */
+void PerfProfiler::setHardwareCounters(bool countersOn){
+    CountersOn = countersOn;
+}
+
+/**
+ * @brief Data harvesting method. Sizes of the populations a call of a phase
+ * works on, for the misses per host and per pathogen.
+ *
+ * @param numbOfHosts - number of hosts
+ * @param numbOfPathos - number of pathogens, all species together
+ */
+void PerfProfiler::setPopulationSizes(unsigned long numbOfHosts, unsigned long numbOfPathos){
+    NumbOfHosts = numbOfHosts;
+    NumbOfPathos = numbOfPathos;
+}
+
+/**
+ * @brief Data harvesting method. Starts timing: registers the CPU clocks (and
+ * opens the hardware counters) of the OpenMP threads the calling thread runs
+ * its parallel regions with, and starts the clock of the whole run. Call it
+ * on the thread running the simulation, after the number of threads is set.
+ */
+void PerfProfiler::start(){
+    int numberOfThreads = omp_get_max_threads();
+    std::vector<clockid_t> clocks(numberOfThreads);
+    std::vector<long> threadIds(numberOfThreads);
+    int teamSize = 1;
+    #pragma omp parallel num_threads(numberOfThreads) default(none) shared(clocks, threadIds, teamSize)
+    {
+        int thread = omp_get_thread_num();
+        if(thread == 0)
+            teamSize = omp_get_num_threads();
+        if(pthread_getcpuclockid(pthread_self(), &clocks[thread]) != 0)
+            clocks[thread] = CLOCK_THREAD_CPUTIME_ID;
+        threadIds[thread] = syscall(SYS_gettid);
+    }
+    clocks.resize(teamSize);
+    threadIds.resize(teamSize);
+    ThreadClocks = clocks;
+    for(int p = 0; p < NumbOfPerfPhases; ++p){
+        ThreadCpu[p].assign(ThreadClocks.size(), 0.0);
+        PhaseStartedCpu[p].assign(ThreadClocks.size(), 0.0);
+        Counts[p].assign(ThreadClocks.size() * NumbOfHwCounters, 0);
+    }
+    Trace.reset(TraceEvents > 0 ? new TraceRecorder(TraceEvents, ThreadClocks.size()) : nullptr);
+    Counters.reset(CountersOn ? new HardwareCounters() : nullptr);
+    if(Counters and !Counters->open(threadIds))
+        std::cout << "Hardware counters cannot be read: " << Counters->getError() << std::endl;
+    Started = std::chrono::steady_clock::now();
+    readThreadCpu(StartedCpu);
+}
+
+/**
+ * @brief Data harvesting method. Reads the CPU time of every registered
+ * thread. A thread that is gone reads as 0.
+ */
+void PerfProfiler::readThreadCpu(std::vector<double> &cpu) const {
+    cpu.resize(ThreadClocks.size());
+    for(std::size_t t = 0; t < ThreadClocks.size(); ++t){
+        timespec ts;
+        cpu[t] = clock_gettime(ThreadClocks[t], &ts) == 0 ? ts.tv_sec + 1e-9 * ts.tv_nsec : 0.0;
+    }
+}
+
+/**
+ * @brief Data harvesting method. A phase starts (see PERF_PHASE()).
+ */
+void PerfProfiler::begin(PerfPhase phase){
+    int p = (int) phase;
+    if(Depth[p]++ > 0)
+        return;
+    if(Trace)
+        Trace->record(0, (uint16_t) p, true);
+    readThreadCpu(PhaseStartedCpu[p]);
+    if(Counters)
+        Counters->read(PhaseStartedCounts[p]);
+    PhaseStarted[p] = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Data harvesting method. A phase ends (see PERF_PHASE()).
+ */
+void PerfProfiler::end(PerfPhase phase){
+    int p = (int) phase;
+    if(--Depth[p] > 0)
+        return;
+    Wall[p] += secondsSince(PhaseStarted[p]);
+    ++Calls[p];
+    readThreadCpu(CpuNow);
+    for(std::size_t t = 0; t < CpuNow.size() and t < ThreadCpu[p].size(); ++t){
+        if(CpuNow[t] > PhaseStartedCpu[p][t])
+            ThreadCpu[p][t] += CpuNow[t] - PhaseStartedCpu[p][t];
+    }
+    if(Counters){
+        Counters->read(CountsNow);
+        for(std::size_t i = 0; i < CountsNow.size() and i < Counts[p].size(); ++i){
+            if(CountsNow[i] > PhaseStartedCounts[p][i])
+                Counts[p][i] += CountsNow[i] - PhaseStartedCounts[p][i];
+        }
+    }
+    if(Trace)
+        Trace->record(0, (uint16_t) p, false);
+}
+
+/**
+ * @brief Data harvesting method. A kernel starts on the calling OpenMP thread
+ * (see PERF_KERNEL()). Call it only when tracing.
+ */
+void PerfProfiler::beginKernel(PerfKernel kernel){
+    Trace->record(omp_get_thread_num(), (uint16_t) (NumbOfPerfPhases + (int) kernel), true);
+}
+
+/**
+ * @brief Data harvesting method. A kernel ends on the calling OpenMP thread.
+ */
+void PerfProfiler::endKernel(PerfKernel kernel){
+    Trace->record(omp_get_thread_num(), (uint16_t) (NumbOfPerfPhases + (int) kernel), false);
+}
+
+/**
+ * @brief Data harvesting method. A host generation is done.
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+void PerfProfiler::countGeneration(int tayme){
+    if(NumbOfGenerations == 0)
+        FirstGeneration = tayme;
+    LastGeneration = tayme;
+    ++NumbOfGenerations;
+}
+
+/**
+ * @brief Data harvesting method. The timings gathered so far: the whole run
+ * and each phase that was called, with the wall time, its share of the run,
+ * the CPU time of each thread and their sum, and the parallel efficiency (CPU
+ * time over wall time times the number of threads; threads busy-waiting for
+ * work count as busy).
+ *
+ * @return JSON object
+ */
+jsonf PerfProfiler::toJson() const {
+    double wall = secondsSince(Started);
+    std::vector<double> cpu;
+    readThreadCpu(cpu);
+    for(std::size_t t = 0; t < cpu.size() and t < StartedCpu.size(); ++t){
+        cpu[t] = cpu[t] > StartedCpu[t] ? cpu[t] - StartedCpu[t] : 0.0;
+    }
+    double numbOfThreads = (double) ThreadClocks.size();
+    jsonf report;
+    report["threads"] = ThreadClocks.size();
+    report["generations"] = NumbOfGenerations;
+    report["first_generation"] = FirstGeneration;
+    report["last_generation"] = LastGeneration;
+    report["wall_seconds"] = wall;
+    report["thread_cpu_seconds"] = cpu;
+    double phasesWall = 0.0;
+    jsonf phases = jsonf::object();
+    for(int p = 0; p < NumbOfPerfPhases; ++p){
+        if(Calls[p] == 0)
+            continue;
+        double cpuSum = 0.0;
+        for(double threadCpu : ThreadCpu[p])
+            cpuSum += threadCpu;
+        jsonf phase;
+        phase["calls"] = Calls[p];
+        phase["wall_seconds"] = Wall[p];
+        phase["wall_fraction"] = wall > 0.0 ? Wall[p] / wall : 0.0;
+        phase["wall_seconds_per_generation"] = NumbOfGenerations > 0 ? Wall[p] / NumbOfGenerations : 0.0;
+        phase["cpu_seconds"] = cpuSum;
+        phase["thread_cpu_seconds"] = ThreadCpu[p];
+        phase["parallel_efficiency"] = Wall[p] > 0.0 ? cpuSum / (Wall[p] * numbOfThreads) : 0.0;
+        jsonf counters = Counters ? countersToJson(p) : jsonf();
+        if(!counters.is_null())
+            phase["hardware_counters"] = counters;
+        phases[PhaseNames[p]] = phase;
+        phasesWall += Wall[p];
+    }
+    report["phases"] = phases;
+    report["other_wall_seconds"] = wall > phasesWall ? wall - phasesWall : 0.0;
+    if(Trace)
+        report["trace_dropped_events"] = Trace->getNumbOfDropped();
+    if(Counters){
+        jsonf counting = jsonf::array();
+        for(int c = 0; c < NumbOfHwCounters; ++c){
+            if(Counters->isCounting((HwCounter) c))
+                counting.push_back(getHwCounterName((HwCounter) c));
+        }
+        report["hardware_counters"] = counting;
+        if(!Counters->getError().empty())
+            report["hardware_counters_error"] = Counters->getError();
+    }
+    return report;
+}
+
+/**
+ * @brief Data harvesting method. Hardware counts of a phase: the sums over the
+ * threads, the instructions per cycle, the instructions and misses per host
+ * and per pathogen of a call, and the counts of each thread. Counters that are
+ * not counting are left out.
+ *
+ * @param phase - the phase
+ * @return JSON object
+ */
+jsonf PerfProfiler::countersToJson(int phase) const {
+    std::size_t numbOfThreads = Counters->getNumbOfThreads();
+    double perHost = Calls[phase] > 0 and NumbOfHosts > 0 ? 1.0 / ((double) Calls[phase] * NumbOfHosts) : 0.0;
+    double perPatho = Calls[phase] > 0 and NumbOfPathos > 0 ? 1.0 / ((double) Calls[phase] * NumbOfPathos) : 0.0;
+    uint64_t totals[NumbOfHwCounters];
+    jsonf counters;
+    for(int c = 0; c < NumbOfHwCounters; ++c){
+        totals[c] = 0;
+        if(!Counters->isCounting((HwCounter) c))
+            continue;
+        std::vector<uint64_t> threadCounts(numbOfThreads);
+        for(std::size_t t = 0; t < numbOfThreads; ++t){
+            threadCounts[t] = Counts[phase][t * NumbOfHwCounters + c];
+            totals[c] += threadCounts[t];
+        }
+        std::string name = getHwCounterName((HwCounter) c);
+        counters[name] = totals[c];
+        counters["thread_" + name] = threadCounts;
+        if((HwCounter) c != HwCounter::Cycles){
+            counters[name + "_per_host"] = totals[c] * perHost;
+            counters[name + "_per_pathogen"] = totals[c] * perPatho;
+        }
+    }
+    if(Counters->isCounting(HwCounter::Cycles) and Counters->isCounting(HwCounter::Instructions)){
+        uint64_t cycles = totals[(int) HwCounter::Cycles];
+        counters["ipc"] = cycles > 0 ? (double) totals[(int) HwCounter::Instructions] / cycles : 0.0;
+    }
+    return counters;
+}
+
+/**
+ * @brief Data harvesting method. Writes the timings (toJson()) to a file. The
+ * file is written aside and renamed, so a periodic dump never leaves it half
+ * written.
+ *
+ * @param fileName - path to the file
+ * @return 'false' if it could not be written
+ */
+bool PerfProfiler::writeReport(const std::string &fileName) const {
+    std::string tmpName = fileName + ".tmp";
+    std::ofstream out(tmpName);
+    out << toJson().dump(4) << std::endl;
+    out.close();
+    if(!out or std::rename(tmpName.c_str(), fileName.c_str()) != 0){
+        std::cout << "Error in PerfProfiler::writeReport(): cannot write the file " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Writes the timeline recorded so far as a
+ * Chrome trace event file (see TraceRecorder), if tracing is on.
+ *
+ * @param fileName - path to the file
+ * @return 'false' if it could not be written
+ */
+bool PerfProfiler::writeTrace(const std::string &fileName) const {
+    if(!Trace)
+        return true;
+    std::vector<std::string> names, categories;
+    for(int p = 0; p < NumbOfPerfPhases; ++p){
+        names.push_back(PhaseNames[p]);
+        categories.push_back("phase");
+    }
+    for(int k = 0; k < NumbOfPerfKernels; ++k){
+        names.push_back(KernelNames[k]);
+        categories.push_back("kernel");
+    }
+    return Trace->writeChromeTrace(fileName, names, categories);
+}
+
+/**
+ * @brief Data harvesting method. The current profiler of the calling thread,
+ * nullptr if there is none.
+ */
+PerfProfiler* PerfProfiler::getCurrent(){
+    return CurrentProfiler;
+}
+
+PerfProfiler::Activation::Activation(PerfProfiler &profiler) : Previous(CurrentProfiler) {
+    CurrentProfiler = &profiler;
+}
+
+PerfProfiler::Activation::~Activation(){
+    CurrentProfiler = Previous;
+}
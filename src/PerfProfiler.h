@@ -0,0 +1,229 @@
+/*
+ * File:   PerfProfiler.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef PERFPROFILER_H
+#define	PERFPROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+class TraceRecorder;
+class HardwareCounters;
+
+/*
+ * Phase timers are compiled in unless MHC_NO_PERF_TIMERS is defined (cmake
+ * -DMHC_PERF_TIMERS=OFF). Without them PERF_PHASE(), PERF_PROFILER() and
+ * PERF_KERNEL() are empty statements, PERF_PROFILER_SHARED is no clause at all
+ * and no PerfReport.json (nor Trace.json) is written.
+ *
+ * Kernels are traced inside parallel regions: PERF_PROFILER() takes the
+ * profiler of the simulation thread before the region, PERF_PROFILER_SHARED
+ * (a clause of the parallel pragma) shares it with the team and
+ * PERF_KERNEL(kernel) traces a kernel on the thread that runs it.
+ */
+#ifdef MHC_NO_PERF_TIMERS
+const bool PerfTimersOn = false;
+#define PERF_PHASE(phase) ((void) 0)
+#define PERF_PROFILER() ((void) 0)
+#define PERF_PROFILER_SHARED
+#define PERF_KERNEL(kernel) ((void) 0)
+#else
+const bool PerfTimersOn = true;
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+#define PERF_PHASE(phase) PerfScope PERF_CONCAT(perfScope, __LINE__)(phase)
+#define PERF_PROFILER() PerfProfiler *perfProfiler = PerfProfiler::getCurrent()
+#define PERF_PROFILER_SHARED shared(perfProfiler)
+#define PERF_KERNEL(kernel) PerfKernelScope PERF_CONCAT(perfKernel, __LINE__)(perfProfiler, kernel)
+#endif
+
+/**
+ * @brief Phases of a generation timed by PerfProfiler.
+ */
+enum class PerfPhase {
+    Infection,
+    PathoSelection,
+    PathoMutation,
+    Fitness,
+    HostSelection,
+    Mating,
+    HostMutation,
+    SavePresented,
+    SaveMhcBeforeMating,
+    SaveMhcWhenMating,
+    SaveMhcAfterMating,
+    SaveDiversity,
+    SaveGeneNumbers,
+    SaveAlleleFreqs,
+    SaveGenomes,
+    SaveSnapshot,
+    Checkpoint,
+    SaveMemoryUsage
+};
+
+const int NumbOfPerfPhases = 18;
+
+/**
+ * @brief Pieces of work inside the parallel regions of a phase, traced per
+ * OpenMP thread when tracing is on (see PerfProfiler::setTracing()).
+ */
+enum class PerfKernel {
+    MutateHost,          // one host in Environment::mutateHostsWithDelDuplPointMuts() and the like
+    SelectPathoSpecies,  // one pathogen species in Environment::selectAndReproducePathoFixedPopSizes()
+    MutatePathogens,     // share of a thread of one species in Environment::mutatePathogensWithRestric()
+    InfectHosts          // share of a thread in Environment::infectWithDrawnPathoIndices()
+};
+
+const int NumbOfPerfKernels = 4;
+
+const char* getPerfPhaseName(PerfPhase phase);
+
+/**
+ * @brief Data harvesting class. Accumulates, for each phase of a generation,
+ * the number of calls, the wall time and the CPU time of every OpenMP thread
+ * of the simulation, and writes it all as PerfReport.json.
+ *
+ * Each simulation has its own profiler. It is made the current one of the
+ * thread running the simulation by an Activation, and PERF_PHASE() scopes
+ * opened on that thread report to it; on other threads they do nothing. CPU
+ * times of the OpenMP threads are read through their CPU clocks, registered
+ * when the profiler is started. A phase opened again inside itself is counted
+ * once.
+ *
+ * With tracing on the profiler also records the begin and end of every phase
+ * and of every kernel (PERF_KERNEL(), inside parallel regions), on the track
+ * of the OpenMP thread that ran it, and writes the timeline as Trace.json.
+ *
+ * With hardware counters on (see HardwareCounters) each phase also gets the
+ * cycles, instructions, last level cache misses and branch mispredictions of
+ * all the threads while it ran, reported with the instructions per cycle and
+ * the misses per host and per pathogen of a call.
+ */
+class PerfProfiler {
+public:
+    PerfProfiler();
+    virtual ~PerfProfiler();
+    void setTracing(std::size_t eventsPerThread);
+    void setHardwareCounters(bool countersOn);
+    void setPopulationSizes(unsigned long numbOfHosts, unsigned long numbOfPathos);
+    void start();
+    void begin(PerfPhase phase);
+    void end(PerfPhase phase);
+    void beginKernel(PerfKernel kernel);
+    void endKernel(PerfKernel kernel);
+    bool isTracing() const { return Trace != nullptr; }
+    void countGeneration(int tayme);
+    nlohmann::json toJson() const;
+    bool writeReport(const std::string &fileName) const;
+    bool writeTrace(const std::string &fileName) const;
+    static PerfProfiler* getCurrent();
+
+    /**
+     * @brief Makes a profiler the current one of the calling thread for the
+     * life time of the object.
+     */
+    class Activation {
+    public:
+        explicit Activation(PerfProfiler &profiler);
+        ~Activation();
+    private:
+        PerfProfiler *Previous;
+    };
+private:
+    void readThreadCpu(std::vector<double> &cpu) const;
+    nlohmann::json countersToJson(int phase) const;
+    std::vector<clockid_t> ThreadClocks;       // CPU clocks of the OpenMP threads, by thread number
+    std::chrono::steady_clock::time_point Started;
+    std::vector<double> StartedCpu;
+    uint64_t Calls[NumbOfPerfPhases];
+    double Wall[NumbOfPerfPhases];
+    std::vector<double> ThreadCpu[NumbOfPerfPhases];
+    int Depth[NumbOfPerfPhases];               // open scopes of each phase
+    std::chrono::steady_clock::time_point PhaseStarted[NumbOfPerfPhases];
+    std::vector<double> PhaseStartedCpu[NumbOfPerfPhases];
+    std::vector<double> CpuNow;
+    int FirstGeneration;
+    int LastGeneration;
+    long NumbOfGenerations;
+    std::size_t TraceEvents;                   // events kept per thread, 0 - no tracing
+    std::unique_ptr<TraceRecorder> Trace;
+    bool CountersOn;
+    std::unique_ptr<HardwareCounters> Counters;
+    std::vector<uint64_t> Counts[NumbOfPerfPhases];        // [thread * NumbOfHwCounters + counter]
+    std::vector<uint64_t> PhaseStartedCounts[NumbOfPerfPhases];
+    std::vector<uint64_t> CountsNow;
+    unsigned long NumbOfHosts;
+    unsigned long NumbOfPathos;
+};
+
+/**
+ * @brief Data harvesting class. Times a phase from its construction to its
+ * destruction, for the current profiler of the thread (if any). Use it through
+ * PERF_PHASE(), which compiles to nothing when the timers are off.
+ */
+class PerfScope {
+public:
+    explicit PerfScope(PerfPhase phase) : Profiler(PerfProfiler::getCurrent()), Phase(phase) {
+        if(Profiler)
+            Profiler->begin(Phase);
+    }
+    ~PerfScope() {
+        if(Profiler)
+            Profiler->end(Phase);
+    }
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+private:
+    PerfProfiler *Profiler;
+    PerfPhase Phase;
+};
+
+/**
+ * @brief Data harvesting class. Traces a kernel, from its construction to its
+ * destruction, on the thread it runs on. The profiler is taken before the
+ * parallel region (the current one is set on the simulation thread only). Use
+ * it through PERF_PROFILER() and PERF_KERNEL().
+ */
+class PerfKernelScope {
+public:
+    PerfKernelScope(PerfProfiler *profiler, PerfKernel kernel)
+            : Profiler(profiler and profiler->isTracing() ? profiler : nullptr), Kernel(kernel) {
+        if(Profiler)
+            Profiler->beginKernel(Kernel);
+    }
+    ~PerfKernelScope() {
+        if(Profiler)
+            Profiler->endKernel(Kernel);
+    }
+    PerfKernelScope(const PerfKernelScope&) = delete;
+    PerfKernelScope& operator=(const PerfKernelScope&) = delete;
+private:
+    PerfProfiler *Profiler;
+    PerfKernel Kernel;
+};
+
+#endif	/* PERFPROFILER_H */
@@ -1,5 +1,7 @@
 #include <random>
 #include <stdexcept>
+#include <sstream>
+#include "BinaryIO.h"
 #include "Random.h"
 
 /**
@@ -49,6 +51,38 @@ unsigned int Random::getRandomFromUniform(unsigned int from, unsigned int thru)
 }
 
 
+/**
+ * @brief Fills a strided array with random values in [0, range) drawn with
+ * Lemire's nearly-divisionless method.
+ *
+ * Works in two passes: first the raw engine output is written to all the slots,
+ * then each slot is mapped to the range with a multiply-shift. One 32-bit draw
+ * and one multiplication per slot; the (slow) modulo is done once per call and
+ * a slot is drawn again only in the rare case it falls into the biased zone.
+ * See: Lemire D. (2019) *Fast Random Integer Generation in an Interval*.
+ * ACM TOMACS 29(1).
+ *
+ * @param out - pointer to the first slot to fill
+ * @param count - number of slots to fill
+ * @param stride - distance (in elements) between two consecutive slots
+ * @param range - number of possible values (has to be larger than 0)
+ */
+void Random::fillBoundedLemire(unsigned int* out, unsigned long count, unsigned long stride, unsigned int range)
+{
+    for(unsigned long i = 0; i < count; ++i){
+        out[i * stride] = (uint32_t) m_mt();
+    }
+    uint32_t threshold = (uint32_t) (-range) % range;
+    for(unsigned long i = 0; i < count; ++i){
+        uint64_t m = (uint64_t) out[i * stride] * (uint64_t) range;
+        while ((uint32_t) m < threshold) {
+            m = (uint64_t) (uint32_t) m_mt() * (uint64_t) range;
+        }
+        out[i * stride] = (unsigned int) (m >> 32);
+    }
+}
+
+
 /**
  * @brief Returns a random float value in [0, 1) from uniform distribution
  *
@@ -208,4 +242,31 @@ float Random::CustomProb::getOneValue(unsigned int indx) {
 
 std::mt19937 Random::returnEngene() {
     return m_mt;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Writes the state of the PRNG engine to a binary stream, so the
+ * sequence of numbers can be continued exactly (see readState()).
+ *
+ * @param out - the stream
+ */
+void Random::writeState(std::ostream &out) const {
+    std::stringstream ss;
+    ss << m_mt;
+    BinaryIO::writeString(out, ss.str());
+}
+
+/**
+ * @brief Reads the state of the PRNG engine written by writeState().
+ *
+ * @param in - the stream
+ * @return 'false' if the state could not be read
+ */
+bool Random::readState(std::istream &in) {
+    std::string state;
+    if(!BinaryIO::readString(in, state))
+        return false;
+    std::stringstream ss(state);
+    ss >> m_mt;
+    return !ss.fail();
+}
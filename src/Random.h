@@ -1,3 +1,4 @@
+#include <iostream>
 #include <random>
 
 #ifndef RANDOM_H
@@ -32,6 +33,8 @@ class Random{
         };
         //return a random unsigned int value in [min, max] from uniform distribution
         unsigned int getRandomFromUniform(unsigned int from, unsigned int thru);
+        //fill `count` strided slots of `out` with random values in [0, range) with Lemire's method
+        void fillBoundedLemire(unsigned int* out, unsigned long count, unsigned long stride, unsigned int range);
         //return a random float value in [0, 1) from uniform distribution
         float getUni();
         //return a random double value in [min, max] from uniform distribution
@@ -47,6 +50,9 @@ class Random{
         std::vector<float> getAlotOfValuesAccordingToGivenProb(CustomProb probData, unsigned int manySamples);
 
         std::mt19937 returnEngene();
+        //write/read the state of the engine to/from a binary stream (see BinaryIO)
+        void writeState(std::ostream &out) const;
+        bool readState(std::istream &in);
 };
 
 #endif // RANDOM_H
@@ -0,0 +1,201 @@
+/*
+ * File:   RecordStream.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "RecordStream.h"
+
+/**
+ * @brief Data harvesting method. Constructor.
+ *
+ * @param bufferSize - bytes kept in memory before they are written to the file
+ */
+RecordFileBuf::RecordFileBuf(std::size_t bufferSize) : FileDescriptor(-1), Buffer(bufferSize ? bufferSize : 1),
+                                                       Failed(false) {
+    setp(Buffer.data(), Buffer.data() + Buffer.size());
+}
+
+/**
+ * @brief Data harvesting method. Destructor. Writes out what is buffered.
+ */
+RecordFileBuf::~RecordFileBuf() {
+    close();
+}
+
+/**
+ * @brief Data harvesting method. Opens a file, closing the one open before.
+ *
+ * @param path - path to the file
+ * @param truncate - 'true' to start the file anew, 'false' to append to it
+ * @return 'false' if the file cannot be opened
+ */
+bool RecordFileBuf::open(const std::string &path, bool truncate){
+    bool reported = Failed and FileDescriptor < 0 and path == Path;  // failed to open before
+    close();
+    Path = path;
+    Failed = false;
+    FileDescriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND), 0644);
+    if(FileDescriptor < 0){
+        if(!reported){
+            std::cout << "Error in RecordFileBuf::open(): cannot open the file " << path << ": "
+                      << std::strerror(errno) << std::endl;
+        }
+        Failed = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Data harvesting method. Writes out what is buffered and, if asked,
+ * forces the file to the disk (fsync).
+ *
+ * @param toDisk - 'true' to call fsync
+ * @return 'false' if writing failed
+ */
+bool RecordFileBuf::commit(bool toDisk){
+    if(FileDescriptor < 0)
+        return true;
+    bool ok = writeOut();
+    if(ok and toDisk and fsync(FileDescriptor) != 0){
+        std::cout << "Error in RecordFileBuf::commit(): fsync of " << Path << " failed: "
+                  << std::strerror(errno) << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Data harvesting method. Writes out what is buffered and closes the
+ * file.
+ */
+void RecordFileBuf::close(){
+    if(FileDescriptor < 0)
+        return;
+    writeOut();
+    ::close(FileDescriptor);
+    FileDescriptor = -1;
+}
+
+bool RecordFileBuf::isOpen() const {
+    return FileDescriptor >= 0;
+}
+
+/**
+ * @brief Data harvesting method. The buffer is full: writes it out and puts the
+ * character into the emptied buffer.
+ */
+RecordFileBuf::int_type RecordFileBuf::overflow(int_type ch){
+    if(!writeOut())
+        return traits_type::eof();
+    if(!traits_type::eq_int_type(ch, traits_type::eof())){
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+/**
+ * @brief Data harvesting method. Flushing the stream writes nothing, records
+ * stay in the buffer until it is full or until commit().
+ */
+int RecordFileBuf::sync(){
+    return 0;
+}
+
+/**
+ * @brief Data harvesting method. Writes the buffer to the file and empties it.
+ * Records that cannot be written (the file is not open or writing failed) are
+ * dropped; the first time it happens is reported.
+ *
+ * @return 'false' if records were dropped
+ */
+bool RecordFileBuf::writeOut(){
+    const char *data = pbase();
+    std::size_t left = pptr() - pbase();
+    if(left > 0 and FileDescriptor < 0){
+        if(!Failed){
+            std::cout << "Error in RecordFileBuf::writeOut(): records dropped, the file " << Path
+                      << " is not open" << std::endl;
+        }
+        Failed = true;
+    }
+    while(left > 0 and FileDescriptor >= 0){
+        ssize_t written = ::write(FileDescriptor, data, left);
+        if(written < 0){
+            if(errno == EINTR)
+                continue;
+            if(!Failed){
+                std::cout << "Error in RecordFileBuf::writeOut(): cannot write the file " << Path << ": "
+                          << std::strerror(errno) << std::endl;
+            }
+            Failed = true;
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+    setp(Buffer.data(), Buffer.data() + Buffer.size());
+    return !Failed;
+}
+
+/**
+ * @brief Data harvesting method. Constructor. No file is open yet.
+ *
+ * @param bufferSize - bytes kept in memory before they are written to the file
+ */
+RecordStream::RecordStream(std::size_t bufferSize) : std::ostream(nullptr), FileBuf(bufferSize) {
+    rdbuf(&FileBuf);
+}
+
+RecordStream::~RecordStream() {
+}
+
+/**
+ * @brief Data harvesting method. Opens a file, see RecordFileBuf::open().
+ */
+bool RecordStream::open(const std::string &path, bool truncate){
+    clear();
+    bool ok = FileBuf.open(path, truncate);
+    if(!ok)
+        setstate(std::ios::failbit);
+    return ok;
+}
+
+/**
+ * @brief Data harvesting method. Writes out the buffer, see RecordFileBuf::commit().
+ */
+bool RecordStream::commit(bool toDisk){
+    return FileBuf.commit(toDisk);
+}
+
+void RecordStream::close(){
+    FileBuf.close();
+}
+
+bool RecordStream::isOpen() const {
+    return FileBuf.isOpen();
+}
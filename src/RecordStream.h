@@ -0,0 +1,82 @@
+/*
+ * File:   RecordStream.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef RECORDSTREAM_H
+#define	RECORDSTREAM_H
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * @brief When the output files written every generation are forced to the disk
+ * (fsync). Each step up is safer and slower.
+ */
+enum class FsyncPolicy {
+    Never,          // the operating system decides
+    Checkpoint,     // at checkpoints and at the end of run
+    Generation      // after every host generation
+};
+
+/**
+ * @brief Data harvesting class. Stream buffer of an output file that stays open
+ * for the whole run. Data collects in a large buffer in memory and goes to the
+ * file only when the buffer is full or on commit(). Flushing the stream (e.g.
+ * with std::endl) does not write anything, so records of many generations go
+ * to the file in one system call.
+ */
+class RecordFileBuf : public std::streambuf {
+public:
+    explicit RecordFileBuf(std::size_t bufferSize);
+    virtual ~RecordFileBuf();
+    bool open(const std::string &path, bool truncate);
+    bool commit(bool toDisk);
+    void close();
+    bool isOpen() const;
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+private:
+    bool writeOut();
+    int FileDescriptor;
+    std::string Path;
+    std::vector<char> Buffer;
+    bool Failed;
+};
+
+/**
+ * @brief Data harvesting class. Output stream on a RecordFileBuf.
+ */
+class RecordStream : public std::ostream {
+public:
+    explicit RecordStream(std::size_t bufferSize);
+    virtual ~RecordStream();
+    bool open(const std::string &path, bool truncate);
+    bool commit(bool toDisk);
+    void close();
+    bool isOpen() const;
+private:
+    RecordFileBuf FileBuf;
+};
+
+#endif	/* RECORDSTREAM_H */
@@ -0,0 +1,427 @@
+/*
+ * File:   Scenario.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <boost/lexical_cast.hpp>
+
+#include "Scenario.h"
+
+using jsonf = nlohmann::json;
+
+namespace {
+
+    template <typename T>
+    struct NamedValue {
+        const char *name;
+        T value;
+    };
+
+    const NamedValue<InfectionMode> InfectionNames[] = {
+        {"one", InfectionMode::OneFromOneSpecies},
+        {"k", InfectionMode::KFromOneSpecies},
+        {"every", InfectionMode::EveryOne}
+    };
+
+    const NamedValue<FitnessFunction> FitnessNames[] = {
+        {"JustInfection", FitnessFunction::JustInfection},
+        {"PerGene", FitnessFunction::PerGene},
+        {"Drift", FitnessFunction::Drift},
+        {"AlphaXSqr", FitnessFunction::AlphaXSqr},
+        {"ExpFunc", FitnessFunction::ExpFunc},
+        {"ExpFuncUniqAlleles", FitnessFunction::ExpFuncUniqAlleles}
+    };
+
+    const NamedValue<HostSelection> SelectionNames[] = {
+        {"NoMating", HostSelection::NoMating},
+        {"Replace", HostSelection::Replace}
+    };
+
+    const NamedValue<MatingMode> MatingNames[] = {
+        {"none", MatingMode::None},
+        {"MeanOptimalNumber", MatingMode::MeanOptimalNumber},
+        {"NoCommonMHC", MatingMode::NoCommonMHC},
+        {"OneDifferentMHC", MatingMode::OneDifferentMHC},
+        {"MaxDifferentNumber", MatingMode::MaxDifferentNumber},
+        {"Random", MatingMode::Random}
+    };
+
+    const NamedValue<HostMutation> MutationNames[] = {
+        {"PointMutsDelDupl", HostMutation::PointMutsDelDupl},
+        {"AllMhcChangeDelDupl", HostMutation::AllMhcChangeDelDupl}
+    };
+
+    const NamedValue<MetricsCompression> CompressionNames[] = {
+        {"none", MetricsCompression::None},
+        {"delta", MetricsCompression::Delta},
+        {"block", MetricsCompression::Block}
+    };
+
+    const NamedValue<Harvester> HarvesterNames[] = {
+        {"diversity", Harvester::Diversity},
+        {"presented", Harvester::Presented},
+        {"mating", Harvester::Mating},
+        {"gene_numbers", Harvester::GeneNumbers},
+        {"allele_freqs", Harvester::AlleleFreqs},
+        {"genomes", Harvester::Genomes}
+    };
+
+    template <typename T, std::size_t N>
+    bool valueFromName(const NamedValue<T> (&names)[N], const std::string &name, T &value){
+        for(const NamedValue<T> &nv : names){
+            if(name == nv.name){
+                value = nv.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T, std::size_t N>
+    std::string nameFromValue(const NamedValue<T> (&names)[N], T value){
+        for(const NamedValue<T> &nv : names){
+            if(value == nv.value)
+                return nv.name;
+        }
+        return "unknown";
+    }
+
+    bool boolFromString(const std::string &str, bool &value){
+        if(str == "1" or str == "true" or str == "yes" or str == "YES"){
+            value = true;
+            return true;
+        }
+        if(str == "0" or str == "false" or str == "no" or str == "NO"){
+            value = false;
+            return true;
+        }
+        return false;
+    }
+}
+
+/**
+ * @brief Core method. Sets the default scenario: the one of the default main
+ * file (optimal number of MHC types searched by a mate, alpha-bounded fitness).
+ */
+ScenarioSpec::ScenarioSpec() {
+    setPreset("default");
+}
+
+ScenarioSpec::~ScenarioSpec() = default;
+
+/**
+ * @brief Core method. Names of the scenario presets, one for each of the main
+ * files which used to be kept in the Scenarios directory.
+ *
+ * @return list of preset names
+ */
+std::vector<std::string> ScenarioSpec::getPresetNames(){
+    return {"default", "core", "optimAlpha", "optimNoAlphaNoLimit", "maxDifferentAlpha",
+            "minSharedAlpha", "minSharedNew", "randomMatingAlpha", "noSexAlpha",
+            "newStylePntMhcMut", "oldStyleAllMhcMut"};
+}
+
+/**
+ * @brief Core method. Sets up one of the named scenarios.
+ *
+ * @param presetName - name of the preset, see getPresetNames()
+ * @return 'true' if the preset exists, 'false' if it does not (nothing changes)
+ */
+bool ScenarioSpec::setPreset(const std::string &presetName){
+    std::vector<std::string> names = getPresetNames();
+    if(std::find(names.begin(), names.end(), presetName) == names.end()){
+        std::cout << "Error in ScenarioSpec::setPreset(): there is no scenario called '"
+                  << presetName << "'." << std::endl;
+        return false;
+    }
+    Name = presetName;
+    Infection = InfectionMode::OneFromOneSpecies;
+    ExposuresPerSpec = 1;
+    Fitness = FitnessFunction::ExpFuncUniqAlleles;
+    Selection = HostSelection::NoMating;
+    Mating = MatingMode::MeanOptimalNumber;
+    Mutation = HostMutation::PointMutsDelDupl;
+    ScaleHostMutation = true;
+    ClonalHosts = false;
+    SavePathoGenomes = false;
+    SaveGeneNumbers = false;
+    SaveAlleleFreqs = false;
+    BinarySnapshots = false;
+    MetricsStore = false;
+    MetricsPacking = MetricsCompression::None;
+    for(int h = 0; h < NumbOfHarvesters; ++h){
+        Cadences[h] = OutputSchedule::getDefaultCadence((Harvester) h);
+    }
+    GenomeSample = 0;
+    MemoryEvery = 0;
+    if(presetName == "core"){
+        ClonalHosts = true;
+        SavePathoGenomes = true;
+        SaveGeneNumbers = true;
+    } else if(presetName == "optimNoAlphaNoLimit"){
+        Fitness = FitnessFunction::JustInfection;
+    } else if(presetName == "maxDifferentAlpha"){
+        Mating = MatingMode::MaxDifferentNumber;
+    } else if(presetName == "minSharedAlpha"){
+        Mating = MatingMode::NoCommonMHC;
+    } else if(presetName == "minSharedNew"){
+        Fitness = FitnessFunction::JustInfection;
+        Mating = MatingMode::NoCommonMHC;
+    } else if(presetName == "randomMatingAlpha"){
+        Mating = MatingMode::Random;
+    } else if(presetName == "noSexAlpha"){
+        Selection = HostSelection::Replace;
+        Mating = MatingMode::None;
+    } else if(presetName == "newStylePntMhcMut"){
+        Selection = HostSelection::Replace;
+        Mating = MatingMode::None;
+        SaveGeneNumbers = true;
+    } else if(presetName == "oldStyleAllMhcMut"){
+        Selection = HostSelection::Replace;
+        Mating = MatingMode::None;
+        Mutation = HostMutation::AllMhcChangeDelDupl;
+        ScaleHostMutation = false;
+        SaveGeneNumbers = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Core method. Changes one stage of the scenario.
+ *
+ * @param key - name of the stage or switch (dashes and underscores are the same)
+ * @param value - the value as text
+ * @return 'true' if the key and the value are valid, 'false' otherwise
+ */
+bool ScenarioSpec::setOption(const std::string &key, const std::string &value){
+    std::string kk = key;
+    std::replace(kk.begin(), kk.end(), '-', '_');
+    bool ok;
+    if(kk == "scenario"){
+        ok = setPreset(value);
+    } else if(kk == "infection"){
+        ok = valueFromName(InfectionNames, value, Infection);
+    } else if(kk == "exposures"){
+        try {
+            ExposuresPerSpec = boost::lexical_cast<unsigned int>(value);
+            ok = ExposuresPerSpec > 0;
+        }
+        catch(boost::bad_lexical_cast &e) {
+            ok = false;
+        }
+    } else if(kk == "fitness"){
+        ok = valueFromName(FitnessNames, value, Fitness);
+    } else if(kk == "selection"){
+        ok = valueFromName(SelectionNames, value, Selection);
+    } else if(kk == "mating"){
+        ok = valueFromName(MatingNames, value, Mating);
+    } else if(kk == "host_mutation"){
+        ok = valueFromName(MutationNames, value, Mutation);
+    } else if(kk == "scale_host_mutation"){
+        ok = boolFromString(value, ScaleHostMutation);
+    } else if(kk == "clonal_hosts"){
+        ok = boolFromString(value, ClonalHosts);
+    } else if(kk == "save_patho_genomes"){
+        ok = boolFromString(value, SavePathoGenomes);
+    } else if(kk == "save_gene_numbers"){
+        ok = boolFromString(value, SaveGeneNumbers);
+    } else if(kk == "save_allele_freqs"){
+        ok = boolFromString(value, SaveAlleleFreqs);
+    } else if(kk == "binary_snapshots"){
+        ok = boolFromString(value, BinarySnapshots);
+    } else if(kk == "metrics_store"){
+        ok = boolFromString(value, MetricsStore);
+    } else if(kk == "metrics_compression"){
+        ok = valueFromName(CompressionNames, value, MetricsPacking);
+    } else if(kk.compare(0, 8, "cadence_") == 0){
+        Harvester harvester;
+        if(!valueFromName(HarvesterNames, kk.substr(8), harvester)){
+            std::cout << "Error in ScenarioSpec::setOption(): unknown option '" << key << "'." << std::endl;
+            return false;
+        }
+        ok = Cadences[(int) harvester].fromString(value);
+    } else if(kk == "genome_sample"){
+        try {
+            GenomeSample = boost::lexical_cast<unsigned long>(value);
+            ok = true;
+        }
+        catch(boost::bad_lexical_cast &e) {
+            ok = false;
+        }
+    } else if(kk == "memory_every"){
+        try {
+            MemoryEvery = boost::lexical_cast<unsigned long>(value);
+            ok = true;
+        }
+        catch(boost::bad_lexical_cast &e) {
+            ok = false;
+        }
+    } else {
+        std::cout << "Error in ScenarioSpec::setOption(): unknown option '" << key << "'." << std::endl;
+        return false;
+    }
+    if(!ok){
+        std::cout << "Error in ScenarioSpec::setOption(): wrong value '" << value
+                  << "' for option '" << key << "'." << std::endl;
+    }
+    return ok;
+}
+
+/**
+ * @brief Core method. Reads options given as key=value (command line options
+ * without the leading dashes). A preset (scenario) goes first, then the JSON
+ * file (scenario-file), then the remaining options in the order they were given.
+ *
+ * @param options - the options
+ * @return 'true' if all options were valid
+ */
+bool ScenarioSpec::readOptions(const std::vector<std::string> &options){
+    bool ok = true;
+    std::vector<std::pair<std::string, std::string> > keyVals;
+    for(auto &opt : options){
+        std::size_t eq = opt.find('=');
+        if(eq == std::string::npos){
+            std::cout << "Option --" << opt << " needs a value (--key=value)." << std::endl;
+            ok = false;
+            continue;
+        }
+        keyVals.emplace_back(opt.substr(0, eq), opt.substr(eq + 1));
+    }
+    for(auto &kv : keyVals){
+        if(kv.first == "scenario")
+            ok = setPreset(kv.second) and ok;
+    }
+    for(auto &kv : keyVals){
+        if(kv.first == "scenario-file" or kv.first == "scenario_file")
+            ok = loadJson(kv.second) and ok;
+    }
+    for(auto &kv : keyVals){
+        if(kv.first != "scenario" and kv.first != "scenario-file" and kv.first != "scenario_file")
+            ok = setOption(kv.first, kv.second) and ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Core method. Sets the scenario from a JSON object. The "scenario" key
+ * (a preset) is applied first, other keys are applied on top of it.
+ *
+ * @param jsonObj - JSON object with keys as in setOption()
+ * @return 'true' if all keys were valid
+ */
+bool ScenarioSpec::setFromJson(const jsonf &jsonObj){
+    if(!jsonObj.is_object()){
+        std::cout << "Error in ScenarioSpec::setFromJson(): a scenario has to be a JSON object." << std::endl;
+        return false;
+    }
+    bool ok = true;
+    if(jsonObj.count("scenario")){
+        ok = setPreset(jsonObj["scenario"].get<std::string>());
+    }
+    for(auto it = jsonObj.begin(); it != jsonObj.end(); ++it){
+        if(it.key() == "scenario") continue;
+        std::string value;
+        if(it.value().is_string()){
+            value = it.value().get<std::string>();
+        } else if(it.value().is_boolean()){
+            value = it.value().get<bool>() ? "true" : "false";
+        } else {
+            value = it.value().dump();
+        }
+        ok = setOption(it.key(), value) and ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Core method. Reads the scenario from a JSON file, see setFromJson().
+ *
+ * @param fileName - path to the JSON file
+ * @return 'true' if the file was read and all keys were valid
+ */
+bool ScenarioSpec::loadJson(const std::string &fileName){
+    std::ifstream inJson(fileName);
+    if(!inJson.good()){
+        std::cout << "Error in ScenarioSpec::loadJson(): cannot open the file "
+                  << fileName << std::endl;
+        return false;
+    }
+    jsonf jsonObj;
+    try {
+        inJson >> jsonObj;
+    }
+    catch(std::exception &e) {
+        std::cout << "Error in ScenarioSpec::loadJson(): " << e.what() << std::endl;
+        return false;
+    }
+    return setFromJson(jsonObj);
+}
+
+/**
+ * @brief Data harvesting method. The scenario as a JSON object, in a form that
+ * can be read back by setFromJson().
+ *
+ * @return JSON object
+ */
+jsonf ScenarioSpec::toJson() const {
+    jsonf jsonObj;
+    jsonObj["scenario"] = Name;
+    jsonObj["infection"] = nameFromValue(InfectionNames, Infection);
+    jsonObj["exposures"] = ExposuresPerSpec;
+    jsonObj["fitness"] = nameFromValue(FitnessNames, Fitness);
+    jsonObj["selection"] = nameFromValue(SelectionNames, Selection);
+    jsonObj["mating"] = nameFromValue(MatingNames, Mating);
+    jsonObj["host_mutation"] = nameFromValue(MutationNames, Mutation);
+    jsonObj["scale_host_mutation"] = ScaleHostMutation;
+    jsonObj["clonal_hosts"] = ClonalHosts;
+    jsonObj["save_patho_genomes"] = SavePathoGenomes;
+    jsonObj["save_gene_numbers"] = SaveGeneNumbers;
+    jsonObj["save_allele_freqs"] = SaveAlleleFreqs;
+    jsonObj["binary_snapshots"] = BinarySnapshots;
+    jsonObj["metrics_store"] = MetricsStore;
+    jsonObj["metrics_compression"] = nameFromValue(CompressionNames, MetricsPacking);
+    for(const NamedValue<Harvester> &nv : HarvesterNames){
+        jsonObj[std::string("cadence_") + nv.name] = Cadences[(int) nv.value].toString();
+    }
+    jsonObj["genome_sample"] = GenomeSample;
+    jsonObj["memory_every"] = MemoryEvery;
+    return jsonObj;
+}
+
+/**
+ * @brief Data harvesting method. One line description of the scenario.
+ *
+ * @return the description
+ */
+std::string ScenarioSpec::describe() const {
+    std::stringstream ss;
+    ss << Name << ": infection=" << nameFromValue(InfectionNames, Infection);
+    if(Infection == InfectionMode::KFromOneSpecies)
+        ss << " (" << ExposuresPerSpec << ")";
+    ss << " fitness=" << nameFromValue(FitnessNames, Fitness)
+       << " selection=" << nameFromValue(SelectionNames, Selection)
+       << " mating=" << nameFromValue(MatingNames, Mating)
+       << " host_mutation=" << nameFromValue(MutationNames, Mutation);
+    return ss.str();
+}
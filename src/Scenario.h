@@ -0,0 +1,119 @@
+/*
+ * File:   Scenario.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef SCENARIO_H
+#define	SCENARIO_H
+
+#include <string>
+#include <vector>
+
+#include "FitnessPolicies.h"
+#include "MetricsStore.h"
+#include "OutputSchedule.h"
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief How hosts meet pathogens in each pathogen generation.
+ */
+enum class InfectionMode {
+    OneFromOneSpecies,  // Environment::infectOneFromOneSpecHeteroBatched()
+    KFromOneSpecies,    // Environment::infectKFromOneSpecHeteroBatched()
+    EveryOne            // Environment::infectEveryOne()
+};
+
+/**
+ * @brief How the next host generation is selected.
+ */
+enum class HostSelection {
+    NoMating,           // Environment::selectAndReprodHostsNoMating(), mating follows
+    Replace             // Environment::selectAndReprodHostsReplace(), random mating of hermaphrodites
+};
+
+/**
+ * @brief Mate choice done after the selection.
+ */
+enum class MatingMode {
+    None,
+    MeanOptimalNumber,  // Environment::matingMeanOptimalNumberMHCsmallSubset()
+    NoCommonMHC,        // Environment::matingWithNoCommonMHCsmallSubset()
+    OneDifferentMHC,    // Environment::matingWithOneDifferentMHCsmallSubset()
+    MaxDifferentNumber, // Environment::matingMaxDifferentNumber()
+    Random              // Environment::matingRandom()
+};
+
+/**
+ * @brief Mutation regime of hosts.
+ */
+enum class HostMutation {
+    PointMutsDelDupl,   // Environment::mutateHostsWithDelDuplPointMuts()
+    AllMhcChangeDelDupl // Environment::mutateHostWithDelDuplAllMHCchange()
+};
+
+/**
+ * @brief Core class. Description of a scenario: which procedure runs at each
+ * stage of a generation (infect, select pathogens, mutate pathogens, fitness,
+ * select hosts, mate, mutate hosts, harvest). Replaces the copies of main file
+ * that used to live in the Scenarios directory - each of them is now a named
+ * preset (see setPreset()).
+ *
+ * A scenario can be built from a preset, a JSON file and/or "key=value"
+ * options, applied in this order. Keys and values are the same in JSON and in
+ * options: infection, exposures, fitness, selection, mating, host_mutation,
+ * scale_host_mutation, clonal_hosts, save_patho_genomes, save_gene_numbers,
+ * save_allele_freqs, binary_snapshots, metrics_store, metrics_compression,
+ * cadence_diversity, cadence_presented, cadence_mating, cadence_gene_numbers,
+ * cadence_allele_freqs, cadence_genomes (see OutputCadence), genome_sample,
+ * memory_every.
+ */
+class ScenarioSpec {
+public:
+    ScenarioSpec();
+    virtual ~ScenarioSpec();
+    bool setPreset(const std::string &presetName);
+    bool setOption(const std::string &key, const std::string &value);
+    bool readOptions(const std::vector<std::string> &options);
+    bool loadJson(const std::string &fileName);
+    bool setFromJson(const nlohmann::json &jsonObj);
+    nlohmann::json toJson() const;
+    std::string describe() const;
+    static std::vector<std::string> getPresetNames();
+
+    std::string Name;
+    InfectionMode Infection;
+    unsigned int ExposuresPerSpec;   // pathogens of each species met by a host, KFromOneSpecies only
+    FitnessFunction Fitness;
+    HostSelection Selection;
+    MatingMode Mating;
+    HostMutation Mutation;
+    bool ScaleHostMutation;          // convert per-gene host mutation rate to per-bit (Environment::MMtoPMscaling())
+    bool ClonalHosts;                // start from a clonal host population instead of a random one
+    bool SavePathoGenomes;           // dump pathogen genomes at the beginning and at the end of run
+    bool SaveGeneNumbers;            // save numbers of genes of all hosts in each generation
+    bool SaveAlleleFreqs;            // save numbers of copies of all MHC alleles in each generation
+    bool BinarySnapshots;            // dump genomes as PopulationSnapshot.N.bin instead of the text files
+    bool MetricsStore;               // write the per-generation numbers to Metrics.bin instead of the text files
+    MetricsCompression MetricsPacking;  // how the integer columns of Metrics.bin are packed
+    OutputCadence Cadences[NumbOfHarvesters];  // when each group of output files is saved, see OutputSchedule
+    unsigned long GenomeSample;      // hosts (and pathogens) written to a genome dump, 0 - all of them
+    unsigned long MemoryEvery;       // generations between memory accounts (MemoryUsage.csv), 0 - none
+};
+
+#endif	/* SCENARIO_H */
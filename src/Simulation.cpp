@@ -0,0 +1,1079 @@
+/*
+ * File:   Simulation.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <boost/lexical_cast.hpp>
+
+#include "Simulation.h"
+#include "BinaryIO.h"
+#include "Snapshot.h"
+
+using jsonf = nlohmann::json;
+
+namespace {
+
+    const char CheckpointMagic[8] = {'M', 'H', 'C', 'C', 'H', 'K', 'P', 'T'};
+    const uint32_t CheckpointVersion = 2;
+
+    volatile std::sig_atomic_t StopRequested = 0;
+
+    void requestStop(int){
+        StopRequested = 1;
+    }
+
+    void writeModelParamsBinary(std::ostream &out, const ModelParams &params){
+        BinaryIO::write(out, params.numberOfThreads);
+        BinaryIO::write(out, params.mhcGeneLength);
+        BinaryIO::write(out, params.antigenLength);
+        BinaryIO::write(out, params.hostPopSize);
+        BinaryIO::write(out, params.pathoPopSize);
+        BinaryIO::write(out, params.patho_sp);
+        BinaryIO::write(out, params.hostGeneNumbb);
+        BinaryIO::write(out, params.patoPerHostGeneration);
+        BinaryIO::write(out, params.numOfHostGenerations);
+        BinaryIO::write(out, params.hostMutationProb);
+        BinaryIO::write(out, params.pathoMutationProb);
+        BinaryIO::write(out, params.HeteroHomo);
+        BinaryIO::write(out, params.deletion);
+        BinaryIO::write(out, params.duplication);
+        BinaryIO::write(out, params.maxGene);
+        BinaryIO::write(out, params.NumbPartners);
+        BinaryIO::write(out, params.alpha);
+    }
+
+    bool readModelParamsBinary(std::istream &in, ModelParams &params){
+        return BinaryIO::read(in, params.numberOfThreads) and BinaryIO::read(in, params.mhcGeneLength)
+               and BinaryIO::read(in, params.antigenLength) and BinaryIO::read(in, params.hostPopSize)
+               and BinaryIO::read(in, params.pathoPopSize) and BinaryIO::read(in, params.patho_sp)
+               and BinaryIO::read(in, params.hostGeneNumbb) and BinaryIO::read(in, params.patoPerHostGeneration)
+               and BinaryIO::read(in, params.numOfHostGenerations) and BinaryIO::read(in, params.hostMutationProb)
+               and BinaryIO::read(in, params.pathoMutationProb) and BinaryIO::read(in, params.HeteroHomo)
+               and BinaryIO::read(in, params.deletion) and BinaryIO::read(in, params.duplication)
+               and BinaryIO::read(in, params.maxGene) and BinaryIO::read(in, params.NumbPartners)
+               and BinaryIO::read(in, params.alpha);
+    }
+
+    /**
+     * @brief Reads the part of a checkpoint preceding the state: the magic
+     * bytes, the version, the parameters and the scenario.
+     */
+    bool readCheckpointHead(std::istream &in, const std::string &fileName, ModelParams &params,
+                            ScenarioSpec &spec){
+        char magic[8];
+        uint32_t version;
+        if(!in.read(magic, 8) or !std::equal(magic, magic + 8, CheckpointMagic)){
+            std::cout << "Error in Simulation: " << fileName << " is not a checkpoint file." << std::endl;
+            return false;
+        }
+        if(!BinaryIO::read(in, version) or version != CheckpointVersion){
+            std::cout << "Error in Simulation: checkpoint " << fileName << " has version " << version
+                      << ", this program reads version " << CheckpointVersion << "." << std::endl;
+            return false;
+        }
+        std::string specJson;
+        if(!readModelParamsBinary(in, params) or !BinaryIO::readString(in, specJson)){
+            std::cout << "Error in Simulation: checkpoint " << fileName << " is damaged." << std::endl;
+            return false;
+        }
+        try {
+            return spec.setFromJson(nlohmann::json::parse(specJson));
+        }
+        catch(std::exception &e) {
+            std::cout << "Error in Simulation: checkpoint " << fileName << " is damaged." << std::endl;
+            return false;
+        }
+    }
+
+    /**
+     * @brief Points of a generation at which data are harvested.
+     */
+    enum class HarvestPoint {
+        AfterPathogens,  // numbers of presented pathogens
+        AfterSelection,  // numbers of MHC types before mating
+        AfterMating,     // numbers of MHC types of mates and offspring
+        AfterMutation    // genetic diversity of hosts (and numbers of genes)
+    };
+
+    class InfectStage : public ScenarioStage {
+    public:
+        InfectStage(InfectionMode mode, unsigned int exposures) : Mode(mode), Exposures(exposures) {}
+        void run(Simulation &sim, int /*tayme*/) override {
+            switch(Mode){
+                case InfectionMode::OneFromOneSpecies:
+                    sim.getEnvironment().infectOneFromOneSpecHeteroBatched();
+                    break;
+                case InfectionMode::KFromOneSpecies:
+                    sim.getEnvironment().infectKFromOneSpecHeteroBatched(Exposures);
+                    break;
+                case InfectionMode::EveryOne:
+                    sim.getEnvironment().infectEveryOne();
+                    break;
+            }
+        }
+        std::string getName() const override { return "infect"; }
+    private:
+        InfectionMode Mode;
+        unsigned int Exposures;
+    };
+
+    class SelectPathoStage : public ScenarioStage {
+    public:
+        void run(Simulation &sim, int /*tayme*/) override {
+            sim.getEnvironment().selectAndReproducePathoFixedPopSizes();
+        }
+        std::string getName() const override { return "select-patho"; }
+    };
+
+    class MutatePathoStage : public ScenarioStage {
+    public:
+        void run(Simulation &sim, int tayme) override {
+            Environment &ENV = sim.getEnvironment();
+            ENV.mutatePathogensWithRestric(sim.getParams().pathoMutationProb, sim.getParams().mhcGeneLength,
+                                           tayme, sim.getTaggingSystem());
+            ENV.clearPathoInfectionData();
+        }
+        std::string getName() const override { return "mutate-patho"; }
+    };
+
+    class FitnessStage : public ScenarioStage {
+    public:
+        explicit FitnessStage(FitnessFunction fitFun) : FitFun(fitFun) {}
+        void run(Simulation &sim, int /*tayme*/) override {
+            sim.getEnvironment().calculateHostsFitness(FitFun, sim.getParams().alpha, sim.getParams().maxGene);
+        }
+        std::string getName() const override { return "fitness"; }
+    private:
+        FitnessFunction FitFun;
+    };
+
+    class SelectHostStage : public ScenarioStage {
+    public:
+        explicit SelectHostStage(HostSelection selection) : Selection(selection) {}
+        void run(Simulation &sim, int /*tayme*/) override {
+            if(Selection == HostSelection::Replace)
+                sim.getEnvironment().selectAndReprodHostsReplace();
+            else
+                sim.getEnvironment().selectAndReprodHostsNoMating();
+        }
+        std::string getName() const override { return "select-host"; }
+    private:
+        HostSelection Selection;
+    };
+
+    class MateStage : public ScenarioStage {
+    public:
+        explicit MateStage(MatingMode mating) : Mating(mating) {}
+        void run(Simulation &sim, int /*tayme*/) override {
+            Environment &ENV = sim.getEnvironment();
+            int partners = sim.getParams().NumbPartners;
+            switch(Mating){
+                case MatingMode::None:
+                    break;
+                case MatingMode::MeanOptimalNumber:
+                    ENV.matingMeanOptimalNumberMHCsmallSubset(partners);
+                    break;
+                case MatingMode::NoCommonMHC:
+                    ENV.matingWithNoCommonMHCsmallSubset((unsigned long) partners);
+                    break;
+                case MatingMode::OneDifferentMHC:
+                    ENV.matingWithOneDifferentMHCsmallSubset(partners);
+                    break;
+                case MatingMode::MaxDifferentNumber:
+                    ENV.matingMaxDifferentNumber(partners);
+                    break;
+                case MatingMode::Random:
+                    ENV.matingRandom();
+                    break;
+            }
+        }
+        std::string getName() const override { return "mate"; }
+    private:
+        MatingMode Mating;
+    };
+
+    class MutateHostStage : public ScenarioStage {
+    public:
+        explicit MutateHostStage(HostMutation mutation) : Mutation(mutation) {}
+        void run(Simulation &sim, int tayme) override {
+            const ModelParams &pp = sim.getParams();
+            if(Mutation == HostMutation::AllMhcChangeDelDupl)
+                sim.getEnvironment().mutateHostWithDelDuplAllMHCchange(sim.getHostMutationProb(), pp.deletion,
+                        pp.duplication, pp.maxGene, tayme, sim.getTaggingSystem());
+            else
+                sim.getEnvironment().mutateHostsWithDelDuplPointMuts(sim.getHostMutationProb(), pp.deletion,
+                        pp.duplication, pp.maxGene, tayme, sim.getTaggingSystem());
+        }
+        std::string getName() const override { return "mutate-host"; }
+    private:
+        HostMutation Mutation;
+    };
+
+    class HarvestStage : public ScenarioStage {
+    public:
+        explicit HarvestStage(HarvestPoint point) : Point(point) {}
+        void run(Simulation &sim, int tayme) override {
+            Environment &ENV = sim.getEnvironment();
+            DataHandler &Data2file = sim.getDataHandler();
+            switch(Point){
+                case HarvestPoint::AfterPathogens:
+                    Data2file.savePresentedPathos(ENV, tayme);
+                    break;
+                case HarvestPoint::AfterSelection:
+                    Data2file.saveMhcNumbersBeforeMating(ENV, tayme);
+                    break;
+                case HarvestPoint::AfterMating:
+                    Data2file.saveMhcNumbersWhenMating(ENV, tayme);
+                    Data2file.saveMhcNumbersAfterMating(ENV, tayme);
+                    break;
+                case HarvestPoint::AfterMutation:
+                    Data2file.saveHostGeneticDivers(ENV, tayme);
+                    if(sim.getSpec().SaveGeneNumbers)
+                        Data2file.saveHostGeneNumbers(ENV, tayme);
+                    if(sim.getSpec().SaveAlleleFreqs)
+                        Data2file.saveAlleleFrequencies(ENV, tayme);
+                    break;
+            }
+        }
+        std::string getName() const override { return "harvest"; }
+    private:
+        HarvestPoint Point;
+    };
+}
+
+/**
+ * @brief Core method. Reads the 17 input parameters of the model given as text,
+ * in the order of the command line.
+ *
+ * @param args - the parameters as text
+ * @param params - the structure to fill
+ * @return 'false' if there are not exactly 17 parameters or not all of them are numbers
+ */
+bool readModelParams(const std::vector<std::string> &args, ModelParams &params){
+    if(args.size() != 17)
+        return false;
+    try {
+        params.numberOfThreads = boost::lexical_cast<unsigned int>(args[0]);
+        params.mhcGeneLength = boost::lexical_cast<unsigned long>(args[1]);
+        params.antigenLength = boost::lexical_cast<unsigned long>(args[2]);
+        params.hostPopSize = boost::lexical_cast<int>(args[3]);
+        params.pathoPopSize = boost::lexical_cast<int>(args[4]);
+        params.patho_sp = boost::lexical_cast<int>(args[5]);
+        params.hostGeneNumbb = boost::lexical_cast<unsigned long>(args[6]);
+        params.patoPerHostGeneration = boost::lexical_cast<int>(args[7]);
+        params.numOfHostGenerations = boost::lexical_cast<int>(args[8]);
+        params.hostMutationProb = boost::lexical_cast<double>(args[9]);
+        params.pathoMutationProb = boost::lexical_cast<double>(args[10]);
+        params.HeteroHomo = boost::lexical_cast<int>(args[11]);
+        params.deletion = boost::lexical_cast<double>(args[12]);
+        params.duplication = boost::lexical_cast<double>(args[13]);
+        params.maxGene = boost::lexical_cast<unsigned long>(args[14]);
+        params.NumbPartners = boost::lexical_cast<int>(args[15]);
+        params.alpha = boost::lexical_cast<double>(args[16]);
+    }
+    catch(boost::bad_lexical_cast &e) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Core method. Sets up the environment (with its random number
+ * generators) and composes the generation from the scenario.
+ *
+ * @param params - input parameters of the model
+ * @param spec - the scenario
+ */
+Simulation::Simulation(const ModelParams &params, const ScenarioSpec &spec)
+        : Params(params), Spec(spec), HostMutationProb(params.hostMutationProb), ENV(params.numberOfThreads),
+          FirstGeneration(1), CheckpointingOn(false), CheckpointEvery(0), Stopped(false),
+          PerfReportEvery(0) {
+    composePipeline();
+    Data2file.setMetricsStore(Spec.MetricsStore, Spec.MetricsPacking);
+    OutputSchedule &schedule = Data2file.getSchedule();
+    for(int h = 0; h < NumbOfHarvesters; ++h){
+        schedule.setCadence((Harvester) h, Spec.Cadences[h]);
+    }
+    schedule.setGenomeSample(Spec.GenomeSample);
+    schedule.setLastGeneration(Params.numOfHostGenerations);
+    Profiler.setPopulationSizes((unsigned long) Params.hostPopSize, (unsigned long) Params.pathoPopSize);
+}
+
+Simulation::~Simulation() = default;
+
+/**
+ * @brief Core method. Builds the lists of stages of the pathogen and host
+ * generations and picks the host generation loop: one of the fast paths
+ * compiled for a fitness + mating combination, or the generic one going
+ * through the stages.
+ */
+void Simulation::composePipeline(){
+    PathoStages.clear();
+    PathoStages.emplace_back(new InfectStage(Spec.Infection, Spec.ExposuresPerSpec));
+    PathoStages.emplace_back(new SelectPathoStage());
+    PathoStages.emplace_back(new MutatePathoStage());
+
+    HostStages.clear();
+    HostStages.emplace_back(new HarvestStage(HarvestPoint::AfterPathogens));
+    HostStages.emplace_back(new FitnessStage(Spec.Fitness));
+    HostStages.emplace_back(new SelectHostStage(Spec.Selection));
+    HostStages.emplace_back(new HarvestStage(HarvestPoint::AfterSelection));
+    if(Spec.Mating != MatingMode::None){
+        HostStages.emplace_back(new MateStage(Spec.Mating));
+        HostStages.emplace_back(new HarvestStage(HarvestPoint::AfterMating));
+    }
+    HostStages.emplace_back(new MutateHostStage(Spec.Mutation));
+    HostStages.emplace_back(new HarvestStage(HarvestPoint::AfterMutation));
+
+    HostGeneration = &Simulation::runHostGenerationStaged;
+    if(Spec.Selection != HostSelection::NoMating or Spec.Mutation != HostMutation::PointMutsDelDupl)
+        return;
+    if(Spec.Fitness == FitnessFunction::ExpFuncUniqAlleles){
+        switch(Spec.Mating){
+            case MatingMode::MeanOptimalNumber:
+                HostGeneration = &Simulation::runHostGenerationFast<FitnessFunction::ExpFuncUniqAlleles,
+                                                                    MatingMode::MeanOptimalNumber>;
+                break;
+            case MatingMode::NoCommonMHC:
+                HostGeneration = &Simulation::runHostGenerationFast<FitnessFunction::ExpFuncUniqAlleles,
+                                                                    MatingMode::NoCommonMHC>;
+                break;
+            case MatingMode::MaxDifferentNumber:
+                HostGeneration = &Simulation::runHostGenerationFast<FitnessFunction::ExpFuncUniqAlleles,
+                                                                    MatingMode::MaxDifferentNumber>;
+                break;
+            case MatingMode::Random:
+                HostGeneration = &Simulation::runHostGenerationFast<FitnessFunction::ExpFuncUniqAlleles,
+                                                                    MatingMode::Random>;
+                break;
+            default:
+                break;
+        }
+    } else if(Spec.Fitness == FitnessFunction::JustInfection){
+        switch(Spec.Mating){
+            case MatingMode::MeanOptimalNumber:
+                HostGeneration = &Simulation::runHostGenerationFast<FitnessFunction::JustInfection,
+                                                                    MatingMode::MeanOptimalNumber>;
+                break;
+            case MatingMode::NoCommonMHC:
+                HostGeneration = &Simulation::runHostGenerationFast<FitnessFunction::JustInfection,
+                                                                    MatingMode::NoCommonMHC>;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Core method. Is the host generation going through one of the loops
+ * compiled for a particular scenario?
+ *
+ * @return 'true' for a fast path, 'false' for the generic list of stages
+ */
+bool Simulation::isFastPath() const {
+    return HostGeneration != &Simulation::runHostGenerationStaged;
+}
+
+/**
+ * @brief Data harvesting method. Lists the stages of a generation.
+ *
+ * @return stage names separated with arrows
+ */
+std::string Simulation::getPipelineDescription() const {
+    std::string desc = "(";
+    for(const auto &stage : PathoStages){
+        desc += stage->getName() + (stage == PathoStages.back() ? ") x " : " -> ");
+    }
+    desc += std::to_string(Params.patoPerHostGeneration);
+    for(const auto &stage : HostStages){
+        desc += " -> " + stage->getName();
+    }
+    if(isFastPath())
+        desc += " [fast path]";
+    return desc;
+}
+
+/**
+ * @brief Core method. Runs the whole simulation: set-up, all host generations
+ * and the final data dump.
+ *
+ * @return 'false' if the scenario cannot be run with given parameters
+ */
+bool Simulation::run(){
+    if(!checkParams() or !setUp())
+        return false;
+    runAllGenerations();
+    return true;
+}
+
+/**
+ * @brief Core method. Runs a replicate of another simulation: starts from a
+ * copy of its initial populations (see setUpPopulations()) instead of building
+ * new ones, with freshly seeded random number generators, so replicates
+ * differ only in their random streams.
+ *
+ * @param origin - simulation with populations set up and not run yet
+ * @return 'false' if the scenario cannot be run with given parameters
+ */
+bool Simulation::runReplicate(const Simulation &origin){
+    if(!checkParams())
+        return false;
+    ENV = origin.ENV;
+    ENV.seedEnvsRNG();
+    Tags = origin.Tags;
+    HostMutationProb = origin.HostMutationProb;
+    setUpOutput();
+    runAllGenerations();
+    return true;
+}
+
+/**
+ * @brief Core method. Can the scenario be run with given parameters?
+ *
+ * @return 'false' if not (and says why)
+ */
+bool Simulation::checkParams() const {
+    if(Params.HeteroHomo != 10){
+        std::cout << "This instance of the model allows only heterozygote";
+        std::cout << " advantage. Sorry :-(" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Core method. All host generations, the genome dumps the output
+ * schedule asks for between them, and the final data dump. The phases of the
+ * generations are timed by the profiler of the simulation, made the current
+ * one of the calling thread while they run, and written to PerfReport.json.
+ */
+void Simulation::runAllGenerations(){
+    PerfProfiler::Activation profiling(Profiler);
+    Profiler.start();
+    std::cout << "Calculating...." << std::endl;
+    for(int i = FirstGeneration; i <= Params.numOfHostGenerations; ++i){
+        Data2file.planGeneration(ENV, i);
+        runHostGeneration(i);
+        saveMemoryUsage(i);
+        Data2file.endGeneration();
+        if(i < Params.numOfHostGenerations and Data2file.isDue(Harvester::Genomes))
+            saveGenomes(i);
+        Profiler.countGeneration(i);
+        if(CheckpointingOn and StopRequested){
+            saveCheckpoint(i);
+            writePerfReport();
+            std::cout << "Stopped after generation " << i << ". Continue with --resume="
+                      << CheckpointFile << std::endl;
+            Stopped = true;
+            return;
+        }
+        if(CheckpointingOn and CheckpointEvery > 0 and i % CheckpointEvery == 0 and i < Params.numOfHostGenerations)
+            saveCheckpoint(i);
+        if(PerfReportEvery > 0 and i % PerfReportEvery == 0 and i < Params.numOfHostGenerations)
+            writePerfReport();
+    }
+    finish();
+    writePerfReport();
+}
+
+/**
+ * @brief Core method. Switches on checkpointing: the whole state of the
+ * simulation is saved every given number of generations and when the program
+ * gets SIGTERM (see installSignalHandlers()).
+ *
+ * @param fileName - checkpoint file, in the output directory of the simulation
+ * @param everyGenerations - generations between checkpoints, 0 - only on SIGTERM
+ */
+void Simulation::setCheckpointing(const std::string &fileName, int everyGenerations){
+    CheckpointingOn = true;
+    CheckpointFile = fileName;
+    CheckpointEvery = everyGenerations;
+}
+
+/**
+ * @brief Data harvesting method. Makes the run write PerfReport.json (see
+ * PerfProfiler) every given number of generations too, not only at its end.
+ *
+ * @param everyGenerations - generations between the dumps, 0 - only at the end
+ */
+void Simulation::setPerfReporting(int everyGenerations){
+    PerfReportEvery = everyGenerations;
+}
+
+/**
+ * @brief Data harvesting method. Makes the run record a timeline of the
+ * phases and kernels on each OpenMP thread, written as Trace.json (Chrome
+ * trace event format, for Perfetto) with PerfReport.json.
+ *
+ * @param eventsPerThread - events kept per thread (the last ones), 0 - no tracing
+ */
+void Simulation::setTracing(std::size_t eventsPerThread){
+    Profiler.setTracing(eventsPerThread);
+}
+
+/**
+ * @brief Data harvesting method. Makes the run count cycles, instructions,
+ * cache misses and branch mispredictions of each phase with the hardware
+ * counters of its threads (see HardwareCounters), reported in PerfReport.json.
+ *
+ * @param countersOn - 'true' to count
+ */
+void Simulation::setHardwareCounters(bool countersOn){
+    Profiler.setHardwareCounters(countersOn);
+}
+
+/**
+ * @brief Data harvesting method. Sets the output and the self-reporting
+ * options of the run all at once (see RunOptions).
+ *
+ * @param options - the options
+ */
+void Simulation::setRunOptions(const RunOptions &options){
+    Data2file.setAsyncOutput(options.AsyncTasks, options.AsyncBytes);
+    Data2file.setFsyncPolicy(options.Fsync);
+    setPerfReporting(options.PerfReportEvery);
+    setTracing(options.TraceEvents);
+    setHardwareCounters(options.HwCounters);
+}
+
+/**
+ * @brief Core method. Saves the whole state of the simulation after a host
+ * generation to a versioned binary file: parameters, scenario, generation
+ * number, tag counter, states of the data handler, of the random number
+ * generators and of the populations. The file is written aside and renamed,
+ * so a run killed while saving keeps the previous checkpoint. Records still
+ * queued for the background writer are written first, so the output files
+ * are never behind a checkpoint.
+ *
+ * @param tayme - the last generation done
+ * @return 'false' if the file could not be written
+ */
+bool Simulation::saveCheckpoint(int tayme){
+    PERF_PHASE(PerfPhase::Checkpoint);
+    Data2file.flushOutput();
+    std::string fileName = Data2file.getOutputPath(CheckpointFile);
+    std::string tmpName = fileName + ".tmp";
+    std::ofstream out(tmpName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!out.good()){
+        std::cout << "Error in Simulation::saveCheckpoint(): cannot open the file " << tmpName << std::endl;
+        return false;
+    }
+    out.write(CheckpointMagic, 8);
+    BinaryIO::write(out, CheckpointVersion);
+    writeModelParamsBinary(out, Params);
+    BinaryIO::writeString(out, Spec.toJson().dump());
+    BinaryIO::write(out, tayme);
+    BinaryIO::write(out, HostMutationProb);
+    BinaryIO::write(out, (uint64_t) Tags.getLastTag());
+    Data2file.writeState(out);
+    ENV.writeState(out);
+    out.write(CheckpointMagic, 8);
+    out.close();
+    if(!out or std::rename(tmpName.c_str(), fileName.c_str()) != 0){
+        std::cout << "Error in Simulation::saveCheckpoint(): cannot write the file " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Core method. Reads the parameters and the scenario saved in a
+ * checkpoint, to construct the simulation to resume.
+ *
+ * @param fileName - checkpoint file
+ * @param params - the parameters read
+ * @param spec - the scenario read
+ * @return 'false' if the file is not a readable checkpoint
+ */
+bool Simulation::readCheckpointHeader(const std::string &fileName, ModelParams &params, ScenarioSpec &spec){
+    std::ifstream in(fileName, std::ios::in | std::ios::binary);
+    if(!in.good()){
+        std::cout << "Error in Simulation::readCheckpointHeader(): cannot open the file " << fileName << std::endl;
+        return false;
+    }
+    return readCheckpointHead(in, fileName, params, spec);
+}
+
+/**
+ * @brief Core method. Continues a run from a checkpoint (see saveCheckpoint()).
+ * The simulation has to be constructed with the parameters and the scenario of
+ * the checkpoint (readCheckpointHeader()). Records of generations done after
+ * the checkpoint are removed from the output files, so with the same number of
+ * threads the run goes on exactly as if it had never been stopped.
+ *
+ * @param fileName - checkpoint file
+ * @return 'false' if the checkpoint could not be read or the run cannot go on
+ */
+bool Simulation::resume(const std::string &fileName){
+    if(!checkParams())
+        return false;
+    int tayme;
+    if(!readCheckpoint(fileName, true, tayme))
+        return false;
+    Data2file.dropRecordsAfter(tayme);
+    FirstGeneration = tayme + 1;
+    std::cout << "Resuming after generation " << tayme << "." << std::endl;
+    runAllGenerations();
+    return true;
+}
+
+/**
+ * @brief Core method. Reads the state saved in a checkpoint.
+ *
+ * @param fileName - checkpoint file
+ * @param continueRun - 'true' to restore everything (resume), 'false' to take
+ * only the populations and the tag counter (warm start)
+ * @param tayme - the generation the checkpoint was saved after
+ * @return 'false' if the checkpoint could not be read
+ */
+bool Simulation::readCheckpoint(const std::string &fileName, bool continueRun, int &tayme){
+    std::ifstream in(fileName, std::ios::in | std::ios::binary);
+    ModelParams savedParams;
+    ScenarioSpec savedSpec;
+    if(!in.good() or !readCheckpointHead(in, fileName, savedParams, savedSpec))
+        return false;
+    double savedMutationProb;
+    uint64_t lastTag;
+    DataHandler savedDataHandler;
+    char magic[8];
+    if(!(BinaryIO::read(in, tayme) and BinaryIO::read(in, savedMutationProb) and BinaryIO::read(in, lastTag)
+         and (continueRun ? Data2file.readState(in) : savedDataHandler.readState(in))
+         and ENV.readState(in, continueRun) and in.read(magic, 8)
+         and std::equal(magic, magic + 8, CheckpointMagic))){
+        std::cout << "Error in Simulation::readCheckpoint(): checkpoint " << fileName << " is damaged." << std::endl;
+        return false;
+    }
+    if(continueRun)
+        HostMutationProb = savedMutationProb;
+    Tags.setLastTag(lastTag);
+    return true;
+}
+
+/**
+ * @brief Core method. Has the run been stopped by SIGTERM (with a checkpoint
+ * saved) before its last generation?
+ *
+ * @return 'true' if stopped
+ */
+bool Simulation::wasStopped() const {
+    return Stopped;
+}
+
+/**
+ * @brief Core method. Makes SIGTERM (e.g. a cluster time limit) stop the
+ * simulations which have checkpointing on after the generation they are
+ * running, with a checkpoint saved.
+ */
+void Simulation::installSignalHandlers(){
+    std::signal(SIGTERM, requestStop);
+}
+
+/**
+ * @brief Core method. Starts the run from evolved populations instead of new
+ * ones (see setUpPopulations()). Host and pathogen sources can be a checkpoint
+ * (saveCheckpoint()), a binary population snapshot (PopulationSnapshot.N.bin)
+ * or a genomes file (HostGenomesFile.N.csv, PathoGenomesFile.N.csv).
+ *
+ * @param hostSource - checkpoint, snapshot or host genomes file, empty - no warm start
+ * @param pathoSource - checkpoint, snapshot or pathogen genomes file, empty -
+ * pathogens of the host checkpoint or snapshot if it has them, new ones otherwise
+ */
+void Simulation::setWarmStart(const std::string &hostSource, const std::string &pathoSource){
+    WarmStartHosts = hostSource;
+    WarmStartPathos = pathoSource;
+}
+
+/**
+ * @brief Core method. Sets up host and pathogen populations and saves the data
+ * of generation zero, see setUpPopulations() and setUpOutput().
+ *
+ * @return 'false' if the populations could not be set up
+ */
+bool Simulation::setUp(){
+    if(!setUpPopulations())
+        return false;
+    setUpOutput();
+    return true;
+}
+
+/**
+ * @brief Core method. Sets up host and pathogen populations (with the
+ * no-mutation sites of pathogens), new or loaded from a snapshot (see
+ * setWarmStart()).
+ *
+ * @return 'false' if a snapshot could not be loaded
+ */
+bool Simulation::setUpPopulations(){
+    if(!WarmStartHosts.empty()){
+        if(!setUpWarmStart())
+            return false;
+    } else if(Spec.ClonalHosts){
+        ENV.setHostClonalPopulation(Params.hostPopSize, Params.mhcGeneLength, Params.hostGeneNumbb, 0, Tags);
+    } else {
+        ENV.setHostRandomPopulation(Params.hostPopSize, Params.mhcGeneLength, Params.hostGeneNumbb, 0, Tags);
+    }
+    std::cout << "Host population all set!" << std::endl;
+    if(WarmStartHosts.empty()){
+        ENV.setPathoPopulatioDivSpecies(Params.pathoPopSize, Params.antigenLength, Params.patho_sp,
+                                        Params.mhcGeneLength, 0, 0, Tags);
+    }
+    std::cout << "Pathogen population all set!" << std::endl;
+    if(Spec.ScaleHostMutation)
+        HostMutationProb = ENV.MMtoPMscaling(Params.hostMutationProb, Params.mhcGeneLength);
+    return true;
+}
+
+/**
+ * @brief Core method. Loads populations for a warm start (see setWarmStart()).
+ * Genes and antigens keep their tags and times of origin from the source run,
+ * new tags continue after the largest one loaded. Populations are resampled
+ * when their sizes differ from the parameters of this run. If there are no
+ * pathogens to load, or their number of species differs, new ones are made.
+ *
+ * @return 'false' if a snapshot could not be loaded or does not fit the run
+ */
+bool Simulation::setUpWarmStart(){
+    bool pathosLoaded = false;
+    int tayme;
+    if(isCheckpointFile(WarmStartHosts)){
+        if(!readCheckpoint(WarmStartHosts, false, tayme))
+            return false;
+        pathosLoaded = WarmStartPathos.empty();
+        std::cout << "Warm start from generation " << tayme << " of " << WarmStartHosts << "." << std::endl;
+    } else if(isSnapshotFile(WarmStartHosts)){
+        SnapshotReader snapshot;
+        if(!snapshot.open(WarmStartHosts) or !ENV.setHostPopulationFromSnapshot(snapshot, Params.mhcGeneLength, Tags))
+            return false;
+        if(WarmStartPathos.empty() and snapshot.getHeader().HasPathogens){
+            if(!ENV.setPathoPopulationFromSnapshot(snapshot, Params.antigenLength, Params.mhcGeneLength, Tags))
+                return false;
+            pathosLoaded = true;
+        }
+        std::cout << "Warm start from generation " << snapshot.getHeader().Time << " of " << WarmStartHosts
+                  << "." << std::endl;
+    } else {
+        if(!ENV.setHostPopulationFromFile(WarmStartHosts, Params.mhcGeneLength, Tags))
+            return false;
+        std::cout << "Warm start from " << WarmStartHosts << "." << std::endl;
+    }
+    if(!WarmStartPathos.empty()){
+        if(isCheckpointFile(WarmStartPathos)){
+            Simulation source(Params, Spec);
+            if(!source.readCheckpoint(WarmStartPathos, false, tayme))
+                return false;
+            ENV.copyPathoPopulation(source.ENV);
+            if(source.Tags.getLastTag() > Tags.getLastTag())
+                Tags.setLastTag(source.Tags.getLastTag());
+        } else if(isSnapshotFile(WarmStartPathos)){
+            SnapshotReader snapshot;
+            if(!snapshot.open(WarmStartPathos)
+               or !ENV.setPathoPopulationFromSnapshot(snapshot, Params.antigenLength, Params.mhcGeneLength, Tags))
+                return false;
+        } else if(!ENV.setPathoPopulationFromFile(WarmStartPathos, Params.antigenLength, Params.mhcGeneLength, Tags)){
+            return false;
+        }
+        pathosLoaded = true;
+    }
+    if(pathosLoaded and ENV.getPathoNumOfSpecies() != (unsigned long) Params.patho_sp){
+        std::cout << "There are " << ENV.getPathoNumOfSpecies() << " pathogen species in the snapshot and "
+                  << Params.patho_sp << " in this run, making new pathogens." << std::endl;
+        pathosLoaded = false;
+    }
+    if(!pathosLoaded){
+        ENV.setPathoPopulatioDivSpecies(Params.pathoPopSize, Params.antigenLength, Params.patho_sp,
+                                        Params.mhcGeneLength, 0, 0, Tags);
+    }
+    ENV.resizeHostPopulation(Params.hostPopSize);
+    ENV.resizePathoPopulation(Params.pathoPopSize);
+    if(!ENV.checkLoadedPopulations(Params.mhcGeneLength, Params.antigenLength, Params.patho_sp))
+        return false;
+    ENV.clearHostInfectionsData();
+    ENV.clearPathoInfectionData();
+    return true;
+}
+
+/**
+ * @brief Core method. Does the file start like a checkpoint?
+ *
+ * @param fileName - file to check
+ * @return 'true' if it is a checkpoint, 'false' if not or it cannot be read
+ */
+bool Simulation::isCheckpointFile(const std::string &fileName){
+    std::ifstream in(fileName, std::ios::in | std::ios::binary);
+    char magic[8];
+    return in.read(magic, 8) and std::equal(magic, magic + 8, CheckpointMagic);
+}
+
+/**
+ * @brief Core method. Does the file start like a population snapshot?
+ *
+ * @param fileName - file to check
+ * @return 'true' if it is a snapshot, 'false' if not or it cannot be read
+ */
+bool Simulation::isSnapshotFile(const std::string &fileName){
+    std::ifstream in(fileName, std::ios::in | std::ios::binary);
+    char magic[8];
+    return in.read(magic, 8) and std::equal(magic, magic + 8, SnapshotWriter::Magic);
+}
+
+/**
+ * @brief Data harvesting method. Adds scenario-related information to
+ * InputParameters.json and saves the data of generation zero.
+ */
+void Simulation::setUpOutput(){
+    Data2file.setAllFilesAsFirtsTimers();
+    Data2file.savePathoNoMuttList(ENV);
+
+    // Adding extra info about the parameters of this simulation
+    jsonf jsonfile;
+    std::ifstream inJson(Data2file.getOutputPath("InputParameters.json"));
+    if(inJson.good()){
+        inJson >> jsonfile;
+    }
+    inJson.close();
+    jsonfile["separated_species_genomes"] = "YES";
+    if(Spec.ScaleHostMutation)
+        jsonfile["point_mutation_in_host_is_used"] = HostMutationProb;
+    else
+        jsonfile["point_mutation_in_host_is_used"] = "NO";
+    jsonfile["scenario"] = Spec.toJson();
+    if(!WarmStartHosts.empty()){
+        jsonfile["warm_start_hosts"] = WarmStartHosts;
+        jsonfile["warm_start_pathogens"] = WarmStartPathos;
+    }
+    std::ofstream InputParams;
+    InputParams.open(Data2file.getOutputPath("InputParameters.json"));
+    InputParams << jsonfile.dump(4);
+    InputParams.close();
+
+    Data2file.planGeneration(ENV, 0);
+    saveGenomes(0);
+    Data2file.saveHostGeneticDivers(ENV, 0);
+    Data2file.saveMhcNumbersBeforeMating(ENV, 0);
+    if(Spec.Mating != MatingMode::None){
+        Data2file.saveMhcNumbersWhenMating(ENV, 0);
+        Data2file.saveMhcNumbersAfterMating(ENV, 0);
+    }
+    if(Spec.SaveGeneNumbers)
+        Data2file.saveHostGeneNumbers(ENV, 0);
+    if(Spec.SaveAlleleFreqs)
+        Data2file.saveAlleleFrequencies(ENV, 0);
+    Data2file.savePresentedPathos(ENV, 0);
+    saveMemoryUsage(0);
+}
+
+/**
+ * @brief Core method. Runs all the pathogen generations that happen within one
+ * host generation.
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+void Simulation::runPathoGenerations(int tayme){
+    for(int j = 0; j < Params.patoPerHostGeneration; ++j){
+        for(auto &stage : PathoStages){
+            stage->run(*this, tayme);
+        }
+    }
+}
+
+/**
+ * @brief Core method. Runs one host generation (with its pathogen generations).
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+void Simulation::runHostGeneration(int tayme){
+    (this->*HostGeneration)(tayme);
+}
+
+/**
+ * @brief Core method. Generic host generation: goes through the list of stages.
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+void Simulation::runHostGenerationStaged(int tayme){
+    runPathoGenerations(tayme);
+    for(auto &stage : HostStages){
+        stage->run(*this, tayme);
+    }
+    ENV.clearHostInfectionsData();
+}
+
+/**
+ * @brief Core method. Host generation compiled for one fitness + mating
+ * combination. Calls Environment directly and uses the fused fitness +
+ * roulette wheel pass (Environment::calculateHostsFitnessAndSelectionWeights()).
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+template <FitnessFunction Fit, MatingMode Mate>
+void Simulation::runHostGenerationFast(int tayme){
+    for(int j = 0; j < Params.patoPerHostGeneration; ++j){
+        infect();
+        ENV.selectAndReproducePathoFixedPopSizes();
+        ENV.mutatePathogensWithRestric(Params.pathoMutationProb, Params.mhcGeneLength, tayme, Tags);
+        ENV.clearPathoInfectionData();
+    }
+    Data2file.savePresentedPathos(ENV, tayme);
+    ENV.calculateHostsFitnessAndSelectionWeights(Fit, Params.alpha, Params.maxGene);
+    ENV.selectAndReprodHostsNoMatingWeighted();
+    Data2file.saveMhcNumbersBeforeMating(ENV, tayme);
+    mateHosts(Mate);
+    Data2file.saveMhcNumbersWhenMating(ENV, tayme);
+    Data2file.saveMhcNumbersAfterMating(ENV, tayme);
+    ENV.mutateHostsWithDelDuplPointMuts(HostMutationProb, Params.deletion, Params.duplication, Params.maxGene,
+                                        tayme, Tags);
+    Data2file.saveHostGeneticDivers(ENV, tayme);
+    if(Spec.SaveGeneNumbers)
+        Data2file.saveHostGeneNumbers(ENV, tayme);
+    if(Spec.SaveAlleleFreqs)
+        Data2file.saveAlleleFrequencies(ENV, tayme);
+    ENV.clearHostInfectionsData();
+}
+
+/**
+ * @brief Core method. Infects hosts the way the scenario says.
+ */
+void Simulation::infect(){
+    switch(Spec.Infection){
+        case InfectionMode::OneFromOneSpecies:
+            ENV.infectOneFromOneSpecHeteroBatched();
+            break;
+        case InfectionMode::KFromOneSpecies:
+            ENV.infectKFromOneSpecHeteroBatched(Spec.ExposuresPerSpec);
+            break;
+        case InfectionMode::EveryOne:
+            ENV.infectEveryOne();
+            break;
+    }
+}
+
+/**
+ * @brief Core method. Mate choice. Inlined into the fast paths, where the
+ * mating mode is a compile-time constant.
+ *
+ * @param mating - mating mode
+ */
+inline void Simulation::mateHosts(MatingMode mating){
+    switch(mating){
+        case MatingMode::None:
+            break;
+        case MatingMode::MeanOptimalNumber:
+            ENV.matingMeanOptimalNumberMHCsmallSubset(Params.NumbPartners);
+            break;
+        case MatingMode::NoCommonMHC:
+            ENV.matingWithNoCommonMHCsmallSubset((unsigned long) Params.NumbPartners);
+            break;
+        case MatingMode::OneDifferentMHC:
+            ENV.matingWithOneDifferentMHCsmallSubset(Params.NumbPartners);
+            break;
+        case MatingMode::MaxDifferentNumber:
+            ENV.matingMaxDifferentNumber(Params.NumbPartners);
+            break;
+        case MatingMode::Random:
+            ENV.matingRandom();
+            break;
+    }
+}
+
+/**
+ * @brief Core method. Final infection and the data dump at the end of run.
+ */
+void Simulation::finish(){
+    infect();
+    saveGenomes(Params.numOfHostGenerations);
+    Data2file.flushOutput();
+}
+
+/**
+ * @brief Data harvesting method. Dumps host (and pathogen, if the scenario
+ * asks for it) genomes, as text files or as a binary snapshot.
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+void Simulation::saveGenomes(int tayme){
+    if(Spec.BinarySnapshots){
+        Data2file.savePopulSnapshot(ENV, tayme, Spec.SavePathoGenomes);
+        return;
+    }
+    if(Spec.SavePathoGenomes)
+        Data2file.savePathoPopulToFile(ENV, tayme);
+    Data2file.saveHostPopulToFile(ENV, tayme);
+}
+
+/**
+ * @brief Data harvesting method. Saves the memory footprint of the simulation
+ * (see MemoryUsage) every MemoryEvery generations of the scenario and at the
+ * end of run.
+ *
+ * @param tayme - time stamp (host generation number)
+ */
+void Simulation::saveMemoryUsage(int tayme){
+    if(Spec.MemoryEvery > 0 and ((unsigned long) tayme % Spec.MemoryEvery == 0 or tayme == Params.numOfHostGenerations))
+        Data2file.saveMemoryUsage(ENV, tayme);
+}
+
+/**
+ * @brief Data harvesting method. Writes the phase timings of the run so far to
+ * PerfReport.json, next to InputParameters.json, and the timeline to
+ * Trace.json when tracing. Does nothing when the timers are compiled out.
+ */
+void Simulation::writePerfReport(){
+    if(!PerfTimersOn)
+        return;
+    Profiler.writeReport(Data2file.getOutputPath("PerfReport.json"));
+    Profiler.writeTrace(Data2file.getOutputPath("Trace.json"));
+}
+
+Environment& Simulation::getEnvironment(){
+    return ENV;
+}
+
+DataHandler& Simulation::getDataHandler(){
+    return Data2file;
+}
+
+Tagging_system& Simulation::getTaggingSystem(){
+    return Tags;
+}
+
+const ModelParams& Simulation::getParams() const {
+    return Params;
+}
+
+const ScenarioSpec& Simulation::getSpec() const {
+    return Spec;
+}
+
+/**
+ * @brief Core method. Host mutation probability actually used: per-bit if the
+ * scenario scales it (see Environment::MMtoPMscaling()), as given otherwise.
+ * Valid after setUp().
+ *
+ * @return mutation probability
+ */
+double Simulation::getHostMutationProb() const {
+    return HostMutationProb;
+}
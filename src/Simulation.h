@@ -0,0 +1,168 @@
+/*
+ * File:   Simulation.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef SIMULATION_H
+#define	SIMULATION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Tagging_system.h"
+#include "Environment.h"
+#include "DataHandler.h"
+#include "PerfProfiler.h"
+#include "Scenario.h"
+
+/**
+ * @brief The 17 input parameters of the model, in the order of the command line.
+ */
+struct ModelParams {
+    unsigned int numberOfThreads;
+    unsigned long mhcGeneLength;
+    unsigned long antigenLength;
+    int hostPopSize;
+    int pathoPopSize;
+    int patho_sp;
+    unsigned long hostGeneNumbb;
+    int patoPerHostGeneration;
+    int numOfHostGenerations;
+    double hostMutationProb;
+    double pathoMutationProb;
+    int HeteroHomo;
+    double deletion;
+    double duplication;
+    unsigned long maxGene;
+    int NumbPartners;
+    double alpha;
+};
+
+bool readModelParams(const std::vector<std::string> &args, ModelParams &params);
+
+/**
+ * @brief Run options that are not a part of the model or of the scenario: how
+ * the output is written and what the run reports on itself.
+ */
+struct RunOptions {
+    std::size_t AsyncTasks;           // records waiting for the background writer, 0 - written at once
+    std::size_t AsyncBytes;           // most bytes waiting for the background writer
+    FsyncPolicy Fsync;
+    int PerfReportEvery;              // generations between dumps of PerfReport.json, 0 - only at the end
+    std::size_t TraceEvents;          // timeline events kept per thread, 0 - no timeline
+    bool HwCounters;
+};
+
+class Simulation;
+
+/**
+ * @brief Core class. One stage of a generation (infect, select pathogens, mutate
+ * pathogens, fitness, select hosts, mate, mutate hosts, harvest). A scenario is
+ * a list of stages composed at start-up, see Simulation.
+ */
+class ScenarioStage {
+public:
+    virtual ~ScenarioStage() = default;
+    virtual void run(Simulation &sim, int tayme) = 0;
+    virtual std::string getName() const = 0;
+};
+
+typedef std::vector<std::unique_ptr<ScenarioStage> > stagesVector;
+
+/**
+ * @brief Core class. One run of the model: the environment, the tagging system
+ * and the data handler, plus the scenario of a generation.
+ *
+ * The generation is composed at start-up from typed stages (ScenarioStage)
+ * picked according to the ScenarioSpec. The most common combinations (fitness
+ * proportionate selection followed by mate choice, with ExpFuncUniqAlleles or
+ * JustInfection fitness) have their own generation loop compiled for the
+ * combination, which calls Environment directly and uses the fused
+ * fitness + roulette wheel pass.
+ */
+class Simulation {
+public:
+    Simulation(const ModelParams &params, const ScenarioSpec &spec);
+    virtual ~Simulation();
+    bool run();
+    bool runReplicate(const Simulation &origin);
+    bool resume(const std::string &fileName);
+    void setCheckpointing(const std::string &fileName, int everyGenerations);
+    void setPerfReporting(int everyGenerations);
+    void setTracing(std::size_t eventsPerThread);
+    void setHardwareCounters(bool countersOn);
+    void setRunOptions(const RunOptions &options);
+    bool saveCheckpoint(int tayme);
+    bool wasStopped() const;
+    static bool readCheckpointHeader(const std::string &fileName, ModelParams &params, ScenarioSpec &spec);
+    static void installSignalHandlers();
+    void setWarmStart(const std::string &hostSource, const std::string &pathoSource);
+    bool setUp();
+    bool setUpPopulations();
+    void setUpOutput();
+    void runAllGenerations();
+    void runPathoGenerations(int tayme);
+    void runHostGeneration(int tayme);
+    void finish();
+    bool isFastPath() const;
+    std::string getPipelineDescription() const;
+    Environment& getEnvironment();
+    DataHandler& getDataHandler();
+    Tagging_system& getTaggingSystem();
+    const ModelParams& getParams() const;
+    const ScenarioSpec& getSpec() const;
+    double getHostMutationProb() const;
+private:
+    typedef void (Simulation::*GenerationFn)(int);
+    void composePipeline();
+    bool checkParams() const;
+    bool readCheckpoint(const std::string &fileName, bool continueRun, int &tayme);
+    bool setUpWarmStart();
+    static bool isCheckpointFile(const std::string &fileName);
+    static bool isSnapshotFile(const std::string &fileName);
+    void runHostGenerationStaged(int tayme);
+    template <FitnessFunction Fit, MatingMode Mate>
+    void runHostGenerationFast(int tayme);
+    void infect();
+    void saveGenomes(int tayme);
+    void saveMemoryUsage(int tayme);
+    void writePerfReport();
+    void mateHosts(MatingMode mating);
+    ModelParams Params;
+    ScenarioSpec Spec;
+    double HostMutationProb;          // after scaling to per-bit rate when the scenario asks for it
+    Tagging_system Tags;
+    DataHandler Data2file;
+    Environment ENV;
+    stagesVector PathoStages;
+    stagesVector HostStages;
+    GenerationFn HostGeneration;
+    int FirstGeneration;              // 1, or the one after the checkpoint the run was resumed from
+    bool CheckpointingOn;
+    std::string CheckpointFile;
+    int CheckpointEvery;              // generations between checkpoints, 0 - only when stopped with SIGTERM
+    bool Stopped;
+    std::string WarmStartHosts;       // checkpoint or genomes file to start from, empty - new populations
+    std::string WarmStartPathos;
+    PerfProfiler Profiler;
+    int PerfReportEvery;              // generations between dumps of PerfReport.json, 0 - only at the end
+};
+
+#endif	/* SIMULATION_H */
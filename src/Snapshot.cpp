@@ -0,0 +1,442 @@
+/*
+ * File:   Snapshot.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Snapshot.h"
+
+const char SnapshotWriter::Magic[8] = {'M', 'H', 'C', 'S', 'N', 'A', 'P', 'S'};
+
+namespace {
+
+    inline uint64_t roundUpTo8(uint64_t bytes){
+        return (bytes + 7) & ~((uint64_t) 7);
+    }
+}
+
+/**
+ * @brief Core method. Constructor.
+ *
+ * @param out - binary stream to write the snapshot to
+ */
+SnapshotWriter::SnapshotWriter(std::ostream &out) : Out(out), Position(0), Good(true), FileSize(0) {
+    Buffer.reserve(BufferSize + 64);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+}
+
+/**
+ * @brief Core method. Sets the positions of the sections and the size of the
+ * file from the counts in the header.
+ *
+ * @param header - header with all the counts set
+ */
+void SnapshotWriter::setLayout(SnapshotHeader &header){
+    const uint64_t H = header.NumbOfHosts;
+    const uint64_t G = header.NumbOfGenes;
+    const uint64_t P = header.NumbOfPathos;
+    const uint64_t sizes[NumbOfSnapshotSections][2] = {
+        {8, H + 1}, {4, H}, {4, H}, {4, H}, {8, H + 1}, {4, header.NumbOfPresented},
+        {8, G}, {4, G}, {8, G}, {8, G + 1}, {4, header.NumbOfGeneLineage}, {8, header.NumbOfGeneLineage},
+        {8, header.NumbOfSpecies + 1}, {4, P}, {4, P}, {8, P * header.AntigenWords}, {4, P}, {8, P},
+        {8, P + 1}, {8, header.NumbOfAntigenLineage}
+    };
+    uint64_t position = roundUpTo8(sizeof(SnapshotHeader));
+    for(int s = 0; s < NumbOfSnapshotSections; ++s){
+        header.Sections[s] = position;
+        position += roundUpTo8(sizes[s][0] * sizes[s][1]);
+    }
+    header.FileSize = position;
+}
+
+/**
+ * @brief Core method. Writes the header. Counts have to be set, the magic
+ * number, the version and the layout are filled in here.
+ *
+ * @param header - header with all the counts set
+ */
+void SnapshotWriter::writeHeader(SnapshotHeader &header){
+    std::memcpy(header.Magic, Magic, sizeof(Magic));
+    header.Version = Version;
+    setLayout(header);
+    std::copy(header.Sections, header.Sections + NumbOfSnapshotSections, Sections);
+    FileSize = header.FileSize;
+    put(header);
+}
+
+/**
+ * @brief Core method. Moves to the beginning of a section. Sections have to be
+ * written in their order and complete.
+ *
+ * @param section - the section that comes next
+ */
+void SnapshotWriter::beginSection(SnapshotSection section){
+    padTo(Sections[section]);
+}
+
+/**
+ * @brief Core method. Pads the last section and writes out what is buffered.
+ *
+ * @return 'false' if the sections did not add up or the stream failed
+ */
+bool SnapshotWriter::finish(){
+    padTo(FileSize);
+    flush();
+    Out.flush();
+    return Good and Out.good();
+}
+
+void SnapshotWriter::flush(){
+    Out.write(Buffer.data(), Buffer.size());
+    Buffer.clear();
+}
+
+void SnapshotWriter::padTo(uint64_t position){
+    if(Position > position){
+        Good = false;
+        return;
+    }
+    Buffer.insert(Buffer.end(), position - Position, 0);
+    Position = position;
+    if(Buffer.size() >= BufferSize)
+        flush();
+}
+
+/**
+ * @brief Core method. Constructor. Nothing is open yet, see open().
+ */
+SnapshotReader::SnapshotReader() : Data(nullptr), Size(0), Header(nullptr), Mapped(false) {
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+/**
+ * @brief Core method. Maps a snapshot file to memory and checks that its
+ * header and offsets are consistent, so columns can be used without further
+ * checks.
+ *
+ * @param fileName - the snapshot file
+ * @return 'false' if the file cannot be mapped or is not a valid snapshot
+ */
+bool SnapshotReader::open(const std::string &fileName){
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0){
+        std::cout << "Error in SnapshotReader::open(): cannot open the file " << fileName << std::endl;
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 or (uint64_t) fileStat.st_size < sizeof(SnapshotHeader)){
+        std::cout << "Error in SnapshotReader::open(): " << fileName << " is too short for a snapshot." << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED){
+        std::cout << "Error in SnapshotReader::open(): cannot map the file " << fileName << std::endl;
+        return false;
+    }
+    Data = static_cast<const char*>(mapped);
+    Size = fileStat.st_size;
+    Header = reinterpret_cast<const SnapshotHeader*>(Data);
+    Mapped = true;
+    if(!checkLayout()){
+        std::cout << "Error in SnapshotReader::open(): " << fileName << " is not a valid snapshot." << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Core method. Reads a snapshot that is in memory already, e.g. written
+ * by Environment::writeSnapshot() to a string. The memory has to be aligned to
+ * 8 bytes and to stay there until the reader is closed.
+ *
+ * @param data - the snapshot
+ * @param size - its size
+ * @return 'false' if it is not a valid snapshot
+ */
+bool SnapshotReader::open(const char *data, std::size_t size){
+    close();
+    if(size < sizeof(SnapshotHeader)){
+        std::cout << "Error in SnapshotReader::open(): too short for a snapshot." << std::endl;
+        return false;
+    }
+    Data = data;
+    Size = size;
+    Header = reinterpret_cast<const SnapshotHeader*>(Data);
+    if(!checkLayout()){
+        std::cout << "Error in SnapshotReader::open(): not a valid snapshot." << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Core method. Are the header and the offsets of the snapshot
+ * consistent, so columns can be used without further checks?
+ */
+bool SnapshotReader::checkLayout() const {
+    // All counts have to be believable before the layout is calculated from them
+    const uint64_t counts[] = {Header->GeneBits, Header->AntigenBits, Header->AntigenWords, Header->NumbOfHosts,
+                               Header->NumbOfGenes, Header->NumbOfPresented, Header->NumbOfGeneLineage,
+                               Header->NumbOfSpecies, Header->NumbOfPathos, Header->NumbOfAntigenLineage};
+    bool ok = std::equal(SnapshotWriter::Magic, SnapshotWriter::Magic + 8, Header->Magic)
+              and Header->Version == SnapshotWriter::Version;
+    for(uint64_t count : counts){
+        ok = ok and count <= Size;
+    }
+    ok = ok and Header->GeneBits <= 64 and Header->AntigenWords == (Header->AntigenBits + 63) / 64
+         and (Header->NumbOfPathos == 0 or Header->AntigenWords <= Size / Header->NumbOfPathos);
+    if(ok){
+        SnapshotHeader layout = *Header;
+        SnapshotWriter::setLayout(layout);
+        ok = layout.FileSize == Header->FileSize and Header->FileSize <= Size
+             and std::equal(layout.Sections, layout.Sections + NumbOfSnapshotSections, Header->Sections);
+    }
+    ok = ok and checkOffsets(HostGeneOffsets, Header->NumbOfHosts, Header->NumbOfGenes)
+            and checkOffsets(HostPresentedOffsets, Header->NumbOfHosts, Header->NumbOfPresented)
+            and checkOffsets(GeneLineageOffsets, Header->NumbOfGenes, Header->NumbOfGeneLineage)
+            and checkOffsets(SpeciesOffsets, Header->NumbOfSpecies, Header->NumbOfPathos)
+            and checkOffsets(AntigenLineageOffsets, Header->NumbOfPathos, Header->NumbOfAntigenLineage);
+    for(unsigned long i = 0; ok and i < Header->NumbOfHosts; ++i){
+        ok = getHostChromoOneSize(i) <= getColumn<uint64_t>(HostGeneOffsets)[i + 1] - getHostFirstGene(i);
+    }
+    return ok;
+}
+
+/**
+ * @brief Core method. Unmaps the file.
+ */
+void SnapshotReader::close(){
+    if(Data and Mapped)
+        munmap(const_cast<char*>(Data), Size);
+    Data = nullptr;
+    Size = 0;
+    Header = nullptr;
+    Mapped = false;
+}
+
+/**
+ * @brief Core method. Is an offsets column non-decreasing, starting at zero
+ * and ending at the number of entries it points to?
+ */
+bool SnapshotReader::checkOffsets(SnapshotSection section, uint64_t numbOfItems, uint64_t numbOfEntries) const {
+    const uint64_t *offsets = getColumn<uint64_t>(section);
+    if(offsets[0] != 0 or offsets[numbOfItems] != numbOfEntries)
+        return false;
+    for(uint64_t i = 0; i < numbOfItems; ++i){
+        if(offsets[i] > offsets[i + 1])
+            return false;
+    }
+    return true;
+}
+
+const SnapshotHeader& SnapshotReader::getHeader() const {
+    return *Header;
+}
+
+unsigned long SnapshotReader::getNumbOfHosts() const {
+    return Header->NumbOfHosts;
+}
+
+unsigned long SnapshotReader::getNumbOfPathos() const {
+    return Header->NumbOfPathos;
+}
+
+/**
+ * @brief Data harvesting method. Index of the first gene of a host in the gene
+ * columns. Genes of its chromosome one come first, then of chromosome two.
+ */
+unsigned long SnapshotReader::getHostFirstGene(unsigned long host) const {
+    return getColumn<uint64_t>(HostGeneOffsets)[host];
+}
+
+unsigned long SnapshotReader::getHostChromoOneSize(unsigned long host) const {
+    return getColumn<uint32_t>(HostChromoOneSizes)[host];
+}
+
+unsigned long SnapshotReader::getHostChromoTwoSize(unsigned long host) const {
+    const uint64_t *offsets = getColumn<uint64_t>(HostGeneOffsets);
+    return offsets[host + 1] - offsets[host] - getHostChromoOneSize(host);
+}
+
+uint64_t SnapshotReader::getGeneAllele(unsigned long gene) const {
+    return getColumn<uint64_t>(GeneAlleles)[gene];
+}
+
+/**
+ * @brief Data harvesting method. Bits of an antigen, 64 in a word, bit No. 0
+ * is the lowest bit of the first word.
+ */
+const uint64_t* SnapshotReader::getAntigenWords(unsigned long patho) const {
+    return getColumn<uint64_t>(AntigenBits) + patho * Header->AntigenWords;
+}
+
+/**
+ * @brief Data harvesting method. Writes the hosts in the format of
+ * DataHandler::saveHostPopulToFile() (HostGenomesFile.N.csv).
+ *
+ * @param out - the stream
+ * @param sample - places of the hosts to write, in ascending order; empty for all of them
+ */
+void SnapshotReader::writeHostText(std::ostream &out, const std::vector<std::size_t> &sample) const {
+    if(sample.empty())
+        out << "#Genomes_of_all_host_at_time = " << Header->Time << std::endl;
+    else
+        out << "#Genomes_of_" << sample.size() << "_of_" << Header->NumbOfHosts
+            << "_hosts_sampled_at_time = " << Header->Time << std::endl;
+    out << "#bit-gene\tchromosome\ttime_of_origin\tgene_own_tag" <<
+            "\tTime_of_parental_mutation\tAll_parental_tags etc." << std::endl;
+    const uint32_t *infecting = getColumn<uint32_t>(HostInfecting);
+    const uint32_t *presented = getColumn<uint32_t>(HostPresented);
+    const uint64_t *presentedOffsets = getColumn<uint64_t>(HostPresentedOffsets);
+    const int32_t *species = getColumn<int32_t>(PresentedSpecies);
+    std::string text;
+    std::size_t numbOfHosts = sample.empty() ? Header->NumbOfHosts : sample.size();
+    for(std::size_t n = 0; n < numbOfHosts; ++n){
+        unsigned long i = sample.empty() ? n : sample[n];
+        text.clear();
+        text += " === Host has " + std::to_string(infecting[i]) + " parasites and presented "
+                + std::to_string(presented[i]) + " - these are: ";
+        for(uint64_t k = presentedOffsets[i]; k < presentedOffsets[i + 1]; ++k){
+            text += std::to_string(species[k]) + " ";
+        }
+        text += "===\n";
+        unsigned long first = getHostFirstGene(i);
+        unsigned long chromoOne = getHostChromoOneSize(i);
+        unsigned long last = first + chromoOne + getHostChromoTwoSize(i);
+        for(unsigned long g = first; g < last; ++g){
+            writeGeneText(text, g, g < first + chromoOne ? "\tch_one\t" : "\tch_two\t");
+        }
+        out.write(text.data(), text.size());
+    }
+}
+
+/**
+ * @brief Data harvesting method. Adds one line of HostGenomesFile.N.csv.
+ */
+void SnapshotReader::writeGeneText(std::string &line, unsigned long gene, const char *chromo) const {
+    uint64_t allele = getGeneAllele(gene);
+    for(uint64_t b = Header->GeneBits; b-- > 0; ){
+        line += ((allele >> b) & 1) ? '1' : '0';
+    }
+    line += chromo;
+    line += std::to_string(getColumn<int32_t>(GeneTimes)[gene]) + "\t"
+            + std::to_string(getColumn<uint64_t>(GeneTags)[gene]);
+    const uint64_t *lineage = getColumn<uint64_t>(GeneLineageOffsets);
+    if(lineage[gene] == lineage[gene + 1]){
+        line += "\t-1\n";
+        return;
+    }
+    const int32_t *mutationTimes = getColumn<int32_t>(GeneMutationTimes);
+    const uint64_t *parentTags = getColumn<uint64_t>(GeneParentTags);
+    for(uint64_t k = lineage[gene]; k < lineage[gene + 1]; ++k){
+        line += "\t" + std::to_string(mutationTimes[k]) + "\t" + std::to_string(parentTags[k]);
+    }
+    line += "\n";
+}
+
+/**
+ * @brief Data harvesting method. Writes the pathogens in the format of
+ * DataHandler::savePathoPopulToFile() (PathoGenomesFile.N.csv).
+ *
+ * @param out - the stream
+ * @param sample - places of the pathogens (of all species together) to write,
+ * in ascending order; empty for all of them
+ */
+void SnapshotReader::writePathoText(std::ostream &out, const std::vector<std::size_t> &sample) const {
+    if(sample.empty())
+        out << "#Genomes_of_all_pathogens_at_time = " << Header->Time << std::endl;
+    else
+        out << "#Genomes_of_" << sample.size() << "_of_" << Header->NumbOfPathos
+            << "_pathogens_sampled_at_time = " << Header->Time << std::endl;
+    out << "#bit-gene\tchromosome\ttime_of_origin\tgene_own_tag\tAll_parental_tags"
+            << std::endl;
+    const int32_t *species = getColumn<int32_t>(PathoSpecies);
+    const uint32_t *infected = getColumn<uint32_t>(PathoInfected);
+    const int32_t *times = getColumn<int32_t>(AntigenTimes);
+    const uint64_t *tags = getColumn<uint64_t>(AntigenTags);
+    const uint64_t *lineage = getColumn<uint64_t>(AntigenLineageOffsets);
+    const uint64_t *parentTags = getColumn<uint64_t>(AntigenParentTags);
+    std::string text;
+    std::size_t numbOfPathos = sample.empty() ? Header->NumbOfPathos : sample.size();
+    for(std::size_t n = 0; n < numbOfPathos; ++n){
+        unsigned long p = sample.empty() ? n : sample[n];
+        text.clear();
+        text += " === Patho. sp. No. " + std::to_string(species[p]) + " has infected "
+                + std::to_string(infected[p]) + " hosts ===\n";
+        const uint64_t *words = getAntigenWords(p);
+        for(uint64_t b = Header->AntigenBits; b-- > 0; ){
+            text += ((words[b / 64] >> (b % 64)) & 1) ? '1' : '0';
+        }
+        text += "\tch_pat\t" + std::to_string(times[p]) + "\t" + std::to_string(tags[p]);
+        for(uint64_t k = lineage[p]; k < lineage[p + 1]; ++k){
+            text += "\t" + std::to_string(parentTags[k]);
+        }
+        text += "\n";
+        out.write(text.data(), text.size());
+    }
+}
+
+/**
+ * @brief Data harvesting method. Converts the snapshot to the text files it
+ * stands for: HostGenomesFile.N.csv and, if it has pathogens,
+ * PathoGenomesFile.N.csv.
+ *
+ * @param outputDir - directory for the files (empty or ending with '/')
+ * @return 'false' if a file could not be written
+ */
+bool SnapshotReader::convertToText(const std::string &outputDir) const {
+    std::string tayme = std::to_string(Header->Time);
+    std::ofstream hostFile(outputDir + "HostGenomesFile." + tayme + ".csv");
+    writeHostText(hostFile);
+    hostFile.close();
+    if(!hostFile.good()){
+        std::cout << "Error in SnapshotReader::convertToText(): cannot write " << outputDir
+                  << "HostGenomesFile." << tayme << ".csv" << std::endl;
+        return false;
+    }
+    if(Header->HasPathogens){
+        std::ofstream pathoFile(outputDir + "PathoGenomesFile." + tayme + ".csv");
+        writePathoText(pathoFile);
+        pathoFile.close();
+        if(!pathoFile.good()){
+            std::cout << "Error in SnapshotReader::convertToText(): cannot write " << outputDir
+                      << "PathoGenomesFile." << tayme << ".csv" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
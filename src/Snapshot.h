@@ -0,0 +1,158 @@
+/*
+ * File:   Snapshot.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef SNAPSHOT_H
+#define	SNAPSHOT_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Sections (columns) of a population snapshot, in the order they have in
+ * the file. H - hosts, G - host genes, L - host gene lineage entries, S -
+ * pathogen species, P - pathogens, A - antigen lineage entries.
+ */
+enum SnapshotSection {
+    HostGeneOffsets,       // uint64 x (H + 1), first gene of each host; its chromosome one, then two
+    HostChromoOneSizes,    // uint32 x H
+    HostInfecting,         // uint32 x H, number of pathogens infecting
+    HostPresented,         // uint32 x H, number of pathogens presented
+    HostPresentedOffsets,  // uint64 x (H + 1), first entry of each host in PresentedSpecies
+    PresentedSpecies,      // int32, species of the pathogens presented
+    GeneAlleles,           // uint64 x G, the bits of a MHC gene
+    GeneTimes,             // int32 x G, time of origin
+    GeneTags,              // uint64 x G
+    GeneLineageOffsets,    // uint64 x (G + 1), first lineage entry of each gene
+    GeneMutationTimes,     // int32 x L
+    GeneParentTags,        // uint64 x L
+    SpeciesOffsets,        // uint64 x (S + 1), first pathogen of each species
+    PathoSpecies,          // int32 x P
+    PathoInfected,         // uint32 x P, number of hosts infected
+    AntigenBits,           // uint64 x (P * AntigenWords), the bits of an antigen, 64 in a word
+    AntigenTimes,          // int32 x P, time of origin
+    AntigenTags,           // uint64 x P
+    AntigenLineageOffsets, // uint64 x (P + 1), first lineage entry of each antigen
+    AntigenParentTags,     // uint64 x A
+    NumbOfSnapshotSections
+};
+
+/**
+ * @brief Header of a population snapshot file. The counts fix the size of every
+ * section, sections follow the header in the order of SnapshotSection, each one
+ * starting at a multiple of 8 bytes. Values are in the native byte order.
+ */
+struct SnapshotHeader {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t HasPathogens;
+    int64_t Time;
+    uint64_t GeneBits;
+    uint64_t AntigenBits;
+    uint64_t AntigenWords;
+    uint64_t NumbOfHosts;
+    uint64_t NumbOfGenes;
+    uint64_t NumbOfPresented;
+    uint64_t NumbOfGeneLineage;
+    uint64_t NumbOfSpecies;
+    uint64_t NumbOfPathos;
+    uint64_t NumbOfAntigenLineage;
+    uint64_t FileSize;
+    uint64_t Sections[NumbOfSnapshotSections];  // file offset of each section
+};
+
+/**
+ * @brief Core class. Streams the columns of a population snapshot to a file
+ * (see Environment::writeSnapshot()). Counts go into the header first, so the
+ * position of every section is known up front and columns are written one
+ * after another without keeping the population in a second copy.
+ */
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::ostream &out);
+    virtual ~SnapshotWriter();
+    void writeHeader(SnapshotHeader &header);
+    void beginSection(SnapshotSection section);
+    template <typename T>
+    void put(T value){
+        const char *bytes = reinterpret_cast<const char*>(&value);
+        Buffer.insert(Buffer.end(), bytes, bytes + sizeof(T));
+        Position += sizeof(T);
+        if(Buffer.size() >= BufferSize)
+            flush();
+    }
+    bool finish();
+    static void setLayout(SnapshotHeader &header);
+    static const char Magic[8];
+    static const uint32_t Version = 1;
+private:
+    void flush();
+    void padTo(uint64_t position);
+    std::ostream &Out;
+    std::vector<char> Buffer;
+    uint64_t Position;                 // bytes written so far, buffered ones included
+    bool Good;
+    uint64_t Sections[NumbOfSnapshotSections];
+    uint64_t FileSize;
+    static const std::size_t BufferSize = 1 << 16;
+};
+
+/**
+ * @brief Core class. Reads a population snapshot through a memory map (or
+ * from a snapshot already in memory): the columns are used where they lie,
+ * nothing is copied or parsed. Can convert the snapshot back to the text
+ * format of DataHandler::saveHostPopulToFile() and
+ * DataHandler::savePathoPopulToFile().
+ */
+class SnapshotReader {
+public:
+    SnapshotReader();
+    virtual ~SnapshotReader();
+    bool open(const std::string &fileName);
+    bool open(const char *data, std::size_t size);
+    void close();
+    const SnapshotHeader& getHeader() const;
+    template <typename T>
+    const T* getColumn(SnapshotSection section) const {
+        return reinterpret_cast<const T*>(Data + Header->Sections[section]);
+    }
+    unsigned long getNumbOfHosts() const;
+    unsigned long getNumbOfPathos() const;
+    unsigned long getHostFirstGene(unsigned long host) const;
+    unsigned long getHostChromoOneSize(unsigned long host) const;
+    unsigned long getHostChromoTwoSize(unsigned long host) const;
+    uint64_t getGeneAllele(unsigned long gene) const;
+    const uint64_t* getAntigenWords(unsigned long patho) const;
+    void writeHostText(std::ostream &out, const std::vector<std::size_t> &sample = {}) const;
+    void writePathoText(std::ostream &out, const std::vector<std::size_t> &sample = {}) const;
+    bool convertToText(const std::string &outputDir) const;
+private:
+    bool checkLayout() const;
+    bool checkOffsets(SnapshotSection section, uint64_t numbOfItems, uint64_t numbOfEntries) const;
+    void writeGeneText(std::string &line, unsigned long gene, const char *chromo) const;
+    const char *Data;
+    std::size_t Size;
+    const SnapshotHeader *Header;
+    bool Mapped;                       // 'true' if Data is a mapped file
+};
+
+#endif	/* SNAPSHOT_H */
@@ -0,0 +1,330 @@
+/*
+ * File:   SweepRunner.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+
+#include "SweepRunner.h"
+
+/**
+ * @brief Core method. Constructor.
+ *
+ * @param numberOfCores - cores the sweep uses; 0 means all of them
+ * @param spec - the scenario of all the runs (a line of the parameter file can change it)
+ */
+SweepRunner::SweepRunner(unsigned int numberOfCores, const ScenarioSpec &spec) : BaseSpec(spec) {
+    unsigned int threadsAvailable = std::thread::hardware_concurrency();
+    if(threadsAvailable == 0) // if the value is not well defined or not computable, set at least 1 core
+        threadsAvailable = 1;
+    Cores = (numberOfCores == 0 or numberOfCores > threadsAvailable) ? threadsAvailable : numberOfCores;
+    FreeCores = Cores;
+    QueuedJobs = 0;
+    FailedJobs = 0;
+    Options = {0, 0, FsyncPolicy::Checkpoint, 0, 0, false};
+}
+
+SweepRunner::~SweepRunner() = default;
+
+/**
+ * @brief Core method. Reads a parameter file: one run per line, the 17 input
+ * parameters separated with spaces, optionally followed by scenario options
+ * (--key=value) which apply to this run only. Empty lines and lines starting
+ * with '#' are skipped.
+ *
+ * @param fileName - path to the parameter file
+ * @return 'true' if the file was read and all the lines are correct
+ */
+bool SweepRunner::readParamFile(const std::string &fileName){
+    std::ifstream paramFile(fileName);
+    if(!paramFile.good()){
+        std::cout << "Error in SweepRunner::readParamFile(): cannot open the file "
+                  << fileName << std::endl;
+        return false;
+    }
+    bool ok = true;
+    std::string line;
+    while(std::getline(paramFile, line)){
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos or line[first] == '#')
+            continue;
+        ok = addJob(line) and ok;
+    }
+    if(Jobs.empty()){
+        std::cout << "Error in SweepRunner::readParamFile(): no runs in the file "
+                  << fileName << std::endl;
+        return false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Core method. Adds a run given as one line of the parameter file.
+ *
+ * @param line - 17 parameters and, optionally, scenario options
+ * @return 'true' if the parameters and the options are correct
+ */
+bool SweepRunner::addJob(const std::string &line){
+    SweepJob job;
+    job.Index = Jobs.size() + 1;
+    job.Line = line;
+    job.Spec = BaseSpec;
+    std::vector<std::string> args;
+    std::vector<std::string> options;
+    std::stringstream ss(line);
+    std::string word;
+    while(ss >> word){
+        if(word.size() > 2 and word.compare(0, 2, "--") == 0)
+            options.push_back(word.substr(2));
+        else
+            args.push_back(word);
+    }
+    if(!readModelParams(args, job.Params)){
+        std::cout << "Error in SweepRunner::addJob(): line " << job.Index
+                  << " has to have 17 numbers: " << line << std::endl;
+        return false;
+    }
+    if(!job.Spec.readOptions(options)){
+        std::cout << "Error in SweepRunner::addJob(): wrong scenario options in line "
+                  << job.Index << ": " << line << std::endl;
+        return false;
+    }
+    DataHandler paramsChecker;
+    if(paramsChecker.checkParamsIfWrong(job.Params.numberOfThreads, job.Params.mhcGeneLength,
+            job.Params.antigenLength, job.Params.hostPopSize, job.Params.pathoPopSize, job.Params.patho_sp,
+            job.Params.hostGeneNumbb, job.Params.patoPerHostGeneration, job.Params.numOfHostGenerations,
+            job.Params.hostMutationProb, job.Params.pathoMutationProb, job.Params.HeteroHomo,
+            job.Params.deletion, job.Params.duplication, job.Params.maxGene, job.Params.alpha,
+            job.Params.NumbPartners)){
+        std::cout << "Error in SweepRunner::addJob(): wrong parameters in line "
+                  << job.Index << ": " << line << std::endl;
+        return false;
+    }
+    job.Threads = job.Params.numberOfThreads;
+    if(job.Threads == 0 or job.Threads > Cores)
+        job.Threads = Cores;
+    job.Params.numberOfThreads = job.Threads;
+    job.Cost = estimateCost(job.Params);
+    Jobs.push_back(job);
+    return true;
+}
+
+/**
+ * @brief Core method. Estimated amount of work of a run. Infection dominates
+ * the run time: every pathogen generation each host checks the epitopes of
+ * one pathogen per species against all its MHCs.
+ *
+ * @param params - input parameters of the run
+ * @return the estimate, in arbitrary units
+ */
+double SweepRunner::estimateCost(const ModelParams &params){
+    double epitopes = params.antigenLength > params.mhcGeneLength
+                      ? (double) (params.antigenLength - params.mhcGeneLength + 1) : 1.0;
+    double perPathoGen = (double) params.hostPopSize * (double) params.patho_sp
+                         * 2.0 * (double) params.hostGeneNumbb * epitopes
+                         + (double) params.pathoPopSize * (double) params.antigenLength;
+    return (double) params.numOfHostGenerations * (double) params.patoPerHostGeneration * perPathoGen;
+}
+
+/**
+ * @brief Core method. Runs all the runs of the sweep and returns when all are
+ * finished.
+ *
+ * @return number of runs that failed
+ */
+unsigned long SweepRunner::run(){
+    std::vector<SweepJob> sorted(Jobs);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const SweepJob &a, const SweepJob &b){
+        return a.Cost > b.Cost;
+    });
+    Queues.assign(Cores, std::deque<SweepJob>());
+    for(std::size_t i = 0; i < sorted.size(); ++i){
+        Queues[i % Cores].push_back(sorted[i]);
+    }
+    FreeCores = Cores;
+    QueuedJobs = sorted.size();
+    FailedJobs = 0;
+    std::cout << "Sweep of " << sorted.size() << " runs on " << Cores << " cores." << std::endl;
+    std::vector<std::thread> workers;
+    for(unsigned int id = 0; id < Cores; ++id){
+        workers.emplace_back(&SweepRunner::worker, this, id);
+    }
+    for(auto &wrk : workers){
+        wrk.join();
+    }
+    return FailedJobs;
+}
+
+/**
+ * @brief Core method. Loop of a worker thread: takes runs until there are
+ * none left.
+ *
+ * @param id - number of the worker, which is also the number of its queue
+ */
+void SweepRunner::worker(unsigned int id){
+    SweepJob job;
+    while(takeJob(id, job)){
+        bool ok = runJob(job);
+        {
+            std::lock_guard<std::mutex> lock(QueueMutex);
+            FreeCores += job.Threads;
+            if(!ok)
+                ++FailedJobs;
+            std::cout << "Run No. " << job.Index << (ok ? " finished." : " FAILED.") << std::endl;
+        }
+        QueueCond.notify_all();
+    }
+}
+
+/**
+ * @brief Core method. Takes the next run for a worker, waiting until enough
+ * cores are free.
+ *
+ * @param id - number of the worker
+ * @param job - the run taken
+ * @return 'false' if there are no runs left
+ */
+bool SweepRunner::takeJob(unsigned int id, SweepJob &job){
+    std::unique_lock<std::mutex> lock(QueueMutex);
+    while(QueuedJobs > 0){
+        if(popFittingJob(id, job)){
+            FreeCores -= job.Threads;
+            --QueuedJobs;
+            std::cout << "Run No. " << job.Index << " launched on " << job.Threads
+                      << " core(s)! Params are set to: " << job.Line << std::endl;
+            return true;
+        }
+        QueueCond.wait(lock);
+    }
+    return false;
+}
+
+/**
+ * @brief Core method. Finds a run that fits the free cores: the most expensive
+ * one of the worker's own queue or the cheapest one of the other queues.
+ * Called with the queue lock held.
+ *
+ * @param id - number of the worker
+ * @param job - the run found
+ * @return 'true' if a run was found (and removed from its queue)
+ */
+bool SweepRunner::popFittingJob(unsigned int id, SweepJob &job){
+    std::deque<SweepJob> &own = Queues[id];
+    for(auto it = own.begin(); it != own.end(); ++it){
+        if(it->Threads <= FreeCores){
+            job = *it;
+            own.erase(it);
+            return true;
+        }
+    }
+    for(unsigned int k = 1; k < Cores; ++k){
+        std::deque<SweepJob> &victim = Queues[(id + k) % Cores];
+        for(auto it = victim.rbegin(); it != victim.rend(); ++it){
+            if(it->Threads <= FreeCores){
+                job = *it;
+                victim.erase(std::next(it).base());
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Core method. Makes all the runs of the sweep start from the same
+ * evolved populations (see Simulation::setWarmStart()), so that each
+ * parameter set skips the burn-in.
+ *
+ * @param hostSource - checkpoint or host genomes file
+ * @param pathoSource - checkpoint or pathogen genomes file, may be empty
+ */
+void SweepRunner::setWarmStart(const std::string &hostSource, const std::string &pathoSource){
+    WarmStartHosts = hostSource;
+    WarmStartPathos = pathoSource;
+}
+
+/**
+ * @brief Data harvesting method. Output and reporting options given to every
+ * run of the sweep (see Simulation::setRunOptions()).
+ *
+ * @param options - the options
+ */
+void SweepRunner::setRunOptions(const RunOptions &options){
+    Options = options;
+}
+
+/**
+ * @brief Core method. Runs one simulation in its own directory.
+ *
+ * @param job - the run
+ * @return 'true' if the run went through
+ */
+bool SweepRunner::runJob(SweepJob &job){
+    std::string dirName = "MHC." + std::to_string(job.Index);
+    mkdir(dirName.c_str(), 0755);
+    struct stat dirStat;
+    if(stat(dirName.c_str(), &dirStat) != 0 or !S_ISDIR(dirStat.st_mode)){
+        std::cout << "Error in SweepRunner::runJob(): cannot create the directory " << dirName << std::endl;
+        return false;
+    }
+    try {
+        Simulation Sim(job.Params, job.Spec);
+        Sim.setWarmStart(WarmStartHosts, WarmStartPathos);
+        Sim.setRunOptions(Options);
+        DataHandler &Data2file = Sim.getDataHandler();
+        Data2file.setOutputDirectory(dirName);
+        Data2file.inputParamsToFile(job.Params.numberOfThreads, job.Params.mhcGeneLength,
+                job.Params.antigenLength, job.Params.hostPopSize, job.Params.pathoPopSize, job.Params.patho_sp,
+                job.Params.hostGeneNumbb, job.Params.patoPerHostGeneration, job.Params.numOfHostGenerations,
+                job.Params.hostMutationProb, job.Params.pathoMutationProb, job.Params.HeteroHomo,
+                job.Params.deletion, job.Params.duplication, job.Params.maxGene, job.Params.alpha,
+                job.Params.NumbPartners);
+        return Sim.run();
+    }
+    catch(std::exception &e) {
+        std::cout << "Error in SweepRunner::runJob(): run No. " << job.Index << " stopped: "
+                  << e.what() << std::endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Data harvesting method. Number of runs in the sweep.
+ *
+ * @return number of runs
+ */
+unsigned long SweepRunner::getNumberOfJobs() const {
+    return Jobs.size();
+}
+
+/**
+ * @brief Data harvesting method. Number of cores the sweep uses.
+ *
+ * @return number of cores
+ */
+unsigned int SweepRunner::getNumberOfCores() const {
+    return Cores;
+}
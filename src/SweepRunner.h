@@ -0,0 +1,91 @@
+/*
+ * File:   SweepRunner.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef SWEEPRUNNER_H
+#define	SWEEPRUNNER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Scenario.h"
+#include "Simulation.h"
+
+/**
+ * @brief One run of a parameter sweep: one line of the parameter file.
+ */
+struct SweepJob {
+    unsigned long Index;       // line number (non-empty lines only), the run goes to MHC.<Index>
+    ModelParams Params;
+    ScenarioSpec Spec;
+    std::string Line;          // the line as given, for the log
+    unsigned int Threads;      // cores the run occupies
+    double Cost;               // estimated amount of work, see SweepRunner::estimateCost()
+};
+
+/**
+ * @brief Core class. Runs a parameter sweep in one process: every line of a
+ * parameter file (ParamParam.csv, the same one BashScripts/MassModelLauncher.sh
+ * reads) is a separate simulation, run in its own MHC.N directory.
+ *
+ * Runs go side by side on a fixed number of cores. Each run occupies as many
+ * cores as it has threads (parameter No. 1; 0 means all the cores), so
+ * single-threaded replicates fill the cores left over by multi-threaded large
+ * runs and OpenMP teams never oversubscribe the machine. There is one worker
+ * thread per core with its own queue of runs. The runs are sorted from the most
+ * to the least expensive and dealt to the queues in turns. A worker takes the
+ * first run of its own queue that fits the free cores and, if there is none,
+ * steals one from the back (the cheap end) of another queue.
+ */
+class SweepRunner {
+public:
+    SweepRunner(unsigned int numberOfCores, const ScenarioSpec &spec);
+    virtual ~SweepRunner();
+    bool readParamFile(const std::string &fileName);
+    bool addJob(const std::string &line);
+    unsigned long run();
+    unsigned long getNumberOfJobs() const;
+    unsigned int getNumberOfCores() const;
+    static double estimateCost(const ModelParams &params);
+    void setWarmStart(const std::string &hostSource, const std::string &pathoSource);
+    void setRunOptions(const RunOptions &options);
+private:
+    void worker(unsigned int id);
+    bool takeJob(unsigned int id, SweepJob &job);
+    bool popFittingJob(unsigned int id, SweepJob &job);
+    bool runJob(SweepJob &job);
+    unsigned int Cores;
+    ScenarioSpec BaseSpec;
+    std::vector<SweepJob> Jobs;
+    std::vector<std::deque<SweepJob> > Queues;
+    std::mutex QueueMutex;
+    std::condition_variable QueueCond;
+    unsigned int FreeCores;
+    unsigned long QueuedJobs;
+    unsigned long FailedJobs;
+    std::string WarmStartHosts;     // snapshot all the runs start from, see Simulation::setWarmStart()
+    std::string WarmStartPathos;
+    RunOptions Options;             // output and reporting options of every run
+};
+
+#endif	/* SWEEPRUNNER_H */
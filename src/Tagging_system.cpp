@@ -20,7 +20,6 @@
 
 #include "Tagging_system.h"
 
-unsigned long int theTag = 0;
 /**
  * @brief Data collecting method. Constructor.
  */
@@ -30,10 +29,56 @@ Tagging_system::Tagging_system()
     omp_init_lock(&lockTagCreation);
 }
 
+/**
+ * @brief Data collecting method. Copy constructor. The copy continues from the
+ * same tag as the original but has its own lock.
+ */
+Tagging_system::Tagging_system(const Tagging_system &orig)
+{
+    theTag = orig.theTag;
+    omp_init_lock(&lockTagCreation);
+}
+
+Tagging_system& Tagging_system::operator=(const Tagging_system &orig)
+{
+    omp_set_lock(&lockTagCreation);
+    theTag = orig.theTag;
+    omp_unset_lock(&lockTagCreation);
+    return *this;
+}
+
+Tagging_system::~Tagging_system()
+{
+    omp_destroy_lock(&lockTagCreation);
+}
+
 unsigned long int Tagging_system::getTag()
 {
     omp_set_lock(&lockTagCreation);
-    theTag++;
+    unsigned long int newTag = ++theTag;
+    omp_unset_lock(&lockTagCreation);
+    return newTag;
+}
+
+/**
+ * @brief Data collecting method. The last tag given, needed to continue the
+ * tagging after a restart from a checkpoint.
+ */
+unsigned long int Tagging_system::getLastTag()
+{
+    omp_set_lock(&lockTagCreation);
+    unsigned long int lastTag = theTag;
+    omp_unset_lock(&lockTagCreation);
+    return lastTag;
+}
+
+/**
+ * @brief Data collecting method. Continues tagging from a given tag (the next
+ * tag will be lastTag + 1).
+ */
+void Tagging_system::setLastTag(unsigned long int lastTag)
+{
+    omp_set_lock(&lockTagCreation);
+    theTag = lastTag;
     omp_unset_lock(&lockTagCreation);
-    return theTag;
 }
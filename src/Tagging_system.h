@@ -23,23 +23,28 @@
 #include <omp.h>
 #include <atomic>
 
-extern unsigned long int theTag;
-
 /**
  * @class Tagging_system
  * 
  * @brief A little handy machine which generates unique tags for genes. These tags 
  * are used when keeping the track of evolution of individual MHC alleles. They do
  * not fallow a time sequence! Not when you use a multi-threaded computing.
+ * Each simulation has its own tagging system, so simulations run side by side
+ * (see SweepRunner) do not share the counter.
  */
 class Tagging_system {
 private:
-    //    unsigned long int theTag;
+    unsigned long int theTag;
     omp_lock_t lockTagCreation;
 
 public:
     Tagging_system();
+    Tagging_system(const Tagging_system &orig);
+    Tagging_system& operator=(const Tagging_system &orig);
+    ~Tagging_system();
     unsigned long int getTag();
+    unsigned long int getLastTag();
+    void setLastTag(unsigned long int lastTag);
 };
 
 #endif  /* TAGGING_SYSTEM */
@@ -0,0 +1,229 @@
+/*
+ * File:   TextFormat.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef TEXTFORMAT_H
+#define	TEXTFORMAT_H
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include "boost/dynamic_bitset.hpp"
+
+/**
+ * @brief Helpers writing numbers and bit-strings as text straight into a
+ * character buffer, the way std::to_chars does: no locale, no stream state, no
+ * temporary strings. Output is the same as of std::ostream << for integers and
+ * of boost::to_string() for bit-strings. The buffer has to have room for
+ * MaxDigits characters (plus a sign for negative numbers), or for the whole
+ * bit-string.
+ */
+namespace TextFormat {
+
+    const std::size_t MaxDigits = 20;  // digits of the largest 64-bit number
+
+    const char DigitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    /**
+     * @brief Writes an unsigned number, two digits at a time.
+     *
+     * @param out - where the text goes
+     * @param value - the number
+     * @return end of the written text
+     */
+    inline char* write(char *out, unsigned long long value){
+        char tmp[MaxDigits];
+        char *p = tmp + MaxDigits;
+        while(value >= 100){
+            unsigned pair = (unsigned) (value % 100) * 2;
+            value /= 100;
+            *--p = DigitPairs[pair + 1];
+            *--p = DigitPairs[pair];
+        }
+        if(value >= 10){
+            unsigned pair = (unsigned) value * 2;
+            *--p = DigitPairs[pair + 1];
+            *--p = DigitPairs[pair];
+        } else {
+            *--p = (char) ('0' + value);
+        }
+        std::size_t length = tmp + MaxDigits - p;
+        std::memcpy(out, p, length);
+        return out + length;
+    }
+
+    inline char* write(char *out, long long value){
+        if(value < 0){
+            *out++ = '-';
+            return write(out, 0ull - (unsigned long long) value);
+        }
+        return write(out, (unsigned long long) value);
+    }
+
+    inline char* write(char *out, unsigned long value){ return write(out, (unsigned long long) value); }
+    inline char* write(char *out, unsigned value){ return write(out, (unsigned long long) value); }
+    inline char* write(char *out, long value){ return write(out, (long long) value); }
+    inline char* write(char *out, int value){ return write(out, (long long) value); }
+
+    /**
+     * @brief Writes a string literal.
+     *
+     * @param out - where the text goes
+     * @param text - the literal
+     * @return end of the written text
+     */
+    template <std::size_t N>
+    inline char* writeText(char *out, const char (&text)[N]){
+        std::memcpy(out, text, N - 1);
+        return out + N - 1;
+    }
+
+    /**
+     * @brief The eight characters ('0'/'1', most significant bit first) of each
+     * of the 256 bytes.
+     */
+    struct ByteBitsTable {
+        char Text[256 * 8];
+        ByteBitsTable(){
+            for(unsigned byte = 0; byte < 256; ++byte){
+                for(unsigned bit = 0; bit < 8; ++bit){
+                    Text[byte * 8 + 7 - bit] = (byte >> bit) & 1u ? '1' : '0';
+                }
+            }
+        }
+    };
+
+    inline const char* byteBits(){
+        static const ByteBitsTable table;
+        return table.Text;
+    }
+
+    /**
+     * @brief Writes bits first to first+63 of a bit-string held in a 64-bit
+     * block, a byte at a time. The bit-string is written the way
+     * boost::to_string() does it: the most significant bit first, so bit i
+     * goes to end[-1 - i].
+     *
+     * @param end - end of the text of the whole bit-string
+     * @param block - the bits
+     * @param first - index of the lowest bit of the block in the bit-string
+     * @param length - length of the whole bit-string
+     */
+    inline void writeBitBlock(char *end, unsigned long long block, std::size_t first, std::size_t length){
+        const char *table = byteBits();
+        for(std::size_t bit = first; bit < length and bit < first + 64; bit += 8, block >>= 8){
+            if(bit + 8 <= length){
+                std::memcpy(end - bit - 8, table + (block & 0xFF) * 8, 8);
+            } else {
+                for(std::size_t i = bit; i < length; ++i){
+                    end[-1 - (long) i] = (block >> (i - bit)) & 1u ? '1' : '0';
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Writes the lowest bits of a number as a bit-string of a given
+     * length, the same as boost::to_string(boost::dynamic_bitset<>(length, value)).
+     *
+     * @param out - where the text goes
+     * @param value - the bits
+     * @param length - number of characters to write
+     * @return end of the written text
+     */
+    inline char* writeBits(char *out, unsigned long long value, std::size_t length){
+        if(length > 64){
+            std::memset(out, '0', length - 64);
+        }
+        writeBitBlock(out + length, value, 0, length);
+        return out + length;
+    }
+
+    /**
+     * @brief Output iterator taking the blocks of a dynamic_bitset (from the
+     * lowest one) and writing them as text, see boost::to_block_range().
+     */
+    struct BitBlockWriter {
+        typedef std::output_iterator_tag iterator_category;
+        typedef void value_type;
+        typedef void difference_type;
+        typedef void pointer;
+        typedef void reference;
+        char *End;
+        std::size_t First;
+        std::size_t Length;
+        BitBlockWriter& operator*(){ return *this; }
+        BitBlockWriter& operator++(){ return *this; }
+        BitBlockWriter& operator++(int){ return *this; }
+        BitBlockWriter& operator=(unsigned long block){
+            writeBitBlock(End, block, First, Length);
+            First += sizeof(unsigned long) * CHAR_BIT;
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Writes a bit-string the same way as boost::to_string().
+     *
+     * @param out - where the text goes
+     * @param bits - the bit-string
+     * @return end of the written text
+     */
+    inline char* writeBits(char *out, const boost::dynamic_bitset<> &bits){
+        static_assert(sizeof(unsigned long) * CHAR_BIT == 64, "blocks of dynamic_bitset<> have to be 64-bit");
+        BitBlockWriter writer = {out + bits.size(), 0, bits.size()};
+        boost::to_block_range(bits, writer);
+        return out + bits.size();
+    }
+
+    /**
+     * @brief Appends a record line to a buffer: the time stamp and the values,
+     * each preceded by a space, and the end of line.
+     *
+     * @param line - the buffer
+     * @param tayme - time stamp (hosts generation number)
+     * @param values - the values
+     * @param count - number of the values
+     */
+    template <typename T>
+    inline void appendRecord(std::vector<char> &line, int tayme, const T *values, std::size_t count){
+        std::size_t used = line.size();
+        line.resize(used + (count + 1) * (MaxDigits + 2) + 1);
+        char *p = write(line.data() + used, tayme);
+        for(std::size_t i = 0; i < count; ++i){
+            *p++ = ' ';
+            p = write(p, values[i]);
+        }
+        *p++ = '\n';
+        line.resize(p - line.data());
+    }
+
+    template <typename T>
+    inline void appendRecord(std::vector<char> &line, int tayme, const std::vector<T> &values){
+        appendRecord(line, tayme, values.data(), values.size());
+    }
+}
+
+#endif	/* TEXTFORMAT_H */
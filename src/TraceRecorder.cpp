@@ -0,0 +1,158 @@
+/*
+ * File:   TraceRecorder.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "TraceRecorder.h"
+#include "TextFormat.h"
+
+namespace {
+
+    const std::size_t FlushBytes = 1 << 20;
+
+    template <std::size_t N>
+    void appendText(std::vector<char> &out, const char (&text)[N]){
+        out.insert(out.end(), text, text + N - 1);
+    }
+
+    void appendText(std::vector<char> &out, const std::string &text){
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    void appendNumber(std::vector<char> &out, unsigned long long value){
+        char digits[TextFormat::MaxDigits];
+        out.insert(out.end(), digits, TextFormat::write(digits, value));
+    }
+
+    /**
+     * @brief Appends nanoseconds as microseconds with three decimals, the unit
+     * of the "ts" field.
+     */
+    void appendMicroseconds(std::vector<char> &out, int64_t nanoseconds){
+        unsigned long long ns = nanoseconds > 0 ? (unsigned long long) nanoseconds : 0;
+        appendNumber(out, ns / 1000);
+        unsigned frac = (unsigned) (ns % 1000);
+        char text[4] = {'.', (char) ('0' + frac / 100), (char) ('0' + frac / 10 % 10), (char) ('0' + frac % 10)};
+        out.insert(out.end(), text, text + 4);
+    }
+}
+
+/**
+ * @brief Data harvesting method. Constructor. Makes the rings and starts the
+ * clock of the timeline.
+ *
+ * @param eventsPerThread - size of each ring, at least 1
+ * @param numbOfThreads - number of rings, one per OpenMP thread
+ */
+TraceRecorder::TraceRecorder(std::size_t eventsPerThread, std::size_t numbOfThreads)
+        : Capacity(eventsPerThread > 0 ? eventsPerThread : 1), Rings(numbOfThreads),
+          Origin(std::chrono::steady_clock::now()) {
+    for(Ring &ring : Rings){
+        ring.Events.resize(Capacity);
+        ring.Written = 0;
+    }
+}
+
+TraceRecorder::~TraceRecorder() = default;
+
+/**
+ * @brief Data harvesting method. Number of events overwritten in full rings.
+ */
+uint64_t TraceRecorder::getNumbOfDropped() const {
+    uint64_t dropped = 0;
+    for(const Ring &ring : Rings){
+        if(ring.Written > Capacity)
+            dropped += ring.Written - Capacity;
+    }
+    return dropped;
+}
+
+/**
+ * @brief Data harvesting method. Writes the timeline as a Chrome trace event
+ * JSON file: a "B" and an "E" event for each scope, one track (tid) per
+ * OpenMP thread. An end whose begin was overwritten in the ring is left out.
+ * The file is written aside and renamed.
+ *
+ * @param fileName - path to the file
+ * @param names - names of the events, by TraceEvent::Name
+ * @param categories - category ("cat") of each name
+ * @return 'false' if the file could not be written
+ */
+bool TraceRecorder::writeChromeTrace(const std::string &fileName, const std::vector<std::string> &names,
+                                     const std::vector<std::string> &categories) const {
+    std::string tmpName = fileName + ".tmp";
+    std::ofstream out(tmpName, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::vector<char> text;
+    text.reserve(FlushBytes + 4096);
+    appendText(text, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":");
+    appendNumber(text, getNumbOfDropped());
+    appendText(text, "},\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                     "\"args\":{\"name\":\"MHC model\"}}");
+    for(std::size_t t = 0; t < Rings.size(); ++t){
+        appendText(text, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        appendNumber(text, t);
+        appendText(text, ",\"args\":{\"name\":\"OpenMP thread ");
+        appendNumber(text, t);
+        appendText(text, "\"}}");
+    }
+    for(std::size_t t = 0; t < Rings.size(); ++t){
+        const Ring &ring = Rings[t];
+        uint64_t numbOfEvents = ring.Written < Capacity ? ring.Written : Capacity;
+        uint64_t depth = 0;
+        for(uint64_t e = ring.Written - numbOfEvents; e < ring.Written; ++e){
+            const TraceEvent &event = ring.Events[e % Capacity];
+            if(event.Begin){
+                ++depth;
+            } else if(depth > 0){
+                --depth;
+            } else {
+                continue;
+            }
+            appendText(text, ",\n{\"name\":\"");
+            appendText(text, event.Name < names.size() ? names[event.Name] : std::string("unknown"));
+            appendText(text, "\",\"cat\":\"");
+            appendText(text, event.Name < categories.size() ? categories[event.Name] : std::string("unknown"));
+            if(event.Begin)
+                appendText(text, "\",\"ph\":\"B\",\"ts\":");
+            else
+                appendText(text, "\",\"ph\":\"E\",\"ts\":");
+            appendMicroseconds(text, event.Time);
+            appendText(text, ",\"pid\":1,\"tid\":");
+            appendNumber(text, t);
+            text.push_back('}');
+            if(text.size() >= FlushBytes){
+                out.write(text.data(), text.size());
+                text.clear();
+            }
+        }
+    }
+    appendText(text, "\n]}\n");
+    out.write(text.data(), text.size());
+    out.close();
+    if(!out or std::rename(tmpName.c_str(), fileName.c_str()) != 0){
+        std::cout << "Error in TraceRecorder::writeChromeTrace(): cannot write the file " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+/*
+ * File:   TraceRecorder.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+#ifndef TRACERECORDER_H
+#define	TRACERECORDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One begin or end of a traced scope.
+ */
+struct TraceEvent {
+    int64_t Time;        // nanoseconds since the recorder was made
+    uint16_t Name;       // index into the names given to writeChromeTrace()
+    uint16_t Begin;      // 1 - begin, 0 - end
+};
+
+/**
+ * @brief Allocator of memory aligned to a cache line (64 bytes), for the
+ * containers of types declared alignas(64); the default allocator does not
+ * align them before C++17.
+ */
+template <class T>
+struct CacheLineAllocator {
+    typedef T value_type;
+    CacheLineAllocator() = default;
+    template <class U>
+    CacheLineAllocator(const CacheLineAllocator<U>&){}
+    T* allocate(std::size_t n){
+        void *memory = nullptr;
+        if(posix_memalign(&memory, 64, n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(memory);
+    }
+    void deallocate(T *memory, std::size_t){
+        std::free(memory);
+    }
+};
+
+template <class T, class U>
+bool operator==(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&){ return true; }
+template <class T, class U>
+bool operator!=(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&){ return false; }
+
+/**
+ * @brief Data harvesting class. Timeline of begin and end events, one ring
+ * buffer per OpenMP thread, exported in the Chrome trace event format (opens
+ * in Perfetto or chrome://tracing).
+ *
+ * Each ring is written by its own thread only, so recording takes no lock and
+ * no atomic operation: it is one clock read and one store. When a ring is full
+ * the oldest events are overwritten, so the trace keeps the end of the run.
+ * Rings are read only between parallel regions (the end of a region orders
+ * the writes of its threads before the reads). Each ring starts a cache line
+ * of its own (see CacheLineAllocator), so the write positions of two threads
+ * never share one.
+ */
+class TraceRecorder {
+public:
+    TraceRecorder(std::size_t eventsPerThread, std::size_t numbOfThreads);
+    virtual ~TraceRecorder();
+
+    /**
+     * @brief Data harvesting method. Records an event on the ring of a thread.
+     * Threads the recorder has no ring for are ignored.
+     *
+     * @param thread - OpenMP thread number of the calling thread
+     * @param name - what begins or ends
+     * @param begin - 'true' for a begin, 'false' for an end
+     */
+    void record(std::size_t thread, uint16_t name, bool begin){
+        if(thread >= Rings.size())
+            return;
+        Ring &ring = Rings[thread];
+        TraceEvent &event = ring.Events[ring.Written % Capacity];
+        event.Time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - Origin).count();
+        event.Name = name;
+        event.Begin = begin;
+        ++ring.Written;
+    }
+    uint64_t getNumbOfDropped() const;
+    bool writeChromeTrace(const std::string &fileName, const std::vector<std::string> &names,
+                          const std::vector<std::string> &categories) const;
+private:
+    struct alignas(64) Ring {
+        std::vector<TraceEvent> Events;
+        uint64_t Written;     // events recorded so far, the ring keeps the last Capacity of them
+    };
+    std::size_t Capacity;
+    std::vector<Ring, CacheLineAllocator<Ring> > Rings;
+    std::chrono::steady_clock::time_point Origin;
+};
+
+#endif	/* TRACERECORDER_H */
@@ -0,0 +1,157 @@
+/*
+ * File:   AlleleTableTest.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "AlleleTable.h"
+#include "Environment.h"
+#include "FitnessPolicies.h"
+#include "Tagging_system.h"
+#include "TestCheck.h"
+
+namespace {
+
+    const unsigned long GeneSize = 16;
+    const unsigned long MaxGene = 12;
+
+    /**
+     * @brief Copies of every allele counted gene by gene in the whole host
+     * population, in ascending order of alleles.
+     */
+    std::vector<std::pair<unsigned long, unsigned long> > recount(const std::vector<Host> &hosts){
+        std::map<unsigned long, unsigned long> counts;
+        for(const Host &host : hosts){
+            for(const Gene &gene : host.getChromosomeOneRef())
+                counts[gene.getTheRealGene()] += 1;
+            for(const Gene &gene : host.getChromosomeTwoRef())
+                counts[gene.getTheRealGene()] += 1;
+        }
+        return std::vector<std::pair<unsigned long, unsigned long> >(counts.begin(), counts.end());
+    }
+
+    /**
+     * @brief The table followed the changes of the population (it was not
+     * counted anew) and has the same numbers as a recount.
+     */
+    void checkTable(const AlleleTable &table, const std::vector<Host> &hosts){
+        CHECK(table.isValid());
+        std::vector<std::pair<unsigned long, unsigned long> > counts = recount(hosts);
+        CHECK(table.getFrequencies() == counts);
+        CHECK(table.getNumbOfAlleles() == counts.size());
+        unsigned long copies = 0;
+        for(const auto &count : counts)
+            copies += count.second;
+        CHECK(table.getNumbOfCopies() == copies);
+    }
+
+    /**
+     * @brief One pathogen generation and host fitness, so hosts can be
+     * selected.
+     */
+    void infectAndScore(Environment &env, FitnessFunction fitFun, int tayme, Tagging_system &tags){
+        env.infectOneFromOneSpecHetero();
+        env.selectAndReproducePathoFixedPopSizes();
+        env.mutatePathogensWithRestric(0.05, GeneSize, tayme, tags);
+        env.clearPathoInfectionData();
+        env.infectOneFromOneSpecHetero();
+        env.calculateHostsFitness(fitFun, 0.1, MaxGene);
+    }
+
+    /**
+     * @brief The table is kept up to date through selection, every mating
+     * mode and both kinds of host mutations, over some generations.
+     */
+    void testFollowsGenerations(){
+        Tagging_system tags;
+        Environment env(2);
+        env.setHostRandomPopulation(60, GeneSize, 2, 6, 0, tags);
+        env.setPathoPopulatioDivSpecies(120, 60, 4, GeneSize, 0, 0.1, tags);
+        const AlleleTable &table = env.getHostAlleles();
+        checkTable(table, env.getHostPopulationRef());
+        for(int tayme = 1; tayme <= 12; ++tayme){
+            infectAndScore(env, tayme % 2 ? FitnessFunction::ExpFunc : FitnessFunction::Drift, tayme, tags);
+            switch(tayme % 6){
+                case 0:
+                    env.selectAndReprodHostsReplace();
+                    break;
+                case 1:
+                    env.selectAndReprodHostsNoMating();
+                    env.matingRandom();
+                    break;
+                case 2:
+                    env.selectAndReprodHostsNoMating();
+                    env.matingWithNoCommonMHCsmallSubset(4);
+                    break;
+                case 3:
+                    env.selectAndReprodHostsNoMatingWeighted();
+                    env.matingWithOneDifferentMHCsmallSubset(4);
+                    break;
+                case 4:
+                    env.selectAndReprodHostsNoMating();
+                    env.matingMeanOptimalNumberMHCsmallSubset(4);
+                    break;
+                default:
+                    env.selectAndReprodHostsNoMating();
+                    env.matingMaxDifferentNumber(4);
+            }
+            checkTable(table, env.getHostPopulationRef());
+            if(tayme % 2)
+                env.mutateHostsWithDelDuplPointMuts(0.1, 0.1, 0.1, MaxGene, tayme, tags);
+            else
+                env.mutateHostWithDelDuplAllMHCchange(0.1, 0.1, 0.1, MaxGene, tayme, tags);
+            checkTable(table, env.getHostPopulationRef());
+            env.clearHostInfectionsData();
+        }
+    }
+
+    /**
+     * @brief A change the table does not follow invalidates it, and it is
+     * counted anew the next time it is asked for.
+     */
+    void testRebuild(){
+        Tagging_system tags;
+        Environment env(1);
+        env.setHostRandomPopulation(30, GeneSize, 4, 0, tags);
+        const AlleleTable &table = env.getHostAlleles();
+        checkTable(table, env.getHostPopulationRef());
+        env.resizeHostPopulation(45);
+        CHECK(!table.isValid());
+        CHECK(&env.getHostAlleles() == &table);
+        checkTable(table, env.getHostPopulationRef());
+
+        AlleleTable fresh;
+        fresh.rebuild(env.getHostPopulationRef());
+        CHECK(fresh.getFrequencies() == table.getFrequencies());
+        fresh.add(fresh.getFrequencies().front().first, -1);
+        fresh.addChromosome(env.getHostPopulationRef()[0].getChromosomeOneRef(), 2);
+        unsigned long copies = env.getHostPopulationRef()[0].getChromosomeOneRef().size();
+        CHECK(fresh.getNumbOfCopies() == table.getNumbOfCopies() - 1 + 2 * copies);
+    }
+}
+
+int main(){
+    testFollowsGenerations();
+    testRebuild();
+    return TestCheck::result();
+}
@@ -0,0 +1,161 @@
+/*
+ * File:   CheckpointTest.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <limits>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BinaryIO.h"
+#include "DataHandler.h"
+#include "Environment.h"
+#include "Tagging_system.h"
+#include "TestCheck.h"
+
+namespace {
+
+    /**
+     * @brief Values, vectors and strings come back as they were written.
+     */
+    void testRoundTrip(){
+        std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+        std::vector<uint32_t> numbers = {0, 1, 7, std::numeric_limits<uint32_t>::max()};
+        std::vector<double> empty;
+        std::string text(3 * BinaryIO::ReadStep + 5, 'x');  // read in more than one part
+        text[BinaryIO::ReadStep] = 'y';
+        BinaryIO::write(stream, (int32_t) -42);
+        BinaryIO::write(stream, 0.125);
+        BinaryIO::writeVector(stream, numbers);
+        BinaryIO::writeVector(stream, empty);
+        BinaryIO::writeString(stream, text);
+        BinaryIO::writeString(stream, std::string());
+
+        int32_t integer;
+        double real;
+        std::vector<uint32_t> numbersBack;
+        std::vector<double> emptyBack = {1.0};
+        std::string textBack, emptyTextBack = "z";
+        CHECK(BinaryIO::read(stream, integer) and integer == -42);
+        CHECK(BinaryIO::read(stream, real) and real == 0.125);
+        CHECK(BinaryIO::readVector(stream, numbersBack) and numbersBack == numbers);
+        CHECK(BinaryIO::readVector(stream, emptyBack) and emptyBack.empty());
+        CHECK(BinaryIO::readString(stream, textBack) and textBack == text);
+        CHECK(BinaryIO::readString(stream, emptyTextBack) and emptyTextBack.empty());
+        CHECK(!BinaryIO::read(stream, integer));
+    }
+
+    /**
+     * @brief A stream cut short and a damaged length make reading fail,
+     * without allocating what the length says.
+     */
+    void testDamagedStreams(){
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        BinaryIO::writeString(out, "a string of some length");
+        std::string bytes = out.str();
+        std::istringstream cut(bytes.substr(0, bytes.size() - 1), std::ios::in | std::ios::binary);
+        std::string str;
+        CHECK(!BinaryIO::readString(cut, str));
+
+        std::ostringstream damaged(std::ios::out | std::ios::binary);
+        BinaryIO::write(damaged, (uint64_t) 1 << 39);  // 512 GB
+        BinaryIO::write(damaged, (uint64_t) 12345);
+        std::istringstream in(damaged.str(), std::ios::in | std::ios::binary);
+        std::vector<char> vec;
+        bool read = true;
+        try {
+            read = BinaryIO::readVector(in, vec);
+        } catch(const std::bad_alloc &){
+            CHECK(!"readVector() allocated the damaged length");
+        }
+        CHECK(!read);
+
+        std::ostringstream tooLong(std::ios::out | std::ios::binary);
+        BinaryIO::write(tooLong, BinaryIO::MaxLength + 1);
+        std::istringstream inTooLong(tooLong.str(), std::ios::in | std::ios::binary);
+        CHECK(!BinaryIO::readString(inTooLong, str));
+    }
+
+    /**
+     * @brief The state of an environment (populations, no-mutation sites,
+     * random number generators) is written again byte for byte after it has
+     * been read, and a damaged state is refused.
+     */
+    void testEnvironmentState(){
+        Tagging_system tags;
+        Environment env(1);
+        env.setHostRandomPopulation(60, 16, 4, 0, tags);
+        env.setPathoPopulatioDivSpecies(90, 64, 3, 16, 0, 0.1, tags);
+        env.mutateHostsWithDelDuplPointMuts(0.05, 0.1, 0.1, 10, 1, tags);
+        env.mutatePathogensWithRestric(0.05, 16, 1, tags);
+
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        env.writeState(out);
+        std::string state = out.str();
+        Environment restored(1);
+        std::istringstream in(state, std::ios::in | std::ios::binary);
+        CHECK(restored.readState(in, true));
+        std::ostringstream again(std::ios::out | std::ios::binary);
+        restored.writeState(again);
+        CHECK(again.str() == state);
+        CHECK(restored.getHostsPopSize() == 60);
+        CHECK(restored.getPathoNumOfSpecies() == 3);
+        for(unsigned long i = 0; i < 60; ++i){
+            CHECK(restored.getHostGenesToString(i) == env.getHostGenesToString(i));
+        }
+
+        Environment broken(1);
+        std::istringstream cut(state.substr(0, state.size() / 2), std::ios::in | std::ios::binary);
+        CHECK(!broken.readState(cut, true));
+    }
+
+    /**
+     * @brief The state of the data handler (which files were started, the
+     * output schedule) comes back as it was.
+     */
+    void testDataHandlerState(){
+        DataHandler data;
+        data.setAllFilesAsFirtsTimers();
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        data.writeState(out);
+        std::string state = out.str();
+        DataHandler restored;
+        std::istringstream in(state, std::ios::in | std::ios::binary);
+        CHECK(restored.readState(in));
+        std::ostringstream again(std::ios::out | std::ios::binary);
+        restored.writeState(again);
+        CHECK(again.str() == state);
+
+        std::string wrongLayout = state;
+        wrongLayout[0] = (char) (wrongLayout[0] + 1);  // one flag more than there are
+        std::istringstream inWrong(wrongLayout, std::ios::in | std::ios::binary);
+        CHECK(!restored.readState(inWrong));
+    }
+}
+
+int main(){
+    testRoundTrip();
+    testDamagedStreams();
+    testEnvironmentState();
+    testDataHandlerState();
+    return TestCheck::result();
+}
@@ -0,0 +1,145 @@
+/*
+ * File:   CompressionTest.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <limits>
+#include <vector>
+
+#include "Compression.h"
+#include "TestCheck.h"
+
+namespace {
+
+    /**
+     * @brief Bytes no block compressor can shorten (xorshift).
+     */
+    std::vector<uint8_t> noise(std::size_t size, uint64_t seed){
+        std::vector<uint8_t> bytes(size);
+        for(uint8_t &byte : bytes){
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            byte = (uint8_t) seed;
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief A block comes back as it was; returns the compressed size.
+     */
+    std::size_t checkBlock(const std::vector<uint8_t> &block){
+        std::vector<uint8_t> packed, unpacked;
+        Compression::compressBlock(block.data(), block.size(), packed);
+        CHECK(Compression::decompressBlock(packed.data(), packed.size(), unpacked, block.size()));
+        CHECK(unpacked == block);
+        return packed.size();
+    }
+
+    void testZigzag(){
+        CHECK(Compression::zigzag(0) == 0);
+        CHECK(Compression::zigzag(-1) == 1);
+        CHECK(Compression::zigzag(1) == 2);
+        CHECK(Compression::zigzag(-2) == 3);
+        std::vector<int64_t> values = {0, 1, -1, 63, -64, 1000000, -1000000, std::numeric_limits<int64_t>::max(),
+                                       std::numeric_limits<int64_t>::min()};
+        for(int64_t value : values)
+            CHECK(Compression::unzigzag(Compression::zigzag(value)) == value);
+    }
+
+    /**
+     * @brief Varints come back as written and take as many bytes as they
+     * should; cut or too long ones are refused.
+     */
+    void testVarints(){
+        std::vector<uint64_t> values = {0, 1, 127, 128, 16383, 16384, (uint64_t) 1 << 63,
+                                        std::numeric_limits<uint64_t>::max()};
+        std::vector<uint8_t> stream;
+        for(uint64_t value : values)
+            Compression::appendVarint(stream, value);
+        CHECK(stream.size() == 1 + 1 + 1 + 2 + 2 + 3 + 10 + 10);
+        const uint8_t *in = stream.data();
+        const uint8_t *end = in + stream.size();
+        for(uint64_t value : values){
+            uint64_t back;
+            CHECK(Compression::readVarint(in, end, back) and back == value);
+        }
+        CHECK(in == end);
+        uint64_t back;
+        CHECK(!Compression::readVarint(in, end, back));
+        std::vector<uint8_t> cut = {0x80, 0x80};
+        in = cut.data();
+        CHECK(!Compression::readVarint(in, in + cut.size(), back));
+        std::vector<uint8_t> tooLong(11, 0x80);
+        tooLong.back() = 0x01;
+        in = tooLong.data();
+        CHECK(!Compression::readVarint(in, in + tooLong.size(), back));
+    }
+
+    /**
+     * @brief Blocks of all kinds come back as they were: empty and too short
+     * to match, a run (a match overlapping itself, long lengths), noise (long
+     * literals), repeats farther back than a match can reach, a varint stream.
+     */
+    void testBlocks(){
+        checkBlock({});
+        checkBlock({1, 2, 3});
+        std::size_t packed = checkBlock(std::vector<uint8_t>(5000, 7));
+        CHECK(packed < 50);
+        std::vector<uint8_t> random = noise(3000, 88172645463325252ull);
+        packed = checkBlock(random);
+        CHECK(packed <= random.size() + random.size() / 255 + 16);
+        std::vector<uint8_t> far = noise(70000, 7);
+        far.insert(far.end(), far.begin(), far.begin() + 1000);
+        checkBlock(far);
+        std::vector<uint8_t> stream;
+        for(int round = 0; round < 200; ++round){
+            for(int64_t delta : {1, 1, 2, -3, 0, 0, 130, -1})
+                Compression::appendVarint(stream, Compression::zigzag(delta));
+        }
+        CHECK(checkBlock(stream) < stream.size() / 10);
+    }
+
+    /**
+     * @brief Broken blocks and blocks of another size are refused.
+     */
+    void testDamagedBlocks(){
+        std::vector<uint8_t> block = noise(400, 3);
+        block.insert(block.end(), block.begin(), block.end());
+        std::vector<uint8_t> packed, unpacked;
+        Compression::compressBlock(block.data(), block.size(), packed);
+        CHECK(!Compression::decompressBlock(packed.data(), packed.size(), unpacked, block.size() - 1));
+        CHECK(!Compression::decompressBlock(packed.data(), packed.size(), unpacked, block.size() + 1));
+        CHECK(!Compression::decompressBlock(packed.data(), packed.size() / 2, unpacked, block.size()));
+        CHECK(!Compression::decompressBlock(packed.data(), packed.size() - 3, unpacked, block.size()));
+        std::vector<uint8_t> farBack = {0x10, 9, 0xFF, 0x00};  // one literal, a match 255 bytes back
+        CHECK(!Compression::decompressBlock(farBack.data(), farBack.size(), unpacked, 5));
+        std::vector<uint8_t> noOffset = {0x10, 9, 0x00, 0x00};
+        CHECK(!Compression::decompressBlock(noOffset.data(), noOffset.size(), unpacked, 5));
+    }
+}
+
+int main(){
+    testZigzag();
+    testVarints();
+    testBlocks();
+    testDamagedBlocks();
+    return TestCheck::result();
+}
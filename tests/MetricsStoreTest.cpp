@@ -0,0 +1,206 @@
+/*
+ * File:   MetricsStoreTest.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "MetricsStore.h"
+#include "TestCheck.h"
+
+namespace {
+
+    const std::string FileName = "MetricsStoreTest.bin";
+    const unsigned long NumbOfHosts = 50;
+
+    /**
+     * @brief Numbers of genes of the hosts: spread wide within a generation
+     * but change little between generations, so they get packed as
+     * differences from the previous one.
+     */
+    std::vector<uint64_t> geneNumbers(int tayme){
+        std::vector<uint64_t> values(NumbOfHosts);
+        for(unsigned long i = 0; i < NumbOfHosts; ++i)
+            values[i] = (i * 7919) % 5000 + (i == (unsigned long) tayme % NumbOfHosts ? 1 : 0);
+        return values;
+    }
+
+    /**
+     * @brief Sorted alleles, as many as the generation has: packed as
+     * differences from the previous value.
+     */
+    std::vector<uint64_t> alleles(int tayme){
+        std::vector<uint64_t> values(10 + tayme % 5);
+        for(unsigned long i = 0; i < values.size(); ++i)
+            values[i] = 1000 * i + tayme;
+        return values;
+    }
+
+    std::vector<uint32_t> presented(int tayme){
+        std::vector<uint32_t> values(NumbOfHosts);
+        for(unsigned long i = 0; i < NumbOfHosts; ++i)
+            values[i] = (uint32_t) ((i * 3 + tayme) % 4);
+        return values;
+    }
+
+    void writeGeneration(MetricsWriter &writer, int tayme){
+        writer.add(tayme, HostPopSize, std::vector<double>{100.0 + tayme});
+        writer.add(tayme, HostMhcTypes, std::vector<uint64_t>{(uint64_t) tayme * 3});
+        writer.add(tayme, GeneNumbTotal, geneNumbers(tayme));
+        writer.add(tayme, AlleleValues, alleles(tayme));
+        writer.add(tayme, PresentedPathogens, presented(tayme));
+        writer.endGeneration();
+    }
+
+    void writeStore(MetricsCompression compression, int from, int to, bool truncate){
+        MetricsWriter writer;
+        CHECK(writer.open(FileName, truncate));
+        writer.setCompression(compression);
+        for(int tayme = from; tayme <= to; ++tayme)
+            writeGeneration(writer, tayme);
+        CHECK(writer.commit(false));
+        writer.close();
+    }
+
+    /**
+     * @brief A generation of the store has the columns written for it.
+     */
+    void checkGeneration(const MetricsReader &reader, std::size_t generation, int tayme){
+        CHECK(reader.getTime(generation) == tayme);
+        uint64_t count;
+        const double *popSize = reader.getColumn<double>(generation, HostPopSize, count);
+        CHECK(popSize and count == 1 and popSize[0] == 100.0 + tayme);
+        std::vector<uint64_t> values;
+        CHECK(reader.readColumn(generation, HostMhcTypes, values) and values.size() == 1
+              and values[0] == (uint64_t) tayme * 3);
+        CHECK(reader.readColumn(generation, GeneNumbTotal, values) and values == geneNumbers(tayme));
+        CHECK(reader.readColumn(generation, AlleleValues, values) and values == alleles(tayme));
+        std::vector<uint32_t> narrow = presented(tayme);
+        CHECK(reader.readColumn(generation, PresentedPathogens, values)
+              and values == std::vector<uint64_t>(narrow.begin(), narrow.end()));
+        CHECK(!reader.readColumn(generation, HostPopSize, values));
+        CHECK(!reader.findColumn(generation, MemoryBytes));
+    }
+
+    void checkStore(int last){
+        MetricsReader reader;
+        CHECK(reader.open(FileName));
+        CHECK(reader.getNumbOfGenerations() == (std::size_t) last + 1);
+        for(std::size_t g = 0; g < reader.getNumbOfGenerations(); ++g)
+            checkGeneration(reader, g, (int) g);
+        for(std::size_t g = reader.getNumbOfGenerations(); g-- > 0; )  // against the unpacked columns kept
+            checkGeneration(reader, g, (int) g);
+        std::size_t generation;
+        CHECK(reader.findGeneration(last / 2, generation) and generation == (std::size_t) last / 2);
+        CHECK(!reader.findGeneration(last + 1, generation));
+    }
+
+    /**
+     * @brief Columns come back as written with every compression; packing
+     * is used where it pays, on more generations than KeyframeEvery.
+     */
+    void testRoundTrip(MetricsCompression compression){
+        const int last = 2 * MetricsWriter::KeyframeEvery + 5;
+        writeStore(compression, 0, last, true);
+        checkStore(last);
+        MetricsReader reader;
+        CHECK(reader.open(FileName));
+        bool generationDelta = false, blockCompressed = false;
+        for(std::size_t g = 0; g < reader.getNumbOfGenerations(); ++g){
+            const MetricsColumnEntry *entry = reader.findColumn(g, GeneNumbTotal);
+            CHECK(entry != nullptr);
+            generationDelta = generationDelta or entry->Encoding == MetricGenerationDelta;
+            blockCompressed = blockCompressed or entry->BlockCompressed;
+            CHECK(reader.findColumn(g, HostPopSize)->Encoding == MetricRaw);
+            CHECK(reader.findColumn(g, HostMhcTypes)->Encoding == MetricRaw);
+            if(compression == MetricsCompression::None)
+                CHECK(entry->Encoding == MetricRaw);
+        }
+        CHECK(generationDelta == (compression != MetricsCompression::None));
+        CHECK(blockCompressed == (compression == MetricsCompression::Block));
+    }
+
+    /**
+     * @brief A store cut in the middle of a chunk (the run was killed) is
+     * read up to the last complete chunk, and continued from there.
+     */
+    void testTruncated(){
+        writeStore(MetricsCompression::Block, 0, 19, true);
+        std::ifstream in(FileName, std::ios::in | std::ios::binary | std::ios::ate);
+        long chunksEnd = (long) in.tellg() - 20 * (long) sizeof(MetricsIndexEntry) - (long) sizeof(MetricsTrailer);
+        in.close();
+        writeStore(MetricsCompression::Block, 20, 29, false);
+        CHECK(truncate(FileName.c_str(), chunksEnd + 40) == 0);
+        checkStore(19);
+        writeStore(MetricsCompression::Block, 20, 24, false);
+        checkStore(24);
+    }
+
+    /**
+     * @brief dropAfter() leaves the generations up to the one given; the
+     * store then continues with new generations.
+     */
+    void testDropAfter(){
+        writeStore(MetricsCompression::Block, 0, 40, true);
+        CHECK(MetricsWriter::dropAfter(FileName, 24));
+        checkStore(24);
+        writeStore(MetricsCompression::Block, 25, 30, false);
+        checkStore(30);
+        CHECK(MetricsWriter::dropAfter("MetricsStoreTest.none", 3));
+    }
+
+    /**
+     * @brief Other files and stores of another version are not read.
+     */
+    void testNotAStore(){
+        writeStore(MetricsCompression::None, 0, 3, true);
+        std::fstream file(FileName, std::ios::in | std::ios::out | std::ios::binary);
+        MetricsFileHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        header.Version += 1;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+        MetricsReader reader;
+        CHECK(!reader.open(FileName));
+        MetricsWriter writer;
+        CHECK(!writer.open(FileName, false));
+        std::ofstream text(FileName, std::ios::out | std::ios::trunc);
+        text << "time\tvalue" << std::endl;
+        text.close();
+        CHECK(!reader.open(FileName));
+    }
+}
+
+int main(){
+    testRoundTrip(MetricsCompression::None);
+    testRoundTrip(MetricsCompression::Delta);
+    testRoundTrip(MetricsCompression::Block);
+    testTruncated();
+    testDropAfter();
+    testNotAStore();
+    std::remove(FileName.c_str());
+    return TestCheck::result();
+}
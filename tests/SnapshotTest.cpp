@@ -0,0 +1,205 @@
+/*
+ * File:   SnapshotTest.cpp
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Environment.h"
+#include "Snapshot.h"
+#include "Tagging_system.h"
+#include "TestCheck.h"
+
+namespace {
+
+    const unsigned long GeneSize = 16;
+    const unsigned long AntigenSize = 100;  // more than one 64-bit word
+    const int NumbOfSpecies = 3;
+
+    /**
+     * @brief The genome of an individual without its " === " line, which
+     * counts infections and these are not loaded from a snapshot.
+     */
+    std::string genomeLines(const std::string &text){
+        return text.compare(0, 4, " ===") == 0 ? text.substr(text.find('\n') + 1) : text;
+    }
+
+    /**
+     * @brief The text of the hosts as DataHandler::saveHostPopulToFile() writes it.
+     */
+    std::string hostText(const std::vector<Host> &hosts, const std::vector<std::size_t> &sample, int tayme){
+        std::ostringstream out;
+        if(sample.empty())
+            out << "#Genomes_of_all_host_at_time = " << tayme << std::endl;
+        else
+            out << "#Genomes_of_" << sample.size() << "_of_" << hosts.size()
+                << "_hosts_sampled_at_time = " << tayme << std::endl;
+        out << "#bit-gene\tchromosome\ttime_of_origin\tgene_own_tag"
+            << "\tTime_of_parental_mutation\tAll_parental_tags etc." << std::endl;
+        std::vector<char> text;
+        for(std::size_t n = 0; n < (sample.empty() ? hosts.size() : sample.size()); ++n){
+            hosts[sample.empty() ? n : sample[n]].appendChromosomes(text);
+        }
+        out.write(text.data(), text.size());
+        return out.str();
+    }
+
+    /**
+     * @brief The text of the pathogens as DataHandler::savePathoPopulToFile() writes it.
+     */
+    std::string pathoText(const std::vector<std::vector<Pathogen> > &pathogens, int tayme){
+        std::ostringstream out;
+        out << "#Genomes_of_all_pathogens_at_time = " << tayme << std::endl;
+        out << "#bit-gene\tchromosome\ttime_of_origin\tgene_own_tag\tAll_parental_tags" << std::endl;
+        std::vector<char> text;
+        for(const std::vector<Pathogen> &species : pathogens){
+            for(const Pathogen &patho : species)
+                patho.appendGenesFromGenome(text);
+        }
+        out.write(text.data(), text.size());
+        return out.str();
+    }
+
+    /**
+     * @brief An environment with some history: mutated genes and antigens,
+     * infections.
+     */
+    void makeEnvironment(Environment &env, Tagging_system &tags){
+        env.setHostRandomPopulation(40, GeneSize, 4, 0, tags);
+        env.setPathoPopulatioDivSpecies(60, AntigenSize, NumbOfSpecies, GeneSize, 0, 0.1, tags);
+        env.infectOneFromOneSpecHetero();
+        env.mutateHostsWithDelDuplPointMuts(0.05, 0.1, 0.1, 10, 1, tags);
+        env.mutatePathogensWithRestric(0.05, GeneSize, 1, tags);
+    }
+
+    /**
+     * @brief A snapshot written to a file is mapped back and gives the same
+     * text as the population it was taken from, whole or sampled.
+     */
+    void testFileRoundTrip(const Environment &env){
+        const std::string fileName = "SnapshotTest.bin";
+        {
+            std::ofstream out(fileName, std::ios::out | std::ios::binary);
+            CHECK(env.writeSnapshot(out, 7, true, true));
+        }
+        SnapshotReader reader;
+        CHECK(reader.open(fileName));
+        CHECK(reader.getHeader().Time == 7);
+        CHECK(reader.getNumbOfHosts() == env.getHostPopulationRef().size());
+        CHECK(reader.getNumbOfPathos() == 60);
+        CHECK(reader.getHeader().NumbOfSpecies == (uint64_t) NumbOfSpecies);
+        std::ostringstream hosts, pathos, sampledHosts;
+        reader.writeHostText(hosts);
+        reader.writePathoText(pathos);
+        std::vector<std::size_t> sample = {0, 3, 4, 39};
+        reader.writeHostText(sampledHosts, sample);
+        CHECK(hosts.str() == hostText(env.getHostPopulationRef(), {}, 7));
+        CHECK(pathos.str() == pathoText(env.getPathoPopulationRef(), 7));
+        CHECK(sampledHosts.str() == hostText(env.getHostPopulationRef(), sample, 7));
+        reader.close();
+        std::remove(fileName.c_str());
+    }
+
+    /**
+     * @brief A snapshot held in memory is read in place; one taken without
+     * hosts or without pathogens has those sections empty.
+     */
+    void testMemoryRoundTrip(const Environment &env){
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        CHECK(env.writeSnapshot(out, 3, false, true));
+        std::string snapshot = out.str();
+        SnapshotReader reader;
+        CHECK(reader.open(snapshot.data(), snapshot.size()));
+        CHECK(reader.getNumbOfHosts() == 0);
+        std::ostringstream pathos;
+        reader.writePathoText(pathos);
+        CHECK(pathos.str() == pathoText(env.getPathoPopulationRef(), 3));
+
+        std::ostringstream hostsOnly(std::ios::out | std::ios::binary);
+        CHECK(env.writeSnapshot(hostsOnly, 3, true, false));
+        snapshot = hostsOnly.str();
+        CHECK(reader.open(snapshot.data(), snapshot.size()));
+        CHECK(reader.getNumbOfPathos() == 0 and !reader.getHeader().HasPathogens);
+    }
+
+    /**
+     * @brief Populations loaded from a snapshot have the genomes saved, with
+     * their lineage (the infections are not loaded).
+     */
+    void testLoadPopulations(Environment &env){
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        CHECK(env.writeSnapshot(out, 5, true, true));
+        std::string snapshot = out.str();
+        SnapshotReader reader;
+        CHECK(reader.open(snapshot.data(), snapshot.size()));
+        Tagging_system tags;
+        Environment loaded(1);
+        CHECK(loaded.setHostPopulationFromSnapshot(reader, GeneSize, tags));
+        CHECK(loaded.setPathoPopulationFromSnapshot(reader, AntigenSize, GeneSize, tags));
+        CHECK(loaded.getHostsPopSize() == reader.getNumbOfHosts());
+        for(unsigned long i = 0; i < loaded.getHostsPopSize(); ++i){
+            CHECK(genomeLines(loaded.getHostGenesToString(i)) == genomeLines(env.getHostGenesToString(i)));
+        }
+        CHECK(loaded.getPathoNumOfSpecies() == (unsigned long) NumbOfSpecies);
+        for(unsigned long sp = 0; sp < (unsigned long) NumbOfSpecies; ++sp){
+            CHECK(loaded.getPathoSpeciesPopSize(sp) == env.getPathoSpeciesPopSize(sp));
+            for(unsigned long j = 0; j < loaded.getPathoSpeciesPopSize(sp); ++j){
+                CHECK(genomeLines(loaded.getPathoGenesToString(sp, j))
+                      == genomeLines(env.getPathoGenesToString(sp, j)));
+            }
+        }
+    }
+
+    /**
+     * @brief Cut or damaged snapshots are refused.
+     */
+    void testDamagedSnapshots(const Environment &env){
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        CHECK(env.writeSnapshot(out, 1, true, true));
+        std::string snapshot = out.str();
+        SnapshotReader reader;
+        std::string cut = snapshot.substr(0, snapshot.size() - 8);
+        CHECK(!reader.open(cut.data(), cut.size()));
+        std::string damaged = snapshot;
+        SnapshotHeader *header = reinterpret_cast<SnapshotHeader*>(&damaged[0]);
+        header->NumbOfGenes += 1;
+        CHECK(!reader.open(damaged.data(), damaged.size()));
+        damaged = snapshot;
+        header = reinterpret_cast<SnapshotHeader*>(&damaged[0]);
+        header->Magic[0] = 'X';
+        CHECK(!reader.open(damaged.data(), damaged.size()));
+        CHECK(!reader.open(snapshot.data(), sizeof(SnapshotHeader) - 1));
+    }
+}
+
+int main(){
+    Tagging_system tags;
+    Environment env(1);
+    makeEnvironment(env, tags);
+    testFileRoundTrip(env);
+    testMemoryRoundTrip(env);
+    testLoadPopulations(env);
+    testDamagedSnapshots(env);
+    return TestCheck::result();
+}
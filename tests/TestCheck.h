@@ -0,0 +1,56 @@
+/*
+ * File:   TestCheck.h
+ * Author: Piotr Bentkowski : bentkowski.piotr@gmail.com
+ *
+ * Created on 18 October 2026
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *    MA 02110-1301, USA.
+ */
+
+#ifndef TESTCHECK_H
+#define	TESTCHECK_H
+
+#include <iostream>
+
+/**
+ * @brief Checks of the unit tests. A test program runs its checks with CHECK()
+ * and ends with 'return TestCheck::result();', so ctest sees a failed check as
+ * a non-zero exit code. Failed checks are reported with their place.
+ */
+namespace TestCheck {
+
+    inline int& failures(){
+        static int count = 0;
+        return count;
+    }
+
+    inline void check(bool passed, const char *condition, const char *file, int line){
+        if(!passed){
+            std::cout << "Check failed in " << file << ":" << line << ": " << condition << std::endl;
+            ++failures();
+        }
+    }
+
+    inline int result(){
+        if(failures() > 0)
+            std::cout << failures() << " check(s) failed." << std::endl;
+        return failures() > 0 ? 1 : 0;
+    }
+}
+
+#define CHECK(condition) TestCheck::check((condition), #condition, __FILE__, __LINE__)
+
+#endif	/* TESTCHECK_H */